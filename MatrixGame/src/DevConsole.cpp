@@ -6,6 +6,7 @@
 #include "MatrixMap.hpp"
 #include "DevConsole.hpp"
 #include "MatrixSoundManager.hpp"
+#include "MatrixCollision.hpp"
 
 #include "CFile.hpp"
 
@@ -120,6 +121,122 @@ static void hTestSpdTrace(
     g_MatrixMap->m_DI.T(L"Trace time (ms)", utils::format(L"%u", time2 - time1).c_str(), 5000);
 }
 
+// Robot vs obstacles gate: batched test against the scalar one on random windows of the map.
+static void hTestSpdCollide(
+    [[maybe_unused]] const std::wstring& cmd,
+    [[maybe_unused]] const std::wstring& params)
+{
+    random::seed(1);
+
+    const int cnt = 100000;
+    int nsh = params.empty() ? 1 : (_wtoi(params.c_str()) - 1);  // chassis kind
+    if (nsh < 0 || nsh > 4)
+        nsh = 1;
+
+    BYTE corners[COLLIDE_WINDOW][COLLIDE_WINDOW];
+    SCollideCells cells;
+    D3DXVECTOR2 *pos = (D3DXVECTOR2 *)HAlloc(sizeof(D3DXVECTOR2) * cnt, g_MatrixHeap);
+    SCollideCells *win = (SCollideCells *)HAlloc(sizeof(SCollideCells) * 64, g_MatrixHeap);
+
+    // windows are prepared beforehand, the positions are spread around them
+    for (int w = 0; w < 64; ++w) {
+        int x0 = IRND(g_MatrixMap->m_SizeMove.x - COLLIDE_WINDOW);
+        int y0 = IRND(g_MatrixMap->m_SizeMove.y - COLLIDE_WINDOW);
+        for (int y = 0; y < COLLIDE_WINDOW; ++y)
+            for (int x = 0; x < COLLIDE_WINDOW; ++x)
+                corners[x][y] = g_MatrixMap->MoveGet(x0 + x, y0 + y)->GetType(nsh);
+        win[w].Prepare(corners, x0, y0, x0 + COLLIDE_WINDOW, y0 + COLLIDE_WINDOW);
+    }
+    for (int i = 0; i < cnt; ++i) {
+        const SCollideCells &c = win[i & 63];
+        pos[i].x = (c.m_X0 + FRND(COLLIDE_WINDOW)) * GLOBAL_SCALE_MOVE;
+        pos[i].y = (c.m_Y0 + FRND(COLLIDE_WINDOW)) * GLOBAL_SCALE_MOVE;
+    }
+
+    uint64_t sum1 = 0, sum2 = 0;
+    int missed = 0;
+
+    DWORD time1 = timeGetTime();
+    for (int i = 0; i < cnt; ++i)
+        sum1 += win[i & 63].CandidatesScalar(pos[i], 0);
+    DWORD time2 = timeGetTime();
+    for (int i = 0; i < cnt; ++i)
+        sum2 += win[i & 63].Candidates(pos[i], 0);
+    DWORD time3 = timeGetTime();
+
+    // the batched gate may only be wider than the exact per cell check
+    for (int i = 0; i < cnt; ++i) {
+        const SCollideCells &c = win[i & 63];
+        uint64_t mask = c.Candidates(pos[i], 0);
+        for (int j = 0; j < c.m_Cnt; ++j) {
+            float d, dsx = 0, dsy = 0;
+            if (CMatrixRobotAI::SphereToAABBCheck(pos[i], D3DXVECTOR2(c.m_MinX[j], c.m_MinY[j]),
+                                                  D3DXVECTOR2(c.m_MaxX[j], c.m_MaxY[j]), d, dsx, dsy) &&
+                !(mask & (uint64_t(1) << j)))
+                ++missed;
+        }
+    }
+
+    HFree(win, g_MatrixHeap);
+    HFree(pos, g_MatrixHeap);
+
+    g_MatrixMap->m_DI.T(L"Collide scalar (ms)", utils::format(L"%u", time2 - time1).c_str(), 5000);
+    g_MatrixMap->m_DI.T(L"Collide batched (ms)", utils::format(L"%u", time3 - time2).c_str(), 5000);
+    g_MatrixMap->m_DI.T(L"Collide missed cells", utils::format(L"%d%s", missed, sum1 == sum2 ? L"" : L" (masks differ)").c_str(),
+                        5000);
+}
+
+static void CollectPars(CBlockPar *bp, std::vector<std::pair<CBlockPar *, std::wstring>> &pars)
+{
+    for (int i = 0; i < bp->ParCount(); ++i)
+        pars.emplace_back(bp, bp->ParGetName(i));
+    for (int i = 0; i < bp->BlockCount(); ++i)
+        CollectPars(bp->BlockGet(i), pars);
+}
+
+// Config lookups: a million of ParGet by name and by interned key over the parameters of data.txt
+static void hTestSpdConfig(
+    [[maybe_unused]] const std::wstring& cmd,
+    [[maybe_unused]] const std::wstring& params)
+{
+    CBlockPar data;
+    std::wstring name;
+    if (CFile::FileExist(name, L"cfg\\robots\\data.txt"))
+        data.LoadFromTextFile(L"cfg\\robots\\data.txt");
+    else
+        data.CopyFrom(*g_MatrixData);
+
+    std::vector<std::pair<CBlockPar *, std::wstring>> pars;
+    CollectPars(&data, pars);
+    if (pars.empty())
+        return;
+
+    std::vector<SBlockParKey> keys;
+    for (auto &p : pars)
+        keys.push_back(CBlockPar::Key(p.second));
+
+    random::seed(1);
+    const int cnt = 1000000;
+    std::vector<int> order(cnt);
+    for (int i = 0; i < cnt; ++i)
+        order[i] = IRND(int(pars.size()));
+
+    size_t len1 = 0, len2 = 0;
+
+    DWORD time1 = timeGetTime();
+    for (int i = 0; i < cnt; ++i)
+        len1 += pars[order[i]].first->ParGet(pars[order[i]].second).length();
+    DWORD time2 = timeGetTime();
+    for (int i = 0; i < cnt; ++i)
+        len2 += pars[order[i]].first->ParGet(keys[order[i]]).length();
+    DWORD time3 = timeGetTime();
+
+    g_MatrixMap->m_DI.T(L"Config lookups", utils::format(L"%d over %d pars%ls", cnt, int(pars.size()),
+                                                         len1 == len2 ? L"" : L" (values differ)").c_str(), 5000);
+    g_MatrixMap->m_DI.T(L"Config by name (ms)", utils::format(L"%u", time2 - time1).c_str(), 5000);
+    g_MatrixMap->m_DI.T(L"Config by key (ms)", utils::format(L"%u", time3 - time2).c_str(), 5000);
+}
+
 static void hMusic(
     [[maybe_unused]] const std::wstring& cmd,
     [[maybe_unused]] const std::wstring& params)
@@ -161,10 +278,28 @@ static void hCompress(
     }
 }
 
+static void hCache(
+    [[maybe_unused]] const std::wstring& cmd,
+    [[maybe_unused]] const std::wstring& params)
+{
+    static const CacheClass classes[] = {CacheClass::Texture, CacheClass::TextureManaged, CacheClass::VO};
+    static const wchar *names[] = {L"Cache Texture", L"Cache TextureManaged", L"Cache VO"};
+
+    for (int i = 0; i < 3; ++i) {
+        const SCacheClassStat &st = g_Cache->GetStat(classes[i]);
+        std::wstring budget = st.m_Budget ? utils::format(L"%u KB", st.m_Budget / 1024) : std::wstring{L"none"};
+        g_MatrixMap->m_DI.T(names[i],
+                            utils::format(L"%d loaded, %u KB, budget %ls, evicted %d", st.m_Loaded,
+                                          st.m_Size / 1024, budget.c_str(), st.m_Evicted).c_str(),
+                            10000);
+    }
+}
+
 SCmdItem CDevConsole::m_Commands[] = {
         {L"HELP", hHelp},   {L"SHADOWS", hShadows},       {L"CANNON", hCannon},
         {L"LOG", hLog},     {L"TRACESPD", hTestSpdTrace}, {L"BUILDCFG", hBuildCFG},
         {L"MUSIC", hMusic}, {L"COMPRESS", hCompress},     {L"CALCVIS", hCalcVis},
+        {L"COLLSPD", hTestSpdCollide}, {L"CACHE", hCache}, {L"CFGSPD", hTestSpdConfig},
 
         {NULL, NULL}  // last
 };
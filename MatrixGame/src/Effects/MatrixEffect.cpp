@@ -27,6 +27,7 @@
 #include "../MatrixObject.hpp"
 #include "../MatrixRenderPipeline.hpp"
 #include "../MatrixSkinManager.hpp"
+#include "TextureAtlas.hpp"
 #include <math.h>
 
 #define M_PI 3.14159265358979323846
@@ -246,6 +247,7 @@ void CMatrixEffect::ClearEffects(void) {
     m_Debris = 0;
 
     CBillboard::Deinit();
+    CTextureAtlas::Clear();
     CMatrixEffectPointLight::ClearAll();
 
     if (m_Heap) {
@@ -415,8 +417,11 @@ void CMatrixEffect::InitEffects(CBlockPar &bp_in) {
 
             e->tex = (CTextureManaged *)g_Cache->Get(CacheClass::TextureManaged, texp.GetStrPar(1, L",").c_str());
             // e->tex->Preload();
+            CTextureAtlas::Add(e->tex);
         }
     }
+    // intense billboards and lines of the packed textures are drawn together
+    CTextureAtlas::Build();
 
     m_before_draw_done = 0;
 }
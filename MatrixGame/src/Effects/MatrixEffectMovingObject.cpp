@@ -42,9 +42,6 @@ CMatrixEffectMovingObject::CMatrixEffectMovingObject(const SMOProps &props, DWOR
         m_Props.common.bomb.pos = props.common.bomb.pos;
         m_Props.common.bomb.trajectory = props.common.bomb.trajectory;
     }
-    if (props.handler == MO_Gun_Takt || props.handler == MO_Gun_cannon_Takt) {
-        m_Props.common.gun.maxdist = props.common.gun.maxdist;
-    }
 
     if (m_Props.handler)
         m_Props.handler(m_Mat, m_Props, 0);
@@ -465,160 +462,6 @@ void MO_Bomb_Takt(D3DXMATRIX &m, SMOProps &props, float takt) {
     }
 }
 
-void MO_Gun_Takt(D3DXMATRIX &m, SMOProps &props, float takt) {
-    DTRACE();
-
-    float dtime = 0.1f * float(takt);
-
-    D3DXVECTOR3 to_tgt(props.target - props.curpos);
-
-    float vel = D3DXVec3Length(&props.velocity);
-    D3DXVECTOR3 dir(props.velocity * (1.0f / vel));
-
-    bool hit = false;
-
-    D3DXVECTOR3 newpos = props.curpos + props.velocity * dtime;
-
-    props.common.gun.dist += vel * dtime;
-
-    if ((newpos.z - g_MatrixMap->GetZ(newpos.x, newpos.y)) < (GUN_DAMAGE_RADIUS + 10)) {
-        hit = g_MatrixMap->FindObjects(newpos, GUN_DAMAGE_RADIUS, 1, props.hitmask, props.skip, MOEnum, (uintptr_t)&props);
-    }
-
-    D3DXVECTOR3 hitpos = newpos;
-    CMatrixMapStatic *hito = g_MatrixMap->Trace(&hitpos, props.curpos, newpos, props.hitmask, props.skip);
-    if (hito != TRACE_STOP_NONE) {
-        hit = true;
-    }
-
-    if (g_MatrixMap->m_Camera.IsInFrustum(newpos)) {
-        props.common.gun.in_frustum_count = 100;
-    }
-    else {
-        --props.common.gun.in_frustum_count;
-    }
-
-    if (props.common.gun.in_frustum_count > 0) {
-        CMatrixEffect::CreateBillboardLine(NULL, props.curpos, hitpos, 6, 0x8FFFFFFF, 0, 1000,
-                                           CMatrixEffect::GetBBTexI(BBT_SHLEIF));
-        // DM("cc", CStr(props.curpos.x)  + ","+CStr(props.curpos.y) + ","+ CStr(props.curpos.z) + ","+ CStr(hitpos.x) +
-        // ","+ CStr(hitpos.x) + ","+  CStr(hitpos.x));
-    }
-
-    props.curpos = hitpos;
-
-    VecToMatrixY(m, props.curpos, dir);
-
-    if (hit) {
-        // if (hito == TRACE_STOP_NONE && target != NULL) hito = target;
-        if (hito != TRACE_STOP_WATER) {
-            bool fire = false;
-            if (hito == TRACE_STOP_LANDSCAPE) {
-                CMatrixEffect::CreateLandscapeSpot(NULL, D3DXVECTOR2(hitpos.x, hitpos.y), FSRND(M_PI), FRND(3) + 6,
-                                                   SPOT_VORONKA);
-                hitpos.z = g_MatrixMap->GetZ(hitpos.x, hitpos.y) + 10;
-                fire = true;
-            }
-            CMatrixEffect::CreateExplosion(hitpos, ExplosionMissile, fire);
-        }
-
-        // impact
-        props.endoflife = true;
-        if (props.endhandler) {
-            auto tmp = hitpos - props.startpos;
-            CMatrixEffect::m_Dist2 = D3DXVec3LengthSq(&tmp);
-            props.endhandler(hito, hitpos, props.uservalue, FEHF_LASTHIT);
-            props.endhandler = NULL;
-        }
-    }
-    else if (props.common.gun.dist > props.common.gun.maxdist) {
-        props.endoflife = true;
-        if (props.endhandler) {
-            auto tmp = hitpos - props.startpos;
-            CMatrixEffect::m_Dist2 = D3DXVec3LengthSq(&tmp);
-            props.endhandler(TRACE_STOP_NONE, hitpos, props.uservalue, FEHF_LASTHIT);
-            props.endhandler = NULL;
-        }
-    }
-}
-
-void MO_Gun_cannon_Takt(D3DXMATRIX &m, SMOProps &props, float takt) {
-    DTRACE();
-
-    float dtime = 0.1f * float(takt);
-
-    D3DXVECTOR3 to_tgt(props.target - props.curpos);
-
-    float vel = D3DXVec3Length(&props.velocity);
-    D3DXVECTOR3 dir(props.velocity * (1.0f / vel));
-
-    bool hit = false;
-
-    D3DXVECTOR3 newpos = props.curpos + props.velocity * dtime;
-
-    props.common.gun.dist += vel * dtime;
-
-    if ((newpos.z - g_MatrixMap->GetZ(newpos.x, newpos.y)) < (GUN_DAMAGE_RADIUS + 10)) {
-        hit = g_MatrixMap->FindObjects(newpos, GUN_DAMAGE_RADIUS, 1, props.hitmask, props.skip, MOEnum, (uintptr_t)&props);
-    }
-
-    D3DXVECTOR3 hitpos = newpos;
-    CMatrixMapStatic *hito = g_MatrixMap->Trace(&hitpos, props.curpos, newpos, props.hitmask, props.skip);
-    if (hito != TRACE_STOP_NONE) {
-        hit = true;
-    }
-
-    if (g_MatrixMap->m_Camera.IsInFrustum(newpos)) {
-        props.common.gun.in_frustum_count = 100;
-    }
-    else {
-        --props.common.gun.in_frustum_count;
-    }
-
-    if (props.common.gun.in_frustum_count > 0) {
-        CMatrixEffect::CreateBillboardLine(NULL, props.curpos, hitpos, 4, 0x6FFFFFFF, 0, 500,
-                                           CMatrixEffect::GetBBTexI(BBT_SHLEIF));
-        // DM("cc", CStr(props.curpos.x)  + ","+CStr(props.curpos.y) + ","+ CStr(props.curpos.z) + ","+ CStr(hitpos.x) +
-        // ","+ CStr(hitpos.x) + ","+  CStr(hitpos.x));
-    }
-
-    props.curpos = hitpos;
-
-    VecToMatrixY(m, props.curpos, dir);
-
-    if (hit) {
-        // if (hito == TRACE_STOP_NONE && target != NULL) hito = target;
-        if (hito != TRACE_STOP_WATER) {
-            bool fire = false;
-            if (hito == TRACE_STOP_LANDSCAPE) {
-                CMatrixEffect::CreateLandscapeSpot(NULL, D3DXVECTOR2(hitpos.x, hitpos.y), FSRND(M_PI), FRND(3) + 6,
-                                                   SPOT_VORONKA);
-                hitpos.z = g_MatrixMap->GetZ(hitpos.x, hitpos.y) + 10;
-                fire = true;
-            }
-            CMatrixEffect::CreateExplosion(hitpos, ExplosionMissile, fire);
-        }
-
-        // impact
-        props.endoflife = true;
-        if (props.endhandler) {
-            auto tmp = hitpos - props.startpos;
-            CMatrixEffect::m_Dist2 = D3DXVec3LengthSq(&tmp);
-            props.endhandler(hito, hitpos, props.uservalue, FEHF_LASTHIT);
-            props.endhandler = NULL;
-        }
-    }
-    else if (props.common.gun.dist > props.common.gun.maxdist) {
-        props.endoflife = true;
-        if (props.endhandler) {
-            auto tmp = hitpos - props.startpos;
-            CMatrixEffect::m_Dist2 = D3DXVec3LengthSq(&tmp);
-            props.endhandler(TRACE_STOP_NONE, hitpos, props.uservalue, FEHF_LASTHIT);
-            props.endhandler = NULL;
-        }
-    }
-}
-
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -67,12 +67,6 @@ struct SMOProps {
             int in_frustum_count;
 
         } hm;
-        struct {
-            float maxdist;
-            float dist;
-            int in_frustum_count;
-
-        } gun;
         struct {
             float angle;
 
@@ -140,5 +134,3 @@ public:
 
 void MO_Homing_Missile_Takt(D3DXMATRIX &m, SMOProps &pops, float takt);
 void MO_Bomb_Takt(D3DXMATRIX &m, SMOProps &pops, float takt);
-void MO_Gun_Takt(D3DXMATRIX &m, SMOProps &pops, float takt);
-void MO_Gun_cannon_Takt(D3DXMATRIX &m, SMOProps &pops, float takt);
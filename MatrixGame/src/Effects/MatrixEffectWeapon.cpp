@@ -463,21 +463,9 @@ void CMatrixEffectWeapon::Fire(void) {
         case WEAPON_GUN:
         case WEAPON_CANNON1: {
             DCP();
-            SMOProps mo;
-            mo.common.gun.maxdist = m_WeaponDist * m_WeaponCoefficient;
-            mo.startpos = m_Pos;
-            mo.target = m_Speed;
-            mo.curpos = mo.startpos;
-
-            mo.side = m_SideStorage;
-            // mo.attacker = m_Owner;
-            // if (mo.attacker) mo.attacker->RefInc();
-
-            mo.velocity = m_Dir * 22;
-            mo.object = LoadObject(OBJECT_PATH_GUN, m_Heap);
-            mo.handler = MO_Gun_Takt;
             m_Ref++;
-            CMatrixEffect::CreateMovingObject(NULL, mo, TRACE_ALL, m_Skip, WeaponHit, (uintptr_t)this);
+            g_MatrixMap->m_Projectiles.AddShell(PROJECTILE_GUN, m_Pos, m_Dir * 22, m_WeaponDist * m_WeaponCoefficient, TRACE_ALL,
+                                                m_Skip, WeaponHit, (uintptr_t)this);
 
 #ifdef _DEBUG
             SEffectHandler eh(DEBUG_CALL_INFO);
@@ -653,21 +641,9 @@ void CMatrixEffectWeapon::Fire(void) {
 
         case WEAPON_CANNON0: {
             DCP();
-            SMOProps mo;
-            mo.common.gun.maxdist = m_WeaponDist * m_WeaponCoefficient;
-            mo.startpos = m_Pos;
-            mo.target = m_Speed;
-            mo.curpos = mo.startpos;
-
-            mo.side = m_SideStorage;
-            // mo.attacker = m_Owner;
-            // if (mo.attacker) mo.attacker->RefInc();
-
-            mo.velocity = m_Dir * 27;
-            mo.object = LoadObject(OBJECT_PATH_GUN, m_Heap);
-            mo.handler = MO_Gun_cannon_Takt;
             m_Ref++;
-            CMatrixEffect::CreateMovingObject(NULL, mo, TRACE_ALL, m_Skip, WeaponHit, (uintptr_t)this);
+            g_MatrixMap->m_Projectiles.AddShell(PROJECTILE_CANNON, m_Pos, m_Dir * 27, m_WeaponDist * m_WeaponCoefficient, TRACE_ALL,
+                                                m_Skip, WeaponHit, (uintptr_t)this);
 
 #ifdef _DEBUG
             SEffectHandler eh(DEBUG_CALL_INFO);
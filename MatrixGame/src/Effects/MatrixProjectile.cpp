@@ -0,0 +1,291 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "MatrixProjectile.hpp"
+#include "../MatrixMap.hpp"
+
+#include "MatrixEffectMovingObject.hpp"
+#include "MatrixEffectExplosion.hpp"
+
+void UnloadObject(CVectorObjectAnim *o, CHeap *heap);
+
+CMatrixProjectiles::CMatrixProjectiles(void) : CMain() {
+    m_Cnt = 0;
+    m_Max = 0;
+
+    m_Pos = NULL;
+    m_New = NULL;
+    m_Vel = NULL;
+    m_Dir = NULL;
+    m_Speed = NULL;
+    m_Dist = NULL;
+    m_MaxDist = NULL;
+    m_InFrustum = NULL;
+    m_Kind = NULL;
+    m_NearLand = NULL;
+    m_Owner = NULL;
+
+    m_Object = NULL;
+}
+
+CMatrixProjectiles::~CMatrixProjectiles() {
+    Clear();
+}
+
+void CMatrixProjectiles::Clear(void) {
+    DTRACE();
+
+    // owners are waiting for the last hit to release their weapons
+    for (int i = 0; i < m_Cnt; ++i) {
+        if (m_Kind[i] == PROJECTILE_DEAD || !m_Owner[i].m_Handler)
+            continue;
+        m_Kind[i] = PROJECTILE_DEAD;
+        auto tmp = m_Pos[i] - m_Owner[i].m_Start;
+        CMatrixEffect::m_Dist2 = D3DXVec3LengthSq(&tmp);
+        m_Owner[i].m_Handler(TRACE_STOP_NONE, m_Pos[i], m_Owner[i].m_User, FEHF_LASTHIT);
+    }
+
+    if (m_Pos) {
+        HFree(m_Pos, g_MatrixHeap);
+        HFree(m_New, g_MatrixHeap);
+        HFree(m_Vel, g_MatrixHeap);
+        HFree(m_Dir, g_MatrixHeap);
+        HFree(m_Speed, g_MatrixHeap);
+        HFree(m_Dist, g_MatrixHeap);
+        HFree(m_MaxDist, g_MatrixHeap);
+        HFree(m_InFrustum, g_MatrixHeap);
+        HFree(m_Kind, g_MatrixHeap);
+        HFree(m_NearLand, g_MatrixHeap);
+        HFree(m_Owner, g_MatrixHeap);
+    }
+    m_Pos = NULL;
+    m_New = NULL;
+    m_Vel = NULL;
+    m_Dir = NULL;
+    m_Speed = NULL;
+    m_Dist = NULL;
+    m_MaxDist = NULL;
+    m_InFrustum = NULL;
+    m_Kind = NULL;
+    m_NearLand = NULL;
+    m_Owner = NULL;
+    m_Cnt = 0;
+    m_Max = 0;
+
+    if (m_Object) {
+        UnloadObject(m_Object, CMatrixEffect::m_Heap);
+        m_Object = NULL;
+    }
+}
+
+void CMatrixProjectiles::Grow(void) {
+    m_Max = m_Max ? m_Max * 2 : 64;
+
+    m_Pos = (D3DXVECTOR3 *)HAllocEx(m_Pos, sizeof(D3DXVECTOR3) * m_Max, g_MatrixHeap);
+    m_New = (D3DXVECTOR3 *)HAllocEx(m_New, sizeof(D3DXVECTOR3) * m_Max, g_MatrixHeap);
+    m_Vel = (D3DXVECTOR3 *)HAllocEx(m_Vel, sizeof(D3DXVECTOR3) * m_Max, g_MatrixHeap);
+    m_Dir = (D3DXVECTOR3 *)HAllocEx(m_Dir, sizeof(D3DXVECTOR3) * m_Max, g_MatrixHeap);
+    m_Speed = (float *)HAllocEx(m_Speed, sizeof(float) * m_Max, g_MatrixHeap);
+    m_Dist = (float *)HAllocEx(m_Dist, sizeof(float) * m_Max, g_MatrixHeap);
+    m_MaxDist = (float *)HAllocEx(m_MaxDist, sizeof(float) * m_Max, g_MatrixHeap);
+    m_InFrustum = (int *)HAllocEx(m_InFrustum, sizeof(int) * m_Max, g_MatrixHeap);
+    m_Kind = (BYTE *)HAllocEx(m_Kind, sizeof(BYTE) * m_Max, g_MatrixHeap);
+    m_NearLand = (BYTE *)HAllocEx(m_NearLand, sizeof(BYTE) * m_Max, g_MatrixHeap);
+    m_Owner = (SProjectileOwner *)HAllocEx(m_Owner, sizeof(SProjectileOwner) * m_Max, g_MatrixHeap);
+}
+
+void CMatrixProjectiles::AddShell(EProjectileKind kind, const D3DXVECTOR3 &start, const D3DXVECTOR3 &velocity,
+                                  float maxdist, DWORD hitmask, CMatrixMapStatic *skip, FIRE_END_HANDLER handler,
+                                  uintptr_t user) {
+    DTRACE();
+
+    if (m_Cnt >= m_Max)
+        Grow();
+    if (!m_Object)
+        m_Object = LoadObject(OBJECT_PATH_GUN, CMatrixEffect::m_Heap);
+
+    int i = m_Cnt++;
+
+    m_Pos[i] = start;
+    m_New[i] = start;
+    m_Vel[i] = velocity;
+    m_Speed[i] = D3DXVec3Length(&velocity);
+    m_Dir[i] = velocity * (1.0f / m_Speed[i]);
+    m_Dist[i] = 0;
+    m_MaxDist[i] = maxdist;
+    m_InFrustum[i] = 0;
+    m_Kind[i] = kind;
+    m_NearLand[i] = (start.z - g_MatrixMap->GetZ(start.x, start.y)) < (GUN_DAMAGE_RADIUS + 10);
+
+    m_Owner[i].m_Handler = handler;
+    m_Owner[i].m_User = user;
+    m_Owner[i].m_HitMask = hitmask;
+    m_Owner[i].m_Skip = skip;
+    m_Owner[i].m_Start = start;
+
+    // zero length step, as the moving object effect did on creation: the shell may be fired right into something
+    Step(i);
+}
+
+static bool ProjectileEnum(const D3DXVECTOR3 &center, CMatrixMapStatic *ms, uintptr_t user) {
+    SProjectileOwner *owner = (SProjectileOwner *)user;
+    if (owner->m_Handler) {
+        auto tmp = center - owner->m_Start;
+        CMatrixEffect::m_Dist2 = D3DXVec3LengthSq(&tmp);
+        owner->m_Handler(ms, center, owner->m_User, 0);
+    }
+    return true;
+}
+
+void CMatrixProjectiles::Finish(int i, CMatrixMapStatic *hit, const D3DXVECTOR3 &pos) {
+    SProjectileOwner owner = m_Owner[i];
+    m_Kind[i] = PROJECTILE_DEAD;
+
+    if (owner.m_Handler) {
+        auto tmp = pos - owner.m_Start;
+        CMatrixEffect::m_Dist2 = D3DXVec3LengthSq(&tmp);
+        owner.m_Handler(hit, pos, owner.m_User, FEHF_LASTHIT);
+    }
+}
+
+bool CMatrixProjectiles::Step(int i) {
+    DTRACE();
+
+    // handlers may fire new projectiles, so nothing is kept by reference across the calls
+    SProjectileOwner owner = m_Owner[i];
+    D3DXVECTOR3 curpos = m_Pos[i];
+    D3DXVECTOR3 newpos = m_New[i];
+
+    bool hit = false;
+    if (m_NearLand[i]) {
+        hit = g_MatrixMap->FindObjects(newpos, GUN_DAMAGE_RADIUS, 1, owner.m_HitMask, owner.m_Skip, ProjectileEnum,
+                                       (uintptr_t)&owner);
+    }
+
+    D3DXVECTOR3 hitpos = newpos;
+    CMatrixMapStatic *hito = g_MatrixMap->Trace(&hitpos, curpos, newpos, owner.m_HitMask, owner.m_Skip);
+    if (hito != TRACE_STOP_NONE) {
+        hit = true;
+    }
+
+    if (g_MatrixMap->m_Camera.IsInFrustum(newpos)) {
+        m_InFrustum[i] = 100;
+    }
+    else {
+        --m_InFrustum[i];
+    }
+
+    if (m_InFrustum[i] > 0) {
+        if (m_Kind[i] == PROJECTILE_GUN) {
+            CMatrixEffect::CreateBillboardLine(NULL, curpos, hitpos, 6, 0x8FFFFFFF, 0, 1000,
+                                               CMatrixEffect::GetBBTexI(BBT_SHLEIF));
+        }
+        else {
+            CMatrixEffect::CreateBillboardLine(NULL, curpos, hitpos, 4, 0x6FFFFFFF, 0, 500,
+                                               CMatrixEffect::GetBBTexI(BBT_SHLEIF));
+        }
+    }
+
+    m_Pos[i] = hitpos;
+
+    if (hit) {
+        if (hito != TRACE_STOP_WATER) {
+            bool fire = false;
+            if (hito == TRACE_STOP_LANDSCAPE) {
+                CMatrixEffect::CreateLandscapeSpot(NULL, D3DXVECTOR2(hitpos.x, hitpos.y), FSRND(M_PI), FRND(3) + 6,
+                                                   SPOT_VORONKA);
+                hitpos.z = g_MatrixMap->GetZ(hitpos.x, hitpos.y) + 10;
+                fire = true;
+            }
+            CMatrixEffect::CreateExplosion(hitpos, ExplosionMissile, fire);
+        }
+
+        Finish(i, hito, hitpos);
+        return true;
+    }
+    if (m_Dist[i] > m_MaxDist[i]) {
+        Finish(i, TRACE_STOP_NONE, hitpos);
+        return true;
+    }
+    return false;
+}
+
+void CMatrixProjectiles::Takt(int step) {
+    DTRACE();
+
+    if (m_Cnt == 0)
+        return;
+
+    m_Object->Takt(step);
+
+    float dtime = 0.1f * float(step);
+    int n = m_Cnt;
+
+    // move them all at once, and find out which ones are low enough to splash onto the objects around
+    for (int i = 0; i < n; ++i) {
+        m_New[i] = m_Pos[i] + m_Vel[i] * dtime;
+        m_Dist[i] += m_Speed[i] * dtime;
+    }
+    for (int i = 0; i < n; ++i) {
+        m_NearLand[i] = (m_New[i].z - g_MatrixMap->GetZ(m_New[i].x, m_New[i].y)) < (GUN_DAMAGE_RADIUS + 10);
+    }
+
+    // hits are resolved in order: a hit may kill the object the next shell would hit
+    for (int i = 0; i < n; ++i) {
+        if (m_Kind[i] != PROJECTILE_DEAD)
+            Step(i);
+    }
+
+    // keep the order of the rest, the simulation must not depend on how shells were removed
+    int j = 0;
+    for (int i = 0; i < m_Cnt; ++i) {
+        if (m_Kind[i] == PROJECTILE_DEAD)
+            continue;
+        if (i != j) {
+            m_Pos[j] = m_Pos[i];
+            m_Vel[j] = m_Vel[i];
+            m_Dir[j] = m_Dir[i];
+            m_Speed[j] = m_Speed[i];
+            m_Dist[j] = m_Dist[i];
+            m_MaxDist[j] = m_MaxDist[i];
+            m_InFrustum[j] = m_InFrustum[i];
+            m_Kind[j] = m_Kind[i];
+            m_Owner[j] = m_Owner[i];
+        }
+        ++j;
+    }
+    m_Cnt = j;
+}
+
+void CMatrixProjectiles::BeforeDraw(void) {
+    if (m_Cnt > 0)
+        m_Object->BeforeDraw();
+}
+
+void CMatrixProjectiles::Draw(void) const {
+    DTRACE();
+
+    if (m_Cnt == 0)
+        return;
+
+    CVectorObject::DrawBegin();
+    g_D3DD->SetRenderState(D3DRS_TEXTUREFACTOR, 0xFFFFFFFF);
+    ASSERT_DX(g_D3DD->SetRenderState(D3DRS_AMBIENT, g_MatrixMap->m_AmbientColorObj));
+
+    ASSERT_DX(g_D3DD->SetRenderState(D3DRS_LIGHTING, TRUE));
+
+    D3DXMATRIX m;
+    for (int i = 0; i < m_Cnt; ++i) {
+        if (m_Kind[i] == PROJECTILE_DEAD || !g_MatrixMap->m_Camera.IsInFrustum(m_Pos[i]))
+            continue;
+
+        VecToMatrixY(m, m_Pos[i], m_Dir[i]);
+        ASSERT_DX(g_D3DD->SetTransform(D3DTS_WORLD, &m));
+        m_Object->Draw(0);
+    }
+
+    ASSERT_DX(g_D3DD->SetRenderState(D3DRS_LIGHTING, FALSE));
+    CVectorObject::DrawEnd();
+}
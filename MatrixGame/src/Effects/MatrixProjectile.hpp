@@ -0,0 +1,69 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "MatrixEffect.hpp"
+
+enum EProjectileKind : BYTE {
+    PROJECTILE_GUN,     // gun and cannon1 shells
+    PROJECTILE_CANNON,  // cannon0 shells
+
+    PROJECTILE_DEAD = 0xFF  // finished, removed at the end of the takt
+};
+
+// rarely used data of a projectile: only touched on hit
+struct SProjectileOwner {
+    FIRE_END_HANDLER m_Handler;
+    uintptr_t m_User;
+    DWORD m_HitMask;
+    CMatrixMapStatic *m_Skip;
+    D3DXVECTOR3 m_Start;
+};
+
+/**
+ * @brief Gameplay projectiles (gun shells) stepped together by the logic takt.
+ *
+ * Shells used to be a CMatrixEffectMovingObject each, with its own copy of the shell model, and were dropped when
+ * the effect list was full. Here they live in parallel arrays: the whole set is moved and checked against the
+ * landscape in one pass, then traced one by one. Effects are created only for the trails and on hit.
+ */
+class CMatrixProjectiles : public Base::CMain {
+    int m_Cnt;
+    int m_Max;
+
+    D3DXVECTOR3 *m_Pos;
+    D3DXVECTOR3 *m_New;  // position at the end of the current takt
+    D3DXVECTOR3 *m_Vel;
+    D3DXVECTOR3 *m_Dir;
+    float *m_Speed;
+    float *m_Dist;
+    float *m_MaxDist;
+    int *m_InFrustum;
+    BYTE *m_Kind;
+    BYTE *m_NearLand;
+    SProjectileOwner *m_Owner;
+
+    CVectorObjectAnim *m_Object;  // shell model shared by all the projectiles
+
+    void Grow(void);
+    bool Step(int i);
+    void Finish(int i, CMatrixMapStatic *hit, const D3DXVECTOR3 &pos);
+
+public:
+    CMatrixProjectiles(void);
+    ~CMatrixProjectiles();
+
+    void Clear(void);
+
+    void AddShell(EProjectileKind kind, const D3DXVECTOR3 &start, const D3DXVECTOR3 &velocity, float maxdist,
+                  DWORD hitmask, CMatrixMapStatic *skip, FIRE_END_HANDLER handler, uintptr_t user);
+
+    void Takt(int step);
+    void BeforeDraw(void);
+    void Draw(void) const;
+
+    int GetCount(void) const { return m_Cnt; }
+};
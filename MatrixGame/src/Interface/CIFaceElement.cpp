@@ -152,9 +152,7 @@ void CIFaceElement::BeforeRender(void) {
     }
 }
 
-void CIFaceElement::Render(BYTE alpha) {
-    // CMatrixSideUnit *player_side = g_MatrixMap->GetControllableSide();
-
+void CIFaceElement::BeginRender(void) {
     g_Sampler.SetState(0, D3DSAMP_MAGFILTER, D3DTEXF_POINT);
     g_Sampler.SetState(0, D3DSAMP_MINFILTER, D3DTEXF_POINT);
     g_Sampler.SetState(0, D3DSAMP_MIPFILTER, D3DTEXF_NONE);
@@ -169,9 +167,29 @@ void CIFaceElement::Render(BYTE alpha) {
     SetAlphaOpAnyOrder(0, D3DTOP_MODULATE, D3DTA_TEXTURE, D3DTA_TFACTOR);
     SetColorOpDisable(1);
 
-    g_D3DD->SetRenderState(D3DRS_TEXTUREFACTOR, ((DWORD)alpha << 24));
+    g_D3DD->SetRenderState(D3DRS_MULTISAMPLEANTIALIAS, FALSE);
 
     CInstDraw::BeginDraw(IDFVF_V4_UV);
+}
+
+void CIFaceElement::EndRender(void) {
+    CInstDraw::ActualDraw();
+
+    g_D3DD->SetRenderState(D3DRS_MULTISAMPLEANTIALIAS, TRUE);
+
+    g_D3DD->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
+
+    g_D3DD->SetRenderState(D3DRS_ZENABLE, D3DZB_TRUE);
+    g_D3DD->SetRenderState(D3DRS_ZWRITEENABLE, TRUE);
+
+    g_D3DD->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
+    g_D3DD->SetRenderState(D3DRS_ALPHAREF, 0x08);
+}
+
+void CIFaceElement::Render(BYTE alpha) {
+    // CMatrixSideUnit *player_side = g_MatrixMap->GetControllableSide();
+
+    DWORD tf = (DWORD)alpha << 24;
 
     if (m_nId == IF_CALLHELL_ID && GetState() == IFACE_DISABLED) {
         m_StateImages[GetState()].pImage->Prepare();
@@ -203,9 +221,9 @@ void CIFaceElement::Render(BYTE alpha) {
             geom[i].tu += d;
         }
 
-        CInstDraw::AddVerts(geom, m_StateImages[GetState()].pImage);
+        CInstDraw::AddVertsOrdered(geom, m_StateImages[GetState()].pImage, tf);
 
-        CInstDraw::AddVerts(geom + 4, m_StateImages[GetState()].pImage);
+        CInstDraw::AddVertsOrdered(geom + 4, m_StateImages[GetState()].pImage, tf);
     }
     else {
 #if defined _TRACE || defined _DEBUG
@@ -226,36 +244,27 @@ void CIFaceElement::Render(BYTE alpha) {
         }
 #endif
 
-        CInstDraw::AddVerts(m_StateImages[GetState()].m_Geom, m_StateImages[GetState()].pImage);
+        CInstDraw::AddVertsOrdered(m_StateImages[GetState()].m_Geom, m_StateImages[GetState()].pImage, tf);
 
         if (m_Animation) {
             m_Animation->GetCurrentFrame()->m_StateImages[IFACE_NORMAL].pImage->Prepare();
-            CInstDraw::AddVerts(m_Animation->GetCurrentFrame()->m_StateImages[IFACE_NORMAL].m_Geom,
-                                m_Animation->GetCurrentFrame()->m_StateImages[IFACE_NORMAL].pImage);
+            CInstDraw::AddVertsOrdered(m_Animation->GetCurrentFrame()->m_StateImages[IFACE_NORMAL].m_Geom,
+                                       m_Animation->GetCurrentFrame()->m_StateImages[IFACE_NORMAL].pImage, tf);
         }
     }
 
-    g_D3DD->SetRenderState(D3DRS_MULTISAMPLEANTIALIAS, FALSE);
-    CInstDraw::ActualDraw();
-    g_D3DD->SetRenderState(D3DRS_MULTISAMPLEANTIALIAS, TRUE);
-
-    g_D3DD->SetRenderState(D3DRS_ALPHABLENDENABLE, FALSE);
-
-    g_D3DD->SetRenderState(D3DRS_ZENABLE, D3DZB_TRUE);
-    g_D3DD->SetRenderState(D3DRS_ZWRITEENABLE, TRUE);
-
-    g_D3DD->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
-    g_D3DD->SetRenderState(D3DRS_ALPHAREF, 0x08);
-
+    // the minimap is drawn over its panel right now: the batch up to the panel goes first
     if (m_iParam == IF_MAP_PANELI) {
+        EndRender();
         g_MatrixMap->m_Minimap.Draw();
+        BeginRender();
     }
     else if (m_iParam == IF_RADAR_PNI) {
+        EndRender();
         g_MatrixMap->m_Minimap.DrawRadar(float(g_IFaceList->m_IFRadarPosX + 90), float(g_IFaceList->m_IFRadarPosY + 93),
                                          RADAR_RADIUS);  // 90,92
+        BeginRender();
     }
-
-    return;
 }
 
 bool CIFaceElement::ElementCatch(CPoint mouse) {
@@ -93,6 +93,9 @@ public:
     virtual bool OnMouseLBDown() { return false; }
     virtual bool OnMouseRBDown() { return false; }
     virtual void BeforeRender(void);
+    // elements are drawn in batches: BeginRender, Render of every element, EndRender
+    static void BeginRender(void);
+    static void EndRender(void);
     virtual void Render(BYTE m_VisibleAlpha);
     virtual void Reset();
     void LogicTakt(int ms);
@@ -1002,18 +1002,23 @@ void CInterface::Render() {
     if (m_VisibleAlpha == IS_VISIBLEA || m_AlwaysOnTop) {
         CIFaceElement *pObjectsList = m_FirstElement;
 
+        // one batch for the interface, split only where something else is drawn in between
+        CIFaceElement::BeginRender();
         while (pObjectsList != NULL) {
             if (pObjectsList->GetVisibility()) {
                 pObjectsList->Render(pObjectsList->m_VisibleAlpha);
                 if (pObjectsList->m_strName == IF_BASE_CONSTRUCTION_RIGHT) {
                     if (g_MatrixMap->GetControllableSide()->m_CurrSel == BASE_SELECTED &&
                         g_MatrixMap->GetControllableSide()->m_ConstructPanel->IsActive()) {
+                        CIFaceElement::EndRender();
                         g_MatrixMap->GetControllableSide()->m_Constructor->Render();
+                        CIFaceElement::BeginRender();
                     }
                 }
             }
             pObjectsList = pObjectsList->m_NextElement;
         }
+        CIFaceElement::EndRender();
     }
 }
 
@@ -5026,7 +5031,8 @@ bool CIFaceList::CorrectCoordinates(int screen_width, int screen_height, int &po
 }
 
 void CIFaceList::AddHintReplacements(const std::wstring &element_name) {
-    CBlockPar *repl = g_MatrixData->BlockGet(PAR_REPLACE);
+    static const SBlockParKey key_replace = CBlockPar::Key(PAR_REPLACE);
+    CBlockPar *repl = g_MatrixData->BlockGet(key_replace);
     CMatrixSideUnit *ps = g_MatrixMap->GetControllableSide();
 
     if (element_name == L"thz") {
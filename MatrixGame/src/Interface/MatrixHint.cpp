@@ -504,8 +504,10 @@ static void Replace(std::wstring &text, const wchar *baserepl, CBlockPar *repl)
 CMatrixHint *CMatrixHint::Build(const std::wstring &templatename, const wchar *baserepl) {
     DTRACE();
 
-    CBlockPar *repl = g_MatrixData->BlockGet(PAR_REPLACE);
-    CBlockPar *bp = g_MatrixData->BlockGet(PAR_TEMPLATES);
+    static const SBlockParKey key_replace = CBlockPar::Key(PAR_REPLACE);
+    static const SBlockParKey key_templates = CBlockPar::Key(PAR_TEMPLATES);
+    CBlockPar *repl = g_MatrixData->BlockGet(key_replace);
+    CBlockPar *bp = g_MatrixData->BlockGet(key_templates);
     std::wstring str;
 
     DCP();
@@ -9,17 +9,11 @@
 #include "../MatrixRobot.hpp"
 #include "../MatrixObjectCannon.hpp"
 
-CEnemy::CEnemy() {
-    m_Enemy = NULL;
-    m_EnemyKind = ENEMY_UNDEF;
-    m_PrevEnemy = NULL;
-    m_NextEnemy = NULL;
-    m_DelSlowly = 0;
+CMatrixMapStatic *SEnemy::GetEnemy(void) const {
+    return g_MatrixMap->m_Handles.Resolve(m_Slot, m_NID);
 }
 
-CEnemy::~CEnemy() {}
-
-void CEnemy::ClassifyEnemy([[maybe_unused]] CMatrixMapStatic *relTo) {
+void SEnemy::ClassifyEnemy([[maybe_unused]] CMatrixMapStatic *relTo) {
     m_EnemyKind = ENEMY_ANY;
 }
 
@@ -27,8 +21,9 @@ void CEnemy::ClassifyEnemy([[maybe_unused]] CMatrixMapStatic *relTo) {
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 CInfo::CInfo() {
     m_EnemyCnt = 0;
-    m_FirstEnemy = NULL;
-    m_LastEnemy = NULL;
+    m_EnemyMax = ENEMY_LIST_INLINE;
+    m_Enemy = m_EnemyInline;
+    m_EnemyCheck = 0;
     m_EnemyKind = 0;
     m_Target = NULL;
     m_TargetAttack = NULL;
@@ -57,15 +52,74 @@ CInfo::~CInfo() {
 
 void CInfo::Clear(void) {
     DTRACE();
-    CEnemy *enemies = m_FirstEnemy;
+    m_EnemyCnt = 0;
+    if (m_Enemy != m_EnemyInline) {
+        HFree(m_Enemy, g_MatrixHeap);
+        m_Enemy = m_EnemyInline;
+        m_EnemyMax = ENEMY_LIST_INLINE;
+    }
+}
+
+int CInfo::FindEnemy(u32 nid) const {
+    for (int i = 0; i < m_EnemyCnt; i++) {
+        if (m_Enemy[i].m_NID == nid)
+            return i;
+    }
+    return -1;
+}
+
+void CInfo::DelEnemy(int idx) {
+    m_EnemyCnt--;
+    memmove(m_Enemy + idx, m_Enemy + idx + 1, (m_EnemyCnt - idx) * sizeof(SEnemy));
+}
 
-    while (enemies) {
-        CEnemy *next = enemies->m_NextEnemy;
-        HDelete(CEnemy, enemies, g_MatrixHeap);
-        enemies = next;
+// Drops the enemies which have died since the last check. Cheap if nobody has died.
+void CInfo::Validate(void) {
+    DWORD check = g_MatrixMap->m_Handles.GetReleaseCnt();
+    if (m_EnemyCheck == check)
+        return;
+    m_EnemyCheck = check;
+
+    int cnt = 0;
+    for (int i = 0; i < m_EnemyCnt; i++) {
+        if (m_Enemy[i].GetEnemy() == NULL)
+            continue;
+        if (cnt != i)
+            m_Enemy[cnt] = m_Enemy[i];
+        cnt++;
     }
-    m_FirstEnemy = NULL;
-    m_LastEnemy = NULL;
+    m_EnemyCnt = cnt;
+}
+
+SEnemy *CInfo::InsEnemy(CMatrixMapStatic *ms) {
+    Validate();
+
+    int idx = FindEnemy(ms->m_NID);
+    if (idx >= 0)
+        return m_Enemy + idx;
+
+    int slot = ms->GetHandleSlot();
+    if (slot < 0 || slot > 0xFFFF)
+        ERROR_S(L"Too many objects referenced by the enemy lists");
+
+    // the list is not limited: it only leaves CInfo when it grows out of the inline entries
+    if (m_EnemyCnt >= m_EnemyMax) {
+        m_EnemyMax *= 2;
+        if (m_Enemy == m_EnemyInline) {
+            m_Enemy = (SEnemy *)HAlloc(m_EnemyMax * sizeof(SEnemy), g_MatrixHeap);
+            memcpy(m_Enemy, m_EnemyInline, m_EnemyCnt * sizeof(SEnemy));
+        }
+        else {
+            m_Enemy = (SEnemy *)HAllocEx(m_Enemy, m_EnemyMax * sizeof(SEnemy), g_MatrixHeap);
+        }
+    }
+
+    SEnemy *enemy = m_Enemy + m_EnemyCnt++;
+    enemy->m_NID = ms->m_NID;
+    enemy->m_Slot = (u16)slot;
+    enemy->m_EnemyKind = ENEMY_UNDEF;
+    enemy->ClassifyEnemy(ms);
+    return enemy;
 }
 
 void CInfo::RemoveAllBuilding(CMatrixMapStatic *skip) {
@@ -74,102 +128,68 @@ void CInfo::RemoveAllBuilding(CMatrixMapStatic *skip) {
     if (m_TargetAttack != skip && m_TargetAttack && m_TargetAttack->GetObjectType() == OBJECT_TYPE_BUILDING)
         m_TargetAttack = NULL;
 
-    CEnemy *enemie = m_FirstEnemy;
-    while (enemie) {
-        CEnemy *e2 = enemie;
-        enemie = enemie->m_NextEnemy;
-        if (e2->GetEnemy() != skip && e2->GetEnemy()->GetObjectType() == OBJECT_TYPE_BUILDING) {
-            LIST_DEL(e2, m_FirstEnemy, m_LastEnemy, m_PrevEnemy, m_NextEnemy);
-            HDelete(CEnemy, e2, g_MatrixHeap);
-            m_EnemyCnt--;
-        }
+    Validate();
+    for (int i = m_EnemyCnt - 1; i >= 0; i--) {
+        CMatrixMapStatic *e = m_Enemy[i].GetEnemy();
+        if (e != skip && e->GetObjectType() == OBJECT_TYPE_BUILDING)
+            DelEnemy(i);
     }
 }
 
 void CInfo::RemoveAllSlowely() {
-    CEnemy *enemie = m_FirstEnemy;
-    while (enemie) {
-        CEnemy *e2 = enemie;
-        enemie = enemie->m_NextEnemy;
-        if (e2->m_DelSlowly) {
-            if (e2->GetEnemy() == m_Target)
-                m_Target = NULL;
-            if (e2->GetEnemy() == m_TargetAttack)
-                m_TargetAttack = NULL;
-
-            LIST_DEL(e2, m_FirstEnemy, m_LastEnemy, m_PrevEnemy, m_NextEnemy);
-            HDelete(CEnemy, e2, g_MatrixHeap);
-            m_EnemyCnt--;
+    Validate();
+    for (int i = m_EnemyCnt - 1; i >= 0; i--) {
+        if (m_Enemy[i].m_DelSlowly) {
+            RemoveTarget(m_Enemy[i].GetEnemy());
+            DelEnemy(i);
         }
     }
 }
 
-void CInfo::RemoveFromList(CMatrixMapStatic *ms) {
+void CInfo::RemoveTarget(CMatrixMapStatic *ms) {
     if (m_Target == ms)
         m_Target = NULL;
     if (m_TargetAttack == ms)
         m_TargetAttack = NULL;
+}
 
-    CEnemy *enemy = SearchEnemy(ms);
+void CInfo::RemoveFromList(CMatrixMapStatic *ms) {
+    RemoveTarget(ms);
+
+    SEnemy *enemy = SearchEnemy(ms);
     if (!enemy)
         return;
 
     RemoveFromList(enemy);
 }
 
-void CInfo::RemoveFromList(CEnemy *enemy) {
-    LIST_DEL(enemy, m_FirstEnemy, m_LastEnemy, m_PrevEnemy, m_NextEnemy);
-    HDelete(CEnemy, enemy, g_MatrixHeap);
-    m_EnemyCnt--;
+void CInfo::RemoveFromList(SEnemy *enemy) {
+    DelEnemy(enemy - m_Enemy);
 }
 
 void CInfo::RemoveFromListSlowly(CMatrixMapStatic *ms) {
-    CEnemy *enemy = SearchEnemy(ms);
+    SEnemy *enemy = SearchEnemy(ms);
     if (!enemy) {
-        if (m_Target == ms)
-            m_Target = NULL;
-        if (m_TargetAttack == ms)
-            m_TargetAttack = NULL;
+        RemoveTarget(ms);
         return;
     }
 
     enemy->m_DelSlowly++;
     if (enemy->m_DelSlowly >= 3) {
-        if (m_Target == ms)
-            m_Target = NULL;
-        if (m_TargetAttack == ms)
-            m_TargetAttack = NULL;
-
-        LIST_DEL(enemy, m_FirstEnemy, m_LastEnemy, m_PrevEnemy, m_NextEnemy);
-        HDelete(CEnemy, enemy, g_MatrixHeap);
-        m_EnemyCnt--;
+        RemoveTarget(ms);
+        RemoveFromList(enemy);
     }
 }
 
 void CInfo::AddToList(CMatrixMapStatic *ms) {
     DelIgnore(ms);
 
-    CEnemy *enemy = HNew(g_MatrixHeap) CEnemy;
-    enemy->SetEnemy(ms);
-    enemy->ClassifyEnemy(ms);
-    LIST_ADD(enemy, m_FirstEnemy, m_LastEnemy, m_PrevEnemy, m_NextEnemy);
-    m_EnemyCnt++;
+    SEnemy *enemy = InsEnemy(ms);
+    enemy->m_DelSlowly = 0;
 }
 
 void CInfo::AddToListSlowly(CMatrixMapStatic *ms) {
-    DelIgnore(ms);
-
-    CEnemy *enemy = SearchEnemy(ms);
-    if (enemy) {
-        enemy->m_DelSlowly = 0;
-        return;
-    }
-
-    enemy = HNew(g_MatrixHeap) CEnemy;
-    enemy->SetEnemy(ms);
-    enemy->ClassifyEnemy(ms);
-    LIST_ADD(enemy, m_FirstEnemy, m_LastEnemy, m_PrevEnemy, m_NextEnemy);
-    m_EnemyCnt++;
+    AddToList(ms);
 }
 
 void CInfo::Reset() {
@@ -178,25 +198,23 @@ void CInfo::Reset() {
     m_TargetAttack = NULL;
 }
 
-CEnemy *CInfo::SearchEnemy(CMatrixMapStatic *ms) {
-    CEnemy *enemie = m_FirstEnemy;
-    while (enemie) {
-        if (enemie->GetEnemy() == ms)
-            return enemie;
-        enemie = enemie->m_NextEnemy;
-    }
-    return NULL;
+SEnemy *CInfo::SearchEnemy(CMatrixMapStatic *ms) {
+    if (!ms)
+        return NULL;
+
+    Validate();
+    int idx = FindEnemy(ms->m_NID);
+    return idx >= 0 ? m_Enemy + idx : NULL;
 }
 
 CMatrixMapStatic *CInfo::GetEnemyByKind(uint32_t kind) {
-    CEnemy *enemies = m_FirstEnemy;
-    while (enemies) {
-        if (enemies->GetKind() == kind)
-            return enemies->GetEnemy();
-        enemies = enemies->m_NextEnemy;
+    for (SEnemy *enemy = FirstEnemy(); enemy; enemy = NextEnemy(enemy)) {
+        if (enemy->GetKind() == kind)
+            return enemy->GetEnemy();
     }
     return NULL;
 }
+
 void CInfo::AddBadPlace(int place) {
     if (IsBadPlace(place))
         return;
@@ -244,34 +262,34 @@ bool CInfo::IsBadCoord(const CPoint &coord) {
 void CInfo::AddIgnore(CMatrixMapStatic *ms) {
     int empty = -1;
     for (int i = 0; i < m_IgnoreCnt; i++) {
-        if (m_Ignore[i] == ms) {
+        if (m_Ignore[i] == ms->m_NID) {
             m_IgnoreTime[i] = g_MatrixMap->GetTime();
             return;
         }
-        else if (empty < 0 && (m_Ignore[i] == NULL || (g_MatrixMap->GetTime() - m_IgnoreTime[i]) >= 5000)) {
+        else if (empty < 0 && (m_Ignore[i] == NID_NONE || (g_MatrixMap->GetTime() - m_IgnoreTime[i]) >= 5000)) {
             empty = i;
         }
     }
 
     if (empty >= 0) {
-        m_Ignore[empty] = ms;
+        m_Ignore[empty] = ms->m_NID;
         m_IgnoreTime[empty] = g_MatrixMap->GetTime();
     }
-    else if (m_IgnoreCnt < 16) {
-        m_Ignore[m_IgnoreCnt] = ms;
+    else if (m_IgnoreCnt < IGNORE_LIST_MAX) {
+        m_Ignore[m_IgnoreCnt] = ms->m_NID;
         m_IgnoreTime[m_IgnoreCnt] = g_MatrixMap->GetTime();
         m_IgnoreCnt++;
     }
     else {
-        CopyMemory(m_Ignore, m_Ignore + 1, (16 - 1) * sizeof(CMatrixMapStatic *));
-        CopyMemory(m_IgnoreTime, m_IgnoreTime + 1, (16 - 1) * sizeof(int));
-        m_Ignore[m_IgnoreCnt - 1] = ms;
+        CopyMemory(m_Ignore, m_Ignore + 1, (IGNORE_LIST_MAX - 1) * sizeof(u32));
+        CopyMemory(m_IgnoreTime, m_IgnoreTime + 1, (IGNORE_LIST_MAX - 1) * sizeof(int));
+        m_Ignore[m_IgnoreCnt - 1] = ms->m_NID;
     }
 }
 
 bool CInfo::IsIgnore(CMatrixMapStatic *ms) {
     for (int i = 0; i < m_IgnoreCnt; i++) {
-        if (m_Ignore[i] == ms && (g_MatrixMap->GetTime() - m_IgnoreTime[i]) < 5000) {
+        if (m_Ignore[i] == ms->m_NID && (g_MatrixMap->GetTime() - m_IgnoreTime[i]) < 5000) {
             return true;
         }
     }
@@ -280,8 +298,8 @@ bool CInfo::IsIgnore(CMatrixMapStatic *ms) {
 
 void CInfo::DelIgnore(CMatrixMapStatic *ms) {
     for (int i = 0; i < m_IgnoreCnt; i++) {
-        if (m_Ignore[i] == ms) {
-            m_Ignore[i] = NULL;
+        if (m_Ignore[i] == ms->m_NID) {
+            m_Ignore[i] = NID_NONE;
         }
     }
 }
@@ -6,38 +6,34 @@
 #pragma once
 
 #include "CMain.hpp"
+#include "Types.hpp"
 
 #include <cstdint>
 
 class CMatrixRobotAI;
 class CMatrixMapStatic;
 
+#define ENEMY_LIST_INLINE 32  // enemies kept right in CInfo, a longer list moves to the heap
+#define IGNORE_LIST_MAX   16
+
 /**
  * @brief Represents an enemy be it a robot or a turret or a building some robot may be interested in attacking.
  *
- * Corresponds to a CMatrixMapStatic object.
+ * Corresponds to a CMatrixMapStatic object, which is referenced weakly by (handle slot, NID) pair, see
+ * CMatrixHandleTable. Lives inline in CInfo, so keep it small.
  *
  * Used by all sides.
  */
-class CEnemy : public CMain {
-public:
-    uint32_t m_EnemyKind;
-    CMatrixMapStatic *m_Enemy;
-
-    CEnemy *m_NextEnemy;
-    CEnemy *m_PrevEnemy;
-
-    int m_DelSlowly;
-
-public:
-    CEnemy();
-    ~CEnemy();
+struct SEnemy {
+    u32 m_NID;
+    u16 m_Slot;
+    BYTE m_EnemyKind;
+    BYTE m_DelSlowly;
 
-    void SetEnemy(CMatrixMapStatic *ms) { m_Enemy = ms; }
-    CMatrixMapStatic *GetEnemy() { return m_Enemy; }
+    CMatrixMapStatic *GetEnemy(void) const;
 
     void SetKind(uint32_t kind) { m_EnemyKind |= kind; }
-    uint32_t GetKind() { return m_EnemyKind; }
+    uint32_t GetKind(void) const { return m_EnemyKind; }
 
     void ClassifyEnemy(CMatrixMapStatic *relTo);
 };
@@ -49,8 +45,6 @@ public:
  */
 class CInfo : public CMain {
 public:
-    int m_EnemyCnt;
-
     uint32_t m_EnemyKind;
     CMatrixMapStatic *m_Target;
     CMatrixMapStatic *m_TargetAttack;
@@ -74,16 +68,27 @@ public:
     int m_BadCoordCnt;
     CPoint m_BadCoord[16];  // Список плохих координат, когда робот пропускает другого то эти координаты пропускаются
 
-    int m_IgnoreCnt;  // Список целей, на которые не обращаем внимания
-    CMatrixMapStatic *m_Ignore[16];
-    int m_IgnoreTime[16];
+    int m_IgnoreCnt;  // Список целей (NID), на которые не обращаем внимания
+    u32 m_Ignore[IGNORE_LIST_MAX];
+    int m_IgnoreTime[IGNORE_LIST_MAX];
+
+private:
+    int m_EnemyCnt;
+    int m_EnemyMax;
+    DWORD m_EnemyCheck;  // CMatrixHandleTable::GetReleaseCnt() of the last validation
+    SEnemy *m_Enemy;     // in the order of adding: m_EnemyInline or the heap
+    SEnemy m_EnemyInline[ENEMY_LIST_INLINE];
 
-    CEnemy *m_FirstEnemy;
-    CEnemy *m_LastEnemy;
+    int FindEnemy(u32 nid) const;  // -1 if not in the list
+    void DelEnemy(int idx);
+    SEnemy *InsEnemy(CMatrixMapStatic *ms);
+    void Validate(void);
 
 public:
     CInfo();
     ~CInfo();
+    CInfo(const CInfo &) = delete;
+    CInfo &operator=(const CInfo &) = delete;
 
     void Clear(void);
 
@@ -99,14 +104,25 @@ public:
     void RemoveAllBuilding(CMatrixMapStatic *skip = nullptr);
     void RemoveAllSlowely(void);
 
+    void RemoveTarget(CMatrixMapStatic *ms);
     void RemoveFromList(CMatrixMapStatic *ms);
-    void RemoveFromList(CEnemy *enemy);
+    void RemoveFromList(SEnemy *enemy);
     void RemoveFromListSlowly(CMatrixMapStatic *ms);
     void AddToList(CMatrixMapStatic *ms);
     void AddToListSlowly(CMatrixMapStatic *ms);
-    CEnemy *SearchEnemy(CMatrixMapStatic *ms);
+    SEnemy *SearchEnemy(CMatrixMapStatic *ms);
     CMatrixMapStatic *GetEnemyByKind(uint32_t kind);
-    int GetEnemyCnt() { return m_EnemyCnt; }
+    int GetEnemyCnt() {
+        Validate();
+        return m_EnemyCnt;
+    }
+
+    // Iteration: for (SEnemy *e = FirstEnemy(); e; e = NextEnemy(e)). Do not add or remove enemies meanwhile.
+    SEnemy *FirstEnemy(void) {
+        Validate();
+        return m_EnemyCnt ? m_Enemy : NULL;
+    }
+    SEnemy *NextEnemy(SEnemy *enemy) { return (++enemy < m_Enemy + m_EnemyCnt) ? enemy : NULL; }
     void KillEnemyByKind(uint32_t kind) { m_EnemyKind = kind; }
 
     void AddBadPlace(int place);
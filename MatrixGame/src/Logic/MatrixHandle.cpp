@@ -0,0 +1,62 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "MatrixHandle.hpp"
+#include "../MatrixMap.hpp"
+
+CMatrixHandleTable::CMatrixHandleTable(void) : CMain() {
+    m_Slot = NULL;
+    m_SlotCnt = 0;
+    m_SlotMax = 0;
+    m_FirstFree = -1;
+    m_ReleaseCnt = 0;
+}
+
+CMatrixHandleTable::~CMatrixHandleTable() {
+    Clear();
+}
+
+void CMatrixHandleTable::Clear(void) {
+    if (m_Slot) {
+        HFree(m_Slot, g_MatrixHeap);
+        m_Slot = NULL;
+    }
+    m_SlotCnt = 0;
+    m_SlotMax = 0;
+    m_FirstFree = -1;
+    m_ReleaseCnt++;
+}
+
+int CMatrixHandleTable::Alloc(CMatrixMapStatic *obj, u32 nid) {
+    int slot;
+    if (m_FirstFree >= 0) {
+        slot = m_FirstFree;
+        m_FirstFree = m_Slot[slot].m_NextFree;
+    }
+    else {
+        if (m_SlotCnt >= m_SlotMax) {
+            m_SlotMax = m_SlotMax ? m_SlotMax * 2 : 256;
+            m_Slot = (SSlot *)HAllocEx(m_Slot, sizeof(SSlot) * m_SlotMax, g_MatrixHeap);
+        }
+        slot = m_SlotCnt++;
+    }
+
+    m_Slot[slot].m_Object = obj;
+    m_Slot[slot].m_NID = nid;
+    m_Slot[slot].m_NextFree = -1;
+    return slot;
+}
+
+void CMatrixHandleTable::Release(int slot, u32 nid) {
+    // slot may be already gone together with the table (see Clear)
+    if (slot < 0 || slot >= m_SlotCnt || m_Slot[slot].m_NID != nid)
+        return;
+
+    m_Slot[slot].m_Object = NULL;
+    m_Slot[slot].m_NID = NID_NONE;
+    m_Slot[slot].m_NextFree = m_FirstFree;
+    m_FirstFree = slot;
+    m_ReleaseCnt++;
+}
@@ -0,0 +1,49 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "CMain.hpp"
+#include "Types.hpp"
+
+class CMatrixMapStatic;
+
+#define NID_NONE 0xFFFFFFFF  // NID of nobody
+
+/**
+ * @brief Weak references to map objects: (slot, NID) pairs.
+ *
+ * NID of an object is never reused, so it serves as the generation of the slot: a reference stays valid only while
+ * the slot holds the same NID. Dead objects are dropped by the holders of references lazily instead of sweeping over
+ * everybody who could remember them.
+ */
+class CMatrixHandleTable : public Base::CMain {
+    struct SSlot {
+        CMatrixMapStatic *m_Object;
+        u32 m_NID;  // NID_NONE - slot is free
+        int m_NextFree;
+    };
+
+    SSlot *m_Slot;
+    int m_SlotCnt;
+    int m_SlotMax;
+    int m_FirstFree;
+    DWORD m_ReleaseCnt;  // changes every time an object dies, lets the holders skip validation when nothing died
+
+public:
+    CMatrixHandleTable(void);
+    ~CMatrixHandleTable();
+
+    void Clear(void);
+
+    int Alloc(CMatrixMapStatic *obj, u32 nid);
+    void Release(int slot, u32 nid);
+
+    CMatrixMapStatic *Resolve(int slot, u32 nid) const {
+        return (slot < m_SlotCnt && m_Slot[slot].m_NID == nid) ? m_Slot[slot].m_Object : NULL;
+    }
+    DWORD GetReleaseCnt(void) const { return m_ReleaseCnt; }
+    int GetSlotCnt(void) const { return m_SlotCnt; }
+};
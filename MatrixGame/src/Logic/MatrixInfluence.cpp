@@ -0,0 +1,222 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "MatrixInfluence.hpp"
+#include "../MatrixMap.hpp"
+#include "../MatrixRobot.hpp"
+#include "../MatrixObjectCannon.hpp"
+#include "../MatrixObjectBuilding.hpp"
+
+CMatrixInfluenceMap::CMatrixInfluenceMap(void) : CMain() {
+    m_RegionCnt = 0;
+    m_Cell = NULL;
+    m_NextDecay = 0;
+    memset(m_Total, 0, sizeof(m_Total));
+}
+
+CMatrixInfluenceMap::~CMatrixInfluenceMap() {
+    Clear();
+}
+
+void CMatrixInfluenceMap::Clear(void) {
+    if (m_Cell) {
+        HFree(m_Cell, g_MatrixHeap);
+        m_Cell = NULL;
+    }
+    m_RegionCnt = 0;
+    m_NextDecay = 0;
+    memset(m_Total, 0, sizeof(m_Total));
+}
+
+void CMatrixInfluenceMap::Prepare(void) {
+    if (m_Cell || g_MatrixMap->m_RN.m_RegionCnt <= 0)
+        return;
+
+    m_RegionCnt = g_MatrixMap->m_RN.m_RegionCnt;
+    m_Cell = (SInfluenceCell *)HAllocClear(sizeof(SInfluenceCell) * m_RegionCnt * INFLUENCE_SIDE_CNT, g_MatrixHeap);
+}
+
+static void ApplyCell(SInfluenceCell &c, const SInfluenceTrack &track, int sign) {
+    switch (track.m_Kind) {
+        case INFLUENCE_ROBOT:
+            c.m_RobotCnt += sign;
+            c.m_RobotStrength += sign * track.m_Strength;
+            if (c.m_RobotCnt <= 0)
+                c.m_RobotStrength = 0;  // don't let float error accumulate in empty cells
+            break;
+        case INFLUENCE_CANNON:
+            c.m_CannonCnt += sign;
+            c.m_CannonStrength += sign * track.m_Strength;
+            if (c.m_CannonCnt <= 0)
+                c.m_CannonStrength = 0;
+            break;
+        case INFLUENCE_BASE:
+            c.m_BaseCnt += sign;
+            c.m_BuildingCnt += sign;
+            break;
+        case INFLUENCE_BUILDING:
+            c.m_BuildingCnt += sign;
+            break;
+    }
+}
+
+void CMatrixInfluenceMap::Apply(const SInfluenceTrack &track, int sign) {
+    if (track.m_Kind == INFLUENCE_NONE)
+        return;
+    ASSERT(track.m_Side >= 0 && track.m_Side < INFLUENCE_SIDE_CNT);
+
+    ApplyCell(m_Total[track.m_Side], track, sign);
+    if (track.m_Region >= 0 && track.m_Region < m_RegionCnt)
+        ApplyCell(*Cell(track.m_Region, track.m_Side), track, sign);
+}
+
+void CMatrixInfluenceMap::Refresh(CMatrixMapStatic *obj) {
+    SInfluenceTrack t;
+
+    switch (obj->GetObjectType()) {
+        case OBJECT_TYPE_ROBOTAI:
+            if (obj->IsLiveRobot()) {
+                t.m_Kind = INFLUENCE_ROBOT;
+                t.m_Side = obj->GetSide();
+                t.m_Cell = CPoint(obj->AsRobot()->GetMapPosX(), obj->AsRobot()->GetMapPosY());
+                t.m_Strength = obj->AsRobot()->GetStrength();
+            }
+            break;
+        case OBJECT_TYPE_CANNON:
+            if (obj->IsLiveCannon()) {
+                t.m_Kind = INFLUENCE_CANNON;
+                t.m_Side = obj->GetSide();
+                t.m_Cell = CPoint(int(obj->AsCannon()->m_Pos.x / GLOBAL_SCALE_MOVE),
+                                  int(obj->AsCannon()->m_Pos.y / GLOBAL_SCALE_MOVE));
+                t.m_Strength = obj->IsLiveActiveCannon() ? obj->AsCannon()->GetStrength() : 0.0f;
+            }
+            break;
+        case OBJECT_TYPE_BUILDING:
+            if (obj->IsLiveBuilding()) {
+                t.m_Kind = obj->IsBase() ? INFLUENCE_BASE : INFLUENCE_BUILDING;
+                t.m_Side = obj->GetSide();
+                t.m_Cell = CPoint(int(obj->AsBuilding()->m_Pos.x / GLOBAL_SCALE_MOVE),
+                                  int(obj->AsBuilding()->m_Pos.y / GLOBAL_SCALE_MOVE));
+            }
+            break;
+        default:
+            return;
+    }
+
+    // an object refreshed before the regions were ready still needs its region, even if it does not move
+    SInfluenceTrack &cur = obj->m_InfluenceTrack;
+    if (t.m_Kind == cur.m_Kind && t.m_Side == cur.m_Side && t.m_Cell == cur.m_Cell && t.m_Strength == cur.m_Strength &&
+        (cur.m_Kind == INFLUENCE_NONE || cur.m_RegionDone))
+        return;
+
+    Prepare();
+
+    if (t.m_Kind != INFLUENCE_NONE && m_Cell) {
+        // region lookup may fall back to the nearest region search, so it is done only when the cell has changed
+        if (t.m_Cell == cur.m_Cell && cur.m_Kind != INFLUENCE_NONE && cur.m_RegionDone)
+            t.m_Region = cur.m_Region;
+        else
+            t.m_Region = g_MatrixMap->GetRegion(t.m_Cell);
+        t.m_RegionDone = true;
+    }
+
+    Apply(cur, -1);
+    cur = t;
+    Apply(cur, 1);
+}
+
+void CMatrixInfluenceMap::Remove(CMatrixMapStatic *obj, bool killed) {
+    SInfluenceTrack &cur = obj->m_InfluenceTrack;
+    if (cur.m_Kind == INFLUENCE_NONE)
+        return;
+
+    if (killed) {
+        m_Total[cur.m_Side].m_Losses += cur.m_Strength;
+        if (cur.m_Region >= 0 && cur.m_Region < m_RegionCnt)
+            Cell(cur.m_Region, cur.m_Side)->m_Losses += cur.m_Strength;
+    }
+
+    Apply(cur, -1);
+    cur = SInfluenceTrack();
+}
+
+void CMatrixInfluenceMap::Takt(int time) {
+    if (time < m_NextDecay)
+        return;
+    m_NextDecay = time + INFLUENCE_DECAY_PERIOD;
+
+    for (int s = 0; s < INFLUENCE_SIDE_CNT; s++)
+        m_Total[s].m_Losses *= INFLUENCE_LOSS_DECAY;
+
+    SInfluenceCell *c = m_Cell;
+    for (int i = m_Cell ? m_RegionCnt * INFLUENCE_SIDE_CNT : 0; i > 0; i--, c++)
+        c->m_Losses *= INFLUENCE_LOSS_DECAY;
+}
+
+float CMatrixInfluenceMap::EnemyStrength(int side, int region) const {
+    if (!m_Cell || region < 0)
+        return 0;
+    float s = 0;
+    const SInfluenceCell *c = m_Cell + region * INFLUENCE_SIDE_CNT;
+    for (int i = 0; i < INFLUENCE_SIDE_CNT; i++, c++) {
+        if (i != side)
+            s += c->m_RobotStrength + c->m_CannonStrength;
+    }
+    return s;
+}
+
+float CMatrixInfluenceMap::FriendlyStrength(int side, int region) const {
+    if (!m_Cell || region < 0)
+        return 0;
+    const SInfluenceCell &c = Get(region, side);
+    return c.m_RobotStrength + c.m_CannonStrength;
+}
+
+float CMatrixInfluenceMap::TurretCoverage(int side, int region) const {
+    if (!m_Cell || region < 0)
+        return 0;
+    float s = 0;
+    const SInfluenceCell *c = m_Cell + region * INFLUENCE_SIDE_CNT;
+    for (int i = 0; i < INFLUENCE_SIDE_CNT; i++, c++) {
+        if (i != side)
+            s += c->m_CannonStrength;
+    }
+    return s;
+}
+
+float CMatrixInfluenceMap::Losses(int side, int region) const {
+    if (!m_Cell || region < 0)
+        return 0;
+    return Get(region, side).m_Losses;
+}
+
+bool CMatrixInfluenceMap::Match(int side, int region, DWORD flags) const {
+    if (!m_Cell || region < 0)
+        return false;
+
+    const SInfluenceCell *c = m_Cell + region * INFLUENCE_SIDE_CNT;
+    for (int i = 0; i < INFLUENCE_SIDE_CNT; i++, c++) {
+        if (i == side) {
+            if (!(flags & 1))
+                continue;
+        }
+        else if (i == 0) {
+            if (!(flags & 2))
+                continue;
+        }
+        else if (!(flags & 4))
+            continue;
+
+        if ((flags & 8) && c->m_BaseCnt)
+            return true;
+        if ((flags & 16) && c->m_BuildingCnt)
+            return true;
+        if ((flags & 32) && c->m_RobotCnt && i != 0)
+            return true;
+        if ((flags & 64) && c->m_CannonCnt)
+            return true;
+    }
+    return false;
+}
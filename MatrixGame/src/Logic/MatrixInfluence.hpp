@@ -0,0 +1,89 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "CMain.hpp"
+#include "BaseDef.hpp"
+
+#define INFLUENCE_SIDE_CNT 5  // neutral + 4 playing sides (see CMatrixMap::LoadSide)
+
+#define INFLUENCE_DECAY_PERIOD 100    // ms between two decay steps of the losses
+#define INFLUENCE_LOSS_DECAY   0.99f  // losses multiplier per decay step (halves in ~7 seconds)
+
+class CMatrixMapStatic;
+
+enum EInfluenceKind : BYTE {
+    INFLUENCE_NONE,
+    INFLUENCE_ROBOT,
+    INFLUENCE_CANNON,
+    INFLUENCE_BUILDING,
+    INFLUENCE_BASE,
+};
+
+/**
+ * @brief What a single object currently adds to the influence map.
+ *
+ * Stored inside CMatrixMapStatic, so the contribution can be taken back in O(1) when the object moves or dies.
+ */
+struct SInfluenceTrack {
+    EInfluenceKind m_Kind{INFLUENCE_NONE};
+    int m_Side{0};
+    int m_Region{-1};  // -1 - counted only in the side totals
+    bool m_RegionDone{false};  // m_Region is looked up: the regions were ready at the time
+    Base::CPoint m_Cell{-1, -1};
+    float m_Strength{0};
+};
+
+struct SInfluenceCell {
+    int m_RobotCnt;
+    int m_CannonCnt;
+    int m_BuildingCnt;  // bases are counted here too
+    int m_BaseCnt;
+
+    float m_RobotStrength;
+    float m_CannonStrength;  // turret coverage
+    float m_Losses;          // strength lost recently, decays with time
+};
+
+/**
+ * @brief Per side influence over the regions of CMatrixRoadNetwork.
+ *
+ * Objects push their contribution with Refresh() every logic takt; the cell is touched only when region, side,
+ * kind or strength of the object has changed, so AI queries become O(1) lookups instead of rescans of every object.
+ */
+class CMatrixInfluenceMap : public Base::CMain {
+    int m_RegionCnt;
+    SInfluenceCell *m_Cell;                      // m_RegionCnt * INFLUENCE_SIDE_CNT, region major
+    SInfluenceCell m_Total[INFLUENCE_SIDE_CNT];  // whole map, including objects outside of any region
+    int m_NextDecay;
+
+    SInfluenceCell *Cell(int region, int side) { return m_Cell + region * INFLUENCE_SIDE_CNT + side; }
+    void Apply(const SInfluenceTrack &track, int sign);
+    void Prepare(void);
+
+public:
+    CMatrixInfluenceMap(void);
+    ~CMatrixInfluenceMap();
+
+    void Clear(void);
+
+    void Refresh(CMatrixMapStatic *obj);
+    void Remove(CMatrixMapStatic *obj, bool killed);
+    void Takt(int time);
+
+    const SInfluenceCell &Get(int region, int side) const { return m_Cell[region * INFLUENCE_SIDE_CNT + side]; }
+    const SInfluenceCell &Total(int side) const { return m_Total[side]; }
+    bool IsReady(void) const { return m_Cell != NULL; }
+
+    float EnemyStrength(int side, int region) const;  // robots and turrets of everybody else, neutral turrets too
+    float FriendlyStrength(int side, int region) const;
+    float TurretCoverage(int side, int region) const;  // hostile turrets only
+    float Losses(int side, int region) const;
+
+    // flags: 1-our 2-netral 4-enemy 8-base 16-building 32-robot 64-cannon (as in FindNearRegionWithUTR,
+    // which never matched the neutral robots)
+    bool Match(int side, int region, DWORD flags) const;
+};
@@ -0,0 +1,240 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "MatrixPerception.hpp"
+#include "../MatrixMap.hpp"
+#include "../MatrixRobot.hpp"
+#include "../MatrixObjectCannon.hpp"
+
+#include <algorithm>
+
+// Same positions and ranges CMatrixRobotAI::GatherInfo compares against
+static bool PerceptionPos(CMatrixMapStatic *obj, float &x, float &y, float &reach) {
+    if (obj->IsLiveRobot()) {
+        CMatrixRobotAI *robot = obj->AsRobot();
+        x = robot->m_PosX;
+        y = robot->m_PosY;
+        reach = robot->GetMaxFireDist() * 1.1f;
+        return true;
+    }
+    if (obj->IsLiveCannon()) {
+        const D3DXVECTOR3 &c = obj->GetGeoCenter();
+        x = c.x;
+        y = c.y;
+        reach = obj->AsCannon()->GetFireRadius() * 1.01f;
+        return true;
+    }
+    return false;
+}
+
+CMatrixPerceptionGrid::CMatrixPerceptionGrid(void) : CMain() {
+    m_SizeX = 0;
+    m_SizeY = 0;
+    m_CellStart = NULL;
+    m_Entry = NULL;
+    m_Cell = NULL;
+    m_EntryCnt = 0;
+    m_EntryMax = 0;
+    m_Range = 0;
+
+    m_Mark = NULL;
+    m_Query = 0;
+    m_Cand = NULL;
+    m_CandObj = NULL;
+    m_CandCnt = 0;
+
+    memset(m_RadioCnt, 0, sizeof(m_RadioCnt));
+    m_CheckCnt = 0;
+}
+
+CMatrixPerceptionGrid::~CMatrixPerceptionGrid() {
+    Clear();
+}
+
+void CMatrixPerceptionGrid::Clear(void) {
+    if (m_CellStart) {
+        HFree(m_CellStart, g_MatrixHeap);
+        m_CellStart = NULL;
+    }
+    if (m_Entry) {
+        HFree(m_Entry, g_MatrixHeap);
+        HFree(m_Cell, g_MatrixHeap);
+        HFree(m_Mark, g_MatrixHeap);
+        HFree(m_Cand, g_MatrixHeap);
+        HFree(m_CandObj, g_MatrixHeap);
+        m_Entry = NULL;
+        m_Cell = NULL;
+        m_Mark = NULL;
+        m_Cand = NULL;
+        m_CandObj = NULL;
+    }
+    m_SizeX = 0;
+    m_SizeY = 0;
+    m_EntryCnt = 0;
+    m_EntryMax = 0;
+    m_Range = 0;
+    m_Query = 0;
+    m_CandCnt = 0;
+
+    memset(m_RadioCnt, 0, sizeof(m_RadioCnt));
+    m_CheckCnt = 0;
+}
+
+int CMatrixPerceptionGrid::CellX(float x) const {
+    int c = TruncFloat(x * INVERT(PERCEPTION_CELL));
+    return std::max(0, std::min(m_SizeX - 1, c));
+}
+
+int CMatrixPerceptionGrid::CellY(float y) const {
+    int c = TruncFloat(y * INVERT(PERCEPTION_CELL));
+    return std::max(0, std::min(m_SizeY - 1, c));
+}
+
+void CMatrixPerceptionGrid::Build(void) {
+    DTRACE();
+
+    if (!m_CellStart) {
+        m_SizeX = int(g_MatrixMap->m_Size.x * GLOBAL_SCALE / PERCEPTION_CELL) + 1;
+        m_SizeY = int(g_MatrixMap->m_Size.y * GLOBAL_SCALE / PERCEPTION_CELL) + 1;
+        m_CellStart = (int *)HAlloc(sizeof(int) * (m_SizeX * m_SizeY + 1), g_MatrixHeap);
+    }
+
+    m_EntryCnt = 0;
+    m_Range = 0;
+    m_CheckCnt = 0;
+
+    for (CMatrixMapStatic *obj = CMatrixMapStatic::GetFirstLogic(); obj; obj = obj->GetNextLogic()) {
+        float x, y, reach;
+        if (!PerceptionPos(obj, x, y, reach))
+            continue;
+
+        if (m_EntryCnt >= m_EntryMax) {
+            int old = m_EntryMax;
+            m_EntryMax = m_EntryMax ? m_EntryMax * 2 : 256;
+            m_Entry = (SPerceptionEntry *)HAllocEx(m_Entry, sizeof(SPerceptionEntry) * m_EntryMax, g_MatrixHeap);
+            m_Cell = (SPerceptionEntry *)HAllocEx(m_Cell, sizeof(SPerceptionEntry) * m_EntryMax, g_MatrixHeap);
+            m_Mark = (DWORD *)HAllocEx(m_Mark, sizeof(DWORD) * m_EntryMax, g_MatrixHeap);
+            m_Cand = (int *)HAllocEx(m_Cand, sizeof(int) * m_EntryMax, g_MatrixHeap);
+            m_CandObj = (CMatrixMapStatic **)HAllocEx(m_CandObj, sizeof(CMatrixMapStatic *) * m_EntryMax,
+                                                      g_MatrixHeap);
+            memset(m_Mark + old, 0, sizeof(DWORD) * (m_EntryMax - old));  // queries start from 1
+        }
+
+        SPerceptionEntry &e = m_Entry[m_EntryCnt];
+        e.m_Object = obj;
+        e.m_X = x;
+        e.m_Y = y;
+        e.m_Side = obj->GetSide();
+        e.m_Order = m_EntryCnt;
+        ++m_EntryCnt;
+
+        m_Range = std::max(m_Range, reach);
+    }
+
+    // GatherInfo compares squares in double precision
+    m_Range = m_Range * 1.01f + 1.0f;
+
+    // counting sort by cell: entries of a cell keep the logic order
+    int cells = m_SizeX * m_SizeY;
+    memset(m_CellStart, 0, sizeof(int) * (cells + 1));
+    for (int i = 0; i < m_EntryCnt; ++i) {
+        ++m_CellStart[CellX(m_Entry[i].m_X) + CellY(m_Entry[i].m_Y) * m_SizeX + 1];
+    }
+    for (int c = 0; c < cells; ++c) {
+        m_CellStart[c + 1] += m_CellStart[c];
+    }
+    for (int i = 0; i < m_EntryCnt; ++i) {
+        m_Cell[m_CellStart[CellX(m_Entry[i].m_X) + CellY(m_Entry[i].m_Y) * m_SizeX]++] = m_Entry[i];
+    }
+    for (int c = cells; c > 0; --c) {
+        m_CellStart[c] = m_CellStart[c - 1];
+    }
+    m_CellStart[0] = 0;
+}
+
+void CMatrixPerceptionGrid::CountRadio(void) {
+    memset(m_RadioCnt, 0, sizeof(m_RadioCnt));
+    for (CMatrixMapStatic *obj = CMatrixMapStatic::GetFirstLogic(); obj; obj = obj->GetNextLogic()) {
+        if (obj->GetObjectType() != OBJECT_TYPE_ROBOTAI)
+            continue;
+        int side = obj->GetSide();
+        if (side >= 0 && side < PERCEPTION_SIDE_CNT && obj->AsRobot()->GetEnv()->GetEnemyCnt() > 0)
+            ++m_RadioCnt[side];
+    }
+}
+
+void CMatrixPerceptionGrid::AddCandidate(const SPerceptionEntry &e) {
+    if (m_Mark[e.m_Order] == m_Query)
+        return;
+    m_Mark[e.m_Order] = m_Query;
+    m_Cand[m_CandCnt++] = e.m_Order;
+}
+
+void CMatrixPerceptionGrid::AddKnown(CMatrixMapStatic *obj) {
+    float x, y, reach;
+    if (!obj || !PerceptionPos(obj, x, y, reach))
+        return;
+
+    int c = CellX(x) + CellY(y) * m_SizeX;
+    for (int k = m_CellStart[c]; k < m_CellStart[c + 1]; ++k) {
+        if (m_Cell[k].m_Object == obj) {
+            AddCandidate(m_Cell[k]);
+            return;
+        }
+    }
+}
+
+int CMatrixPerceptionGrid::Query(CMatrixRobotAI *robot, CMatrixMapStatic ***out) {
+    DTRACE();
+
+    m_CandCnt = 0;
+    *out = m_CandObj;
+    if (!m_CellStart || m_EntryCnt == 0)
+        return 0;
+
+    if (++m_Query == 0) {
+        memset(m_Mark, 0, sizeof(DWORD) * m_EntryMax);
+        m_Query = 1;
+    }
+
+    // everybody who may come into range
+    float x = robot->m_PosX;
+    float y = robot->m_PosY;
+    int side = robot->GetSide();
+    float r2 = m_Range * m_Range;
+
+    int x0 = CellX(x - m_Range), x1 = CellX(x + m_Range);
+    int y0 = CellY(y - m_Range), y1 = CellY(y + m_Range);
+    for (int cy = y0; cy <= y1; ++cy) {
+        for (int cx = x0; cx <= x1; ++cx) {
+            int c = cx + cy * m_SizeX;
+            for (int k = m_CellStart[c]; k < m_CellStart[c + 1]; ++k) {
+                const SPerceptionEntry &e = m_Cell[k];
+                if (e.m_Side == side)
+                    continue;
+                float dx = e.m_X - x;
+                float dy = e.m_Y - y;
+                if (dx * dx + dy * dy <= r2)
+                    AddCandidate(e);
+            }
+        }
+    }
+
+    // and everybody already known: they may have to be forgotten
+    CInfo *env = robot->GetEnv();
+    for (SEnemy *enemy = env->FirstEnemy(); enemy; enemy = env->NextEnemy(enemy)) {
+        AddKnown(enemy->GetEnemy());
+    }
+    AddKnown(env->m_Target);
+    AddKnown(env->m_TargetAttack);
+
+    std::sort(m_Cand, m_Cand + m_CandCnt);
+    for (int i = 0; i < m_CandCnt; ++i) {
+        m_CandObj[i] = m_Entry[m_Cand[i]].m_Object;
+    }
+
+    m_CheckCnt += m_CandCnt;
+    return m_CandCnt;
+}
@@ -0,0 +1,69 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "CMain.hpp"
+#include "BaseDef.hpp"
+
+class CMatrixMapStatic;
+class CMatrixRobotAI;
+
+#define PERCEPTION_CELL     256.0f  // world units per side of a grid cell
+#define PERCEPTION_SIDE_CNT 5       // neutral + 4 playing sides (see CMatrixMap::LoadSide)
+
+struct SPerceptionEntry {
+    CMatrixMapStatic *m_Object;
+    float m_X, m_Y;
+    int m_Side;
+    int m_Order;  // index in the logic list order
+};
+
+/**
+ * @brief Live robots and turrets binned over a coarse grid, rebuilt at the start of every GatherInfo pass.
+ *
+ * CMatrixRobotAI::GatherInfo looks only at the units its range ring can reach and at the ones it already knows
+ * about, instead of at every object of the map. Candidates come in the logic list order, so the environment is
+ * filled exactly as by the full scan; a robot with nobody around costs a few empty cells.
+ */
+class CMatrixPerceptionGrid : public Base::CMain {
+    int m_SizeX, m_SizeY;
+    int *m_CellStart;           // m_SizeX * m_SizeY + 1 offsets into m_Cell
+    SPerceptionEntry *m_Entry;  // logic list order
+    SPerceptionEntry *m_Cell;   // cell order
+    int m_EntryCnt;
+    int m_EntryMax;
+    float m_Range;  // the longest reach of all the units, with a margin
+
+    DWORD *m_Mark;  // last query each entry was returned by
+    DWORD m_Query;
+    int *m_Cand;
+    CMatrixMapStatic **m_CandObj;
+    int m_CandCnt;
+
+    int m_RadioCnt[PERCEPTION_SIDE_CNT];  // robots that have something to share by radio
+    int m_CheckCnt;                       // candidates returned since Build
+
+    int CellX(float x) const;
+    int CellY(float y) const;
+    void AddCandidate(const SPerceptionEntry &e);
+    void AddKnown(CMatrixMapStatic *obj);
+
+public:
+    CMatrixPerceptionGrid(void);
+    ~CMatrixPerceptionGrid();
+
+    void Clear(void);
+
+    void Build(void);
+    void CountRadio(void);
+
+    // objects robot's GatherInfo(0) has to look at, valid until the next call
+    int Query(CMatrixRobotAI *robot, CMatrixMapStatic ***out);
+    bool HasRadio(int side) const { return side < 0 || side >= PERCEPTION_SIDE_CNT || m_RadioCnt[side] > 0; }
+
+    int GetEntryCnt(void) const { return m_EntryCnt; }
+    int GetCheckCnt(void) const { return m_CheckCnt; }
+};
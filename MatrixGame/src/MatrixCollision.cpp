@@ -0,0 +1,100 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "MatrixCollision.hpp"
+#include "MatrixMap.hpp"
+
+#ifdef COLLIDE_SSE2
+#include <emmintrin.h>
+#endif
+
+static_assert(COLLIDE_WINDOW_CNT <= 64, "candidates mask is 64 bit");
+static_assert((COLLIDE_WINDOW_CNT & 3) == 0, "SoA arrays are processed by 4");
+
+void SCollideCells::Prepare(const BYTE (*corners)[COLLIDE_WINDOW], int x0, int y0, int x1, int y1) {
+    m_Cnt = 0;
+    m_X0 = x0;
+    m_Y0 = y0;
+    m_X1 = x1;
+    m_Y1 = y1;
+
+    SMatrixMapMove *smm = g_MatrixMap->MoveGet(x0, y0);
+    for (int y = y0; y < y1; ++y, smm += g_MatrixMap->m_SizeMove.x - (x1 - x0)) {
+        for (int x = x0; x < x1; ++x, ++smm) {
+            BYTE corner = corners[x - x0][y - y0];
+            if (corner == 0xFF)
+                continue;
+
+            // same math as CMatrixRobotAI::SphereToAABB
+            m_MinX[m_Cnt] = x * GLOBAL_SCALE_MOVE;
+            m_MinY[m_Cnt] = y * GLOBAL_SCALE_MOVE;
+            m_MaxX[m_Cnt] = m_MinX[m_Cnt] + GLOBAL_SCALE_MOVE;
+            m_MaxY[m_Cnt] = m_MinY[m_Cnt] + GLOBAL_SCALE_MOVE;
+            m_Move[m_Cnt] = smm;
+            m_Cell[m_Cnt] = CPoint(x, y);
+            m_Corner[m_Cnt] = corner;
+            ++m_Cnt;
+        }
+    }
+
+    // pad up to the SIMD width with cells nobody can touch
+    for (int i = m_Cnt; i & 3; ++i) {
+        m_MinX[i] = m_MinY[i] = 1e30f;
+        m_MaxX[i] = m_MaxY[i] = 1e30f;
+    }
+}
+
+uint64_t SCollideCells::CandidatesScalar(const D3DXVECTOR2 &pos, int from) const {
+    uint64_t mask = 0;
+    for (int i = from; i < m_Cnt; ++i) {
+        float dx = 0, dy = 0;
+        if (pos.x < m_MinX[i])
+            dx = m_MinX[i] - pos.x;
+        else if (pos.x > m_MaxX[i])
+            dx = pos.x - m_MaxX[i];
+        if (pos.y < m_MinY[i])
+            dy = m_MinY[i] - pos.y;
+        else if (pos.y > m_MaxY[i])
+            dy = pos.y - m_MaxY[i];
+
+        if (dx * dx + dy * dy <= COLLIDE_GATE_R * COLLIDE_GATE_R)
+            mask |= uint64_t(1) << i;
+    }
+    return mask;
+}
+
+uint64_t SCollideCells::Candidates(const D3DXVECTOR2 &pos, int from) const {
+#ifdef COLLIDE_SSE2
+    if (from >= m_Cnt)
+        return 0;
+
+    const __m128 px = _mm_set1_ps(pos.x);
+    const __m128 py = _mm_set1_ps(pos.y);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 r2 = _mm_set1_ps(COLLIDE_GATE_R * COLLIDE_GATE_R);
+
+    uint64_t mask = 0;
+    for (int i = from & ~3; i < m_Cnt; i += 4) {
+        // distance from the point to the box along an axis: max(min - p, p - max, 0)
+        __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(m_MinX + i), px),
+                                          _mm_sub_ps(px, _mm_loadu_ps(m_MaxX + i))),
+                               zero);
+        __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(m_MinY + i), py),
+                                          _mm_sub_ps(py, _mm_loadu_ps(m_MaxY + i))),
+                               zero);
+        __m128 d = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+        mask |= uint64_t(_mm_movemask_ps(_mm_cmple_ps(d, r2))) << i;
+    }
+
+    // drop lanes before 'from' and the padding
+    mask &= ~uint64_t(0) << from;
+    if (m_Cnt < 64)
+        mask &= (uint64_t(1) << m_Cnt) - 1;
+    return mask;
+#else
+    return CandidatesScalar(pos, from);
+#endif
+}
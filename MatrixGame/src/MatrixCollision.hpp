@@ -0,0 +1,50 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "MatrixRobot.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLLIDE_SSE2
+#endif
+
+#define COLLIDE_WINDOW     (COLLIDE_FIELD_R * 2)  // move cells per side checked around a robot
+#define COLLIDE_WINDOW_CNT (COLLIDE_WINDOW * COLLIDE_WINDOW)
+
+// Gate radius is a bit larger than COLLIDE_BOT_R, so the batched test never rejects a cell
+// CMatrixRobotAI::SphereToAABBCheck would accept (x87 builds may round the scalar test differently).
+#define COLLIDE_GATE_R (COLLIDE_BOT_R + 0.01f)
+
+struct SMatrixMapMove;
+
+/**
+ * @brief Obstacle cells of the move grid around a robot, in SoA layout for the batched sphere vs AABB test.
+ *
+ * Only cells which are obstacles for the chassis are stored, in the same (row major) order the scalar
+ * collision code walks them, so resolving the candidates in mask order gives exactly the scalar results.
+ */
+struct SCollideCells {
+    int m_Cnt;
+    int m_X0, m_Y0, m_X1, m_Y1;  // window the cells were collected for
+
+    float m_MinX[COLLIDE_WINDOW_CNT];
+    float m_MinY[COLLIDE_WINDOW_CNT];
+    float m_MaxX[COLLIDE_WINDOW_CNT];
+    float m_MaxY[COLLIDE_WINDOW_CNT];
+
+    SMatrixMapMove *m_Move[COLLIDE_WINDOW_CNT];
+    CPoint m_Cell[COLLIDE_WINDOW_CNT];
+    BYTE m_Corner[COLLIDE_WINDOW_CNT];
+
+    SCollideCells(void) : m_Cnt(0), m_X0(-1), m_Y0(-1), m_X1(-1), m_Y1(-1) {}
+
+    // corners[x - x0][y - y0] - SMatrixMapMove::GetType of the cells, 0xFF - passable
+    void Prepare(const BYTE (*corners)[COLLIDE_WINDOW], int x0, int y0, int x1, int y1);
+
+    // bit i is set if cell i (i >= from) may touch the robot sphere at pos
+    uint64_t Candidates(const D3DXVECTOR2 &pos, int from) const;
+    uint64_t CandidatesScalar(const D3DXVECTOR2 &pos, int from) const;
+};
@@ -191,6 +191,8 @@ void CMatrixConfig::SetDefaults(void) {
     m_LandTexturesGloss = true;
     m_DIFlags = 0;
     m_VertexLight = true;
+    m_OcclusionCull = true;
+    m_TerrainLodError = 2.0f;
 
     m_Cursors = NULL;
 
@@ -409,6 +411,14 @@ void CMatrixConfig::ReadParams(void) {
         m_VertexLight = cfg_par->ParGet(CFG_VERTEXLIGHT).GetInt() == 1;
     }
 
+    if (cfg_par->ParCount(CFG_OCCLUSIONCULL) != 0) {
+        m_OcclusionCull = cfg_par->ParGet(CFG_OCCLUSIONCULL).GetInt() == 1;
+    }
+
+    if (cfg_par->ParCount(CFG_TERRAINLODERROR) != 0) {
+        m_TerrainLodError = float(cfg_par->ParGet(CFG_TERRAINLODERROR).GetDouble());
+    }
+
     if (cfg_par->BlockCount(CFG_GAMMARAMP) != 0) {
         CBlockPar *g = cfg_par->BlockGet(CFG_GAMMARAMP);
         m_GammaR.brightness = (float)g->ParGet(L"R").GetStrPar(0, L",").GetDouble();
@@ -426,6 +436,17 @@ void CMatrixConfig::ReadParams(void) {
 
     ApplyGammaRamp();
 
+    // megabytes per cache class, no limit by default
+    if (cfg_par->BlockCount(CFG_CACHEBUDGET) != 0) {
+        CBlockPar *cb = cfg_par->BlockGet(CFG_CACHEBUDGET);
+        if (cb->ParCount(L"Texture") != 0)
+            g_Cache->SetBudget(CacheClass::Texture, cb->ParGet(L"Texture").GetInt() * 1024 * 1024);
+        if (cb->ParCount(L"TextureManaged") != 0)
+            g_Cache->SetBudget(CacheClass::TextureManaged, cb->ParGet(L"TextureManaged").GetInt() * 1024 * 1024);
+        if (cb->ParCount(L"VO") != 0)
+            g_Cache->SetBudget(CacheClass::VO, cb->ParGet(L"VO").GetInt() * 1024 * 1024);
+    }
+
     if (cfg_par->BlockCount(CFG_ASSIGNKEY) != 0) {
         CBlockPar *ak = cfg_par->BlockGet(CFG_ASSIGNKEY);
         int n = ak->ParCount();
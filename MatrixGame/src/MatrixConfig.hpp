@@ -600,6 +600,8 @@ public:
     bool m_LandTexturesGloss;
     bool m_SoftwareCursor;
     bool m_VertexLight;
+    bool m_OcclusionCull;  // skip objects hidden behind the terrain
+    float m_TerrainLodError;  // in pixels, the terrain LOD is off if negative
 
     bool m_ObjTexturesGloss;
     // bool  m_ObjTextures16;
@@ -25,26 +25,40 @@ extern IDirect3DDevice9* g_D3DD;
 
 CMatrixDebugInfo::CMatrixDebugInfo()
 : m_Font{nullptr}
+, m_Sprite{nullptr}
 , m_Pos{DI_KEY_X, DI_KEY_Y}
+, m_Stats{}
 {
     if (D3D_OK != D3DXCreateFontW(g_D3DD, 25, 0, FW_NORMAL, 1, FALSE, DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
                                   PROOF_QUALITY, DEFAULT_PITCH, L"MS Sans Serif", &m_Font))
     {
         throw std::runtime_error("Failed to create font with D3DXCreateFontW()");
     }
+    if (D3D_OK != D3DXCreateSprite(g_D3DD, &m_Sprite))
+    {
+        throw std::runtime_error("Failed to create sprite with D3DXCreateSprite()");
+    }
+    // the glyphs of the keys and numbers are in the texture of the font from the start
+    m_Font->PreloadCharacters(32, 126);
 }
 
 CMatrixDebugInfo::~CMatrixDebugInfo()
 {
+    m_Sprite->Release();
     m_Font->Release();
 };
 
 void CMatrixDebugInfo::Draw()
 {
+    auto time_start = std::chrono::steady_clock::now();
+
     try
     {
         int max_value_len = 0;
 
+        // the glyph quads of all the lines are drawn at End, grouped by the texture
+        m_Sprite->Begin(D3DXSPRITE_ALPHABLEND | D3DXSPRITE_SORT_TEXTURE);
+
         int y = m_Pos.y;
         for (auto& item : m_Items)
         {
@@ -66,21 +80,24 @@ void CMatrixDebugInfo::Draw()
 
             uint32_t color = (alpha << 24) | 0xFFFFFF;
 
-            m_Font->DrawTextW(NULL, item.key.c_str(), item.key.length(), (LPRECT)&r,
+            m_Font->DrawTextW(m_Sprite, item.key.c_str(), item.key.length(), (LPRECT)&r,
                               DT_NOCLIP | DT_LEFT | DT_VCENTER | DT_SINGLELINE, color);
 
             r.left = r.right + 1;
             r.right = r.left + DI_VAL_W;
 
-            m_Font->DrawTextW(NULL, item.val.c_str(), item.val.length(), (LPRECT)&r,
+            m_Font->DrawTextW(m_Sprite, item.val.c_str(), item.val.length(), (LPRECT)&r,
                               DT_LEFT | DT_VCENTER | DT_SINGLELINE | DT_NOCLIP, color);
 
             if (item.val.length() > max_value_len)
                 max_value_len = item.val.length();
 
             y += DI_KEY_H;
+            ++m_Stats.m_Lines;
         }
 
+        m_Sprite->End();
+
         if (m_Items.size() > 0) {
             // Draw rect-pad background
 
@@ -117,6 +134,9 @@ void CMatrixDebugInfo::Draw()
     catch (...)
     {
     }
+
+    ++m_Stats.m_Frames;
+    m_Stats.m_Time += std::chrono::steady_clock::now() - time_start;
 }
 
 void CMatrixDebugInfo::T(const wchar_t *key, const wchar_t *val, int ttl, int bttl, bool add)
@@ -167,10 +187,12 @@ void CMatrixDebugInfo::SetStartPos(const CPoint& pos)
 
 void CMatrixDebugInfo::OnLostDevice()
 {
+    m_Sprite->OnLostDevice();
     m_Font->OnLostDevice();
 }
 
 void CMatrixDebugInfo::OnResetDevice()
 {
     m_Font->OnResetDevice();
+    m_Sprite->OnResetDevice();
 }
\ No newline at end of file
@@ -9,6 +9,8 @@
 
 #include <d3dx9core.h>
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -19,6 +21,19 @@
 #define DI_SIDEINFO      SETBIT(4)
 #define DI_ACTIVESOUNDS  SETBIT(5)
 #define DI_FRUSTUMCENTER SETBIT(6)
+#define DI_GATHERINFO    SETBIT(7)
+#define DI_CACHE         SETBIT(8)
+#define DI_STREAM        SETBIT(9)
+#define DI_CULL          SETBIT(10)
+#define DI_TERRAINLOD    SETBIT(11)
+#define DI_STREAMRING    SETBIT(12)
+
+// totals of Draw, for the benchmarks
+struct SDIStats {
+    int64_t m_Lines;
+    int64_t m_Frames;
+    std::chrono::steady_clock::duration m_Time;
+};
 
 struct SDIItem {
     std::wstring key;
@@ -31,9 +46,12 @@ class CMatrixDebugInfo
 {
     std::vector<SDIItem> m_Items;
     ID3DXFont* m_Font;
+    ID3DXSprite* m_Sprite;  // the lines of a frame go as one batch of the cached glyphs
 
     CPoint m_Pos;
 
+    SDIStats m_Stats;
+
 public:
     CMatrixDebugInfo();
     ~CMatrixDebugInfo();
@@ -47,4 +65,6 @@ public:
 
     void OnLostDevice();
     void OnResetDevice();
+
+    const SDIStats& GetStats() const { return m_Stats; }
 };
\ No newline at end of file
@@ -2008,10 +2008,11 @@ void CMatrixFlyer::ReleaseMe() {
         DeleteProgressBarClone(PBC_CLONE2);
     }
 
+    ReleaseHandle();
     CMatrixMapStatic *objects = CMatrixMapStatic::GetFirstLogic();
     while (objects) {
         if (objects->IsRobot()) {
-            ((CMatrixRobotAI *)objects)->GetEnv()->RemoveFromList(this);
+            ((CMatrixRobotAI *)objects)->GetEnv()->RemoveTarget(this);
         }
         objects = objects->GetNextLogic();
     }
@@ -371,6 +371,9 @@ public:
 
     virtual void BeforeDraw(void);
     virtual void Draw(void);
+    virtual const SSkin *GetDrawSkin(void) const {
+        return (m_UnitCnt > 0 && m_Units[0].m_Graph) ? m_Units[0].m_Graph->GetSkin() : NULL;
+    }
     virtual void DrawShadowStencil(void);
     virtual void DrawShadowProj(void){};
 
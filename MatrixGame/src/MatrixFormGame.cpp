@@ -21,6 +21,8 @@
 #include "MatrixObjectCannon.hpp"
 #include "Interface/CCounter.h"
 #include "MatrixGamePathUtils.hpp"
+#include "TextureStream.hpp"
+#include "StreamRing.hpp"
 
 #include "Network/Command.hpp"
 #include "Network/Message.hpp"
@@ -251,7 +253,7 @@ void CFormMatrixGame::Draw(void) {
         return;
     }
 
-    CInstDraw::DrawFrameBegin();
+    CStreamRing::BeginFrame();
 
     if (FLAG(g_MatrixMap->m_Flags, MMFLAG_AUTOMATIC_MODE))
     {
@@ -266,6 +268,48 @@ void CFormMatrixGame::Draw(void) {
     {
         g_MatrixMap->m_DI.T(L"Free Texture Mem", utils::format(L"%d", g_AvailableTexMem).c_str());
     }
+    if (FLAG(g_Config.m_DIFlags, DI_CACHE))
+    {
+        g_MatrixMap->m_DI.T(
+            L"Cache (items/hits/misses/evicted)",
+            utils::format(
+                L"%d / %d / %d / %d",
+                g_Cache->GetCount(),
+                g_Cache->GetHits(),
+                g_Cache->GetMisses(),
+                g_Cache->GetEvictions()).c_str()
+            );
+    }
+    if (FLAG(g_Config.m_DIFlags, DI_STREAM))
+    {
+        g_MatrixMap->m_DI.T(
+            L"Texture stream (queued/pending/uploaded, last/max ms)",
+            utils::format(
+                L"%d / %d / %d, %u / %u",
+                g_TextureStream->GetQueued(),
+                g_TextureStream->GetPending(),
+                g_TextureStream->GetUploaded(),
+                g_TextureStream->GetLastLatency(),
+                g_TextureStream->GetMaxLatency()).c_str()
+            );
+        if (!g_TextureStream->GetLastName().empty())
+        {
+            g_MatrixMap->m_DI.T(L"Texture stream last", g_TextureStream->GetLastName().c_str());
+        }
+    }
+    if (FLAG(g_Config.m_DIFlags, DI_STREAMRING))
+    {
+        const SStreamRingStats &rs = CStreamRing::GetFrameStats();
+        g_MatrixMap->m_DI.T(
+            L"Stream ring (VB/IB KB, locks, discards)",
+            utils::format(
+                L"%.1f / %.1f, %d, %d",
+                rs.m_VBBytes / 1024.0,
+                rs.m_IBBytes / 1024.0,
+                int(rs.m_Locks),
+                int(rs.m_Discards)).c_str()
+            );
+    }
     if (FLAG(g_Config.m_DIFlags, DI_TARGETCOORD))
     {
         g_MatrixMap->m_DI.T(
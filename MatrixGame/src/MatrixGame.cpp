@@ -14,6 +14,10 @@
 #include "Interface/CInterface.h"
 #include "MatrixRenderPipeline.hpp"
 #include "ShadowStencil.hpp"
+#include "StreamRing.hpp"
+#include "NullDevice.hpp"
+#include "FilterDevice.hpp"
+#include "TextureStream.hpp"
 #include "MatrixLoadProgress.hpp"
 #include "MatrixSkinManager.hpp"
 #include "Interface/CIFaceMenu.h"
@@ -21,11 +25,15 @@
 #include "Interface/CHistory.h"
 #include "MatrixSampleStateManager.hpp"
 #include "MatrixMultiSelection.hpp"
+#include "MatrixGamePathUtils.hpp"
+#include "Text/Render.hpp"
 
 #include <new>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <chrono>
+#include <format>
 
 ////////////////////////////////////////////////////////////////////////////////
 #include <stupid_logger.hpp>
@@ -38,6 +46,58 @@ CMatrixMapLogic *g_MatrixMap;
 CRenderPipeline *g_Render;
 CLoadProgress *g_LoadProgress;
 
+// One line per run on the null device: the CPU time of a frame and what a frame has asked the device for, on average.
+// It goes to the log and to a file, which is kept, so the frames can be compared between builds.
+static void StoreFrameStats(const std::wstring &mapname, const CNullDevice &dev) {
+    int frames = std::max(1, dev.GetFrames());
+    auto ms = [](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+    auto avg = [frames](DWORD v) { return double(v) / frames; };
+
+    const SDeviceStats &t = dev.GetTotal();
+    std::string line = std::format(
+            "cpu={:.2f} max={:.2f} draws={:.0f} prims={:.0f} states={:.0f} same={:.0f} textures={:.0f} locks={:.0f} "
+            "locked={:.1f}KB uploads={:.1f} uploaded={:.1f}KB filter={}",
+            ms(dev.GetFrameTimeTotal()) / frames, ms(dev.GetFrameTimeMax()), avg(t.m_Draws), avg(t.m_Prims),
+            avg(t.m_States), avg(t.m_StatesSame), avg(t.m_Textures), avg(t.m_Locks), avg(t.m_LockedBytes) / 1024,
+            avg(t.m_Uploads), avg(t.m_UploadBytes) / 1024, g_FilterDevice != NULL ? 1 : 0);
+
+    const CMatrixMapCull &cull = g_MatrixMap->m_Cull;
+    const SCullStats &c = cull.GetTotalStats();
+    auto per = [&cull](int v) { return double(v) / std::max(1, cull.GetFrames()); };
+    line += std::format(" tested={:.0f} frustum={:.0f} occluded={:.0f} groups={:.0f} groupsoccluded={:.0f}",
+                        per(c.m_Tested), per(c.m_FrustumCulled), per(c.m_OcclusionCulled), per(c.m_Groups),
+                        per(c.m_GroupsOccluded));
+
+    // CPU time of the billboards, per 10k of them
+    const SBillboardStats &bb = CBillboard::GetStats();
+    line += std::format(" billboards={:.0f} bblines={:.0f} bbdraws={:.1f} bbcpu={:.3f}ms/10k",
+                        double(bb.m_Billboards) / frames, double(bb.m_Lines) / frames, double(bb.m_Draws) / frames,
+                        ms(bb.m_Time) * 10000 / std::max<int64_t>(1, bb.m_Billboards + bb.m_Lines));
+
+    // dynamic vertices and indices of all the systems
+    const SStreamRingStats &rs = CStreamRing::GetTotalStats();
+    int ringframes = std::max(1, CStreamRing::GetFrames());
+    line += std::format(" ringvb={:.1f}KB ringib={:.1f}KB ringlocks={:.1f} ringdiscards={:.2f}",
+                        double(rs.m_VBBytes) / 1024 / ringframes, double(rs.m_IBBytes) / 1024 / ringframes,
+                        double(rs.m_Locks) / ringframes, double(rs.m_Discards) / ringframes);
+
+    // CPU time of the debug overlay (run with all of DebugInfo set to fill it) and of the rendered texts
+    const SDIStats &di = g_MatrixMap->m_DI.GetStats();
+    const Text::Stats &ts = Text::GetStats();
+    line += std::format(" dilines={:.1f} dicpu={:.3f} texts={} textscached={} textcpu={:.3f}",
+                        double(di.m_Lines) / std::max<int64_t>(1, di.m_Frames),
+                        ms(di.m_Time) / std::max<int64_t>(1, di.m_Frames), ts.renders, ts.cached, ms(ts.time));
+
+    std::string name = utils::from_wstring(mapname);
+    lgr.info("Map {}, {} frames on the null device: {}")(name, dev.GetFrames(), line);
+
+    std::ofstream out(std::filesystem::path{PathToOutputFiles(FILE_NAME_FRAMESTATS)}, std::ios::app);
+    if (out)
+        out << std::format("{}\t{}\t{}\n", name, dev.GetFrames(), line);
+}
+
 int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPTSTR, int)
 {
     const wchar *cmd = GetCommandLineW();
@@ -83,7 +143,15 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPTSTR, int)
         }
         else
         {
+            // the map is prepared: textures appearing from now on may come in the background
+            g_TextureStream->Start();
             L3GRun();
+            g_TextureStream->Stop();
+
+            if (g_NullDevice)
+            {
+                StoreFrameStats(g_MatrixMap->MapName(), *g_NullDevice);
+            }
         }
 
         timeEndPeriod(1);
@@ -132,6 +200,24 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE, LPTSTR, int)
     return 1;
 }
 
+// Config compiled from the source on a previous run: it is mapped instead of being parsed again
+static std::wstring ConfigImageName(const std::wstring &source, const wchar *part)
+{
+    return std::format(L"{}\\{}.{:X}", PathToOutputFiles(FOLDER_NAME_CACHE), part, std::hash<std::wstring>{}(source));
+}
+
+static void StoreConfigImage(const CBlockPar &bp, const std::wstring &image, const std::wstring &source)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path{image}.parent_path(), ec);
+    try {
+        bp.SaveInImage(image, source);
+    }
+    catch (const CException &ex) {
+        lgr.warning("Failed to store config image: {}")(utils::from_wstring(ex.Info()));
+    }
+}
+
 /**
  * Goes through and initializes all static variables.
  */
@@ -149,6 +235,7 @@ static void static_init(void) {
     CVectorObject::StaticInit();
     CVOShadowProj::StaticInit();
     CVOShadowStencil::StaticInit();
+    CStreamRing::StaticInit();
     CForm::StaticInit();
 
     // Game
@@ -188,7 +275,7 @@ void CGame::Init(HINSTANCE inst, [[maybe_unused]] HWND wnd, const wchar *map,uin
     DCP();
 
     CStorage stor_cfg(g_MatrixHeap);
-    bool stor_cfg_present = false;
+    bool stor_cfg_loaded = false;
     std::wstring stor_cfg_name;
     std::wstring conf_file{FILE_CONFIGURATION_LOCATION}; // generate the .dat file path
 
@@ -199,29 +286,47 @@ void CGame::Init(HINSTANCE inst, [[maybe_unused]] HWND wnd, const wchar *map,uin
     }
     conf_file += FILE_CONFIGURATION;
 
-    if (CFile::FileExist(stor_cfg_name, conf_file.c_str())) {
-        stor_cfg.Load(conf_file.c_str());
-        stor_cfg_present = true;
-    }
+    // the storage is loaded only if a compiled image of it is missing or stale
+    bool stor_cfg_present = CFile::FileExist(stor_cfg_name, conf_file.c_str());
+    auto load_stor_cfg = [&]() {
+        if (!stor_cfg_loaded) {
+            stor_cfg.Load(conf_file.c_str());
+            stor_cfg_loaded = true;
+        }
+    };
+
+    auto cfg_time = std::chrono::steady_clock::now();
+    std::wstring cfg_source = stor_cfg_present ? conf_file : std::wstring{L"cfg\\robots\\data.txt"};
+    std::wstring cfg_image = ConfigImageName(cfg_source, L"data");
 
     g_MatrixData = HNew(g_MatrixHeap) CBlockPar{};
-    if (stor_cfg_present)
+    bool cfg_compiled = g_MatrixData->LoadFromImage(cfg_image);
+    if (!cfg_compiled)
     {
-        stor_cfg.RestoreBlockPar(L"da", *g_MatrixData);
-        // stor_cfg.RestoreBlockPar(L"if", *g_MatrixData);
-        // g_MatrixData->SaveInTextFile(L"bbb.txt");
-
-        if (CFile::FileExist(stor_cfg_name, L"cfg\\robots\\cfg.txt"))
+        if (stor_cfg_present)
+        {
+            load_stor_cfg();
+            stor_cfg.RestoreBlockPar(L"da", *g_MatrixData);
+            // stor_cfg.RestoreBlockPar(L"if", *g_MatrixData);
+            // g_MatrixData->SaveInTextFile(L"bbb.txt");
+        }
+        else
         {
-            CBlockPar *bpc = g_MatrixData->BlockGet(L"Config");
-            bpc->LoadFromTextFile(L"cfg\\robots\\cfg.txt");
+            g_MatrixData->LoadFromTextFile(cfg_source);
         }
+        StoreConfigImage(*g_MatrixData, cfg_image, cfg_source);
     }
-    else
+
+    if (stor_cfg_present && CFile::FileExist(stor_cfg_name, L"cfg\\robots\\cfg.txt"))
     {
-        g_MatrixData->LoadFromTextFile(L"cfg\\robots\\data.txt");
+        CBlockPar *bpc = g_MatrixData->BlockGet(L"Config");
+        bpc->LoadFromTextFile(L"cfg\\robots\\cfg.txt");
     }
 
+    lgr.info("Config loaded in {} us{}")(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - cfg_time).count(),
+        cfg_compiled ? " (compiled image)" : "");
+
     // init menu replaces
     // TODO: extract texts automatically from cfg.
     {
@@ -384,18 +489,25 @@ void CGame::Init(HINSTANCE inst, [[maybe_unused]] HWND wnd, const wchar *map,uin
 
     DCP();
     CBlockPar bpi;
-    if (stor_cfg_present)
+    std::wstring if_source = stor_cfg_present ? conf_file : std::wstring{IF_PATH};
+    std::wstring if_image = ConfigImageName(if_source, L"iface");
+    if (!bpi.LoadFromImage(if_image))
     {
-        stor_cfg.RestoreBlockPar(L"if", bpi);
-    }
-    else
-    {
-        bpi.LoadFromTextFile(IF_PATH);
+        if (stor_cfg_present)
+        {
+            load_stor_cfg();
+            stor_cfg.RestoreBlockPar(L"if", bpi);
+        }
+        else
+        {
+            bpi.LoadFromTextFile(IF_PATH);
 
-        // CStorage stor(g_CacheHeap);
-        // stor.StoreBlockPar(L"if", bpi);
-        // stor.StoreBlockPar(L"da", *g_MatrixData);
-        // stor.Save(FILE_CONFIGURATION, true);
+            // CStorage stor(g_CacheHeap);
+            // stor.StoreBlockPar(L"if", bpi);
+            // stor.StoreBlockPar(L"da", *g_MatrixData);
+            // stor.Save(FILE_CONFIGURATION, true);
+        }
+        StoreConfigImage(bpi, if_image, if_source);
     }
 
     g_ConfigHistory = HNew(g_MatrixHeap) CHistory;
@@ -785,7 +897,9 @@ void CGame::RunGameLoop(CFormMatrixGame *formgame) {
         SETFLAG(g_Flags, GFLAG_APPACTIVE);
         RESETFLAG(g_Flags, GFLAG_EXITLOOP);
 
+        g_TextureStream->Start();
         L3GRun();
+        g_TextureStream->Stop();
     }
     catch (... /*ExceptionHandler(GetExceptionInformation())*/) {
         SETFLAG(g_Flags, GFLAG_EXITLOOP);
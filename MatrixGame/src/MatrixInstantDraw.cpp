@@ -12,13 +12,6 @@ D3D_IB CInstDraw::m_IB;
 int CInstDraw::m_IB_Count;
 
 void CInstDraw::MarkAllBuffersNoNeed(void) {
-    for (int i = 0; i < IDFVF_CNT; ++i) {
-        if (IS_VB(m_FVFs[i].vb)) {
-            DESTROY_VB(m_FVFs[i].vb);
-            m_FVFs[i].cursize = 0;
-        }
-    }
-
     if (IS_IB(m_IB))
         DESTROY_IB(m_IB);
     m_IB_Count = 0;
@@ -26,9 +19,6 @@ void CInstDraw::MarkAllBuffersNoNeed(void) {
 
 void CInstDraw::ClearAll(void) {
     for (int i = 0; i < IDFVF_CNT; ++i) {
-        if (IS_VB(m_FVFs[i].vb)) {
-            DESTROY_VB(m_FVFs[i].vb);
-        }
         if (m_FVFs[i].sets) {
             for (int s = 0; s < m_FVFs[i].sets_alloc; ++s) {
                 HFree(m_FVFs[i].sets[s].accum, g_MatrixHeap);
@@ -141,10 +131,20 @@ void CInstDraw::AddVerts(void *v, CBaseTexture *tex, DWORD tf) {
     cvb->statistic += 4;
 }
 
-void CInstDraw::DrawFrameBegin(void) {
-    for (int i = 0; i < IDFVF_CNT; ++i) {
-        m_FVFs[i].disp = 0;
+void CInstDraw::AddVertsOrdered(void *v, CBaseTexture *tex, DWORD tf) {
+    SFVF_VB *cvb = m_FVFs + m_Current;
+
+    // the sets are drawn one after another, only the last one may grow
+    for (int i = 0; i < cvb->sets_cnt - 1; ++i) {
+        if (cvb->sets[i].tex == tex && cvb->sets[i].tf_used && cvb->sets[i].tf == tf) {
+            E_FVF fvf = m_Current;
+            ActualDraw();
+            BeginDraw(fvf);
+            break;
+        }
     }
+
+    AddVerts(v, tex, tf);
 }
 
 void CInstDraw::ActualDraw(void) {
@@ -156,28 +156,15 @@ void CInstDraw::ActualDraw(void) {
 
     SFVF_VB *cvb = m_FVFs + m_Current;
 
+    int base;
+    byte *verts;
+
     if (cvb->statistic == 0)
         goto final;
 
-    if (!IS_VB(cvb->vb) || (cvb->statistic + cvb->disp) > cvb->cursize) {
-        cvb->cursize = (cvb->statistic + cvb->disp);
-
-        if (IS_VB(cvb->vb))
-            DESTROY_VB(cvb->vb);
-        CREATE_VB_DYNAMIC(cvb->stride * (cvb->statistic + cvb->disp), cvb->fvf, cvb->vb);
-        if (!IS_VB(cvb->vb)) {
-            cvb->cursize = 0;
-            goto final;
-        }
-    }
-
-    byte *verts;
-    if (cvb->disp == 0) {
-        LOCKP_VB_DYNAMIC(cvb->vb, 0, cvb->stride * cvb->statistic, &verts);
-    }
-    else {
-        LOCKP_VB_NO(cvb->vb, cvb->stride * cvb->disp, cvb->stride * cvb->statistic, &verts);
-    }
+    verts = (byte *)CStreamRing::LockVerts(cvb->statistic, cvb->stride, base);
+    if (verts == NULL)
+        goto final;
 
     for (int i = 0; i < cvb->sets_cnt; ++i) {
         if (cvb->sets[i].accumcnt > cvb->statistic_max_tex) {
@@ -189,7 +176,7 @@ void CInstDraw::ActualDraw(void) {
         verts += sz;
     }
 
-    UNLOCK_VB(cvb->vb);
+    CStreamRing::UnlockVerts();
 
     if (!IS_IB(m_IB) || cvb->statistic_max_tex > m_IB_Count) {
         m_IB_Count = cvb->statistic_max_tex;
@@ -220,7 +207,7 @@ void CInstDraw::ActualDraw(void) {
 
     // draw!
 
-    g_D3DD->SetStreamSource(0, GET_VB(cvb->vb), 0, cvb->stride);
+    CStreamRing::SetStream(cvb->stride);
     ASSERT_DX(g_D3DD->SetIndices(GET_IB(m_IB)));
     g_D3DD->SetFVF(cvb->fvf);
 
@@ -240,14 +227,12 @@ void CInstDraw::ActualDraw(void) {
             }
         }
 
-        g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, cvb->disp + disp, 0, cvb->sets[i].accumcnt, 0,
+        g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, base + disp, 0, cvb->sets[i].accumcnt, 0,
                                      cvb->sets[i].accumcnt / 2);
 
         disp += cvb->sets[i].accumcnt;
     }
 
-    cvb->disp += disp;
-
 final:
     cvb->statistic = 0;
     cvb->statistic_max_tex = 0;
@@ -7,6 +7,7 @@
 #define MATRIX_INSTANT_DRAW_INCLUDE
 
 #include "D3DControl.hpp"
+#include "StreamRing.hpp"
 
 struct SVertBase {};
 
@@ -53,12 +54,9 @@ struct SFVF_VB {
     int stride;
     int statistic;
     int statistic_max_tex;
-    int cursize;  // size of currently allocated VB
-    D3D_VB vb;
     SOneSet *sets;
     int sets_cnt;
     int sets_alloc;
-    int disp;
 };
 
 class CInstDraw : public CMain {
@@ -90,10 +88,11 @@ public:
 #endif
     }
 
-    static void DrawFrameBegin(void);
     static void BeginDraw(E_FVF fvf);
     static void AddVerts(void *v, CBaseTexture *tex);            // add 4 verts
     static void AddVerts(void *v, CBaseTexture *tex, DWORD tf);  // add 4 verts
+    // add 4 verts drawn over all the added before: if they would join an earlier set, the batch is drawn first
+    static void AddVertsOrdered(void *v, CBaseTexture *tex, DWORD tf);
     static void ActualDraw(void);
 
     static void MarkAllBuffersNoNeed(void);
@@ -96,6 +96,10 @@ void CMatrixMapLogic::Clear() {
 
     //	ZoneClear();
     CMatrixMap::Clear();
+
+    m_Influence.Clear();
+    m_Handles.Clear();
+    m_Perception.Clear();
 }
 
 int CMatrixMapLogic::Rnd() {
@@ -120,6 +124,11 @@ double CMatrixMapLogic::RndFloat(double zmin, double zmax) {
 
 void CMatrixMapLogic::GatherInfo(int type) {
     DTRACE();
+    if (type == 0)
+        m_Perception.Build();
+    else if (type == 1)
+        m_Perception.CountRadio();
+
     CMatrixMapStatic *obj = CMatrixMapStatic::GetFirstLogic();
     DCP();
     while (obj) {
@@ -2819,7 +2828,9 @@ void CMatrixMapLogic::Takt(int step) {
 
         if (FLAG(g_MatrixMap->m_Flags, MMFLAG_STAT_DIALOG | MMFLAG_STAT_DIALOG_D)) {
             // stat
-            CBlockPar *repl = g_MatrixData->BlockGet(PAR_REPLACE);
+            static const SBlockParKey key_replace = CBlockPar::Key(PAR_REPLACE);
+            static const SBlockParKey key_side = CBlockPar::Key(L"Side");
+            CBlockPar *repl = g_MatrixData->BlockGet(key_replace);
             std::wstring temp;
             for (int i = 0; i < m_SideCnt; ++i) {
                 CMatrixSideUnit *su = m_Side + i;
@@ -2828,7 +2839,7 @@ void CMatrixMapLogic::Takt(int step) {
                     temp = L"_p_";
                 else {
                     auto par = utils::format(L"%d", su->m_Id);
-                    temp = utils::format(L"_%lc_", g_MatrixData->BlockGet(L"Side")->ParGet(par)[0]);
+                    temp = utils::format(L"_%lc_", g_MatrixData->BlockGet(key_side)->ParGet(par)[0]);
                     utils::to_lower(temp);
                 }
 
@@ -3397,14 +3408,38 @@ void CMatrixMapLogic::physics_process(int step)
     if ((GetTime() - m_GatherInfoLast) > 100) {
         m_GatherInfoLast = GetTime();
 
+        LARGE_INTEGER t1, t2, freq;
+        QueryPerformanceCounter(&t1);
+
         GatherInfo(0);
         GatherInfo(1);
         //        GatherInfo(2);
+
+        if (FLAG(g_Config.m_DIFlags, DI_GATHERINFO)) {
+            QueryPerformanceCounter(&t2);
+            QueryPerformanceFrequency(&freq);
+
+            int robots = 0, enemies = 0;
+            for (CMatrixMapStatic *obj = CMatrixMapStatic::GetFirstLogic(); obj; obj = obj->GetNextLogic()) {
+                if (obj->IsLiveRobot()) {
+                    robots++;
+                    enemies += obj->AsRobot()->GetEnv()->GetEnemyCnt();
+                }
+            }
+            m_DI.T(L"GatherInfo (us)",
+                   utils::format(L"%d (%d robots, %d of %d units looked at)",
+                                 int((t2.QuadPart - t1.QuadPart) * 1000000 / freq.QuadPart), robots,
+                                 m_Perception.GetCheckCnt(), m_Perception.GetEntryCnt())
+                           .c_str());
+            m_DI.T(L"Robot environment (bytes)",
+                   utils::format(L"%d, enemies %d", int(sizeof(CInfo)), enemies).c_str());
+        }
     }
     DCP();
 
 
     CMatrixMapStatic::ProceedLogic(step);
+    m_Influence.Takt(GetTime());
     // int portions = step / LOGIC_TAKT_PERIOD;
     // for (int cnt = 0; cnt < portions; cnt++) {
     //     CMatrixMapStatic::ProceedLogic(LOGIC_TAKT_PERIOD);
@@ -3450,6 +3485,9 @@ void CMatrixMapLogic::physics_process(int step)
     RemoveEffectSpawnerByTime();
     DCP();
 
+    m_Projectiles.Takt(step);
+    DCP();
+
     // SETFLAG(m_Flags,MMFLAG_EFF_TAKT);
     for (PCMatrixEffect e = m_EffectsFirst; e != NULL;) {
 #ifdef DEAD_PTR_SPY_ENABLE
@@ -3612,7 +3650,7 @@ void CMatrixMapLogic::DumpLogic() {
 
                         fprintf(fi, "            m_MapPos=%d,%d    Region=%d\n", robot->GetMapPosX(),
                                 robot->GetMapPosY(), robot->GetRegion());
-                        fprintf(fi, "            m_Environment.m_EnemyCnt=%d\n", env->m_EnemyCnt);
+                        fprintf(fi, "            m_Environment.m_EnemyCnt=%d\n", env->GetEnemyCnt());
                         if (env->m_Place < 0)
                             fprintf(fi, "            m_Environment.m_Place=%d\n", env->m_Place);
                         else
@@ -6,6 +6,9 @@
 #pragma once
 
 #include "MatrixMap.hpp"
+#include "Logic/MatrixInfluence.hpp"
+#include "Logic/MatrixHandle.hpp"
+#include "Logic/MatrixPerception.hpp"
 
 extern CMatrixRobotAI *g_TestRobot;
 extern bool g_TestLocal;
@@ -79,6 +82,10 @@ public:
 
     int m_GatherInfoLast;
 
+    CMatrixInfluenceMap m_Influence;
+    CMatrixHandleTable m_Handles;
+    CMatrixPerceptionGrid m_Perception;
+
 public:
     CMatrixMapLogic(void);
     ~CMatrixMapLogic();
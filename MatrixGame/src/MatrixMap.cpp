@@ -166,6 +166,7 @@ void CMatrixMap::Clear(void) {
 
     // clear effects
 
+    m_Projectiles.Clear();
     while (m_EffectsFirst) {
 #ifdef _DEBUG
         SubEffect(DEBUG_CALL_INFO, m_EffectsFirst);
@@ -601,9 +602,8 @@ float CMatrixMap::GetZLand(double wx, double wy) {
     }
 }
 
+// no DTRACE: the load workers use it
 float CMatrixMap::GetZ(float wx, float wy) {
-    DTRACE();
-
     int x = TruncFloat(wx * INVERT(GLOBAL_SCALE));
     int y = TruncFloat(wy * INVERT(GLOBAL_SCALE));
 
@@ -1327,11 +1327,15 @@ void CMatrixMap::BeforeDraw(void) {
     */
 
     CalcMapGroupVisibility();
+    CalcLandscapeLod();
 
     BeforeDrawLandscape();
     if (CTerSurface::IsSurfacesPresent())
         BeforeDrawLandscapeSurfaces();
 
+    // terrain of the visible groups hides the objects behind it
+    m_Cull.BeginFrame(m_Camera, m_VisibleGroups, m_VisibleGroupsCount, g_Config.m_OcclusionCull);
+
     // build objects sort array
 
     CMatrixMapStatic::SortBegin();
@@ -1341,7 +1345,7 @@ void CMatrixMap::BeforeDraw(void) {
     CMatrixMapGroup **md = m_VisibleGroups;
     while ((cnt--) > 0) {
         if (*(md) != NULL) {
-            (*(md))->SortObjects(m_Camera.GetViewMatrix());
+            (*(md))->SortObjects(m_Camera.GetViewMatrix(), m_Cull.IsOccluded(*md));
             (*(md))->BeforeDrawSurfaces();
         }
         ++md;
@@ -1363,6 +1367,13 @@ void CMatrixMap::BeforeDraw(void) {
 
     if (FLAG(g_Config.m_DIFlags, DI_VISOBJ))
         m_DI.T(L"Visible objects", utils::format(L"%d", CMatrixMapStatic::GetVisObjCnt()).c_str());
+    if (FLAG(g_Config.m_DIFlags, DI_CULL)) {
+        const SCullStats &cs = m_Cull.GetFrameStats();
+        m_DI.T(L"Cull (tested/frustum/occluded, groups occluded)",
+               utils::format(L"%d / %d / %d, %d of %d", cs.m_Tested, cs.m_FrustumCulled, cs.m_OcclusionCulled,
+                             cs.m_GroupsOccluded, cs.m_Groups)
+                       .c_str());
+    }
 
     CMatrixMapStatic::SortEndBeforeDraw();
 
@@ -1378,11 +1389,15 @@ void CMatrixMap::BeforeDraw(void) {
         }
     }
 
+    // the shadow volumes queued by the objects above
+    CVOShadowStencil::BuildAll();
+
     // CVectorObject::m_VB->PrepareAll();
 
     m_Minimap.BeforeDraw();
 
     CBillboard::BeforeDraw();
+    m_Projectiles.BeforeDraw();
     for (PCMatrixEffect e = m_EffectsFirst; e != NULL; e = e->m_Next) {
         e->BeforeDraw();
     }
@@ -1552,16 +1567,18 @@ void CMatrixMap::DrawLandscape(bool all) {
         md = m_Group;
         while (cnt > 0) {
             if ((*md))
-                (*md)->Draw();
+                (*md)->Draw(false);
             md++;
             cnt--;
         }
     }
     else {
+        CMatrixMapGroup::WriteLodIB(m_VisibleGroups, m_VisibleGroupsCount, GetCurrentFrame());
+
         cnt = m_VisibleGroupsCount;
         md = m_VisibleGroups;
         while (cnt > 0) {
-            (*md)->Draw();
+            (*md)->Draw(true);
 
             ///*
 #if DRAW_LANDSCAPE_SETKA == 1
@@ -1920,6 +1937,7 @@ void CMatrixMap::DrawEffects(void) {
 
     // CSortable::SortBegin();
 
+    m_Projectiles.Draw();
     for (PCMatrixEffect e = m_EffectsFirst; e != NULL; e = e->m_Next) {
         e->Draw();
     }
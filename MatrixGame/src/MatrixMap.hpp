@@ -65,11 +65,13 @@
 #include "MatrixWater.hpp"
 #include "MatrixMapTexture.hpp"
 #include "Effects/MatrixEffect.hpp"
+#include "Effects/MatrixProjectile.hpp"
 #include "StringConstants.hpp"
 #include "MatrixMinimap.hpp"
 #include "MatrixConfig.hpp"
 #include "MatrixCursor.hpp"
 #include "MatrixDebugInfo.hpp"
+#include "MatrixMapCull.hpp"
 #include "Logic/MatrixRoadNetwork.hpp"
 #include "DevConsole.hpp"
 #include "MatrixObjectRobot.hpp"
@@ -318,6 +320,7 @@ public:
 
     CDevConsole m_Console;
     CMatrixDebugInfo m_DI;
+    CMatrixMapCull m_Cull;
 
     SRobotWeaponMatrix m_RobotWeaponMatrix[ROBOT_ARMOR_CNT];
 
@@ -346,6 +349,8 @@ public:
     int m_EffectsCnt;
     // CDWORDMap         m_Effects;
 
+    CMatrixProjectiles m_Projectiles;
+
     CEffectSpawner *m_EffectSpawners;
     int m_EffectSpawnersCnt;
 
@@ -461,7 +466,9 @@ public:
     void UnitClear(void);
 
     void UnitInit(int sx, int sy);
-    void PointCalcNormals(int x, int y);
+    // A point without cells around takes the normal of the point above or to the left. If it may not (copy is
+    // false), it is left as it is and false is returned.
+    bool PointCalcNormals(int x, int y, bool copy = true);
 
     void CalcVis(void);  // non realtime function! its updates map data
     // void CalcVisTemp(int from, int to, const D3DXVECTOR3 &ptfrom); // non realtime function! its updates map data
@@ -696,6 +703,8 @@ public:
     float GetGroupMaxZObjRobots(int x, int y);
 
     void CalcMapGroupVisibility(void);
+    // level of detail of the visible groups, see MatrixMapLod.hpp
+    void CalcLandscapeLod(void);
 
     struct SCalcVisRuntime;
 
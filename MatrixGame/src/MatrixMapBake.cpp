@@ -0,0 +1,81 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "MatrixMapBake.hpp"
+#include "MatrixGamePathUtils.hpp"
+#include "StringConstants.hpp"
+#include "Common.hpp"
+#include "CBuf.hpp"
+#include "CException.hpp"
+
+#include <utils.hpp>
+#include <stupid_logger.hpp>
+
+#include <filesystem>
+#include <format>
+
+std::wstring CMatrixMapBake::FileName(const std::wstring &mapname) {
+    std::wstring name{std::filesystem::path{mapname}.filename().native()};
+    return std::format(L"{}\\{}.bake", PathToOutputFiles(FOLDER_NAME_CACHE), name);
+}
+
+void CMatrixMapBake::Load(const std::wstring &mapname, DWORD key, int sizex, int sizey, int groupcnt) {
+    m_FileName = FileName(mapname);
+    m_Header.m_Magic = MAP_BAKE_MAGIC;
+    m_Header.m_Version = MAP_BAKE_VERSION;
+    m_Header.m_Key = key;
+    m_Header.m_SizeX = sizex;
+    m_Header.m_SizeY = sizey;
+    m_Header.m_GroupCnt = groupcnt;
+    m_Header.m_WaterAlphaSize = WATER_ALPHA_SIZE;
+    m_Loaded = false;
+    m_Normals.assign((sizex + 1) * (sizey + 1), D3DXVECTOR3(0, 0, 0));
+    m_Units.assign(sizex * sizey, SMapBakeUnit{});
+    m_WaterAlpha.assign(groupcnt * WATER_ALPHA_SIZE * WATER_ALPHA_SIZE, 0);
+
+    std::error_code ec;
+    if (!std::filesystem::exists(m_FileName, ec))
+        return;
+
+    CBuf buf;
+    try {
+        buf.LoadFromFile(m_FileName);
+    }
+    catch (const CException &) {
+        return;
+    }
+
+    size_t need = sizeof(SMapBakeHeader) + m_Normals.size() * sizeof(D3DXVECTOR3) +
+                  m_Units.size() * sizeof(SMapBakeUnit) + m_WaterAlpha.size();
+    if (buf.Len() != need || memcmp(buf.Get(), &m_Header, sizeof(SMapBakeHeader)) != 0) {
+        lgr.debug("Map bake {} is stale")(utils::from_wstring(m_FileName));
+        return;
+    }
+
+    buf.Pointer(sizeof(SMapBakeHeader));
+    buf.Get(m_Normals.data(), m_Normals.size() * sizeof(D3DXVECTOR3));
+    buf.Get(m_Units.data(), m_Units.size() * sizeof(SMapBakeUnit));
+    buf.Get(m_WaterAlpha.data(), m_WaterAlpha.size());
+    m_Loaded = true;
+
+    lgr.debug("Map bake loaded from {}")(utils::from_wstring(m_FileName));
+}
+
+void CMatrixMapBake::Store(void) const {
+    CBuf buf;
+    buf.Add(&m_Header, sizeof(SMapBakeHeader));
+    buf.Add(m_Normals.data(), m_Normals.size() * sizeof(D3DXVECTOR3));
+    buf.Add(m_Units.data(), m_Units.size() * sizeof(SMapBakeUnit));
+    buf.Add(m_WaterAlpha.data(), m_WaterAlpha.size());
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path{m_FileName}.parent_path(), ec);
+    try {
+        buf.SaveInFile(m_FileName);
+    }
+    catch (const CException &ex) {
+        lgr.warning("Failed to store map bake: {}")(utils::from_wstring(ex.Info()));
+    }
+}
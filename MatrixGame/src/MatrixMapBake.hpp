@@ -0,0 +1,67 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include <d3dx9math.h>
+
+#include <windows.h>
+#include <string>
+#include <vector>
+
+#define MAP_BAKE_MAGIC 0x4B41424D  // "MBAK"
+
+// A bake is only as good as the code which computed it: the version of every baked routine is bumped with a change
+// of the routine, each of them carries a comment pointing here.
+#define MAP_BAKE_NORMALS     2  // CMatrixMap::PointCalcNormals
+#define MAP_BAKE_UNITS       2  // the "units" stage of CMatrixMap::PrepareMap
+#define MAP_BAKE_WATER_ALPHA 2  // CMatrixMapGroup::CalcWaterAlpha
+#define MAP_BAKE_VERSION     ((MAP_BAKE_NORMALS << 16) | (MAP_BAKE_UNITS << 8) | MAP_BAKE_WATER_ALPHA)
+
+// plane coefficients of a unit, see SMatrixMapUnit
+struct SMapBakeUnit {
+    float a1, b1, c1;
+    float a2, b2, c2;
+};
+static_assert(sizeof(SMapBakeUnit) == 6 * sizeof(float));
+
+struct SMapBakeHeader {
+    DWORD m_Magic;
+    DWORD m_Version;
+    DWORD m_Key;  // DATA_UNIQID of the map, CStorage::CalcUniqID for a map without it
+    int m_SizeX, m_SizeY;
+    int m_GroupCnt;
+    DWORD m_WaterAlphaSize;
+};
+
+/**
+ * @brief What PrepareMap derives from the map data, kept in a file next to the other caches.
+ *
+ * The file is keyed by the id of the map and by MAP_BAKE_VERSION, so it is used only for the same map
+ * loaded by the same version of the baked routines. On a hit the stages copy the baked data instead of computing
+ * it, on a miss they fill it in and it is stored after the load.
+ *
+ * The zone and region tables are not here: the editor compiles them into the map (DATA_ROADS) and the load only
+ * reads them, CMatrixRoadNetwork::InitPL then sorts the places by the cells and renumbers them in the regions.
+ */
+class CMatrixMapBake {
+    std::wstring m_FileName;
+    SMapBakeHeader m_Header{};
+    bool m_Loaded{false};
+
+public:
+    std::vector<D3DXVECTOR3> m_Normals;  // of the points
+    std::vector<SMapBakeUnit> m_Units;   // before the bridges are set
+    std::vector<BYTE> m_WaterAlpha;      // WATER_ALPHA_SIZE x WATER_ALPHA_SIZE for every group
+
+    // the key is the id of the map, sizes are in units and groups
+    void Load(const std::wstring &mapname, DWORD key, int sizex, int sizey, int groupcnt);
+    void Store(void) const;
+
+    bool IsLoaded(void) const { return m_Loaded; }
+    DWORD GetKey(void) const { return m_Header.m_Key; }
+
+    static std::wstring FileName(const std::wstring &mapname);
+};
@@ -0,0 +1,433 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "MatrixMapCull.hpp"
+#include "MatrixMap.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#ifdef CULL_SSE2
+#include <emmintrin.h>
+#endif
+
+#define CULL_STACK 64  // enough for 2^20 groups per side
+
+void CMatrixMapCull::Clear(void) {
+    m_Nodes.clear();
+    m_Occluder.clear();
+    m_GroupX = m_GroupY = 0;
+    m_OccluderX = m_OccluderY = 0;
+    m_DepthReady = false;
+}
+
+int CMatrixMapCull::BuildNode(int x0, int y0, int x1, int y1) {
+    int no = int(m_Nodes.size());
+    SNode &n = m_Nodes.emplace_back();
+    n.m_X0 = x0;
+    n.m_Y0 = y0;
+    n.m_X1 = x1;
+    n.m_Y1 = y1;
+    // whole cells, the water of the edge groups is checked over the whole cell too
+    n.m_Min[0] = x0 * float(MAP_GROUP_SIZE * GLOBAL_SCALE);
+    n.m_Min[1] = y0 * float(MAP_GROUP_SIZE * GLOBAL_SCALE);
+    n.m_Max[0] = x1 * float(MAP_GROUP_SIZE * GLOBAL_SCALE);
+    n.m_Max[1] = y1 * float(MAP_GROUP_SIZE * GLOBAL_SCALE);
+    n.m_Min[2] = 0;
+    n.m_Max[2] = 0;
+    n.m_Child[0] = n.m_Child[1] = n.m_Child[2] = n.m_Child[3] = -1;
+
+    if (x1 - x0 <= 1 && y1 - y0 <= 1)
+        return no;
+
+    int xm = (x1 - x0 > 1) ? (x0 + x1) / 2 : x1;
+    int ym = (y1 - y0 > 1) ? (y0 + y1) / 2 : y1;
+    const int rects[4][4] = {{x0, y0, xm, ym}, {xm, y0, x1, ym}, {x0, ym, xm, y1}, {xm, ym, x1, y1}};
+
+    int c = 0;
+    for (const int *r : rects) {
+        if (r[0] >= r[2] || r[1] >= r[3])
+            continue;
+        int child = BuildNode(r[0], r[1], r[2], r[3]);
+        m_Nodes[no].m_Child[c++] = child;  // n is not valid after the vector grows
+    }
+    return no;
+}
+
+void CMatrixMapCull::Build(float bottom) {
+    DTRACE();
+
+    Clear();
+
+    m_GroupX = g_MatrixMap->m_GroupSize.x;
+    m_GroupY = g_MatrixMap->m_GroupSize.y;
+    if (m_GroupX <= 0 || m_GroupY <= 0)
+        return;
+
+    m_Nodes.reserve(m_GroupX * m_GroupY * 2);
+    BuildNode(0, 0, m_GroupX, m_GroupY);
+
+    // occluders: columns under the lowest point of the cells fully covered by the land
+    const CPoint &size = g_MatrixMap->m_Size;
+    m_OccluderX = (size.x + CULL_OCCLUDER_CELL - 1) / CULL_OCCLUDER_CELL;
+    m_OccluderY = (size.y + CULL_OCCLUDER_CELL - 1) / CULL_OCCLUDER_CELL;
+    m_Occluder.assign(m_OccluderX * m_OccluderY, CULL_NO_OCCLUDER);
+    m_Bottom = bottom - CULL_OCCLUDER_BIAS;
+
+    for (int cy = 0; cy < m_OccluderY; ++cy) {
+        for (int cx = 0; cx < m_OccluderX; ++cx) {
+            int x0 = cx * CULL_OCCLUDER_CELL;
+            int y0 = cy * CULL_OCCLUDER_CELL;
+            int x1 = std::min(x0 + CULL_OCCLUDER_CELL, size.x);
+            int y1 = std::min(y0 + CULL_OCCLUDER_CELL, size.y);
+
+            bool solid = true;
+            for (int y = y0; y < y1 && solid; ++y) {
+                for (int x = x0; x < x1; ++x) {
+                    SMatrixMapUnit *mu = g_MatrixMap->UnitGet(x, y);
+                    if (!mu->IsLand() || mu->IsBridge()) {
+                        solid = false;
+                        break;
+                    }
+                }
+            }
+            if (!solid)
+                continue;
+
+            float z = FLT_MAX;
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    z = std::min(z, g_MatrixMap->PointGet(x, y)->z);
+                }
+            }
+            m_Occluder[cx + cy * m_OccluderX] = z - CULL_OCCLUDER_BIAS;
+        }
+    }
+}
+
+void CMatrixMapCull::Refit(void) {
+    // children are after their parent
+    for (int i = int(m_Nodes.size()) - 1; i >= 0; --i) {
+        SNode &n = m_Nodes[i];
+        if (n.m_Child[0] < 0) {
+            CMatrixMapGroup *g = g_MatrixMap->m_Group[n.m_X0 + n.m_Y0 * m_GroupX];
+            if (g == NULL) {
+                n.m_Min[2] = FLT_MAX;
+                n.m_Max[2] = -FLT_MAX;
+            }
+            else {
+                n.m_Min[2] = std::min(g->GetMinZ(), WATER_LEVEL);
+                n.m_Max[2] = std::max(g->GetMaxZObjRobots(), WATER_LEVEL);
+            }
+            continue;
+        }
+
+        n.m_Min[2] = FLT_MAX;
+        n.m_Max[2] = -FLT_MAX;
+        for (int c = 0; c < 4 && n.m_Child[c] >= 0; ++c) {
+            const SNode &child = m_Nodes[n.m_Child[c]];
+            n.m_Min[2] = std::min(n.m_Min[2], child.m_Min[2]);
+            n.m_Max[2] = std::max(n.m_Max[2], child.m_Max[2]);
+        }
+    }
+}
+
+int CMatrixMapCull::TestNode(const SNode &node, const SPlanes &planes) {
+    // a box is out of a plane if its vertex farthest along the normal is out
+#ifdef CULL_SSE2
+    const __m128 cx = _mm_set1_ps(0.5f * (node.m_Min[0] + node.m_Max[0]));
+    const __m128 cy = _mm_set1_ps(0.5f * (node.m_Min[1] + node.m_Max[1]));
+    const __m128 cz = _mm_set1_ps(0.5f * (node.m_Min[2] + node.m_Max[2]));
+    const __m128 ex = _mm_set1_ps(0.5f * (node.m_Max[0] - node.m_Min[0]));
+    const __m128 ey = _mm_set1_ps(0.5f * (node.m_Max[1] - node.m_Min[1]));
+    const __m128 ez = _mm_set1_ps(0.5f * (node.m_Max[2] - node.m_Min[2]));
+    const __m128 abs = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 nx = _mm_loadu_ps(planes.m_X);
+    __m128 ny = _mm_loadu_ps(planes.m_Y);
+    __m128 nz = _mm_loadu_ps(planes.m_Z);
+
+    __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+                             _mm_add_ps(_mm_mul_ps(nz, cz), _mm_loadu_ps(planes.m_D)));
+    __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(nx, abs), ex), _mm_mul_ps(_mm_and_ps(ny, abs), ey)),
+                          _mm_mul_ps(_mm_and_ps(nz, abs), ez));
+
+    if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, r), zero)) != 0)
+        return 0;
+    if (_mm_movemask_ps(_mm_cmpge_ps(_mm_sub_ps(dist, r), zero)) == 15)
+        return 2;
+    return 1;
+#else
+    float c[3], e[3];
+    for (int k = 0; k < 3; ++k) {
+        c[k] = 0.5f * (node.m_Min[k] + node.m_Max[k]);
+        e[k] = 0.5f * (node.m_Max[k] - node.m_Min[k]);
+    }
+
+    int inside = 0;
+    for (int i = 0; i < 4; ++i) {
+        float dist = planes.m_X[i] * c[0] + planes.m_Y[i] * c[1] + planes.m_Z[i] * c[2] + planes.m_D[i];
+        float r = fabs(planes.m_X[i]) * e[0] + fabs(planes.m_Y[i]) * e[1] + fabs(planes.m_Z[i]) * e[2];
+        if (dist + r < 0)
+            return 0;
+        if (dist - r >= 0)
+            ++inside;
+    }
+    return inside == 4 ? 2 : 1;
+#endif
+}
+
+bool CMatrixMapCull::HasPoint(const SNode &node, const D3DXVECTOR2 *pts, int ptscnt) {
+    for (int i = 0; i < ptscnt; ++i) {
+        if (pts[i].x >= node.m_Min[0] && pts[i].x < node.m_Max[0] && pts[i].y >= node.m_Min[1] &&
+            pts[i].y < node.m_Max[1])
+            return true;
+    }
+    return false;
+}
+
+void CMatrixMapCull::CollectGroups(const CMatrixCamera &cam, int x0, int y0, int x1, int y1, const D3DXVECTOR2 *pts,
+                                   int ptscnt, const std::function<void(CMatrixMapGroup *g, int x, int y)> &visit) {
+    if (m_Nodes.empty())
+        return;
+
+    Refit();
+
+    SPlanes planes;
+    const SPlane *src[4] = {&cam.GetFrustPlaneL(), &cam.GetFrustPlaneR(), &cam.GetFrustPlaneT(),
+                            &cam.GetFrustPlaneB()};
+    for (int i = 0; i < 4; ++i) {
+        planes.m_X[i] = src[i]->norm.x;
+        planes.m_Y[i] = src[i]->norm.y;
+        planes.m_Z[i] = src[i]->norm.z;
+        planes.m_D[i] = src[i]->dist;
+    }
+
+    struct SItem {
+        int m_Node;
+        bool m_Inside;  // the parent is inside all the planes
+    };
+    SItem stack[CULL_STACK];
+    int sp = 0;
+    stack[sp++] = {0, false};
+
+    while (sp > 0) {
+        SItem item = stack[--sp];
+        const SNode &n = m_Nodes[item.m_Node];
+
+        if (n.m_X1 <= x0 || n.m_X0 > x1 || n.m_Y1 <= y0 || n.m_Y0 > y1)
+            continue;
+        if (n.m_Min[2] > n.m_Max[2])
+            continue;  // no groups
+
+        bool inside = item.m_Inside;
+        if (!inside) {
+            int side = TestNode(n, planes);
+            // a group with a corner of the visible area in it is taken without the frustum check
+            if (side == 0 && !HasPoint(n, pts, ptscnt))
+                continue;
+            inside = (side == 2);
+        }
+
+        if (n.m_Child[0] < 0) {
+            CMatrixMapGroup *g = g_MatrixMap->m_Group[n.m_X0 + n.m_Y0 * m_GroupX];
+            if (g != NULL)
+                visit(g, n.m_X0, n.m_Y0);
+            continue;
+        }
+
+        // reversed, so the children are visited in order
+        for (int c = 3; c >= 0; --c) {
+            if (n.m_Child[c] < 0)
+                continue;
+            ASSERT(sp < CULL_STACK);
+            stack[sp++] = {n.m_Child[c], inside};
+        }
+    }
+}
+
+void CMatrixMapCull::RasterizeTriangle(const D3DXVECTOR4 &v0, const D3DXVECTOR4 &v1, const D3DXVECTOR4 &v2) {
+    const D3DXVECTOR4 *v[3] = {&v0, &v1, &v2};
+    float sx[3], sy[3];
+    float zmax = 0;
+    for (int i = 0; i < 3; ++i) {
+        float inv = 1.0f / v[i]->w;
+        sx[i] = (v[i]->x * inv * 0.5f + 0.5f) * CULL_DEPTH_W;
+        sy[i] = (0.5f - v[i]->y * inv * 0.5f) * CULL_DEPTH_H;
+        zmax = std::max(zmax, v[i]->w);
+    }
+
+    float area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sy[1] - sy[0]) * (sx[2] - sx[0]);
+    if (fabs(area) < 0.0001f)
+        return;
+    float sign = area > 0 ? 1.0f : -1.0f;
+
+    // edge functions, positive inside
+    float a[3], b[3], c[3];
+    for (int i = 0; i < 3; ++i) {
+        int j = (i + 1) % 3;
+        a[i] = -(sy[j] - sy[i]) * sign;
+        b[i] = (sx[j] - sx[i]) * sign;
+        c[i] = -(a[i] * sx[i] + b[i] * sy[i]);
+    }
+
+    // pixel centers, the shared edges of the neighbour faces leave no gaps;
+    // the depth is the farthest of the triangle, so it is never nearer than the occluder
+    int px0 = std::max(0, int(ceilf(std::min({sx[0], sx[1], sx[2]}) - 0.5f)));
+    int py0 = std::max(0, int(ceilf(std::min({sy[0], sy[1], sy[2]}) - 0.5f)));
+    int px1 = std::min(CULL_DEPTH_W - 1, int(floorf(std::max({sx[0], sx[1], sx[2]}) - 0.5f)));
+    int py1 = std::min(CULL_DEPTH_H - 1, int(floorf(std::max({sy[0], sy[1], sy[2]}) - 0.5f)));
+
+    for (int py = py0; py <= py1; ++py) {
+        float *depth = m_Depth + py * CULL_DEPTH_W;
+        float y = py + 0.5f;
+        for (int px = px0; px <= px1; ++px) {
+            float x = px + 0.5f;
+            if (a[0] * x + b[0] * y + c[0] < 0 || a[1] * x + b[1] * y + c[1] < 0 || a[2] * x + b[2] * y + c[2] < 0)
+                continue;
+            if (zmax < depth[px])
+                depth[px] = zmax;
+        }
+    }
+}
+
+void CMatrixMapCull::RasterizeQuad(const D3DXVECTOR3 &p0, const D3DXVECTOR3 &p1, const D3DXVECTOR3 &p2,
+                                   const D3DXVECTOR3 &p3) {
+    D3DXVECTOR4 v[4];
+    D3DXVec3Transform(v + 0, &p0, &m_ViewProj);
+    D3DXVec3Transform(v + 1, &p1, &m_ViewProj);
+    D3DXVec3Transform(v + 2, &p2, &m_ViewProj);
+    D3DXVec3Transform(v + 3, &p3, &m_ViewProj);
+
+    // no clipping: an occluder crossing the near plane is just not used
+    for (int i = 0; i < 4; ++i) {
+        if (v[i].w < CULL_NEAR)
+            return;
+    }
+
+    RasterizeTriangle(v[0], v[1], v[2]);
+    RasterizeTriangle(v[0], v[2], v[3]);
+}
+
+void CMatrixMapCull::RasterizeCell(int x, int y, const D3DXVECTOR3 &eye) {
+    float z = GetOccluder(x, y);
+    if (z == CULL_NO_OCCLUDER)
+        return;
+
+    float x0 = float(x * CULL_OCCLUDER_CELL * GLOBAL_SCALE);
+    float y0 = float(y * CULL_OCCLUDER_CELL * GLOBAL_SCALE);
+    float x1 = float(std::min((x + 1) * CULL_OCCLUDER_CELL, g_MatrixMap->m_Size.x) * GLOBAL_SCALE);
+    float y1 = float(std::min((y + 1) * CULL_OCCLUDER_CELL, g_MatrixMap->m_Size.y) * GLOBAL_SCALE);
+
+    // only the faces turned to the camera
+    if (eye.z > z) {
+        RasterizeQuad(D3DXVECTOR3(x0, y0, z), D3DXVECTOR3(x1, y0, z), D3DXVECTOR3(x1, y1, z), D3DXVECTOR3(x0, y1, z));
+    }
+
+    // the sides are down to the neighbour column, below it they are inside the solid
+    auto side = [this, z](int nx, int ny) {
+        float zn = GetOccluder(nx, ny);
+        return zn == CULL_NO_OCCLUDER ? m_Bottom : zn;
+    };
+
+    float zn;
+    if (eye.x < x0 && (zn = side(x - 1, y)) < z) {
+        RasterizeQuad(D3DXVECTOR3(x0, y0, zn), D3DXVECTOR3(x0, y1, zn), D3DXVECTOR3(x0, y1, z), D3DXVECTOR3(x0, y0, z));
+    }
+    if (eye.x > x1 && (zn = side(x + 1, y)) < z) {
+        RasterizeQuad(D3DXVECTOR3(x1, y0, zn), D3DXVECTOR3(x1, y1, zn), D3DXVECTOR3(x1, y1, z), D3DXVECTOR3(x1, y0, z));
+    }
+    if (eye.y < y0 && (zn = side(x, y - 1)) < z) {
+        RasterizeQuad(D3DXVECTOR3(x0, y0, zn), D3DXVECTOR3(x1, y0, zn), D3DXVECTOR3(x1, y0, z), D3DXVECTOR3(x0, y0, z));
+    }
+    if (eye.y > y1 && (zn = side(x, y + 1)) < z) {
+        RasterizeQuad(D3DXVECTOR3(x0, y1, zn), D3DXVECTOR3(x1, y1, zn), D3DXVECTOR3(x1, y1, z), D3DXVECTOR3(x0, y1, z));
+    }
+}
+
+void CMatrixMapCull::BeginFrame(const CMatrixCamera &cam, CMatrixMapGroup *const *groups, int cnt, bool occlusion) {
+    m_Frame = SCullStats{};
+    m_Frame.m_Groups = cnt;
+    m_Total.m_Groups += cnt;
+    ++m_Frames;
+
+    m_DepthReady = false;
+    if (!occlusion || m_Occluder.empty())
+        return;
+
+    m_ViewProj = cam.GetViewMatrix() * cam.GetProjMatrix();
+    std::fill(m_Depth, m_Depth + CULL_DEPTH_W * CULL_DEPTH_H, FLT_MAX);
+
+    const D3DXVECTOR3 &eye = cam.GetFrustumCenter();
+    const int cells = MAP_GROUP_SIZE / CULL_OCCLUDER_CELL;
+    for (int i = 0; i < cnt; ++i) {
+        if (groups[i] == NULL)
+            continue;
+        int cx = Float2Int(groups[i]->GetPos0().x * INVERT(GLOBAL_SCALE)) / CULL_OCCLUDER_CELL;
+        int cy = Float2Int(groups[i]->GetPos0().y * INVERT(GLOBAL_SCALE)) / CULL_OCCLUDER_CELL;
+        for (int y = cy; y < cy + cells; ++y) {
+            for (int x = cx; x < cx + cells; ++x) {
+                RasterizeCell(x, y, eye);
+            }
+        }
+    }
+
+    m_DepthReady = true;
+}
+
+bool CMatrixMapCull::IsOccluded(const D3DXVECTOR3 &mins, const D3DXVECTOR3 &maxs) const {
+    if (!m_DepthReady)
+        return false;
+
+    float minx = FLT_MAX, miny = FLT_MAX, maxx = -FLT_MAX, maxy = -FLT_MAX;
+    float zmin = FLT_MAX;
+    for (int i = 0; i < 8; ++i) {
+        D3DXVECTOR3 p((i & 1) ? maxs.x : mins.x, (i & 2) ? maxs.y : mins.y, (i & 4) ? maxs.z : mins.z);
+        D3DXVECTOR4 v;
+        D3DXVec3Transform(&v, &p, &m_ViewProj);
+        if (v.w < CULL_NEAR)
+            return false;
+
+        float inv = 1.0f / v.w;
+        float sx = (v.x * inv * 0.5f + 0.5f) * CULL_DEPTH_W;
+        float sy = (0.5f - v.y * inv * 0.5f) * CULL_DEPTH_H;
+        minx = std::min(minx, sx);
+        maxx = std::max(maxx, sx);
+        miny = std::min(miny, sy);
+        maxy = std::max(maxy, sy);
+        zmin = std::min(zmin, v.w);
+    }
+
+    // one more pixel around: the occluders cover the pixels by the centers.
+    // The part out of the screen is out of the frustum as well.
+    int px0 = std::max(0, int(floorf(minx)) - 1);
+    int py0 = std::max(0, int(floorf(miny)) - 1);
+    int px1 = std::min(CULL_DEPTH_W - 1, int(floorf(maxx)) + 1);
+    int py1 = std::min(CULL_DEPTH_H - 1, int(floorf(maxy)) + 1);
+    if (px0 > px1 || py0 > py1)
+        return false;
+
+    for (int py = py0; py <= py1; ++py) {
+        const float *depth = m_Depth + py * CULL_DEPTH_W;
+        for (int px = px0; px <= px1; ++px) {
+            if (depth[px] >= zmin)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool CMatrixMapCull::IsOccluded(const CMatrixMapGroup *g) {
+    D3DXVECTOR3 mins(g->GetPos0().x, g->GetPos0().y, g->GetMinZ());
+    D3DXVECTOR3 maxs(g->GetPos1().x, g->GetPos1().y, g->GetMaxZObjRobots());
+    if (!IsOccluded(mins, maxs))
+        return false;
+
+    ++m_Frame.m_GroupsOccluded;
+    ++m_Total.m_GroupsOccluded;
+    return true;
+}
@@ -0,0 +1,129 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include <d3dx9math.h>
+
+#include <windows.h>
+#include <functional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULL_SSE2
+#endif
+
+#define CULL_DEPTH_W        128                   // occlusion buffer size, it covers the whole screen
+#define CULL_DEPTH_H        64
+#define CULL_NEAR           1.0f                  // occluders and objects nearer than that are not used
+#define CULL_OCCLUDER_CELL  (MAP_GROUP_SIZE / 2)  // units per occluder side
+#define CULL_OCCLUDER_BIAS  1.0f                  // occluders are lowered by that, "down" units are lower a bit
+#define CULL_NO_OCCLUDER    (-1e30f)
+
+class CMatrixMapGroup;
+class CMatrixCamera;
+
+// per frame, the objects are counted by CMatrixMapStatic::Sort
+struct SCullStats {
+    int m_Tested;           // objects checked for visibility
+    int m_FrustumCulled;    // outside the frustum
+    int m_OcclusionCulled;  // inside the frustum but behind the terrain
+    int m_Groups;           // map groups passed the frustum
+    int m_GroupsOccluded;   // of them hidden behind the terrain, their objects (except flyers) were not checked
+};
+
+/**
+ * @brief Two level culling of the map: a quadtree over the map groups and a coarse occlusion buffer.
+ *
+ * The quadtree nodes hold the bounds of the groups below them (the heights are refit every frame, objects move),
+ * so whole parts of the map outside the frustum are dropped without looking at their groups.
+ *
+ * The occlusion buffer is a small depth buffer the terrain of the visible groups is rasterized into on the CPU.
+ * Terrain is a height field, so the column under the lowest point of a cell is solid: occluders are such columns,
+ * written with the farthest depth of every face, and can not hide anything which is really visible (up to a pixel
+ * of the buffer, the tested rectangles are grown by one). Objects and groups (bounded by RecalcMaxZ) are tested
+ * with their nearest depth over the screen rectangle they cover.
+ */
+class CMatrixMapCull {
+    struct SNode {
+        float m_Min[3], m_Max[3];
+        int m_X0, m_Y0, m_X1, m_Y1;  // groups, [x0, x1) x [y0, y1)
+        int m_Child[4];              // -1 if none; a leaf has no children
+    };
+
+    // frustum planes in SoA layout, the four of them are tested at once
+    struct SPlanes {
+        float m_X[4], m_Y[4], m_Z[4], m_D[4];
+    };
+
+    std::vector<SNode> m_Nodes;  // preorder, the root is the first
+    int m_GroupX{0}, m_GroupY{0};
+
+    std::vector<float> m_Occluder;  // lowest point of every occluder cell or CULL_NO_OCCLUDER
+    int m_OccluderX{0}, m_OccluderY{0};
+    float m_Bottom{0};  // sides of the columns go down to it
+
+    D3DXMATRIX m_ViewProj;
+    float m_Depth[CULL_DEPTH_W * CULL_DEPTH_H];
+    bool m_DepthReady{false};
+
+    SCullStats m_Frame{};
+    SCullStats m_Total{};
+    int m_Frames{0};
+
+    int BuildNode(int x0, int y0, int x1, int y1);
+
+    // 0 - outside, 1 - intersects, 2 - inside all the planes
+    static int TestNode(const SNode &node, const SPlanes &planes);
+    static bool HasPoint(const SNode &node, const D3DXVECTOR2 *pts, int ptscnt);
+    void Refit(void);
+
+    void RasterizeQuad(const D3DXVECTOR3 &p0, const D3DXVECTOR3 &p1, const D3DXVECTOR3 &p2, const D3DXVECTOR3 &p3);
+    void RasterizeTriangle(const D3DXVECTOR4 &v0, const D3DXVECTOR4 &v1, const D3DXVECTOR4 &v2);
+    void RasterizeCell(int x, int y, const D3DXVECTOR3 &eye);
+    float GetOccluder(int x, int y) const {
+        if (x < 0 || y < 0 || x >= m_OccluderX || y >= m_OccluderY)
+            return CULL_NO_OCCLUDER;
+        return m_Occluder[x + y * m_OccluderX];
+    }
+
+public:
+    void Clear(void);
+    // after the map groups and points are ready; bottom is the lowest point of the map
+    void Build(float bottom);
+    bool IsEmpty(void) const { return m_Nodes.empty(); }
+
+    // visits groups of [x0, x1] x [y0, y1] which may be in the frustum of the camera, or contain one of the points
+    void CollectGroups(const CMatrixCamera &cam, int x0, int y0, int x1, int y1, const D3DXVECTOR2 *pts, int ptscnt,
+                       const std::function<void(CMatrixMapGroup *g, int x, int y)> &visit);
+
+    // starts counting the frame and fills the occlusion buffer with the terrain of the visible groups;
+    // without occlusion nothing is reported as occluded
+    void BeginFrame(const CMatrixCamera &cam, CMatrixMapGroup *const *groups, int cnt, bool occlusion);
+
+    bool IsOccluded(const D3DXVECTOR3 &mins, const D3DXVECTOR3 &maxs) const;
+    bool IsOccluded(const D3DXVECTOR3 &center, float radius) const {
+        return IsOccluded(center - D3DXVECTOR3(radius, radius, radius), center + D3DXVECTOR3(radius, radius, radius));
+    }
+    // all the objects of the group (except flyers) are below its RecalcMaxZ height
+    bool IsOccluded(const CMatrixMapGroup *g);
+
+    void CountTested(void) {
+        ++m_Frame.m_Tested;
+        ++m_Total.m_Tested;
+    }
+    void CountFrustumCulled(void) {
+        ++m_Frame.m_FrustumCulled;
+        ++m_Total.m_FrustumCulled;
+    }
+    void CountOcclusionCulled(void) {
+        ++m_Frame.m_OcclusionCulled;
+        ++m_Total.m_OcclusionCulled;
+    }
+
+    const SCullStats &GetFrameStats(void) const { return m_Frame; }
+    const SCullStats &GetTotalStats(void) const { return m_Total; }
+    int GetFrames(void) const { return m_Frames; }
+};
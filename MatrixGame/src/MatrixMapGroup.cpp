@@ -7,11 +7,13 @@
 
 #include "MatrixMap.hpp"
 #include "MatrixMapGroup.hpp"
+#include "MatrixMapLod.hpp"
 #include "MatrixObject.hpp"
 #include "MatrixRobot.hpp"
 #include "MatrixRenderPipeline.hpp"
 #include "MatrixTerSurface.hpp"
 #include "MatrixShadowManager.hpp"
+#include "StreamRing.hpp"
 
 //#define DRAW_GROUP_BBOX
 
@@ -87,6 +89,11 @@ void CMatrixMapGroup::Clear(void) {
         m_BottomGeometryCount = 0;
     }
 
+    if (m_Lod) {
+        HDelete(SBottomLod, m_Lod, g_MatrixHeap);
+        m_Lod = NULL;
+    }
+
     if (m_Surfaces) {
         HFree(m_Surfaces, g_MatrixHeap);
         m_Surfaces = NULL;
@@ -199,6 +206,46 @@ bool CMatrixMapGroup::IsInFrustum(void) const {
     // return g_MatrixMap->IsInFrustum((mins+maxs) * 0.5f);
 }
 
+void CMatrixMapGroup::BottomPoint(SMatrixMapVertexBottom &v, int px, int py) const {
+    int w = std::min(MAP_GROUP_SIZE, (g_MatrixMap->m_Size.x - m_PosX));
+    int h = std::min(MAP_GROUP_SIZE, (g_MatrixMap->m_Size.y - m_PosY));
+
+    SMatrixMapPoint *mp = g_MatrixMap->PointGet(px, py);
+
+    bool down = (mp->color & 0x80000000) != 0;
+
+    while (!down && px >= 1 && py >= 1 && px < g_MatrixMap->m_Size.x && py < g_MatrixMap->m_Size.y) {
+        SMatrixMapUnit *mu = g_MatrixMap->UnitGet(px, py);
+        if (!mu->IsDown())
+            break;
+        if (!(mu - 1)->IsDown())
+            break;
+        if (!(mu - 1 - g_MatrixMap->m_Size.x)->IsDown())
+            break;
+        if (!(mu - g_MatrixMap->m_Size.x)->IsDown())
+            break;
+        down = true;
+        mp->color |= 0x80000000;
+        break;
+    }
+
+    v.ivd.v.x = (px - m_PosX - (w >> 1)) * GLOBAL_SCALE;
+    v.ivd.v.y = (py - m_PosY - (h >> 1)) * GLOBAL_SCALE;
+    v.ivd.v.z = mp->z;  // + downz;
+
+    if (down) {
+        v.ivd.v -= mp->n * 0.5f;
+    }
+
+    v.ivd.defcol = mp->color;
+#ifdef LANDSCAPE_BOTTOM_USE_NORMALES
+    v.ivd.n = mp->n;
+#endif
+    const float macrotexturestep = 1.0f / g_MatrixMap->m_MacrotextureSize;
+    v.tc[1].u = macrotexturestep * px;
+    v.tc[1].v = macrotexturestep * py;
+}
+
 void CMatrixMapGroup::BuildBottom(int x, int y, BYTE *rawbottom) {
     DTRACE();
 
@@ -222,8 +269,6 @@ void CMatrixMapGroup::BuildBottom(int x, int y, BYTE *rawbottom) {
     m_maxz = -10000.0;
     m_minz = 10000.0;
 
-    const float macrotexturestep = 1.0f / g_MatrixMap->m_MacrotextureSize;
-
     m_IdxsSource_bottom.size = 0;
     m_IdxsSource_bottom.inds = NULL;
 
@@ -274,53 +319,31 @@ void CMatrixMapGroup::BuildBottom(int x, int y, BYTE *rawbottom) {
     m_VertsSource_bottom.size = vertcnt * sizeof(SMatrixMapVertexBottom);
     m_VertsSource_bottom.verts = (SMatrixMapVertexBottom *)HAlloc(m_VertsSource_bottom.size, g_MatrixHeap);
 
+    // grid points of the vertices, for the LOD
+    std::vector<int> gx(vertcnt), gy(vertcnt);
+
     static const double ts_inv = 1.0 / double(TEX_BOTTOM_SIZE * g_MatrixMap->m_TexUnionDim);
 
     for (int i = 0; i < vertcnt; ++i) {
         SCompileBottomVert *v = (SCompileBottomVert *)rawbottom;
         rawbottom += sizeof(SCompileBottomVert);
-        SMatrixMapPoint *mp = g_MatrixMap->PointGet(v->x, v->y);
-
-        bool down = (mp->color & 0x80000000) != 0;
-
-        while (!down && v->x >= 1 && v->y >= 1 && v->x < g_MatrixMap->m_Size.x && v->y < g_MatrixMap->m_Size.y) {
-            SMatrixMapUnit *mu = g_MatrixMap->UnitGet(v->x, v->y);
-            if (!mu->IsDown())
-                break;
-            if (!(mu - 1)->IsDown())
-                break;
-            if (!(mu - 1 - g_MatrixMap->m_Size.x)->IsDown())
-                break;
-            if (!(mu - g_MatrixMap->m_Size.x)->IsDown())
-                break;
-            down = true;
-            mp->color |= 0x80000000;
-            break;
-        }
 
-        m_VertsSource_bottom.verts[i].ivd.v.x = (v->x - x - (w >> 1)) * GLOBAL_SCALE;
-        m_VertsSource_bottom.verts[i].ivd.v.y = (v->y - y - (h >> 1)) * GLOBAL_SCALE;
-        m_VertsSource_bottom.verts[i].ivd.v.z = mp->z;  // + downz;
-
-        if (down) {
-            m_VertsSource_bottom.verts[i].ivd.v -= mp->n * 0.5f;
-        }
-
-        m_VertsSource_bottom.verts[i].ivd.defcol = mp->color;
-#ifdef LANDSCAPE_BOTTOM_USE_NORMALES
-        m_VertsSource_bottom.verts[i].ivd.n = mp->n;
-#endif
+        BottomPoint(m_VertsSource_bottom.verts[i], v->x, v->y);
         m_VertsSource_bottom.verts[i].tc[0].u = float(ts_inv * v->tx);
         m_VertsSource_bottom.verts[i].tc[0].v = float(ts_inv * v->ty);
-        m_VertsSource_bottom.verts[i].tc[1].u = macrotexturestep * v->x;
-        m_VertsSource_bottom.verts[i].tc[1].v = macrotexturestep * v->y;
 
-        if (mp->z < m_minz)
-            m_minz = mp->z;
-        if (mp->z > m_maxz)
-            m_maxz = mp->z;
+        gx[i] = v->x - x;
+        gy[i] = v->y - y;
+
+        float z = g_MatrixMap->PointGet(v->x, v->y)->z;
+        if (z < m_minz)
+            m_minz = z;
+        if (z > m_maxz)
+            m_maxz = z;
     }
 
+    BuildLod(w, h, gx.data(), gy.data());
+
     m_maxz_obj = m_maxz;
     m_maxz_obj_robots = m_maxz;
 
@@ -332,7 +355,59 @@ void CMatrixMapGroup::BuildBottom(int x, int y, BYTE *rawbottom) {
     }
 }
 
-void CMatrixMapGroup::BuildWater(int x, int y) {
+// baked: bump MAP_BAKE_WATER_ALPHA when the result changes
+void CMatrixMapGroup::CalcWaterAlpha(BYTE *alpha) const {
+    if (!HasWater())
+        return;
+
+    const float up_level = -1.0f;
+    const float down_level = -20.1f;
+
+    for (int j = 0; j < WATER_ALPHA_SIZE; ++j) {
+        for (int i = 0; i < WATER_ALPHA_SIZE; ++i) {
+            float wx = (float(i) + 0.5f) * ((float)MAP_GROUP_SIZE * GLOBAL_SCALE / (WATER_ALPHA_SIZE)) + p0.x;
+            float wy = (float(j) + 0.5f) * ((float)MAP_GROUP_SIZE * GLOBAL_SCALE / (WATER_ALPHA_SIZE)) + p0.y;
+
+            float wz;
+
+            float scaledx = wx / GLOBAL_SCALE;
+            float scaledy = wy / GLOBAL_SCALE;
+
+            int ix = TruncFloat(scaledx);
+            int iy = TruncFloat(scaledy);
+
+            SMatrixMapUnit *un = g_MatrixMap->UnitGetTest(ix, iy);
+            if (un != NULL && un->IsBridge()) {
+                float kx = scaledx - float(ix);
+                float ky = scaledy - float(iy);
+
+                SMatrixMapPoint *mp = g_MatrixMap->PointGet(ix, iy);
+
+                float z0 = mp->z;
+                float z1 = (mp + 1)->z;
+                float z2 = (mp + g_MatrixMap->m_Size.x + 1)->z;
+                float z3 = (mp + g_MatrixMap->m_Size.x + 2)->z;
+
+                wz = LERPFLOAT(ky, LERPFLOAT(kx, z0, z1), LERPFLOAT(kx, z2, z3));
+            }
+            else {
+                wz = g_MatrixMap->GetZ(wx, wy);
+            }
+
+            byte zz;
+            if (wz < down_level)
+                zz = 255;
+            else if (wz > up_level)
+                zz = 0;
+            else
+                zz = BYTE(255 - int(((wz - down_level) / (up_level - down_level) * 255.0f)));
+
+            alpha[j * WATER_ALPHA_SIZE + i] = zz;
+        }
+    }
+}
+
+void CMatrixMapGroup::BuildWater(int x, int y, const BYTE *alpha) {
     if (HasWater()) {
         x *= MAP_GROUP_SIZE;
         y *= MAP_GROUP_SIZE;
@@ -340,8 +415,6 @@ void CMatrixMapGroup::BuildWater(int x, int y) {
         int w = std::min(MAP_GROUP_SIZE, (g_MatrixMap->m_Size.x - x));
         int h = std::min(MAP_GROUP_SIZE, (g_MatrixMap->m_Size.y - y));
 
-        // const int shadesize = alphasize*alphasize;
-
         D3DLOCKED_RECT lr;
 
         m_WaterAlpha = CACHE_CREATE_TEXTUREMANAGED();
@@ -357,49 +430,9 @@ void CMatrixMapGroup::BuildWater(int x, int y) {
 
         const int pxsz = lr.Pitch / WATER_ALPHA_SIZE;
 
-        const float up_level = -1.0f;
-        const float down_level = -20.1f;
-
         for (int j = 0; j < WATER_ALPHA_SIZE; ++j) {
             for (int i = 0; i < WATER_ALPHA_SIZE; ++i) {
-                float wx = (float(i) + 0.5f) * ((float)MAP_GROUP_SIZE * GLOBAL_SCALE / (WATER_ALPHA_SIZE)) + p0.x;
-                float wy = (float(j) + 0.5f) * ((float)MAP_GROUP_SIZE * GLOBAL_SCALE / (WATER_ALPHA_SIZE)) + p0.y;
-
-                float wz;
-
-                float scaledx = wx / GLOBAL_SCALE;
-                float scaledy = wy / GLOBAL_SCALE;
-
-                int ix = TruncFloat(scaledx);
-                int iy = TruncFloat(scaledy);
-
-                SMatrixMapUnit *un = g_MatrixMap->UnitGetTest(ix, iy);
-                if (un != NULL && un->IsBridge()) {
-                    float kx = scaledx - float(ix);
-                    float ky = scaledy - float(iy);
-
-                    SMatrixMapPoint *mp = g_MatrixMap->PointGet(ix, iy);
-
-                    float z0 = mp->z;
-                    float z1 = (mp + 1)->z;
-                    float z2 = (mp + g_MatrixMap->m_Size.x + 1)->z;
-                    float z3 = (mp + g_MatrixMap->m_Size.x + 2)->z;
-
-                    wz = LERPFLOAT(ky, LERPFLOAT(kx, z0, z1), LERPFLOAT(kx, z2, z3));
-                }
-                else {
-                    wz = g_MatrixMap->GetZ(wx, wy);
-                }
-
-                byte zz;
-                if (wz < down_level)
-                    zz = 255;
-                else if (wz > up_level)
-                    zz = 0;
-                else
-                    zz = BYTE(255 - int(((wz - down_level) / (up_level - down_level) * 255.0f)));
-
-                *(shade + (j * lr.Pitch) + (i * pxsz) + (pxsz - 1)) = zz;
+                *(shade + (j * lr.Pitch) + (i * pxsz) + (pxsz - 1)) = alpha[j * WATER_ALPHA_SIZE + i];
                 // shade[i+j*alphasize] = (int(zz) << shift);
             }
         }
@@ -503,22 +536,38 @@ void CMatrixMapGroup::BeforeDraw(void)
         m_RenderShadowObject = NULL;
     }
 }
-void CMatrixMapGroup::Draw(void) {
+void CMatrixMapGroup::Draw(bool lod) {
     DTRACE();
 
     int vbase = m_VertsSource_bottom.Select(m_BigVB_bottom);
     if (vbase < 0)
         return;
-    int ibase = m_IdxsSource_bottom.Select(m_BigIB_bottom);
-    if (ibase < 0)
-        return;
+
+    int level = lod ? GetLodLevel(g_MatrixMap->GetCurrentFrame()) : 0;
+
+    int ibase;
+    const SBottomGeometry *geometry = m_BottomGeometry;
+    if (level > 0 && m_LodIBase >= 0) {
+        // the indices of the frame are in the stream ring
+        CStreamRing::SetIndices();
+        m_BigIB_bottom->BeforeDraw();
+        ibase = m_LodIBase;
+        geometry = GetLodVariant(level, m_LodSides).m_Geometry.data();
+    }
+    else {
+        ibase = m_IdxsSource_bottom.Select(m_BigIB_bottom);
+        if (ibase < 0)
+            return;
+    }
 
     ASSERT_DX(g_D3DD->SetTransform(D3DTS_WORLD, &m_Matrix));
 
     int type = (g_MatrixMap->m_Macrotexture == NULL) ? 0 : 1;
 
     for (int i = 0; i < m_BottomGeometryCount; ++i) {
-        SBottomGeometry *bg = m_BottomGeometry + i;
+        const SBottomGeometry *bg = geometry + i;
+        if (bg->tricnt == 0)
+            continue;
 
         if (bg->texture < 0) {
             // ASSERT_DX(g_D3DD->SetTransform(D3DTS_WORLD,&m));
@@ -642,7 +691,7 @@ CMatrixMapStatic *CMatrixMapGroup::FindObjectAny(DWORD mask, const D3DXVECTOR3 &
     return NULL;
 }
 
-void CMatrixMapGroup::SortObjects(const D3DXMATRIX &sort) {
+void CMatrixMapGroup::SortObjects(const D3DXMATRIX &sort, bool occluded) {
     DTRACE();
     ////////////////////////// draw group objects
     if (m_Objects) {
@@ -654,7 +703,9 @@ void CMatrixMapGroup::SortObjects(const D3DXMATRIX &sort) {
         int cnt = m_ObjectsContained;
 
         while ((cnt--) > 0) {
-            (*mo)->Sort(sort);
+            // the group is hidden: only flyers may be above it
+            if (!occluded || (*mo)->IsFlyer())
+                (*mo)->Sort(sort);
             ++mo;
         }
     }
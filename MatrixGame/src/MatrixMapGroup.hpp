@@ -11,6 +11,8 @@
 #include "BigVB.hpp"
 #include "BigIB.hpp"
 
+#include <vector>
+
 //#define TEXTURES_OFF
 
 //#define LANDSCAPE_BOTTOM_USE_NORMALES
@@ -75,6 +77,8 @@ struct SBottomGeometry {
 };
 
 struct SObjectCore;
+struct SBottomLod;
+struct SBottomLodVariant;
 
 /**
  * @brief A group is basically a chunk a map terrain consists from.
@@ -102,6 +106,13 @@ class CMatrixMapGroup : public CMain {
     SBottomGeometry *m_BottomGeometry;
     int m_BottomGeometryCount;
 
+    // terrain LOD, see MatrixMapLod.hpp
+    SBottomLod *m_Lod;
+    int m_LodLevel;
+    int m_LodSides;    // LOD_SIDE_* drawn with the step of the finer level
+    DWORD m_LodFrame;  // the level is chosen for that frame
+    int m_LodIBase;    // indices of the frame in the stream ring, -1 if not written
+
     int m_PosX, m_PosY;
     D3DXVECTOR2 p0, p1;
     D3DXMATRIX m_Matrix;
@@ -139,6 +150,11 @@ class CMatrixMapGroup : public CMain {
     int m_IdxsTraceCnt;
     int m_VertsTraceCnt;
 
+    // position and color of the vertices on a map point
+    void BottomPoint(SMatrixMapVertexBottom &v, int px, int py) const;
+    void BuildLod(int w, int h, const int *gx, const int *gy);
+    const SBottomLodVariant &GetLodVariant(int level, int sides);
+
 public:
 #ifdef _DEBUG
     static int m_DPCalls;
@@ -174,6 +190,23 @@ public:
     float GetMaxZLand(void) const { return m_maxz; }
 
     void RecalcMaxZ(void);
+
+    // terrain LOD of the frame, see CMatrixMap::CalcLandscapeLod
+    float GetLodError(int level) const;
+    bool HasSurfaces(void) const { return m_SurfacesCnt > 0; }
+    int GetLodLevel(DWORD frame) const { return (m_LodFrame == frame) ? m_LodLevel : 0; }
+    void SetLodLevel(int level, DWORD frame) {
+        m_LodLevel = level;
+        m_LodFrame = frame;
+    }
+    int GetLastLodLevel(void) const { return m_LodLevel; }
+    DWORD GetLodFrame(void) const { return m_LodFrame; }
+    float GetCamDistSq(void) const { return m_CamDistSq; }
+    // sides (LOD_SIDE_*) drawn with the step of the finer level, the indices are built when first needed
+    void SetLodSides(int sides);
+    int GetLodTriangles(void);
+    // indices of the reduced groups go to the stream ring, they are to be drawn before the next lock of it
+    static void WriteLodIB(CMatrixMapGroup *const *groups, int cnt, DWORD frame);
     void AddNewZObj(float z) {
         if (z > m_maxz_obj) {
             m_maxz_obj = z;
@@ -201,7 +234,9 @@ public:
     void Clear(void);
 
     void BuildBottom(int x, int y, BYTE *rawbottom);
-    void BuildWater(int x, int y);
+    // WATER_ALPHA_SIZE x WATER_ALPHA_SIZE depths, only reads the map: the groups may do it in parallel
+    void CalcWaterAlpha(BYTE *alpha) const;
+    void BuildWater(int x, int y, const BYTE *alpha);
     void InitInshoreWaves(int n, const float *xx, const float *yy, const float *nxx, const float *nyy);
 
     void RemoveShadow(const CMatrixShadowProj *s);
@@ -220,8 +255,9 @@ public:
 
     /**
      * @brief Draws the bottom layer terrain.
+     * @param lod with the level of the frame, the full geometry otherwise
      */
-    void Draw(void);
+    void Draw(bool lod);
     // void DrawZ(void);
 
     void DX_Free(void) {
@@ -235,7 +271,7 @@ public:
     void BeforeDrawSurfaces(void);
 
     void DrawInshorewaves(void);
-    void SortObjects(const D3DXMATRIX &sort);
+    void SortObjects(const D3DXMATRIX &sort, bool occluded);
     /**
      * @brief Draws inshore waves (flushes) near beaches.
      */
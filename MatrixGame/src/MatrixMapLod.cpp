@@ -0,0 +1,394 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "MatrixMapLod.hpp"
+#include "MatrixMap.hpp"
+#include "StreamRing.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+#define LOD_MAX_VERTS 0xFFFF  // indices are 16 bit
+
+// nearest point of the grid of the step, the side of a short group is a point of it too
+static int LodSnap(int c, int step, int size) {
+    int lo = c / step * step;
+    int hi = std::min(lo + step, size);
+    return (c - lo < hi - c) ? lo : hi;
+}
+
+// the point a grid point of the group moves to at the level, sides (LOD_SIDE_*) use the step of the finer level
+static void LodTarget(int level, int sides, int w, int h, int &x, int &y) {
+    int step = LOD_STEP[level];
+    int cx = LodSnap(x, step, w), cy = LodSnap(y, step, h);
+
+    // a point which comes to a finer side stays on the grid of the side (of the nearer one if it comes to a corner)
+    int dx = (cx == 0 && (sides & LOD_SIDE_LEFT)) ? x : ((cx == w && (sides & LOD_SIDE_RIGHT)) ? (w - x) : -1);
+    int dy = (cy == 0 && (sides & LOD_SIDE_TOP)) ? y : ((cy == h && (sides & LOD_SIDE_BOTTOM)) ? (h - y) : -1);
+    if (dx >= 0 && (dy < 0 || dx <= dy)) {
+        x = cx;
+        y = LodSnap(y, LOD_STEP[level - 1], h);
+    }
+    else if (dy >= 0) {
+        x = LodSnap(x, LOD_STEP[level - 1], w);
+        y = cy;
+    }
+    else {
+        x = cx;
+        y = cy;
+    }
+}
+
+static DWORD LodPointKey(int piece, int x, int y) {
+    return (DWORD(piece) << 16) | (DWORD(x) << 8) | DWORD(y);
+}
+
+void CMatrixMapGroup::BuildLod(int w, int h, const int *gx, const int *gy) {
+    DTRACE();
+
+    int vertcnt = m_VertsSource_bottom.size / sizeof(SMatrixMapVertexBottom);
+    if (vertcnt == 0)
+        return;
+
+    m_Lod = HNew(g_MatrixHeap) SBottomLod();
+    SBottomLod &lod = *m_Lod;
+    lod.m_W = w;
+    lod.m_H = h;
+
+    const WORD *inds = m_IdxsSource_bottom.inds;
+    int indcnt = m_IdxsSource_bottom.size / sizeof(WORD);
+
+    // pieces: vertices joined by the triangles, texture coordinates are continuous over a piece
+    std::vector<int> piece(vertcnt);
+    std::iota(piece.begin(), piece.end(), 0);
+    auto root = [&piece](int v) {
+        while (piece[v] != v) {
+            piece[v] = piece[piece[v]];
+            v = piece[v];
+        }
+        return v;
+    };
+    for (int i = 0; i + 2 < indcnt; i += 3) {
+        piece[root(inds[i + 1])] = root(inds[i]);
+        piece[root(inds[i + 2])] = root(inds[i]);
+    }
+
+    // texture coordinates per unit of the grid, from the first triangle of a piece with an area
+    struct SGradient {
+        float dudx, dudy, dvdx, dvdy;
+        bool ok;
+    };
+    std::vector<SGradient> grad(vertcnt, SGradient{0, 0, 0, 0, false});
+    const SMatrixMapVertexBottom *verts = m_VertsSource_bottom.verts;
+    for (int i = 0; i + 2 < indcnt; i += 3) {
+        int a = inds[i], b = inds[i + 1], c = inds[i + 2];
+        SGradient &g = grad[root(a)];
+        if (g.ok)
+            continue;
+        float dx1 = float(gx[b] - gx[a]), dy1 = float(gy[b] - gy[a]);
+        float dx2 = float(gx[c] - gx[a]), dy2 = float(gy[c] - gy[a]);
+        float det = dx1 * dy2 - dx2 * dy1;
+        if (det == 0)
+            continue;
+        float du1 = verts[b].tc[0].u - verts[a].tc[0].u, du2 = verts[c].tc[0].u - verts[a].tc[0].u;
+        float dv1 = verts[b].tc[0].v - verts[a].tc[0].v, dv2 = verts[c].tc[0].v - verts[a].tc[0].v;
+        g.dudx = (du1 * dy2 - du2 * dy1) / det;
+        g.dudy = (dx1 * du2 - dx2 * du1) / det;
+        g.dvdx = (dv1 * dy2 - dv2 * dy1) / det;
+        g.dvdy = (dx1 * dv2 - dx2 * dv1) / det;
+        g.ok = true;
+    }
+
+    // vertices by the piece and the grid point, the compiled ones first
+    std::unordered_map<DWORD, WORD> points;
+    lod.m_X.resize(vertcnt);
+    lod.m_Y.resize(vertcnt);
+    lod.m_Piece.resize(vertcnt);
+    for (int v = 0; v < vertcnt; ++v) {
+        lod.m_X[v] = BYTE(gx[v]);
+        lod.m_Y[v] = BYTE(gy[v]);
+        lod.m_Piece[v] = WORD(root(v));
+        points.emplace(LodPointKey(lod.m_Piece[v], gx[v], gy[v]), WORD(v));
+    }
+
+    // the points the vertices move to at all the levels and sides
+    std::vector<SMatrixMapVertexBottom> added;
+    for (int level = 1; level < LOD_LEVELS; ++level) {
+        for (int sides = 0; sides < LOD_VARIANTS; ++sides) {
+            for (int v = 0; v < vertcnt; ++v) {
+                int x = gx[v], y = gy[v];
+                LodTarget(level, sides, w, h, x, y);
+                if (vertcnt + int(added.size()) >= LOD_MAX_VERTS)
+                    break;
+                if (!points.emplace(LodPointKey(lod.m_Piece[v], x, y), WORD(vertcnt + added.size())).second)
+                    continue;
+
+                SMatrixMapVertexBottom nv;
+                BottomPoint(nv, m_PosX + x, m_PosY + y);
+                nv.tc[0] = verts[v].tc[0];
+                const SGradient &g = grad[lod.m_Piece[v]];
+                if (g.ok) {
+                    float dx = float(x - gx[v]), dy = float(y - gy[v]);
+                    nv.tc[0].u += g.dudx * dx + g.dudy * dy;
+                    nv.tc[0].v += g.dvdx * dx + g.dvdy * dy;
+                }
+                added.push_back(nv);
+                lod.m_X.push_back(BYTE(x));
+                lod.m_Y.push_back(BYTE(y));
+            }
+        }
+    }
+
+    lod.m_Points.assign(points.begin(), points.end());
+    std::sort(lod.m_Points.begin(), lod.m_Points.end());
+
+    if (!added.empty()) {
+        m_VertsSource_bottom.size = (vertcnt + int(added.size())) * sizeof(SMatrixMapVertexBottom);
+        m_VertsSource_bottom.verts = (SMatrixMapVertexBottom *)HAllocEx(m_VertsSource_bottom.verts,
+                                                                        m_VertsSource_bottom.size, g_MatrixHeap);
+        memcpy(m_VertsSource_bottom.verts + vertcnt, added.data(), added.size() * sizeof(SMatrixMapVertexBottom));
+    }
+
+    // error of a level: the heights against the ones interpolated over its grid
+    auto z = [this](int x, int y) { return g_MatrixMap->PointGet(m_PosX + x, m_PosY + y)->z; };
+    lod.m_Error[0] = 0;
+    for (int level = 1; level < LOD_LEVELS; ++level) {
+        int step = LOD_STEP[level];
+        float err = 0;
+        for (int y = 0; y <= h; ++y) {
+            int y0 = std::min(y / step * step, h), y1 = std::min(y0 + step, h);
+            float ky = (y1 > y0) ? float(y - y0) / float(y1 - y0) : 0.0f;
+            for (int x = 0; x <= w; ++x) {
+                int x0 = std::min(x / step * step, w), x1 = std::min(x0 + step, w);
+                float kx = (x1 > x0) ? float(x - x0) / float(x1 - x0) : 0.0f;
+                float zi = LERPFLOAT(ky, LERPFLOAT(kx, z(x0, y0), z(x1, y0)), LERPFLOAT(kx, z(x0, y1), z(x1, y1)));
+                err = std::max(err, fabsf(z(x, y) - zi));
+            }
+        }
+        lod.m_Error[level] = std::max(err, lod.m_Error[level - 1]);
+    }
+
+    // a level can not give the place of one texture to another: the group would change its look at once
+    for (int level = 1; level < LOD_LEVELS; ++level) {
+        for (int i = 0; i < m_BottomGeometryCount; ++i) {
+            const WORD *src = inds + m_BottomGeometry[i].idxbase;
+            int was = 0, now = 0;
+            for (int t = 0; t < m_BottomGeometry[i].tricnt * 3; t += 3) {
+                int x[3], y[3];
+                for (int k = 0; k < 3; ++k) {
+                    x[k] = gx[src[t + k]];
+                    y[k] = gy[src[t + k]];
+                }
+                was += (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                for (int k = 0; k < 3; ++k)
+                    LodTarget(level, 0, w, h, x[k], y[k]);
+                now += (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+            }
+            if (abs(now - was) > LOD_TEXTURE_CHANGE * (2 * w * h)) {
+                for (int l = level; l < LOD_LEVELS; ++l)
+                    lod.m_Error[l] = FLT_MAX;
+                break;
+            }
+        }
+    }
+}
+
+float CMatrixMapGroup::GetLodError(int level) const {
+    if (level == 0)
+        return 0;
+    return (m_Lod != NULL) ? m_Lod->m_Error[level] : FLT_MAX;
+}
+
+const SBottomLodVariant &CMatrixMapGroup::GetLodVariant(int level, int sides) {
+    SBottomLodVariant &var = m_Lod->m_Variants[level - 1][sides];
+    if (var.m_Ready)
+        return var;
+    var.m_Ready = true;
+
+    const SBottomLod &lod = *m_Lod;
+    auto target = [&lod, level, sides](int v) {
+        int x = lod.m_X[v], y = lod.m_Y[v];
+        LodTarget(level, sides, lod.m_W, lod.m_H, x, y);
+        auto it = std::lower_bound(lod.m_Points.begin(), lod.m_Points.end(),
+                                   std::make_pair(LodPointKey(lod.m_Piece[v], x, y), WORD(0)));
+        // not found only if there was no place for it in the VB
+        return (it != lod.m_Points.end() && it->first == LodPointKey(lod.m_Piece[v], x, y)) ? it->second : WORD(v);
+    };
+    auto area = [&lod](int a, int b, int c) {
+        return (lod.m_X[b] - lod.m_X[a]) * (lod.m_Y[c] - lod.m_Y[a]) -
+               (lod.m_X[c] - lod.m_X[a]) * (lod.m_Y[b] - lod.m_Y[a]);
+    };
+
+    var.m_Geometry.assign(m_BottomGeometry, m_BottomGeometry + m_BottomGeometryCount);
+    for (SBottomGeometry &bg : var.m_Geometry) {
+        const WORD *src = m_IdxsSource_bottom.inds + bg.idxbase;
+        int base = int(var.m_Inds.size());
+        int mini = INT_MAX, maxi = -1;
+
+        for (int t = 0; t < bg.tricnt; ++t) {
+            const WORD *tri = src + t * 3;
+            WORD a = target(tri[0]), b = target(tri[1]), c = target(tri[2]);
+            // the ones which became a point or a line (or turned over)
+            int was = area(tri[0], tri[1], tri[2]), now = area(a, b, c);
+            if (now == 0 || (now > 0) != (was > 0))
+                continue;
+
+            var.m_Inds.push_back(a);
+            var.m_Inds.push_back(b);
+            var.m_Inds.push_back(c);
+            mini = std::min({mini, int(a), int(b), int(c)});
+            maxi = std::max({maxi, int(a), int(b), int(c)});
+        }
+
+        bg.idxbase = base;
+        bg.tricnt = (int(var.m_Inds.size()) - base) / 3;
+        bg.minvidx = (bg.tricnt > 0) ? mini : 0;
+        bg.vertcnt = (bg.tricnt > 0) ? (maxi - mini + 1) : 0;
+    }
+    return var;
+}
+
+void CMatrixMapGroup::SetLodSides(int sides) {
+    m_LodSides = sides;
+    if (m_LodLevel > 0)
+        GetLodVariant(m_LodLevel, sides);
+}
+
+int CMatrixMapGroup::GetLodTriangles(void) {
+    if (m_LodLevel == 0) {
+        return m_IdxsSource_bottom.size / (sizeof(WORD) * 3);
+    }
+    return int(GetLodVariant(m_LodLevel, m_LodSides).m_Inds.size()) / 3;
+}
+
+void CMatrixMapGroup::WriteLodIB(CMatrixMapGroup *const *groups, int cnt, DWORD frame) {
+    DTRACE();
+
+    int total = 0;
+    for (int i = 0; i < cnt; ++i) {
+        CMatrixMapGroup *g = groups[i];
+        if (g == NULL)
+            continue;
+        g->m_LodIBase = -1;
+        if (g->GetLodLevel(frame) > 0)
+            total += int(g->GetLodVariant(g->m_LodLevel, g->m_LodSides).m_Inds.size());
+    }
+    if (total == 0)
+        return;
+
+    int ibase;
+    WORD *p = CStreamRing::LockInds(total, ibase);
+    if (p == NULL)
+        return;
+    for (int i = 0; i < cnt; ++i) {
+        CMatrixMapGroup *g = groups[i];
+        if (g == NULL || g->GetLodLevel(frame) == 0)
+            continue;
+        const std::vector<WORD> &inds = g->GetLodVariant(g->m_LodLevel, g->m_LodSides).m_Inds;
+        memcpy(p, inds.data(), inds.size() * sizeof(WORD));
+        p += inds.size();
+        g->m_LodIBase = ibase;
+        ibase += int(inds.size());
+    }
+    CStreamRing::UnlockInds();
+}
+
+void CMatrixMap::CalcLandscapeLod(void) {
+    DTRACE();
+
+    DWORD frame = GetCurrentFrame();
+    float allowed = g_Config.m_TerrainLodError;
+    // pixels per unit of height at the distance of one
+    float k = float(g_ScreenY) * 0.5f / tanf(CAM_HFOV * 0.5f);
+    float radius = MAP_GROUP_SIZE * GLOBAL_SCALE * 0.7071f;
+
+    auto pos = [](const CMatrixMapGroup *g, int &x, int &y) {
+        x = TruncFloat(g->GetPos0().x * (1.0f / (MAP_GROUP_SIZE * GLOBAL_SCALE)) + 0.5f);
+        y = TruncFloat(g->GetPos0().y * (1.0f / (MAP_GROUP_SIZE * GLOBAL_SCALE)) + 0.5f);
+    };
+    // a neighbour drawn this frame
+    auto visible = [this, frame](int x, int y) -> CMatrixMapGroup * {
+        if (x < 0 || y < 0 || x >= m_GroupSize.x || y >= m_GroupSize.y)
+            return NULL;
+        CMatrixMapGroup *g = GetGroupByIndex(x, y);
+        return (g != NULL && g->GetLodFrame() == frame) ? g : NULL;
+    };
+    static const int dirs[4][2] = {{-1, 0}, {0, -1}, {1, 0}, {0, 1}};  // the order of LOD_SIDE_*
+
+    for (int i = 0; i < m_VisibleGroupsCount; ++i) {
+        CMatrixMapGroup *g = m_VisibleGroups[i];
+        if (g == NULL)
+            continue;
+
+        int level = 0;
+        if (allowed >= 0) {
+            float dist = std::max(1.0f, sqrtf(g->GetCamDistSq()) - radius);
+            for (int l = LOD_LEVELS - 1; l > 0; --l) {
+                float err = g->GetLodError(l);
+                if (g->HasSurfaces() && err > LOD_SURFACE_ERROR)
+                    continue;
+                // going coarser needs some margin, the level should not flip every frame
+                float limit = (l > g->GetLastLodLevel()) ? (allowed * LOD_HYSTERESIS) : allowed;
+                if (err * k <= limit * dist) {
+                    level = l;
+                    break;
+                }
+            }
+        }
+        g->SetLodLevel(level, frame);
+    }
+
+    // neighbours differ by a level at most, the finer one wins
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (int i = 0; i < m_VisibleGroupsCount; ++i) {
+            CMatrixMapGroup *g = m_VisibleGroups[i];
+            if (g == NULL || g->GetLodLevel(frame) == 0)
+                continue;
+            int x, y;
+            pos(g, x, y);
+            for (const auto &d : dirs) {
+                CMatrixMapGroup *n = visible(x + d[0], y + d[1]);
+                if (n != NULL && g->GetLodLevel(frame) > n->GetLodLevel(frame) + 1) {
+                    g->SetLodLevel(n->GetLodLevel(frame) + 1, frame);
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    int levels[LOD_LEVELS] = {};
+    int tris = 0;
+    for (int i = 0; i < m_VisibleGroupsCount; ++i) {
+        CMatrixMapGroup *g = m_VisibleGroups[i];
+        if (g == NULL)
+            continue;
+        int level = g->GetLodLevel(frame);
+        int sides = 0;
+        if (level > 0) {
+            int x, y;
+            pos(g, x, y);
+            for (int s = 0; s < 4; ++s) {
+                CMatrixMapGroup *n = visible(x + dirs[s][0], y + dirs[s][1]);
+                if (n != NULL && n->GetLodLevel(frame) < level)
+                    sides |= SETBIT(s);
+            }
+        }
+        g->SetLodSides(sides);
+
+        ++levels[level];
+        if (FLAG(g_Config.m_DIFlags, DI_TERRAINLOD))
+            tris += g->GetLodTriangles();
+    }
+
+    if (FLAG(g_Config.m_DIFlags, DI_TERRAINLOD)) {
+        m_DI.T(L"Terrain LOD (groups by level, triangles)",
+               utils::format(L"%d / %d / %d, %d", levels[0], levels[1], levels[2], tris).c_str());
+    }
+}
@@ -0,0 +1,54 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "MatrixMapGroup.hpp"
+
+#include <utility>
+#include <vector>
+
+#define LOD_LEVELS        3      // level 0 is the compiled geometry
+#define LOD_VARIANTS      16     // a bit per side: the side uses the step of the finer level
+#define LOD_SIDE_LEFT     SETBIT(0)
+#define LOD_SIDE_TOP      SETBIT(1)
+#define LOD_SIDE_RIGHT    SETBIT(2)
+#define LOD_SIDE_BOTTOM   SETBIT(3)
+#define LOD_HYSTERESIS    0.75f  // a group goes coarser when its error is that part of the allowed one
+#define LOD_SURFACE_ERROR 0.05f  // terrain under surfaces may move only that much: they lie on the full geometry
+#define LOD_TEXTURE_CHANGE 0.1f  // part of the group a texture may win or lose at a level
+
+// grid step of a level in units. a step is a multiple of the finer ones, the seams rely on that
+static constexpr int LOD_STEP[LOD_LEVELS] = {1, 2, MAP_GROUP_SIZE};
+
+// indices of a level and the sides
+struct SBottomLodVariant {
+    bool m_Ready;
+    std::vector<WORD> m_Inds;
+    std::vector<SBottomGeometry> m_Geometry;  // as m_BottomGeometry of the group, bases in m_Inds
+};
+
+/**
+ * @brief Reduced geometry of a map group, built at load.
+ *
+ * A level moves every vertex to the nearest point of its grid (vertex clustering), the triangles which become
+ * degenerate are dropped. The heights are taken from the map points, so the vertices of all the textures (and of
+ * the pieces of a texture with different texture coordinates) on one point stay together. A vertex which comes to
+ * a side of the group is moved along the side with the step of the finer of the two groups there: neighbours differ
+ * by a level at most, so every side is drawn either with the step of the group or with the one of the finer level.
+ *
+ * The vertices the moved ones become are added to the group VB at load, their texture coordinates continue the
+ * ones of their piece. The index lists of a level and of the sides are built when first used.
+ */
+struct SBottomLod {
+    int m_W, m_H;                // group size in units
+    std::vector<BYTE> m_X, m_Y;  // grid point of every vertex (the added ones too), in the group
+    std::vector<WORD> m_Piece;   // piece of every compiled vertex, the vertices of a piece share texture coordinates
+    std::vector<std::pair<DWORD, WORD>> m_Points;  // vertex by LodPointKey, sorted
+
+    float m_Error[LOD_LEVELS];  // the biggest height difference from the compiled geometry
+
+    SBottomLodVariant m_Variants[LOD_LEVELS - 1][LOD_VARIANTS];
+};
@@ -14,16 +14,28 @@
 #include "MatrixFlyer.hpp"
 #include "MatrixShadowManager.hpp"
 #include "ShadowStencil.hpp"
+#include "StreamRing.hpp"
 #include "Interface/CConstructor.h"
+#include "MatrixGamePathUtils.hpp"
+#include "MatrixMapBake.hpp"
+#include "TaskGraph.hpp"
+#include "Text/Font.hpp"
+
+#include <utils.hpp>
+#include <stupid_logger.hpp>
 
 #include <new>
 #include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
 #include <vector>
 #include <set>
 
-void CMatrixMap::PointCalcNormals(int x, int y) {
-    DTRACE();
-
+// no DTRACE: it is called from the load workers
+// baked: bump MAP_BAKE_NORMALS when the result changes
+bool CMatrixMap::PointCalcNormals(int x, int y, bool copy) {
     SMatrixMapPoint *p0;  // cur
     SMatrixMapPoint *p1;  // up
     SMatrixMapPoint *p2;  // right
@@ -38,7 +50,7 @@ void CMatrixMap::PointCalcNormals(int x, int y) {
 
     p0 = PointGetTest(x, y);
     if (p0 == NULL)
-        return;
+        return true;
 
     SMatrixMapUnit *mu;
 
@@ -103,6 +115,8 @@ void CMatrixMap::PointCalcNormals(int x, int y) {
     }
 
     if (cnt == 0) {
+        if (!copy && (p1 != NULL || p4 != NULL))
+            return false;
         if (p1 != NULL)
             p0->n = p1->n;
         else if (p4 != NULL)
@@ -114,6 +128,7 @@ void CMatrixMap::PointCalcNormals(int x, int y) {
         // p0->n=n/float(cnt);
         D3DXVec3Normalize(&p0->n, &n);
     }
+    return true;
 }
 
 static int BuildTexUnions(CStorage &stor, int lp1, int lp2) {
@@ -321,6 +336,7 @@ void CMatrixMap::GroupClear(void) {
     DTRACE();
 
     ClearGroupVis();
+    m_Cull.Clear();
 
     if (m_Group != NULL) {
         int cnt = m_GroupSize.x * m_GroupSize.y;
@@ -939,12 +955,41 @@ int CMatrixMap::ReloadDynamics(CStorage &stor, CMatrixMap::EReloadStep step, voi
     return 0;
 }
 
-DWORD uniq;
+DWORD uniq;  // id of the map, keys the caches of what is derived from it
 std::vector<SPreRobot> robots_buf;
 
+// One line per loaded map: the time of every stage (its first start to its last end) and how many threads it took.
+// It goes to the log and to a file, which is kept, so the load times can be compared between builds.
+static void StoreLoadTimes(const std::wstring &mapname, std::chrono::steady_clock::duration props_time,
+                           const CTaskGraph &graph, bool baked) {
+    auto ms = [](std::chrono::steady_clock::duration d) {
+        return std::chrono::duration<double, std::milli>(d).count();
+    };
+
+    auto total = props_time;
+    std::string line = std::format("properties={:.1f}", ms(props_time));
+    for (const STaskStage &st : graph.GetStages()) {
+        line += std::format(" {}={:.1f}", utils::from_wstring(st.m_Name), ms(st.m_End - st.m_Start));
+        if (st.m_Threads > 1)
+            line += std::format("/{}", st.m_Threads);
+        total = std::max(total, props_time + st.m_End);
+    }
+
+    std::string name = utils::from_wstring(mapname);
+    const char *from = baked ? "baked" : "computed";
+    lgr.info("Map {} prepared in {:.1f} ms ({}), {} threads: {}")(name, ms(total), from, graph.GetThreadCnt() + 1,
+                                                                   line);
+
+    std::ofstream out(std::filesystem::path{PathToOutputFiles(FILE_NAME_LOADTIMES)}, std::ios::app);
+    if (out)
+        out << std::format("{}\t{:.1f}\t{}\t{}\n", name, ms(total), from, line);
+}
+
 int CMatrixMap::PrepareMap(CStorage &stor, const std::wstring &mapname) {
     DTRACE();
 
+    auto load_time = std::chrono::steady_clock::now();
+
     robots_buf.clear();
 
     D3DMATERIAL9 mtrl;
@@ -1011,6 +1056,7 @@ int CMatrixMap::PrepareMap(CStorage &stor, const std::wstring &mapname) {
     m_BiasTer = -1.0f;
     m_BiasWater = -1.0f;
 
+    // the id the editor stores in the map, as for the minimap cache; a map without it is hashed whole
     uniq = 0;
     ic = propkey->FindAsWStr(DATA_UNIQID);
     if (ic >= 0)
@@ -1185,179 +1231,265 @@ int CMatrixMap::PrepareMap(CStorage &stor, const std::wstring &mapname) {
 
     UnitInit(sizex, sizey);
 
+    auto props_time = std::chrono::steady_clock::now() - load_time;
+
+    // The rest goes as a graph of stages. The work over the points, the units and the groups is split between the
+    // threads and only reads the map around the piece it writes, so the result does not depend on the order; the
+    // device, the load progress, the random and the heap stay on this thread.
+    CTaskGraph graph;
+
+    // the groups are not built yet, their count is known from the size
+    int grpcnt = TruncFloat((sizex + MAP_GROUP_SIZE - 1) * INVERT(MAP_GROUP_SIZE)) *
+                 TruncFloat((sizey + MAP_GROUP_SIZE - 1) * INVERT(MAP_GROUP_SIZE));
+
+    // normals, units coefs and water depths of the same map come from the bake
+    CMatrixMapBake bake;
+    int baked = graph.AddMain(L"bake", [&stor, &mapname, &bake, sizex, sizey, grpcnt]() {
+        if (uniq == 0)
+            uniq = stor.CalcUniqID();
+        bake.Load(mapname, uniq, sizex, sizey, grpcnt);
+    });
+
     // loading points and units
     CDataBuf *ptsc = stor.GetBuf(DATA_POINTS, DATA_POINTS_DATA, ST_BYTE);
-    SMatrixMapUnit *mu = m_Unit;
-    SMatrixMapPoint *mp = m_Point;
-    SCompilePoint *cp = ptsc->GetFirst<SCompilePoint>(0);
+    SCompilePoint *cp0 = ptsc->GetFirst<SCompilePoint>(0);
 
     CDataBuf *movc = stor.GetBuf(DATA_MOVE, DATA_MOVE_DATA, ST_BYTE);
     SCompileMoveCell *cc = movc->GetFirst<SCompileMoveCell>(0);
 
-    SMatrixMapMove *smm = m_Move;
-
-    g_LoadProgress->SetCurLPPos(300);
-
-    for (int y = 0; y < (m_Size.y + 1); ++y, smm += m_SizeMove.x) {
-        for (int x = 0; x < (m_Size.x + 1); ++x, ++mp, ++cp) {
-            mp->color = (cp->r << 16) | (cp->g << 8) | (cp->b << 0);
-            mp->z = cp->z;
-            mp->z_land = std::max(0.0f, cp->z);
-
-            if (mp->z < m_minz)
-                m_minz = mp->z;
-            if (mp->z > m_maxz)
-                m_maxz = mp->z;
-
-            mp->lum_r = 0;
-            mp->lum_g = 0;
-            mp->lum_b = 0;
-            if (x < m_Size.x && y < m_Size.y) {
-                SCompileMoveCell *cur = cc + cp->move;
-
-                smm->m_Zone = cur->c[0].m_Zone;
-                smm->m_Zubchik = cur->c[0].m_Zubchik;
-                smm->m_Sphere = cur->c[0].m_Sphere;
-                smm->m_Stop = cur->c[0].m_Move;
-
-                (smm + 1)->m_Zone = cur->c[1].m_Zone;
-                (smm + 1)->m_Zubchik = cur->c[1].m_Zubchik;
-                (smm + 1)->m_Sphere = cur->c[1].m_Sphere;
-                (smm + 1)->m_Stop = cur->c[1].m_Move;
-
-                (smm + m_SizeMove.x)->m_Zone = cur->c[2].m_Zone;
-                (smm + m_SizeMove.x)->m_Zubchik = cur->c[2].m_Zubchik;
-                (smm + m_SizeMove.x)->m_Sphere = cur->c[2].m_Sphere;
-                (smm + m_SizeMove.x)->m_Stop = cur->c[2].m_Move;
-
-                (smm + m_SizeMove.x + 1)->m_Zone = cur->c[3].m_Zone;
-                (smm + m_SizeMove.x + 1)->m_Zubchik = cur->c[3].m_Zubchik;
-                (smm + m_SizeMove.x + 1)->m_Sphere = cur->c[3].m_Sphere;
-                (smm + m_SizeMove.x + 1)->m_Stop = cur->c[3].m_Move;
-
-                mu->SetType(cp->flags);
-                ++mu;
-                smm += MOVE_CNT;
+    // heights range of every row, joined after
+    std::vector<float> rowminz(m_Size.y + 1), rowmaxz(m_Size.y + 1);
+
+    int points = graph.AddSplit(L"points", m_Size.y + 1, [this, cp0, cc, &rowminz, &rowmaxz](int from, int to) {
+        for (int y = from; y < to; ++y) {
+            SMatrixMapUnit *mu = m_Unit + y * m_Size.x;
+            SMatrixMapPoint *mp = m_Point + y * (m_Size.x + 1);
+            SCompilePoint *cp = cp0 + y * (m_Size.x + 1);
+            SMatrixMapMove *smm = m_Move + y * m_SizeMove.x * MOVE_CNT;
+            float minz = 10000.0f;
+            float maxz = -10000.0f;
+
+            for (int x = 0; x < (m_Size.x + 1); ++x, ++mp, ++cp) {
+                mp->color = (cp->r << 16) | (cp->g << 8) | (cp->b << 0);
+                mp->z = cp->z;
+                mp->z_land = std::max(0.0f, cp->z);
+
+                if (mp->z < minz)
+                    minz = mp->z;
+                if (mp->z > maxz)
+                    maxz = mp->z;
+
+                mp->lum_r = 0;
+                mp->lum_g = 0;
+                mp->lum_b = 0;
+                if (x < m_Size.x && y < m_Size.y) {
+                    SCompileMoveCell *cur = cc + cp->move;
+
+                    smm->m_Zone = cur->c[0].m_Zone;
+                    smm->m_Zubchik = cur->c[0].m_Zubchik;
+                    smm->m_Sphere = cur->c[0].m_Sphere;
+                    smm->m_Stop = cur->c[0].m_Move;
+
+                    (smm + 1)->m_Zone = cur->c[1].m_Zone;
+                    (smm + 1)->m_Zubchik = cur->c[1].m_Zubchik;
+                    (smm + 1)->m_Sphere = cur->c[1].m_Sphere;
+                    (smm + 1)->m_Stop = cur->c[1].m_Move;
+
+                    (smm + m_SizeMove.x)->m_Zone = cur->c[2].m_Zone;
+                    (smm + m_SizeMove.x)->m_Zubchik = cur->c[2].m_Zubchik;
+                    (smm + m_SizeMove.x)->m_Sphere = cur->c[2].m_Sphere;
+                    (smm + m_SizeMove.x)->m_Stop = cur->c[2].m_Move;
+
+                    (smm + m_SizeMove.x + 1)->m_Zone = cur->c[3].m_Zone;
+                    (smm + m_SizeMove.x + 1)->m_Zubchik = cur->c[3].m_Zubchik;
+                    (smm + m_SizeMove.x + 1)->m_Sphere = cur->c[3].m_Sphere;
+                    (smm + m_SizeMove.x + 1)->m_Stop = cur->c[3].m_Move;
+
+                    mu->SetType(cp->flags);
+                    ++mu;
+                    smm += MOVE_CNT;
+                }
             }
+            rowminz[y] = minz;
+            rowmaxz[y] = maxz;
         }
-    }
-
-    g_LoadProgress->SetCurLPPos(1000);
+    });
+    points = graph.Add(L"points", [this, &rowminz, &rowmaxz]() {
+        for (int y = 0; y <= m_Size.y; ++y) {
+            m_minz = std::min(m_minz, rowminz[y]);
+            m_maxz = std::max(m_maxz, rowmaxz[y]);
+        }
+    }, {points});
 
     // calc normals
-    for (int y = 0; y <= m_Size.y; y++) {
-        for (int x = 0; x <= m_Size.x; x++) {
-            PointCalcNormals(x, y);
+    // A point without cells around takes the normal of the point above or to the left, which may be in another
+    // part: such points are left to the end and done in the order of the map.
+    static_assert(sizeof(SMatrixMapPoint::n) == sizeof(D3DXVECTOR3));
+    std::vector<BYTE> normal_copied((m_Size.x + 1) * (m_Size.y + 1));
+
+    int normals = graph.AddSplit(L"normals", m_Size.y + 1, [this, &normal_copied, &bake](int from, int to) {
+        for (int y = from; y < to; ++y) {
+            int i = y * (m_Size.x + 1);
+            for (int x = 0; x <= m_Size.x; ++x, ++i) {
+                if (bake.IsLoaded())
+                    m_Point[i].n = bake.m_Normals[i];
+                else
+                    normal_copied[i] = !PointCalcNormals(x, y, false);
+            }
         }
-    }
-
-    g_LoadProgress->SetCurLPPos(1500);
+    }, {points, baked});
+    normals = graph.Add(L"normals", [this, &normal_copied, &bake]() {
+        if (bake.IsLoaded())
+            return;
+        int i = 0;
+        for (int y = 0; y <= m_Size.y; ++y) {
+            for (int x = 0; x <= m_Size.x; ++x, ++i) {
+                if (normal_copied[i])
+                    PointCalcNormals(x, y);
+                bake.m_Normals[i] = m_Point[i].n;
+            }
+        }
+    }, {normals});
 
     // IDS Loading...
 
-    {
-        CDataBuf *strc = stor.GetBuf(DATA_STRINGS, DATA_STRINGS_STRING, ST_WCHAR);
-        m_IdsCnt = strc->GetArraysCount() + 1;
-        m_Ids = (std::wstring *)HAlloc(m_IdsCnt * sizeof(std::wstring), g_MatrixHeap);
+    CDataBuf *strc = stor.GetBuf(DATA_STRINGS, DATA_STRINGS_STRING, ST_WCHAR);
+    m_IdsCnt = strc->GetArraysCount() + 1;
+    m_Ids = (std::wstring *)HAlloc(m_IdsCnt * sizeof(std::wstring), g_MatrixHeap);
+
+    int ids = graph.Add(L"ids", [this, strc, &mapname]() {
         int cnt = (m_IdsCnt - 1);
         for (int i = 0; i < cnt; i++) {
             new(&m_Ids[i]) std::wstring(strc->GetAsWStr(i));
         }
         new(&m_Ids[cnt]) std::wstring(mapname);
-    }
-
-    g_LoadProgress->SetCurLPPos(2000);
+    });
 
-    BuildTexUnions(stor, 2100, 50000);
-    GroupBuild(stor);
+    int texunions = graph.AddMain(L"texunions", [&stor]() {
+        g_LoadProgress->SetCurLPPos(2000);
+        BuildTexUnions(stor, 2100, 50000);
+    });
 
-    g_LoadProgress->SetCurLPPos(51000);
+    int groups = graph.AddMain(L"groups", [this, &stor]() {
+        GroupBuild(stor);
+        g_LoadProgress->SetCurLPPos(51000);
+    }, {texunions, normals});
 
     // prepare units coefs
+    // baked: bump MAP_BAKE_UNITS when the result changes
+    static_assert(sizeof(SMapBakeUnit) == sizeof(SMatrixMapUnit::a1) * 6);
+
+    int units = graph.AddSplit(L"units", m_Size.y, [this, &bake](int from, int to) {
+        for (int y = from; y < to; ++y) {
+            SMatrixMapUnit *mu = m_Unit + y * m_Size.x;
+            SMatrixMapPoint *mp = m_Point + y * (m_Size.x + 1);
+            SMapBakeUnit *bu = bake.m_Units.data() + y * m_Size.x;
+            for (int x = 0; x < m_Size.x; ++x, ++mu, ++mp, ++bu) {
+                if (mu->IsWater())
+                    continue;
 
-    mu = m_Unit;
-    mp = m_Point;
-    for (int y = 0; y < m_Size.y; ++y) {
-        for (int x = 0; x < m_Size.x; ++x, ++mu, ++mp) {
-            if (mu->IsWater())
-                continue;
-
-            D3DXVECTOR3 p0, p1, p2, p3;
-            D3DXPLANE pl;
-            float cc;
-
-            p0.x = 0;
-            p0.y = 0;
-            p0.z = mp->z;
-            p1.x = GLOBAL_SCALE;
-            p1.y = 0;
-            p1.z = (mp + 1)->z;
-            p2.x = GLOBAL_SCALE;
-            p2.y = GLOBAL_SCALE;
-            p2.z = (mp + m_Size.x + 2)->z;
-            p3.x = 0;
-            p3.y = GLOBAL_SCALE;
-            p3.z = (mp + m_Size.x + 1)->z;
-
-            if (mu->IsFlat()) {
-                mu->a1 = p0.z;
-            }
-            else {
-                D3DXPlaneFromPoints(&pl, &p0, &p1, &p2);
-                cc = -1.0f / pl.c;
-                mu->a1 = pl.a * cc;
-                mu->b1 = pl.b * cc;
-                mu->c1 = pl.d * cc;
-
-                D3DXPlaneFromPoints(&pl, &p0, &p2, &p3);
-                cc = -1.0f / pl.c;
-                mu->a2 = pl.a * cc;
-                mu->b2 = pl.b * cc;
-                mu->c2 = pl.d * cc;
+                if (bake.IsLoaded()) {
+                    mu->a1 = bu->a1;
+                    mu->b1 = bu->b1;
+                    mu->c1 = bu->c1;
+                    mu->a2 = bu->a2;
+                    mu->b2 = bu->b2;
+                    mu->c2 = bu->c2;
+                    continue;
+                }
+
+                D3DXVECTOR3 p0, p1, p2, p3;
+                D3DXPLANE pl;
+                float cc;
+
+                p0.x = 0;
+                p0.y = 0;
+                p0.z = mp->z;
+                p1.x = GLOBAL_SCALE;
+                p1.y = 0;
+                p1.z = (mp + 1)->z;
+                p2.x = GLOBAL_SCALE;
+                p2.y = GLOBAL_SCALE;
+                p2.z = (mp + m_Size.x + 2)->z;
+                p3.x = 0;
+                p3.y = GLOBAL_SCALE;
+                p3.z = (mp + m_Size.x + 1)->z;
+
+                if (mu->IsFlat()) {
+                    mu->a1 = p0.z;
+                }
+                else {
+                    D3DXPlaneFromPoints(&pl, &p0, &p1, &p2);
+                    cc = -1.0f / pl.c;
+                    mu->a1 = pl.a * cc;
+                    mu->b1 = pl.b * cc;
+                    mu->c1 = pl.d * cc;
+
+                    D3DXPlaneFromPoints(&pl, &p0, &p2, &p3);
+                    cc = -1.0f / pl.c;
+                    mu->a2 = pl.a * cc;
+                    mu->b2 = pl.b * cc;
+                    mu->c2 = pl.d * cc;
+                }
+                *bu = SMapBakeUnit{mu->a1, mu->b1, mu->c1, mu->a2, mu->b2, mu->c2};
             }
         }
-        ++mp;
-    }
+    }, {points, baked});
 
-    g_LoadProgress->SetCurLPPos(52000);
+    int inshores = graph.AddMain(L"inshores", [this, &stor, propkey, propval]() {
+        g_LoadProgress->SetCurLPPos(52000);
 
-    ic = propkey->FindAsWStr(DATA_DISABLEINSHORE);
-    if (ic >= 0) {
-        INITFLAG(m_Flags, MMFLAG_DISABLEINSHORE_BUILD, propval->GetAsParamParser(ic).GetInt() != 0);
-    }
+        int ic = propkey->FindAsWStr(DATA_DISABLEINSHORE);
+        if (ic >= 0) {
+            INITFLAG(m_Flags, MMFLAG_DISABLEINSHORE_BUILD, propval->GetAsParamParser(ic).GetInt() != 0);
+        }
 
-    // building water
-    CDataBuf *inshore_x = stor.GetBuf(DATA_GROUPS_INSHORES, DATA_GROUPS_INSHORES_X, ST_FLOAT);
-    if (inshore_x != NULL && !FLAG(m_Flags, MMFLAG_DISABLEINSHORE_BUILD)) {
-        // loading inshores
+        CDataBuf *inshore_x = stor.GetBuf(DATA_GROUPS_INSHORES, DATA_GROUPS_INSHORES_X, ST_FLOAT);
+        if (inshore_x != NULL && !FLAG(m_Flags, MMFLAG_DISABLEINSHORE_BUILD)) {
+            // loading inshores
 
-        CDataBuf *inshore_y = stor.GetBuf(DATA_GROUPS_INSHORES, DATA_GROUPS_INSHORES_Y, ST_FLOAT);
-        CDataBuf *inshore_nx = stor.GetBuf(DATA_GROUPS_INSHORES, DATA_GROUPS_INSHORES_NX, ST_FLOAT);
-        CDataBuf *inshore_ny = stor.GetBuf(DATA_GROUPS_INSHORES, DATA_GROUPS_INSHORES_NY, ST_FLOAT);
+            CDataBuf *inshore_y = stor.GetBuf(DATA_GROUPS_INSHORES, DATA_GROUPS_INSHORES_Y, ST_FLOAT);
+            CDataBuf *inshore_nx = stor.GetBuf(DATA_GROUPS_INSHORES, DATA_GROUPS_INSHORES_NX, ST_FLOAT);
+            CDataBuf *inshore_ny = stor.GetBuf(DATA_GROUPS_INSHORES, DATA_GROUPS_INSHORES_NY, ST_FLOAT);
 
-        int index = 0;
+            int index = 0;
 
-        for (int j = 0; j < m_GroupSize.y; ++j) {
-            for (int i = 0; i < m_GroupSize.x; ++i, ++index) {
-                int n = inshore_x->GetArrayLength(index);
-                if (n == 0)
-                    continue;
+            for (int j = 0; j < m_GroupSize.y; ++j) {
+                for (int i = 0; i < m_GroupSize.x; ++i, ++index) {
+                    int n = inshore_x->GetArrayLength(index);
+                    if (n == 0)
+                        continue;
 
-                float *xx = inshore_x->GetFirst<float>(index);
-                float *yy = inshore_y->GetFirst<float>(index);
-                float *nxx = inshore_nx->GetFirst<float>(index);
-                float *nyy = inshore_ny->GetFirst<float>(index);
+                    float *xx = inshore_x->GetFirst<float>(index);
+                    float *yy = inshore_y->GetFirst<float>(index);
+                    float *nxx = inshore_nx->GetFirst<float>(index);
+                    float *nyy = inshore_ny->GetFirst<float>(index);
 
-                PCMatrixMapGroup g = GetGroupByIndex(i, j);
-                if (g)
-                    g->InitInshoreWaves(n, xx, yy, nxx, nyy);
+                    PCMatrixMapGroup g = GetGroupByIndex(i, j);
+                    if (g)
+                        g->InitInshoreWaves(n, xx, yy, nxx, nyy);
+                }
             }
+
+            SETFLAG(m_Flags, MMFLAG_DISABLEINSHORE_BUILD);
         }
+    }, {groups, units});
 
-        SETFLAG(m_Flags, MMFLAG_DISABLEINSHORE_BUILD);
-    }
+    // building water: the depths are taken in parallel, the textures are made here
+    std::vector<BYTE> &water_alpha = bake.m_WaterAlpha;
+
+    int wateralpha = graph.AddSplit(L"wateralpha", grpcnt, [this, &bake](int from, int to) {
+        if (bake.IsLoaded())
+            return;
+        for (int i = from; i < to; ++i) {
+            if (m_Group[i])
+                m_Group[i]->CalcWaterAlpha(bake.m_WaterAlpha.data() + i * WATER_ALPHA_SIZE * WATER_ALPHA_SIZE);
+        }
+    }, {groups, units});
+
+    int water = graph.AddMain(L"water", [this, &water_alpha]() {
+        ASSERT(int(water_alpha.size()) == m_GroupSize.x * m_GroupSize.y * WATER_ALPHA_SIZE * WATER_ALPHA_SIZE);
 
-    {
         int x = 0;
         int y = 0;
         int cntg = m_GroupSize.x * m_GroupSize.y;
@@ -1374,13 +1506,13 @@ int CMatrixMap::PrepareMap(CStorage &stor, const std::wstring &mapname) {
                 ++y;
             }
             if (m_Group[i])
-                m_Group[i]->BuildWater(x, y);
+                m_Group[i]->BuildWater(x, y, water_alpha.data() + i * WATER_ALPHA_SIZE * WATER_ALPHA_SIZE);
         }
-    }
+    }, {inshores, wateralpha});
 
     // load bridges here, to set z of points
 
-    {
+    int bridges = graph.AddMain(L"bridges", [this, &stor]() {
         CDataBuf *br = stor.GetBuf(DATA_BRIDGES, DATA_BRIDGES_DATA, ST_BYTE);
         if (br) {
             for (DWORD i = 0; i < br->GetArraysCount(); ++i) {
@@ -1455,15 +1587,15 @@ int CMatrixMap::PrepareMap(CStorage &stor, const std::wstring &mapname) {
                 }
             }
         }
-    }
-
-    g_LoadProgress->SetCurLPPos(82000);
+    }, {water});
 
     // loading surfaces
     // if (0)
-    {
+    int surfaces = graph.AddMain(L"surfaces", [&stor, propkey, propval]() {
+        g_LoadProgress->SetCurLPPos(82000);
+
         bool striped = false;
-        ic = propkey->FindAsWStr(DATA_TOPTEXSTRIPED);
+        int ic = propkey->FindAsWStr(DATA_TOPTEXSTRIPED);
         if (ic >= 0)
             striped = propval->GetAsWStr(ic) == L"1";
 
@@ -1497,78 +1629,97 @@ int CMatrixMap::PrepareMap(CStorage &stor, const std::wstring &mapname) {
 
             CTerSurface::Load(i + index, srfc->GetFirst<BYTE>(i));
         }
-    }
-
-    g_LoadProgress->SetCurLPPos(88000);
-    int allobj = ReloadDynamics(stor, RS_MAPOBJECTS);
-    g_LoadProgress->SetCurLPPos(89000);
-    allobj += ReloadDynamics(stor, RS_BUILDINGS);
-    g_LoadProgress->SetCurLPPos(89500);
-
-    ASSERT(robots_buf.empty());
-    allobj += ReloadDynamics(stor, RS_ROBOTS, &robots_buf);
-    g_LoadProgress->SetCurLPPos(90000);
-    allobj += ReloadDynamics(stor, RS_CANNONS);
-    g_LoadProgress->SetCurLPPos(91000);
-    ReloadDynamics(stor, RS_EFFECTS);
-    g_LoadProgress->SetCurLPPos(92000);
-
-    CDataBuf *roads = stor.GetBuf(DATA_ROADS, DATA_ROADS_DATA, ST_BYTE);
-    if (roads && roads->GetArrayLength(0) > 0) {
-        CBuf rnb;
-        rnb.Add(roads->GetFirst<BYTE>(0), roads->GetArrayLength(0));
-        rnb.Pointer(0);
-        DWORD ver = rnb.Get<DWORD>();
-        if (ver != 27)
-            ERROR_S(L"Please, recompile map with last editor...");
-
-        m_RN.Load(rnb, ver);
-        m_RN.InitPL(m_SizeMove.x, m_SizeMove.y);
-    }
+    }, {bridges});
+
+    int allobj = 0;
+    int dynamics = graph.AddMain(L"dynamics", [this, &stor, &allobj]() {
+        g_LoadProgress->SetCurLPPos(88000);
+        allobj = ReloadDynamics(stor, RS_MAPOBJECTS);
+        g_LoadProgress->SetCurLPPos(89000);
+        allobj += ReloadDynamics(stor, RS_BUILDINGS);
+        g_LoadProgress->SetCurLPPos(89500);
+
+        ASSERT(robots_buf.empty());
+        allobj += ReloadDynamics(stor, RS_ROBOTS, &robots_buf);
+        g_LoadProgress->SetCurLPPos(90000);
+        allobj += ReloadDynamics(stor, RS_CANNONS);
+        g_LoadProgress->SetCurLPPos(91000);
+        ReloadDynamics(stor, RS_EFFECTS);
+        g_LoadProgress->SetCurLPPos(92000);
+    }, {surfaces, ids});
+
+    int roads = graph.AddMain(L"roads", [this, &stor]() {
+        CDataBuf *roads = stor.GetBuf(DATA_ROADS, DATA_ROADS_DATA, ST_BYTE);
+        if (roads && roads->GetArrayLength(0) > 0) {
+            CBuf rnb;
+            rnb.Add(roads->GetFirst<BYTE>(0), roads->GetArrayLength(0));
+            rnb.Pointer(0);
+            DWORD ver = rnb.Get<DWORD>();
+            if (ver != 27)
+                ERROR_S(L"Please, recompile map with last editor...");
+
+            m_RN.Load(rnb, ver);
+            m_RN.InitPL(m_SizeMove.x, m_SizeMove.y);
+        }
+    }, {dynamics});
 
     // prepare vis
-    CDataBuf *dbl = stor.GetBuf(DATA_GROUPS_VIS, DATA_GROUPS_VIS_LEVELS, ST_INT32);
+    // it allocates from the heap for every group, which is not for the workers
+    int vis = graph.AddMain(L"visibility", [this, &stor]() {
+        CDataBuf *dbl = stor.GetBuf(DATA_GROUPS_VIS, DATA_GROUPS_VIS_LEVELS, ST_INT32);
 
-    if (dbl) {
-        CDataBuf *dbg = stor.GetBuf(DATA_GROUPS_VIS, DATA_GROUPS_VIS_GROUPS, ST_INT32);
-        CDataBuf *dbz = stor.GetBuf(DATA_GROUPS_VIS, DATA_GROUPS_VIS_ZFROM, ST_FLOAT);
+        if (dbl) {
+            CDataBuf *dbg = stor.GetBuf(DATA_GROUPS_VIS, DATA_GROUPS_VIS_GROUPS, ST_INT32);
+            CDataBuf *dbz = stor.GetBuf(DATA_GROUPS_VIS, DATA_GROUPS_VIS_ZFROM, ST_FLOAT);
 
-        float *z = dbz->GetFirst<float>(0);
+            float *z = dbz->GetFirst<float>(0);
 
-        int gcnt = m_GroupSize.x * m_GroupSize.y;
+            int gcnt = m_GroupSize.x * m_GroupSize.y;
 
-        m_GroupVis = (SGroupVisibility *)HAllocClear(sizeof(SGroupVisibility) * gcnt, g_MatrixHeap);
-        ASSERT(gcnt == dbl->GetArraysCount());
+            m_GroupVis = (SGroupVisibility *)HAllocClear(sizeof(SGroupVisibility) * gcnt, g_MatrixHeap);
+            ASSERT(gcnt == dbl->GetArraysCount());
 
-        for (int i = 0; i < gcnt; ++i) {
-            SGroupVisibility *gv = m_GroupVis + i;
+            for (int i = 0; i < gcnt; ++i) {
+                SGroupVisibility *gv = m_GroupVis + i;
 
-            gv->levels_cnt = dbl->GetArrayLength(i);
-            gv->levels = (int *)HAlloc(gv->levels_cnt * sizeof(int), g_MatrixHeap);
-            memcpy(gv->levels, dbl->GetFirst<int>(i), gv->levels_cnt * sizeof(int));
+                gv->levels_cnt = dbl->GetArrayLength(i);
+                gv->levels = (int *)HAlloc(gv->levels_cnt * sizeof(int), g_MatrixHeap);
+                memcpy(gv->levels, dbl->GetFirst<int>(i), gv->levels_cnt * sizeof(int));
 
-            gv->vis_cnt = dbg->GetArrayLength(i);
-            gv->vis = (PCMatrixMapGroup *)HAlloc(gv->vis_cnt * sizeof(PCMatrixMapGroup), g_MatrixHeap);
-            int *f = dbg->GetFirst<int>(i);
-            for (int t = 0; t < gv->vis_cnt; ++t) {
-                gv->vis[t] = g_MatrixMap->m_Group[f[t]];
+                gv->vis_cnt = dbg->GetArrayLength(i);
+                gv->vis = (PCMatrixMapGroup *)HAlloc(gv->vis_cnt * sizeof(PCMatrixMapGroup), g_MatrixHeap);
+                int *f = dbg->GetFirst<int>(i);
+                for (int t = 0; t < gv->vis_cnt; ++t) {
+                    gv->vis[t] = g_MatrixMap->m_Group[f[t]];
+                }
+                gv->z_from = z[i];
             }
-            gv->z_from = z[i];
         }
-    }
+        g_LoadProgress->SetCurLPPos(94000);
+    }, {roads});
+
+    int campos = 0;
+    graph.AddMain(L"static", [this, &stor, &allobj, &campos]() {
+        StaticPrepare(allobj);
+        m_Cursor.SetPos(100, 100);
+
+        m_StartTime = timeGetTime();
+        for (int i = 0; i < m_SideCnt; ++i) {
+            // m_Side[i].SetStatus(SS_NONE);
+            m_Side[i].ClearStatistics();
+        }
 
-    g_LoadProgress->SetCurLPPos(94000);
+        campos = ReloadDynamics(stor, RS_CAMPOS);
+    }, {vis});
 
-    StaticPrepare(allobj);
-    m_Cursor.SetPos(100, 100);
+    graph.Run();
 
-    m_StartTime = timeGetTime();
-    for (int i = 0; i < m_SideCnt; ++i) {
-        // m_Side[i].SetStatus(SS_NONE);
-        m_Side[i].ClearStatistics();
-    }
+    if (!bake.IsLoaded())
+        bake.Store();
+
+    StoreLoadTimes(mapname, props_time, graph, bake.IsLoaded());
 
-    return ReloadDynamics(stor, RS_CAMPOS);
+    return campos;
 }
 
 void CMatrixMap::StaticPrepare2(void* robots) {
@@ -1747,6 +1898,7 @@ void CMatrixMap::Restart(void) {
     m_EffectSpawners = NULL;
 
     // removing all effects
+    m_Projectiles.Clear();
     while (m_EffectsFirst) {
 #ifdef _DEBUG
         SubEffect(DEBUG_CALL_INFO, m_EffectsFirst);
@@ -1935,6 +2087,7 @@ void CMatrixMap::CreatePoolDefaultResources(bool loading) {
     else {
         m_Minimap.RestoreTexture();
         m_DI.OnResetDevice();
+        Text::OnResetDevice();
         CBaseTexture::OnResetDevice();
     }
 
@@ -1988,8 +2141,10 @@ void CMatrixMap::ReleasePoolDefaultResources(void) {
     CVOShadowProj::MarkAllBuffersNoNeed();
     CVOShadowStencil::MarkAllBuffersNoNeed();
     CInstDraw::MarkAllBuffersNoNeed();
+    CStreamRing::MarkAllBuffersNoNeed();
     SInshorewave::MarkAllBuffersNoNeed();
     m_DI.OnLostDevice();
+    Text::OnLostDevice();
     CBaseTexture::OnLostDevice();
 
     RESETFLAG(m_Flags, MMFLAG_VIDEO_RESOURCES_READY);
@@ -12,6 +12,7 @@
 #include "MatrixSkinManager.hpp"
 #include "MatrixFlyer.hpp"
 #include "MatrixObjectCannon.hpp"
+#include "RenderQueue.hpp"
 
 #include "Mem.hpp"
 
@@ -68,6 +69,8 @@ SObjectCore *CMatrixMapStatic::GetCore(const SDebugCallInfo &dci) {
 CMatrixMapStatic::~CMatrixMapStatic() {
     UnjoinGroup();
     DelLT();
+    g_MatrixMap->m_Influence.Remove(this, false);
+    ReleaseHandle();
     if (g_MatrixMap->m_TraceStopObj == this) {
         g_MatrixMap->m_TraceStopObj = NULL;
     }
@@ -81,9 +84,29 @@ CMatrixMapStatic::~CMatrixMapStatic() {
     m_Core->Release();
 }
 
+int CMatrixMapStatic::GetHandleSlot(void) {
+    if (m_HandleSlot < 0 || g_MatrixMap->m_Handles.Resolve(m_HandleSlot, m_NID) != this)
+        m_HandleSlot = g_MatrixMap->m_Handles.Alloc(this, m_NID);
+    return m_HandleSlot;
+}
+
+void CMatrixMapStatic::ReleaseHandle(void) {
+    if (m_HandleSlot < 0)
+        return;
+    g_MatrixMap->m_Handles.Release(m_HandleSlot, m_NID);
+    m_HandleSlot = -1;
+}
+
+void CMatrixMapStatic::RemoveInfluence(void) {
+    g_MatrixMap->m_Influence.Remove(this, false);
+}
+
 void CMatrixMapStatic::StaticTakt(int ms) {
     DTRACE();
 
+    // before LogicTakt: object may be deleted inside of it
+    g_MatrixMap->m_Influence.Refresh(this);
+
     if (IsAblaze()) {
         DCP();
         int ttl = GetAblazeTTL();
@@ -732,9 +755,25 @@ void CMatrixMapStatic::SortEndGraphicTakt(int step) {
 void CMatrixMapStatic::SortEndDraw(void) {
     DTRACE();
 
+    // every Draw sets up its own states, so the order is free: by the type, then by the skin, so the draws of
+    // the same textures and stages go one after another, then near to far as they are sorted
+    static CRenderQueue queue;
+    queue.Clear();
     for (int i = objects_left; i < objects_rite; ++i) {
-        objects[i]->Draw();
+        CMatrixMapStatic *o = objects[i];
+        queue.Add(CRenderQueue::Key(o->GetObjectType(), CRenderQueue::Material(o->GetDrawSkin()), i - objects_left),
+                  o);
     }
+    queue.Sort();
+
+    // the units of the robots and the cannons are drawn after the rest, grouped by their frames
+    CMatrixRobot::DrawBatchBegin();
+    CMatrixCannon::DrawBatchBegin();
+    for (int i = 0; i < queue.GetCount(); ++i) {
+        ((CMatrixMapStatic *)queue.Get(i).m_Data)->Draw();
+    }
+    CMatrixRobot::DrawBatchEnd();
+    CMatrixCannon::DrawBatchEnd();
 }
 
 void CMatrixMapStatic::SortEndBeforeDraw(void) {
@@ -775,15 +814,35 @@ void CMatrixMapStatic::Sort(const D3DXMATRIX &sort) {
 
     // check visibility with frustum...
 
+    CMatrixMapCull &cull = g_MatrixMap->m_Cull;
+    cull.CountTested();
+
+    D3DXVECTOR3 r(GetRadius(), GetRadius(), GetRadius());
+    D3DXVECTOR3 mins(GetGeoCenter() - r), maxs(GetGeoCenter() + r);
     if (IsFlyer()) {
-        if (!g_MatrixMap->m_Camera.IsInFrustum(GetGeoCenter(), GetRadius()))
+        if (!g_MatrixMap->m_Camera.IsInFrustum(GetGeoCenter(), GetRadius())) {
+            cull.CountFrustumCulled();
             return;
+        }
     }
     else {
         if (!g_MatrixMap->m_Camera.IsInFrustum(m_AdditionalPoint)) {
-            if (!g_MatrixMap->m_Camera.IsInFrustum(GetGeoCenter(), GetRadius()))
+            if (!g_MatrixMap->m_Camera.IsInFrustum(GetGeoCenter(), GetRadius())) {
+                cull.CountFrustumCulled();
                 return;
+            }
         }
+        // the shadow end as well, it is calculated for the map objects only
+        if (GetObjectType() == OBJECT_TYPE_MAPOBJECT) {
+            D3DXVec3Minimize(&mins, &mins, &m_AdditionalPoint);
+            D3DXVec3Maximize(&maxs, &maxs, &m_AdditionalPoint);
+        }
+    }
+
+    // ...and with the terrain in front of it
+    if (cull.IsOccluded(mins, maxs)) {
+        cull.CountOcclusionCulled();
+        return;
     }
 
 #if SHOW_ASSIGNED_GROUPS
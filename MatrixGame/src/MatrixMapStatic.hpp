@@ -11,6 +11,7 @@
 #include <utils.hpp>
 
 #include "Network/StateManager.hpp"
+#include "Logic/MatrixInfluence.hpp"
 
 class CMatrixMapGroup;
 typedef CMatrixMapGroup *PCMatrixMapGroup;
@@ -296,6 +297,12 @@ public:
     CMatrixMapStatic *m_NextStackItem;
     CMatrixMapStatic *m_PrevStackItem;
 
+    SInfluenceTrack m_InfluenceTrack;  // what this object currently adds to g_MatrixMap->m_Influence
+
+    int m_HandleSlot{-1};  // slot in g_MatrixMap->m_Handles, taken on first demand
+    int GetHandleSlot(void);
+    void ReleaseHandle(void);  // all weak references to the object become invalid
+
     bool IsNotOnMinimap(void) const { return FLAG(m_RChange, MR_MiniMap); }
     void SetInvulnerability(void) { SETFLAG(m_ObjectState, OBJECT_STATE_INVULNERABLE); }
     void ResetInvulnerability(void) { RESETFLAG(m_ObjectState, OBJECT_STATE_INVULNERABLE); }
@@ -461,8 +468,11 @@ public:
     inline void DelLT(void) {
         if (InLT()) {
             LIST_DEL_CLEAR(this, m_FirstLogicTemp, m_LastLogicTemp, m_PrevLogicTemp, m_NextLogicTemp);
+            RemoveInfluence();
         }
     }
+    // out of the logic list the object is not refreshed, so it takes its contribution back
+    void RemoveInfluence(void);
 
     static void ProceedLogic(int ms);
 
@@ -483,6 +493,8 @@ public:
 
     virtual void BeforeDraw(void) = 0;
     virtual void Draw(void) = 0;
+    // the skin Draw starts with, the draws of the same skin go one after another
+    virtual const SSkin *GetDrawSkin(void) const { return NULL; }
     virtual void DrawShadowStencil(void) = 0;
     virtual void DrawShadowProj(void) = 0;
     virtual void FreeDynamicResources(void) = 0;
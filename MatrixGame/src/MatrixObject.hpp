@@ -132,6 +132,7 @@ public:
 
     virtual void BeforeDraw(void);
     virtual void Draw(void);
+    virtual const SSkin *GetDrawSkin(void) const { return m_Graph ? m_Graph->GetSkin() : NULL; }
     virtual void DrawShadowStencil(void);
     virtual void DrawShadowProj(void);
 
@@ -1352,6 +1352,7 @@ void CMatrixBuilding::ReleaseMe(void) {
     //}
     //}
 
+    ReleaseHandle();
     CMatrixMapStatic *objects = CMatrixMapStatic::GetFirstLogic();
 
     while (objects) {
@@ -1362,7 +1363,7 @@ void CMatrixBuilding::ReleaseMe(void) {
             }
 
             objects->AsRobot()->RemoveCaptureCandidate(this);
-            objects->AsRobot()->GetEnv()->RemoveFromList(this);
+            objects->AsRobot()->GetEnv()->RemoveTarget(this);
             if (objects->AsRobot()->GetCaptureFactory() == this) {
                 objects->AsRobot()->StopCapture();
             }
@@ -303,6 +303,11 @@ public:
                         CMatrixMapStatic *attaker);
     virtual void BeforeDraw(void);
     virtual void Draw(void);
+    virtual const SSkin *GetDrawSkin(void) const {
+        if (m_GGraph == NULL || m_GGraph->m_First == NULL || m_GGraph->m_First->m_Obj == NULL)
+            return NULL;
+        return m_GGraph->m_First->m_Obj->GetSkin();
+    }
     virtual void DrawShadowStencil(void);
     virtual void DrawShadowProj(void);
 
@@ -519,10 +519,34 @@ void CMatrixCannon::BeforeDraw(void) {
         m_ShadowProj->BeforeRender();
 }
 
+CVOBatch CMatrixCannon::m_Batch;
+
+void CMatrixCannon::DrawBatchEnd(void) {
+    for (int i = 0; i < 4; i++) {
+        ASSERT_DX(g_D3DD->SetSamplerState(i, D3DSAMP_MIPMAPLODBIAS, *((LPDWORD)(&g_MatrixMap->m_BiasCannons))));
+    }
+    m_Batch.Flush();
+}
+
 void CMatrixCannon::Draw(void) {
     // g_D3DD->SetRenderState( D3DRS_NORMALIZENORMALS,  TRUE );
     uintptr_t coltex = (uintptr_t)g_MatrixMap->GetSideColorTexture(m_Side)->Tex();
 
+    if (m_Batch.IsOpen()) {
+        DWORD tf = m_Core->m_TerainColor;
+        if (m_CurrState == CANNON_DIP)
+            tf = 0xFF808080;
+        else if (m_CurrState == CANNON_UNDER_CONSTRUCTION)
+            tf = 0xFF00FF00;
+        for (int i = 0; i < m_UnitCnt; i++) {
+            if (m_CurrState == CANNON_DIP && m_Unit[i].u1.s2.m_TTL <= 0)
+                continue;
+            ASSERT(m_Unit[i].m_Graph);
+            m_Batch.Add(m_Unit[i].m_Graph, DWORD(coltex), m_Unit[i].m_Matrix, tf, false);
+        }
+        return;
+    }
+
     for (int i = 0; i < 4; i++) {
         ASSERT_DX(g_D3DD->SetSamplerState(i, D3DSAMP_MIPMAPLODBIAS, *((LPDWORD)(&g_MatrixMap->m_BiasCannons))));
     }
@@ -1382,6 +1406,7 @@ bool CMatrixCannon::Damage(EWeapon weap, const D3DXVECTOR3 &pos, const D3DXVECTO
         m_ShadowType = SHADOW_OFF;
         RChange(MR_ShadowProjGeom | MR_ShadowStencil);
         RNeed(MR_ShadowProjGeom | MR_ShadowStencil);
+        g_MatrixMap->m_Influence.Remove(this, true);
         m_CurrState = CANNON_DIP;
 
         ReleaseMe();
@@ -1505,11 +1530,12 @@ void CMatrixCannon::ReleaseMe(void) {
     //    }
     //}
 
+    ReleaseHandle();
     CMatrixMapStatic *objects = CMatrixMapStatic::GetFirstLogic();
 
     while (objects) {
         if (objects->IsLiveRobot()) {
-            objects->AsRobot()->GetEnv()->RemoveFromList(this);
+            objects->AsRobot()->GetEnv()->RemoveTarget(this);
         }
         else if (objects->IsLiveBuilding()) {
             objects->AsBuilding()->m_BS.DeleteItem(this);
@@ -76,6 +76,8 @@ struct SMatrixCannonUnit {
 class CMatrixCannon : public CMatrixMapStatic {
     static void FireHandler(CMatrixMapStatic *hit, const D3DXVECTOR3 &pos, uintptr_t user, DWORD flags);
 
+    static CVOBatch m_Batch;  // units of all the cannons drawn by CMatrixMapStatic::SortEndDraw
+
 protected:
     // hitpoint
     CMatrixProgressBar m_PB;
@@ -195,6 +197,12 @@ public:
 
     virtual void BeforeDraw(void);
     virtual void Draw(void);
+    // see CMatrixRobot::DrawBatchBegin
+    static void DrawBatchBegin(void) { m_Batch.Open(); }
+    static void DrawBatchEnd(void);
+    virtual const SSkin *GetDrawSkin(void) const {
+        return (m_UnitCnt > 0 && m_Unit[0].m_Graph) ? m_Unit[0].m_Graph->GetSkin() : NULL;
+    }
     virtual void DrawShadowStencil(void);
     virtual void DrawShadowProj(void);
 
@@ -982,18 +982,33 @@ void CMatrixRobot::BeforeDraw(void) {
     }
 }
 
+void CMatrixRobot::DrawBatchEnd(void) {
+    for (int i = 0; i < 4; i++) {
+        ASSERT_DX(g_D3DD->SetSamplerState(i, D3DSAMP_MIPMAPLODBIAS, *((LPDWORD)(&g_MatrixMap->m_BiasRobots))));
+    }
+    m_Batch.Flush();
+}
+
 void CMatrixRobot::Draw(void) {
     uintptr_t coltex = (uintptr_t)g_MatrixMap->GetSideColorTexture(m_Side)->Tex();
     // g_D3DD->SetRenderState( D3DRS_NORMALIZENORMALS,  TRUE );
 
-    for (int i = 0; i < 4; i++) {
-        ASSERT_DX(g_D3DD->SetSamplerState(i, D3DSAMP_MIPMAPLODBIAS, *((LPDWORD)(&g_MatrixMap->m_BiasRobots))));
+    bool batch = m_Batch.IsOpen() && !IsInterfaceDraw();
+    if (!batch) {
+        for (int i = 0; i < 4; i++) {
+            ASSERT_DX(g_D3DD->SetSamplerState(i, D3DSAMP_MIPMAPLODBIAS, *((LPDWORD)(&g_MatrixMap->m_BiasRobots))));
+        }
     }
 
     if (m_CurrState == ROBOT_DIP) {
         for (int i = 0; i < m_UnitCnt; i++) {
             if (m_Unit[i].u1.s2.m_TTL <= 0)
                 continue;
+            if (batch) {
+                m_Batch.Add(m_Unit[i].m_Graph, DWORD(coltex), m_Unit[i].m_Matrix, 0xFF808080,
+                            m_Unit[i].u1.s1.m_Invert);
+                continue;
+            }
             g_D3DD->SetRenderState(D3DRS_TEXTUREFACTOR, 0xFF808080);
             ASSERT_DX(g_D3DD->SetTransform(D3DTS_WORLD, &(m_Unit[i].m_Matrix)));
             if (m_Unit[i].u1.s1.m_Invert) {
@@ -1009,6 +1024,11 @@ void CMatrixRobot::Draw(void) {
     else {
         for (int i = 0; i < m_UnitCnt; i++) {
             ASSERT(m_Unit[i].m_Graph);
+            if (batch) {
+                m_Batch.Add(m_Unit[i].m_Graph, DWORD(coltex), m_Unit[i].m_Matrix, m_Core->m_TerainColor,
+                            m_Unit[i].u1.s1.m_Invert);
+                continue;
+            }
             g_D3DD->SetRenderState(D3DRS_TEXTUREFACTOR, m_Core->m_TerainColor);
 
             ASSERT_DX(g_D3DD->SetTransform(D3DTS_WORLD, &(m_Unit[i].m_Matrix)));
@@ -1399,6 +1419,7 @@ void CMatrixRobot::SwitchAnimation(EAnimation a) {
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 SPneumaticData *CMatrixRobot::m_Pneumaic;
+CVOBatch CMatrixRobot::m_Batch;
 
 int g_fcnt;
 
@@ -176,6 +176,7 @@ protected:
     float m_MaxHitPointInversed;  // for normalized calcs
 
     static SPneumaticData *m_Pneumaic;
+    static CVOBatch m_Batch;  // units of all the robots drawn by CMatrixMapStatic::SortEndDraw
 
     // DWORD       m_RobotFlags; // m_ObjectState used instead. do not uncomment!
 public:
@@ -274,6 +275,10 @@ public:
 
     static void BuildPneumaticData(CVectorObject *vo);
     static void DestroyPneumaticData(void);
+
+    // Draw puts the units off till DrawBatchEnd, the units of the same frame and skin are drawn together
+    static void DrawBatchBegin(void) { m_Batch.Open(); }
+    static void DrawBatchEnd(void);
     void LinkPneumatic(void);
     void FirstLinkPneumatic(void);
 
@@ -306,6 +311,9 @@ public:
 
     virtual void BeforeDraw(void);
     virtual void Draw(void);
+    virtual const SSkin *GetDrawSkin(void) const {
+        return (m_UnitCnt > 0 && m_Unit[0].m_Graph) ? m_Unit[0].m_Graph->GetSkin() : NULL;
+    }
     virtual void DrawShadowStencil(void);
     virtual void DrawShadowProj(void);
 
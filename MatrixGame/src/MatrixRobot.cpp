@@ -11,6 +11,7 @@
 #include "Logic/MatrixRule.h"
 #include "MatrixObjectCannon.hpp"
 #include "MatrixFlyer.hpp"
+#include "MatrixCollision.hpp"
 #include "Interface/CInterface.h"
 
 #include "Effects/MatrixEffectShleif.hpp"
@@ -2042,6 +2043,7 @@ bool CMatrixRobotAI::Damage(
 
         DCP();
         SwitchAnimation(ANIMATION_OFF);
+        g_MatrixMap->m_Influence.Remove(this, true);
         m_CurrState = ROBOT_DIP;
 
         bool onair = false;
@@ -2744,6 +2746,7 @@ D3DXVECTOR3 CMatrixRobotAI::SphereRobotToAABBObstacleCollision(D3DXVECTOR3 &corr
     int calc_for_y = -COLLIDE_FIELD_R * 2;
     BYTE corners[COLLIDE_FIELD_R + COLLIDE_FIELD_R][COLLIDE_FIELD_R + COLLIDE_FIELD_R];
     memset(corners, -1, sizeof(corners));
+    SCollideCells cells;
 
     for (int cnt = 0; cnt < 4; cnt++) {
         //        robot_pos.x += vCorrTotal.x;
@@ -2791,25 +2794,32 @@ D3DXVECTOR3 CMatrixRobotAI::SphereRobotToAABBObstacleCollision(D3DXVECTOR3 &corr
 
             calc_for_x = x0;
             calc_for_y = y0;
+            cells.m_Cnt = -1;
         }
 
-        for (int y = y0; y < y1; ++y, smm += g_MatrixMap->m_SizeMove.x - (x1 - x0)) {
-            for (int x = x0; x < x1; ++x, ++smm) {
-                BYTE corner = corners[x - x0][y - y0];
-                if (corner == 0xFF)
-                    continue;
+        if (cells.m_Cnt < 0 || cells.m_X0 != x0 || cells.m_Y0 != y0 || cells.m_X1 != x1 || cells.m_Y1 != y1)
+            cells.Prepare(corners, x0, y0, x1, y1);
 
-                D3DXVECTOR3 col = SphereToAABB(robot_pos, smm, CPoint(x, y),
-                                               corner);  //, x >= (x1-COLLIDE_FIELD_R), y >= (y1-COLLIDE_FIELD_R));
+        // SphereToAABB does nothing for the cells out of the robot sphere, so only the candidates are resolved.
+        // The candidates are rechecked after every correction, as the scalar code checks each cell at the
+        // position corrected by the previous cells.
+        uint64_t cand = cells.Candidates(robot_pos, 0);
+        for (int i = 0; cand && i < cells.m_Cnt; ++i) {
+            if (!(cand & (uint64_t(1) << i)))
+                continue;
 
-                if (!IS_ZERO_VECTOR(col)) {
-                    col.z = 0;
+            D3DXVECTOR3 col = SphereToAABB(robot_pos, cells.m_Move[i], cells.m_Cell[i],
+                                           cells.m_Corner[i]);  //, x >= (x1-COLLIDE_FIELD_R), y >= (y1-COLLIDE_FIELD_R));
 
-                    robot_pos.x += col.x;
-                    robot_pos.y += col.y;
+            if (!IS_ZERO_VECTOR(col)) {
+                col.z = 0;
 
-                    col_cnt++;
-                }
+                robot_pos.x += col.x;
+                robot_pos.y += col.y;
+
+                col_cnt++;
+
+                cand = cells.Candidates(robot_pos, i + 1);
             }
         }
     }
@@ -4422,12 +4432,15 @@ void CMatrixRobotAI::GatherInfo(int type) {
     //    if(m_GatherPeriod >= GATHER_PERIOD) m_GatherPeriod = 0;
     //    else return;
 
-    CMatrixMapStatic *obj = CMatrixMapStatic::GetFirstLogic();
+    CMatrixMapStatic *obj;
     DCP();
 
     if (type == 0) {
         // Look
-        while (obj) {
+        CMatrixMapStatic **cand;
+        int cand_cnt = g_MatrixMap->m_Perception.Query(this, &cand);
+        for (int ci = 0; ci < cand_cnt; ++ci) {
+            obj = cand[ci];
             DCP();
             if (obj->IsLiveRobot() && obj != this && obj->GetSide() != m_Side) {
                 CMatrixRobotAI *robot = (CMatrixRobotAI *)obj;
@@ -4581,8 +4594,6 @@ void CMatrixRobotAI::GatherInfo(int type) {
                 }
             }
             DCP();
-            obj = obj->GetNextLogic();
-            DCP();
         }
     }
     else if (type == 1) {
@@ -4591,8 +4602,8 @@ void CMatrixRobotAI::GatherInfo(int type) {
         int r = GetRegion();
         DCP();
 
-        // Get info about enemies by radio
-        obj = CMatrixMapStatic::GetFirstLogic();
+        // Get info about enemies by radio (if anybody of the side knows something)
+        obj = g_MatrixMap->m_Perception.HasRadio(GetSide()) ? CMatrixMapStatic::GetFirstLogic() : NULL;
         DCP();
         while (obj) {
             DCP();
@@ -4600,26 +4611,24 @@ void CMatrixRobotAI::GatherInfo(int type) {
                 DCP();
                 if (obj->AsRobot()->m_GroupLogic == m_GroupLogic) {  // Если в одной группе
                     DCP();
-                    CEnemy *enemie = obj->AsRobot()->m_Environment.m_FirstEnemy;
-                    while (enemie) {
+                    CInfo *env = obj->AsRobot()->GetEnv();
+                    for (SEnemy *enemie = env->FirstEnemy(); enemie; enemie = env->NextEnemy(enemie)) {
                         DCP();
                         if (enemie->GetEnemy()->GetSide() != GetSide()) {
                             if (!enemie->m_DelSlowly)
                                 m_Environment.AddToListSlowly(enemie->GetEnemy());
                         }
-                        enemie = enemie->m_NextEnemy;
                     }
                 }
                 else if (obj->AsRobot()->GetTeam() == GetTeam() &&
                          obj->AsRobot()->GetRegion() == r) {  // Если в одной команде и в одном регионе
-                    CEnemy *enemie = obj->AsRobot()->m_Environment.m_FirstEnemy;
-                    while (enemie) {
+                    CInfo *env = obj->AsRobot()->GetEnv();
+                    for (SEnemy *enemie = env->FirstEnemy(); enemie; enemie = env->NextEnemy(enemie)) {
                         DCP();
                         if (enemie->GetEnemy()->GetSide() != GetSide()) {
                             if (!enemie->m_DelSlowly)
                                 m_Environment.AddToListSlowly(enemie->GetEnemy());
                         }
-                        enemie = enemie->m_NextEnemy;
                         DCP();
                     }
                 }
@@ -4640,23 +4649,23 @@ void CMatrixRobotAI::GatherInfo(int type) {
             if(gobj->GetObject()->GetObjectType() == OBJECT_TYPE_ROBOTAI){
                 CMatrixRobotAI* bot = (CMatrixRobotAI*)gobj->GetObject();
                 if(bot->m_Environment.GetEnemyCnt() > 0){
-                    CEnemy* enemies = bot->m_Environment.m_FirstEnemy;
+                    SEnemy* enemies = bot->m_Environment.FirstEnemy();
                     while(enemies){
                         if(!m_Environment.SearchEnemy(enemies->GetEnemy()))
                             m_Environment.AddToList(enemies->GetEnemy());
-                        enemies = enemies->m_NextEnemy;
+                        enemies = bot->m_Environment.NextEnemy(enemies);
                     }
                 }
             }
             gobj = gobj->m_NextObject;
         }*/
     // Classify all enemies
-    CEnemy *enemies = m_Environment.m_FirstEnemy;
+    SEnemy *enemies = m_Environment.FirstEnemy();
     DCP();
     while (enemies) {
         DCP();
         enemies->ClassifyEnemy(this);
-        enemies = enemies->m_NextEnemy;
+        enemies = m_Environment.NextEnemy(enemies);
         DCP();
     }
     DCP();
@@ -5198,10 +5207,12 @@ void CMatrixRobotAI::ReleaseMe(void) {
         }
     }
 
+    // enemy lists drop the robot by themselves, only the target pointers have to be reset
+    ReleaseHandle();
     CMatrixMapStatic *objects = CMatrixMapStatic::GetFirstLogic();
     while (objects) {
         if (objects->IsLiveRobot() && objects->AsRobot() != this) {
-            objects->AsRobot()->m_Environment.RemoveFromList(this);
+            objects->AsRobot()->m_Environment.RemoveTarget(this);
         }
         objects = objects->GetNextLogic();
     }
@@ -1883,27 +1883,11 @@ void SideSelectionCallBack(CMatrixMapStatic *ms, uintptr_t param) {
 ////////////////////////////////////////////////////////////////////////////////
 void CMatrixSideUnit::CalcStrength() {
     DTRACE();
-    int c_base = 0;
-    int c_building = 0;
-    float s_cannon = 0;
-    float s_robot = 0;
-
-    CMatrixMapStatic *obj = CMatrixMapStatic::GetFirstLogic();
-    while (obj) {
-        if (obj->GetSide() == m_Id) {
-            if (obj->IsLiveBuilding()) {
-                if (obj->AsBuilding()->IsBase())
-                    c_base++;
-                else
-                    c_building++;
-            }
-            else if (obj->IsLiveActiveCannon())
-                s_cannon += obj->AsCannon()->GetStrength();
-            else if (obj->IsLiveRobot())
-                s_robot += obj->AsRobot()->GetStrength();
-        }
-        obj = obj->GetNextLogic();
-    }
+    const SInfluenceCell &total = g_MatrixMap->m_Influence.Total(m_Id);
+    int c_base = total.m_BaseCnt;
+    int c_building = total.m_BuildingCnt - total.m_BaseCnt;
+    float s_cannon = total.m_CannonStrength;
+    float s_robot = total.m_RobotStrength;
 
     int res = 0;
     for (int r = 0; r < MAX_RESOURCES; r++)
@@ -2217,7 +2201,7 @@ void CMatrixSideUnit::EscapeFromBomb() {
     int escape_dist = Float2Int(escape_radius / GLOBAL_SCALE_MOVE) + 4;
     CPoint tp, tp2;
     int i;
-    CEnemy *enemy;
+    SEnemy *enemy;
 
     // Find bomb carrying robot if it is present.
     CMatrixMapStatic *ms = CMatrixMapStatic::GetFirstLogic();
@@ -2233,9 +2217,9 @@ void CMatrixSideUnit::EscapeFromBomb() {
         ASSERT(rbcnt < MAX_ROBOTS * 3);
         min_dist_enemy[rbcnt] = 1e20f;
 
-        enemy = ms->AsRobot()->GetEnv()->m_FirstEnemy;
-        for (; enemy; enemy = enemy->m_NextEnemy) {
-            auto tmp = GetWorldPos(enemy->m_Enemy) - GetWorldPos(ms);
+        enemy = ms->AsRobot()->GetEnv()->FirstEnemy();
+        for (; enemy; enemy = ms->AsRobot()->GetEnv()->NextEnemy(enemy)) {
+            auto tmp = GetWorldPos(enemy->GetEnemy()) - GetWorldPos(ms);
             min_dist_enemy[rbcnt] = std::min(min_dist_enemy[rbcnt], D3DXVec2LengthSq(&tmp));
         }
 
@@ -2321,9 +2305,9 @@ void CMatrixSideUnit::EscapeFromBomb() {
         float rpy = robot->m_PosY;
 
         float mde = 1e20f;
-        enemy = ms->AsRobot()->GetEnv()->m_FirstEnemy;
-        for (; enemy; enemy = enemy->m_NextEnemy) {
-            auto tmp = GetWorldPos(enemy->m_Enemy) - GetWorldPos(ms);
+        enemy = ms->AsRobot()->GetEnv()->FirstEnemy();
+        for (; enemy; enemy = ms->AsRobot()->GetEnv()->NextEnemy(enemy)) {
+            auto tmp = GetWorldPos(enemy->GetEnemy()) - GetWorldPos(ms);
             mde = std::min(mde, D3DXVec2LengthSq(&tmp));
         }
 
@@ -4525,37 +4509,8 @@ int CMatrixSideUnit::FindNearRegionWithUTR(int from, int *exclude_list, int excl
             for (t = 0; t < exclude_cnt; t++)
                 if (u == exclude_list[t])
                     break;
-            if (t >= exclude_cnt) {
-                if (flags & 1) {
-                    if ((flags & 8) && (m_Region[u].m_OurBaseCnt))
-                        return u;
-                    else if ((flags & 16) && (m_Region[u].m_OurBuildingCnt))
-                        return u;
-                    else if ((flags & 32) && (m_Region[u].m_OurRobotCnt))
-                        return u;
-                    else if ((flags & 64) && (m_Region[u].m_OurCannonCnt))
-                        return u;
-                }
-                if (flags & 2) {
-                    if ((flags & 8) && (m_Region[u].m_NeutralBaseCnt))
-                        return u;
-                    else if ((flags & 16) && (m_Region[u].m_NeutralBuildingCnt))
-                        return u;
-                    //                else if((flags & 32) && (m_Region[u].m_NeutralRobotCnt)) return u;
-                    else if ((flags & 64) && (m_Region[u].m_NeutralCannonCnt))
-                        return u;
-                }
-                if (flags & 4) {
-                    if ((flags & 8) && (m_Region[u].m_EnemyBaseCnt))
-                        return u;
-                    else if ((flags & 16) && (m_Region[u].m_EnemyBuildingCnt))
-                        return u;
-                    else if ((flags & 32) && (m_Region[u].m_EnemyRobotCnt))
-                        return u;
-                    else if ((flags & 64) && (m_Region[u].m_EnemyCannonCnt))
-                        return u;
-                }
-            }
+            if (t >= exclude_cnt && g_MatrixMap->m_Influence.Match(m_Id, u, flags))
+                return u;
 
             m_RegionIndex[cnt] = u;
             cnt++;
@@ -5269,18 +5224,18 @@ void CMatrixSideUnit::WarTL(int group) {
         if (!rl[i]->GetEnv()->m_TargetAttack) {
             // Находим ближайшего незакрытого врага
             float mindist = 1e10f;
-            CEnemy *enemyfind = NULL;
-            CEnemy *enemy = rl[i]->GetEnv()->m_FirstEnemy;
+            SEnemy *enemyfind = NULL;
+            SEnemy *enemy = rl[i]->GetEnv()->FirstEnemy();
             while (enemy) {
-                if (IsLiveUnit(enemy->m_Enemy) && enemy->m_Enemy != rl[i]) {
-                    float cd = Dist2(GetWorldPos(enemy->m_Enemy), GetWorldPos(rl[i]));
+                if (IsLiveUnit(enemy->GetEnemy()) && enemy->GetEnemy() != rl[i]) {
+                    float cd = Dist2(GetWorldPos(enemy->GetEnemy()), GetWorldPos(rl[i]));
                     if (cd < mindist) {
                         // Проверяем не закрыт ли он своими
                         D3DXVECTOR3 des, from, dir, p;
                         float t, dist;
 
                         from = rl[i]->GetGeoCenter();
-                        des = PointOfAim(enemy->m_Enemy);
+                        des = PointOfAim(enemy->GetEnemy());
                         dist = sqrt(POW2(from.x - des.x) + POW2(from.y - des.y) + POW2(from.z - des.z));
                         if (dist > 0.0f) {
                             t = 1.0f / dist;
@@ -5306,25 +5261,25 @@ void CMatrixSideUnit::WarTL(int group) {
                         }
                     }
                 }
-                enemy = enemy->m_NextEnemy;
+                enemy = rl[i]->GetEnv()->NextEnemy(enemy);
             }
             // Если не нашли открытого ищем закрытого
             if (!enemyfind) {
-                enemy = rl[i]->GetEnv()->m_FirstEnemy;
+                enemy = rl[i]->GetEnv()->FirstEnemy();
                 while (enemy) {
-                    if (IsLiveUnit(enemy->m_Enemy) && enemy->m_Enemy != rl[i]) {
-                        float cd = Dist2(GetWorldPos(enemy->m_Enemy), GetWorldPos(rl[i]));
+                    if (IsLiveUnit(enemy->GetEnemy()) && enemy->GetEnemy() != rl[i]) {
+                        float cd = Dist2(GetWorldPos(enemy->GetEnemy()), GetWorldPos(rl[i]));
                         if (cd < mindist) {
                             mindist = cd;
                             enemyfind = enemy;
                         }
                     }
-                    enemy = enemy->m_NextEnemy;
+                    enemy = rl[i]->GetEnv()->NextEnemy(enemy);
                 }
             }
 
             if (enemyfind) {
-                rl[i]->GetEnv()->m_TargetAttack = enemyfind->m_Enemy;
+                rl[i]->GetEnv()->m_TargetAttack = enemyfind->GetEnemy();
                 // Если новая цель пушка то меняем позицию
                 if (rl[i]->GetEnv()->m_TargetAttack->IsLiveActiveCannon()) {
                     rl[i]->GetEnv()->m_Place = -1;
@@ -5837,13 +5792,13 @@ void CMatrixSideUnit::WarTL(int group) {
                 // Если стоим на месте
                 if (IsInPlace(rl[i])) {
                     // Если несколько врагов и в цель не попадаем в течении долгого времени, то переназначаем цель
-                    if (env->m_EnemyCnt > 1 && (curTime - env->m_TargetChange) > 4000 &&
+                    if (env->GetEnemyCnt() > 1 && (curTime - env->m_TargetChange) > 4000 &&
                         (curTime - env->m_LastHitTarget) > 4000) {
                         env->m_TargetAttack = NULL;
                     }
                     // Если один враг и в цель не попадаем в течении долгого времени и стоим на месте, то переназначаем
                     // место
-                    if (env->m_EnemyCnt == 1 && (curTime - env->m_TargetChange) > 4000 &&
+                    if (env->GetEnemyCnt() == 1 && (curTime - env->m_TargetChange) > 4000 &&
                         (curTime - env->m_LastHitTarget) > 4000) {
                         env->AddBadPlace(env->m_Place);
                         env->m_Place = -1;
@@ -5897,7 +5852,7 @@ void CMatrixSideUnit::WarTL(int group) {
                 // Если стоим на месте
                 if (IsInPlace(rl[i])) {
                     // Если несколько врагов, а текущий долго закрыт своими, то переназначаем цель
-                    if (env->m_EnemyCnt > 1 && (curTime - env->m_TargetChange) > 4000 &&
+                    if (env->GetEnemyCnt() > 1 && (curTime - env->m_TargetChange) > 4000 &&
                         (curTime - env->m_LastFire) > 4000) {
                         env->m_TargetAttack = NULL;
                     }
@@ -8015,20 +7970,20 @@ bool CMatrixSideUnit::FirePL(int group) {
         }
         if (!(rl[i]->GetEnv()->m_TargetAttack && rl[i]->GetEnv()->SearchEnemy(rl[i]->GetEnv()->m_TargetAttack))) {
             float mindist = 1e10f;
-            CEnemy *enemyfind = NULL;
-            CEnemy *enemy = NULL;
+            SEnemy *enemyfind = NULL;
+            SEnemy *enemy = NULL;
             // Находим ближайшего незакрытого врага
-            enemy = rl[i]->GetEnv()->m_FirstEnemy;
+            enemy = rl[i]->GetEnv()->FirstEnemy();
             while (enemy) {
-                if (IsLiveUnit(enemy->m_Enemy) && enemy->m_Enemy != rl[i]) {
-                    float cd = Dist2(GetWorldPos(enemy->m_Enemy), GetWorldPos(rl[i]));
+                if (IsLiveUnit(enemy->GetEnemy()) && enemy->GetEnemy() != rl[i]) {
+                    float cd = Dist2(GetWorldPos(enemy->GetEnemy()), GetWorldPos(rl[i]));
                     if (cd < mindist) {
                         // Проверяем не закрыт ли он своими
                         D3DXVECTOR3 des, from, dir, p;
                         float t, dist;
 
                         from = rl[i]->GetGeoCenter();
-                        des = PointOfAim(enemy->m_Enemy);
+                        des = PointOfAim(enemy->GetEnemy());
                         dist = sqrt(POW2(from.x - des.x) + POW2(from.y - des.y) + POW2(from.z - des.z));
                         if (dist > 0.0f) {
                             t = 1.0f / dist;
@@ -8055,25 +8010,25 @@ bool CMatrixSideUnit::FirePL(int group) {
                         }
                     }
                 }
-                enemy = enemy->m_NextEnemy;
+                enemy = rl[i]->GetEnv()->NextEnemy(enemy);
             }
             // Если не нашли открытого ищем закрытого
             if (!enemyfind) {
-                enemy = rl[i]->GetEnv()->m_FirstEnemy;
+                enemy = rl[i]->GetEnv()->FirstEnemy();
                 while (enemy) {
-                    if (IsLiveUnit(enemy->m_Enemy) && enemy->m_Enemy != rl[i]) {
-                        float cd = Dist2(GetWorldPos(enemy->m_Enemy), GetWorldPos(rl[i]));
+                    if (IsLiveUnit(enemy->GetEnemy()) && enemy->GetEnemy() != rl[i]) {
+                        float cd = Dist2(GetWorldPos(enemy->GetEnemy()), GetWorldPos(rl[i]));
                         if (cd < mindist) {
                             mindist = cd;
                             enemyfind = enemy;
                         }
                     }
-                    enemy = enemy->m_NextEnemy;
+                    enemy = rl[i]->GetEnv()->NextEnemy(enemy);
                 }
             }
 
             if (enemyfind) {
-                rl[i]->GetEnv()->m_TargetAttack = enemyfind->m_Enemy;
+                rl[i]->GetEnv()->m_TargetAttack = enemyfind->GetEnemy();
             }
         }
     }
@@ -8277,13 +8232,13 @@ void CMatrixSideUnit::WarPL(int group) {
             (rl[i]->GetEnv()->m_TargetAttack->GetObjectType() != OBJECT_TYPE_CANNON ||
              ((CMatrixCannon *)(rl[i]->GetEnv()->m_TargetAttack))->m_ParentBuilding != m_PlayerGroup[group].m_Obj)) {
             float mindist = 1e10f;
-            CEnemy *enemyfind = NULL;
-            CEnemy *enemy = rl[i]->GetEnv()->m_FirstEnemy;
+            SEnemy *enemyfind = NULL;
+            SEnemy *enemy = rl[i]->GetEnv()->FirstEnemy();
             while (enemy) {
-                if (enemy->m_Enemy->IsLiveActiveCannon() &&
-                    enemy->m_Enemy->AsCannon()->m_ParentBuilding == m_PlayerGroup[group].m_Obj) {
+                if (enemy->GetEnemy()->IsLiveActiveCannon() &&
+                    enemy->GetEnemy()->AsCannon()->m_ParentBuilding == m_PlayerGroup[group].m_Obj) {
                     while (true) {
-                        float cd = Dist2(GetWorldPos(enemy->m_Enemy), GetWorldPos(rl[i]));
+                        float cd = Dist2(GetWorldPos(enemy->GetEnemy()), GetWorldPos(rl[i]));
                         if (enemyfind) {
                             if (mindist < cd)
                                 break;
@@ -8294,35 +8249,35 @@ void CMatrixSideUnit::WarPL(int group) {
                         break;
                     }
                 }
-                enemy = enemy->m_NextEnemy;
+                enemy = rl[i]->GetEnv()->NextEnemy(enemy);
             }
             if (enemyfind) {
-                rl[i]->GetEnv()->m_TargetAttack = enemyfind->m_Enemy;
+                rl[i]->GetEnv()->m_TargetAttack = enemyfind->GetEnemy();
                 rl[i]->GetEnv()->m_Place = -1;
             }
         }
 
         if (!rl[i]->GetEnv()->m_TargetAttack) {
             float mindist = 1e10f;
-            CEnemy *enemyfind = NULL;
-            CEnemy *enemy = NULL;
+            SEnemy *enemyfind = NULL;
+            SEnemy *enemy = NULL;
             // Находим цель которую указал игрок
             if (m_PlayerGroup[group].m_Obj && m_PlayerGroup[group].m_Obj != rl[i]) {
                 enemyfind = rl[i]->GetEnv()->SearchEnemy(m_PlayerGroup[group].m_Obj);
             }
             // Находим ближайшего незакрытого врага
             if (!enemyfind) {
-                enemy = rl[i]->GetEnv()->m_FirstEnemy;
+                enemy = rl[i]->GetEnv()->FirstEnemy();
                 while (enemy) {
-                    if (IsLiveUnit(enemy->m_Enemy) && enemy->m_Enemy != rl[i]) {
-                        float cd = Dist2(GetWorldPos(enemy->m_Enemy), GetWorldPos(rl[i]));
+                    if (IsLiveUnit(enemy->GetEnemy()) && enemy->GetEnemy() != rl[i]) {
+                        float cd = Dist2(GetWorldPos(enemy->GetEnemy()), GetWorldPos(rl[i]));
                         if (cd < mindist) {
                             // Проверяем не закрыт ли он своими
                             D3DXVECTOR3 des, from, dir, p;
                             float t, dist;
 
                             from = rl[i]->GetGeoCenter();
-                            des = PointOfAim(enemy->m_Enemy);
+                            des = PointOfAim(enemy->GetEnemy());
                             dist = sqrt(POW2(from.x - des.x) + POW2(from.y - des.y) + POW2(from.z - des.z));
                             if (dist > 0.0f) {
                                 t = 1.0f / dist;
@@ -8349,26 +8304,26 @@ void CMatrixSideUnit::WarPL(int group) {
                             }
                         }
                     }
-                    enemy = enemy->m_NextEnemy;
+                    enemy = rl[i]->GetEnv()->NextEnemy(enemy);
                 }
             }
             // Если не нашли открытого ищем закрытого
             if (!enemyfind) {
-                enemy = rl[i]->GetEnv()->m_FirstEnemy;
+                enemy = rl[i]->GetEnv()->FirstEnemy();
                 while (enemy) {
-                    if (IsLiveUnit(enemy->m_Enemy) && enemy->m_Enemy != rl[i]) {
-                        float cd = Dist2(GetWorldPos(enemy->m_Enemy), GetWorldPos(rl[i]));
+                    if (IsLiveUnit(enemy->GetEnemy()) && enemy->GetEnemy() != rl[i]) {
+                        float cd = Dist2(GetWorldPos(enemy->GetEnemy()), GetWorldPos(rl[i]));
                         if (cd < mindist) {
                             mindist = cd;
                             enemyfind = enemy;
                         }
                     }
-                    enemy = enemy->m_NextEnemy;
+                    enemy = rl[i]->GetEnv()->NextEnemy(enemy);
                 }
             }
 
             if (enemyfind) {
-                rl[i]->GetEnv()->m_TargetAttack = enemyfind->m_Enemy;
+                rl[i]->GetEnv()->m_TargetAttack = enemyfind->GetEnemy();
                 // Если новая цель пушка или завод, то меняем позицию
                 if (rl[i]->GetEnv()->m_TargetAttack->IsLiveActiveCannon() ||
                     rl[i]->GetEnv()->m_TargetAttack->IsLiveBuilding()) {
@@ -8884,13 +8839,13 @@ void CMatrixSideUnit::WarPL(int group) {
                 // Если стоим на месте
                 if (IsInPlace(rl[i])) {
                     // Если несколько врагов и в цель не попадаем в течении долгого времени, то переназначаем цель
-                    if (env->m_EnemyCnt > 1 && (curTime - env->m_TargetChange) > 4000 &&
+                    if (env->GetEnemyCnt() > 1 && (curTime - env->m_TargetChange) > 4000 &&
                         (curTime - env->m_LastHitTarget) > 4000) {
                         env->m_TargetAttack = NULL;
                     }
                     // Если один враг и в цель не попадаем в течении долгого времени и стоим на месте, то переназначаем
                     // место
-                    if (env->m_EnemyCnt == 1 && (curTime - env->m_TargetChange) > 4000 &&
+                    if (env->GetEnemyCnt() == 1 && (curTime - env->m_TargetChange) > 4000 &&
                         (curTime - env->m_LastHitTarget) > 4000) {
                         env->AddBadPlace(env->m_Place);
                         env->m_Place = -1;
@@ -8944,7 +8899,7 @@ void CMatrixSideUnit::WarPL(int group) {
                 // Если стоим на месте
                 if (IsInPlace(rl[i])) {
                     // Если несколько врагов, а текущий долго закрыт своими, то переназначаем цель
-                    if (env->m_EnemyCnt > 1 && (curTime - env->m_TargetChange) > 4000 &&
+                    if (env->GetEnemyCnt() > 1 && (curTime - env->m_TargetChange) > 4000 &&
                         (curTime - env->m_LastFire) > 4000) {
                         env->m_TargetAttack = NULL;
                     }
@@ -9532,12 +9487,10 @@ void CMatrixSideUnit::PGRemoveAllPassive(int no, CMatrixMapStatic *skip) {
 
             if (env->m_Target && env->m_Target != skip && IsPassive(env->m_Target))
                 env->m_Target = NULL;
-            CEnemy *enemie = env->m_FirstEnemy;
-            while (enemie) {
-                CEnemy *e2 = enemie;
-                enemie = enemie->m_NextEnemy;
-                if (e2->GetEnemy() != skip && IsPassive(e2->GetEnemy()))
-                    env->RemoveFromList(e2);
+            for (int e = env->GetEnemyCnt() - 1; e >= 0; e--) {
+                SEnemy *enemie = env->FirstEnemy() + e;
+                if (enemie->GetEnemy() != skip && IsPassive(enemie->GetEnemy()))
+                    env->RemoveFromList(enemie);
             }
         }
         obj = obj->GetNextLogic();
@@ -9865,9 +9818,7 @@ void CMatrixSideUnit::PGAssignPlacePlayer(int no, const CPoint &center) {
 }
 
 void CMatrixSideUnit::PGCalcStat() {
-    CMatrixMapStatic *ms;
     int i, u, t;  //,cnt,sme,dist;
-    CPoint tp;
 
     if (m_Region == NULL)
         m_Region = (SMatrixLogicRegion *)HAllocClear(sizeof(SMatrixLogicRegion) * g_MatrixMap->m_RN.m_RegionCnt,
@@ -9875,89 +9826,52 @@ void CMatrixSideUnit::PGCalcStat() {
     if (m_RegionIndex == NULL)
         m_RegionIndex = (int *)HAllocClear(sizeof(int) * g_MatrixMap->m_RN.m_RegionCnt, g_MatrixHeap);
 
+    const CMatrixInfluenceMap &inf = g_MatrixMap->m_Influence;
     for (i = 0; i < g_MatrixMap->m_RN.m_RegionCnt; i++) {
-        m_Region[i].m_EnemyRobotCnt = 0;
-        m_Region[i].m_EnemyCannonCnt = 0;
-        m_Region[i].m_EnemyBuildingCnt = 0;
-        m_Region[i].m_EnemyBaseCnt = 0;
-        m_Region[i].m_NeutralCannonCnt = 0;
-        m_Region[i].m_NeutralBuildingCnt = 0;
-        m_Region[i].m_NeutralBaseCnt = 0;
-        m_Region[i].m_OurRobotCnt = 0;
-        m_Region[i].m_OurCannonCnt = 0;
-        m_Region[i].m_OurBuildingCnt = 0;
-        m_Region[i].m_OurBaseCnt = 0;
-        m_Region[i].m_EnemyRobotDist = -1;
-        m_Region[i].m_EnemyBuildingDist = -1;
-        m_Region[i].m_OurBaseDist = -1;
-        m_Region[i].m_Danger = 0;
-        m_Region[i].m_DangerAdd = 0;
-    }
-
-    ms = CMatrixMapStatic::GetFirstLogic();
-    while (ms) {
-        switch (ms->GetObjectType()) {
-            case OBJECT_TYPE_BUILDING:
-                i = GetRegion(int(((CMatrixBuilding *)ms)->m_Pos.x / GLOBAL_SCALE_MOVE),
-                              int(((CMatrixBuilding *)ms)->m_Pos.y / GLOBAL_SCALE_MOVE));
-                if (i >= 0) {
-                    if (((CMatrixBuilding *)ms)->m_Side == 0)
-                        m_Region[i].m_NeutralBuildingCnt++;
-                    else if (((CMatrixBuilding *)ms)->m_Side != m_Id)
-                        m_Region[i].m_EnemyBuildingCnt++;
-                    else
-                        m_Region[i].m_OurBuildingCnt++;
-
-                    if (((CMatrixBuilding *)ms)->m_Kind == 0) {
-                        if (((CMatrixBuilding *)ms)->m_Side == 0)
-                            m_Region[i].m_NeutralBaseCnt++;
-                        else if (((CMatrixBuilding *)ms)->m_Side != m_Id)
-                            m_Region[i].m_EnemyBaseCnt++;
-                        else
-                            m_Region[i].m_OurBaseCnt++;
-                    }
-                }
-                break;
-            case OBJECT_TYPE_ROBOTAI:
-
-                if (((CMatrixRobotAI *)ms)->m_CurrState != ROBOT_DIP) {
-                    tp.x = int(ms->AsRobot()->m_PosX / GLOBAL_SCALE_MOVE);
-                    tp.y = int(ms->AsRobot()->m_PosY / GLOBAL_SCALE_MOVE);
-                    i = GetRegion(tp);
-
-                    if (i >= 0) {
-                        if (ms->AsRobot()->m_Side == 0)
-                            ;
-                        else if (ms->AsRobot()->m_Side != m_Id) {
-                            m_Region[i].m_EnemyRobotCnt++;
-                            float d = ms->AsRobot()->GetStrength();
-                            m_Region[i].m_Danger += d;
-                        }
-                        else
-                            m_Region[i].m_OurRobotCnt++;
-                    }
-                }
-                break;
+        SMatrixLogicRegion &lr = m_Region[i];
+        lr.m_EnemyRobotCnt = 0;
+        lr.m_EnemyCannonCnt = 0;
+        lr.m_EnemyBuildingCnt = 0;
+        lr.m_EnemyBaseCnt = 0;
+        lr.m_NeutralCannonCnt = 0;
+        lr.m_NeutralBuildingCnt = 0;
+        lr.m_NeutralBaseCnt = 0;
+        lr.m_OurRobotCnt = 0;
+        lr.m_OurCannonCnt = 0;
+        lr.m_OurBuildingCnt = 0;
+        lr.m_OurBaseCnt = 0;
+        lr.m_EnemyRobotDist = -1;
+        lr.m_EnemyBuildingDist = -1;
+        lr.m_OurBaseDist = -1;
+        lr.m_Danger = 0;
+        lr.m_DangerAdd = 0;
+
+        if (!inf.IsReady())
+            continue;
 
-            case OBJECT_TYPE_CANNON:
-                tp.x = int(((CMatrixCannon *)ms)->m_Pos.x / GLOBAL_SCALE_MOVE);
-                tp.y = int(((CMatrixCannon *)ms)->m_Pos.y / GLOBAL_SCALE_MOVE);
-                i = GetRegion(tp);
-                if (i >= 0) {
-                    if (ms->GetSide() == 0) {
-                        m_Region[i].m_NeutralCannonCnt++;
-                        m_Region[i].m_DangerAdd += ((CMatrixCannon *)ms)->GetStrength();
-                    }
-                    else if (ms->GetSide() != m_Id) {
-                        m_Region[i].m_EnemyCannonCnt++;
-                        m_Region[i].m_DangerAdd += ((CMatrixCannon *)ms)->GetStrength();
-                    }
-                    else
-                        m_Region[i].m_OurCannonCnt++;
-                }
-                break;
+        for (t = 0; t < INFLUENCE_SIDE_CNT; t++) {
+            const SInfluenceCell &c = inf.Get(i, t);
+            if (t == 0) {
+                lr.m_NeutralBuildingCnt += c.m_BuildingCnt;
+                lr.m_NeutralBaseCnt += c.m_BaseCnt;
+                lr.m_NeutralCannonCnt += c.m_CannonCnt;
+                lr.m_DangerAdd += c.m_CannonStrength;
+            }
+            else if (t != m_Id) {
+                lr.m_EnemyBuildingCnt += c.m_BuildingCnt;
+                lr.m_EnemyBaseCnt += c.m_BaseCnt;
+                lr.m_EnemyRobotCnt += c.m_RobotCnt;
+                lr.m_EnemyCannonCnt += c.m_CannonCnt;
+                lr.m_Danger += c.m_RobotStrength;
+                lr.m_DangerAdd += c.m_CannonStrength;
+            }
+            else {
+                lr.m_OurBuildingCnt += c.m_BuildingCnt;
+                lr.m_OurBaseCnt += c.m_BaseCnt;
+                lr.m_OurRobotCnt += c.m_RobotCnt;
+                lr.m_OurCannonCnt += c.m_CannonCnt;
+            }
         }
-        ms = ms->GetNextLogic();
     }
 
     // Выращиваем опасность
@@ -10855,7 +10769,7 @@ bool CMatrixSideUnit::CanMoveNoEnemy(byte mm, int r1, int r2) {
             if (u == r2)
                 break;
 
-            if (m_Region[u].m_EnemyRobotCnt > 0 || m_Region[u].m_EnemyCannonCnt > 0)
+            if (g_MatrixMap->m_Influence.Match(m_Id, u, 4 | 32 | 64))
                 continue;
 
             m_RegionIndex[cnt] = u;
@@ -82,6 +82,8 @@ const SSkin *CSkinManager::GetSkin(const wchar *textures, DWORD gsp) {
             temp_prev = temp;
             sk.m_Tex = (CTextureManaged *)g_Cache->Get(CacheClass::TextureManaged, temp.c_str());
 
+            // skins are only drawn: a new one does not stall the frame, it comes in the background
+            sk.m_Tex->StreamOn();
             sk.m_Tex->Preload();
             // gsp = GSP_SIDE_NOALPHA;
             // ATTENTION
@@ -116,6 +118,13 @@ const SSkin *CSkinManager::GetSkin(const wchar *textures, DWORD gsp) {
         }
     }
 
+    if (sk.m_TexGloss)
+        sk.m_TexGloss->StreamOn();
+    if (sk.m_TexBack)
+        sk.m_TexBack->StreamOn();
+    if (sk.m_TexMask)
+        sk.m_TexMask->StreamOn();
+
     for (int i = 0; i < m_SkinsCount[gsp]; ++i) {
         if ((*(m_Skins[gsp][i])) == sk)
             return m_Skins[gsp][i];
@@ -660,6 +660,19 @@ void CMatrixMap::CalcMapGroupVisibility(void) {
 
     m_VisWater.clear();
 
+    if (m_Cull.IsEmpty())
+        m_Cull.Build(m_minz);
+
+    // map groups: the quadtree drops the parts out of the frustum at once
+    if (no_info_about_visibility) {
+        m_Cull.CollectGroups(m_Camera, iminx, iminy, imaxx, imaxy, visRuntime.pos, NPOS,
+                             [this, &visRuntime](CMatrixMapGroup *g, int x, int y) {
+                                 visRuntime.i = x;
+                                 visRuntime.j = y;
+                                 CheckCandidate(visRuntime, g);
+                             });
+    }
+
     // DM("TIME", "TIME_STEP1 " + CStr(iminx) + " " + CStr(iminy)+ " " + CStr(imaxx)+ " " + CStr(imaxy));
 
     for (visRuntime.j = iminy; visRuntime.j <= imaxy /*m_GroupSize.y*/; ++visRuntime.j) {
@@ -667,16 +680,12 @@ void CMatrixMap::CalcMapGroupVisibility(void) {
             bool is_map = (visRuntime.i >= 0) && (visRuntime.i < m_GroupSize.x) && (visRuntime.j >= 0) &&
                           (visRuntime.j < m_GroupSize.y);
             if (is_map) {
-                // calculate visibility of map group
+                // visibility of map groups is already calculated
                 CMatrixMapGroup *cmg = m_Group[visRuntime.j * m_GroupSize.x + visRuntime.i];
 
                 if (cmg == NULL) {
                     goto water_calc;
                 }
-                else {
-                    if (no_info_about_visibility)
-                        CheckCandidate(visRuntime, cmg);
-                }
             }
             else {
                 // calculate visibility of free water
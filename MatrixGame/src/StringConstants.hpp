@@ -226,6 +226,8 @@
 #define CFG_OBJECTTEX16     L"ObjectTextures16Bit"
 #define CFG_DEBUGINFO       L"DebugInfo"
 #define CFG_VERTEXLIGHT     L"VertexLight"
+#define CFG_OCCLUSIONCULL   L"OcclusionCull"
+#define CFG_TERRAINLODERROR L"TerrainLodError"
 #define CFG_ASSIGNKEY       L"AssignKey"
 #define CFG_IZVRATMS        L"IzvratMultiSelection"
 #define CFG_ROBOTSHADOW     L"RobotShadow"
@@ -233,6 +235,7 @@
 #define CFG_OBJECTTOMINIMAP L"ObjectsToMinimap"
 #define CFG_GAMMARAMP       L"GammaRamp"
 #define CFG_MAXFPS          L"MaxFps"
+#define CFG_CACHEBUDGET     L"CacheBudget"
 
 #define PAR_TEMPLATES               L"Templates"
 #define PAR_REPLACE                 L"Replaces"
@@ -662,6 +665,8 @@
 #define FOLDER_NAME_CACHE       L"Cache"
 #define FOLDER_NAME_SCREENSHOTS L"Screenshots"
 #define FILE_NAME_SCREENSHOT    L"Shot"
+#define FILE_NAME_LOADTIMES     L"LoadTimes.txt"
+#define FILE_NAME_FRAMESTATS    L"FrameStats.txt"
 
 // interface
 
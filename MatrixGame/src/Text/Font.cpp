@@ -66,6 +66,8 @@ void prepareRangersFont()
     }
 };
 
+std::map<std::wstring_view, Text::Font> fonts;
+
 } // namespace
 
 namespace Text {
@@ -73,10 +75,33 @@ namespace Text {
 Font::Font(LPD3DXFONT font)
 : m_font{font}
 {
+    if (!m_font)
+    {
+        return;
+    }
+
+    // fill the glyph textures of the font once, not glyph by glyph while rendering: latin and cyrillic
+    m_font->PreloadCharacters(32, 255);
+    m_font->PreloadCharacters(0x401, 0x451);
+
+    IDirect3DDevice9* device{nullptr};
+    if (FAILED(m_font->GetDevice(&device)) || FAILED(D3DXCreateSprite(device, &m_sprite)))
+    {
+        lgr.error("Failed to create sprite for font");
+        m_sprite = nullptr;
+    }
+    if (device)
+    {
+        device->Release();
+    }
 }
 
 Font::~Font()
 {
+    if (m_sprite)
+    {
+        m_sprite->Release();
+    }
     if (m_font)
     {
         m_font->Release();
@@ -115,26 +140,70 @@ size_t Font::CalcTextWidth(std::wstring_view text) const
     return rect.right;
 }
 
+LPD3DXSPRITE Font::GetSprite() const
+{
+    return m_sprite;
+}
+
+void Font::OnLostDevice()
+{
+    if (m_sprite)
+    {
+        m_sprite->OnLostDevice();
+    }
+    if (m_font)
+    {
+        m_font->OnLostDevice();
+    }
+}
+
+void Font::OnResetDevice()
+{
+    if (m_font)
+    {
+        m_font->OnResetDevice();
+    }
+    if (m_sprite)
+    {
+        m_sprite->OnResetDevice();
+    }
+}
+
 Font& GetFont(IDirect3DDevice9* device, std::wstring_view font_name)
 {
-    static auto m_fonts = [&]{
+    if (fonts.empty())
+    {
         prepareRangersFont();
 
-        std::map<std::wstring_view, Font> fonts;
         fonts.emplace(L"Font.1Normal", loadFont(device, L"Verdana", 13));
         fonts.emplace(L"Font.2Mini",   loadFont(device, L"Verdana", 12));
         fonts.emplace(L"Font.2Small",  loadFont(device, L"Verdana", 13));
         fonts.emplace(L"Font.2Normal", loadFont(device, L"Verdana", 14));
         fonts.emplace(L"Font.2Ranger", loadFont(device, L"Rangers", 10));
-        return fonts;
-    }();
+    }
 
-    if (!m_fonts.contains(font_name))
+    if (!fonts.contains(font_name))
     {
         throw std::runtime_error("Unknown font: " + utils::from_wstring(font_name));
     }
 
-    return m_fonts.at(font_name);
+    return fonts.at(font_name);
+}
+
+void OnLostDevice()
+{
+    for (auto& [name, font] : fonts)
+    {
+        font.OnLostDevice();
+    }
+}
+
+void OnResetDevice()
+{
+    for (auto& [name, font] : fonts)
+    {
+        font.OnResetDevice();
+    }
 }
 
 } // namespace Text
\ No newline at end of file
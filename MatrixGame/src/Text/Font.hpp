@@ -29,10 +29,21 @@ public:
 
     size_t CalcTextWidth(std::wstring_view text) const;
 
+    // batches the glyphs of a text drawn with the font, may be null
+    LPD3DXSPRITE GetSprite() const;
+
+    void OnLostDevice();
+    void OnResetDevice();
+
 private:
     LPD3DXFONT m_font{nullptr};
+    LPD3DXSPRITE m_sprite{nullptr};
 };
 
 Font& GetFont(IDirect3DDevice9* device, std::wstring_view font_name);
 
+// of all the fonts, around the reset of the device
+void OnLostDevice();
+void OnResetDevice();
+
 } // namespace Text
@@ -7,6 +7,11 @@
 
 #include <d3dx9tex.h>
 
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
 extern IDirect3DDevice9* g_D3DD;
 
 namespace {
@@ -51,7 +56,8 @@ void DrawComplexText(
     const Text::Font& font,
     const RECT &rect,
     const DWORD format,
-    const D3DCOLOR defaultColor)
+    const D3DCOLOR defaultColor,
+    LPD3DXSPRITE sprite)
 {
     const size_t lineHeight = font.GetHeight();
     const size_t spaceWidth = font.GetSpaceWidth();
@@ -88,7 +94,7 @@ void DrawComplexText(
         posRect.left = pos.x;
         posRect.top = pos.y;
         uint32_t textColor = color ? color : defaultColor;
-        font->DrawTextW(NULL, str.data(), str.size(), &posRect, format, textColor);
+        font->DrawTextW(sprite, str.data(), str.size(), &posRect, format, textColor);
     };
 
     size_t x = rect.left;
@@ -156,11 +162,55 @@ void DrawComplexText(
     return;
 }
 
-} // namespace
+// what a text is rendered of: the same text is not rendered again but copied from the cache
+struct CacheKey
+{
+    std::wstring text;
+    std::wstring font;
+    uint32_t color;
+    int sizex;
+    int sizey;
+    int alignx;
+    int aligny;
+    int smex;
+    int smy;
+    int clip[4];
+
+    bool operator == (const CacheKey&) const = default;
+};
 
-namespace Text {
+struct CacheKeyHash
+{
+    size_t operator () (const CacheKey& key) const
+    {
+        size_t h = std::hash<std::wstring>{}(key.text);
+        const auto mix = [&h](size_t v) { h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+        mix(std::hash<std::wstring>{}(key.font));
+        for (int v : {int(key.color), key.sizex, key.sizey, key.alignx, key.aligny, key.smex, key.smy, key.clip[0],
+                      key.clip[1], key.clip[2], key.clip[3]})
+        {
+            mix(std::hash<int>{}(v));
+        }
+        return h;
+    }
+};
 
-void Render(
+struct CachedText
+{
+    int sizex{0};
+    int sizey{0};
+    std::vector<uint8_t> pixels; // rows of sizex RGBA pixels
+};
+
+// the whole cache is dropped when it grows over that
+constexpr size_t CACHE_MAX_BYTES = 8 * 1024 * 1024;
+
+std::unordered_map<CacheKey, CachedText, CacheKeyHash> cache;
+size_t cache_bytes = 0;
+
+Text::Stats stats;
+
+bool RenderText(
     std::wstring_view text,
     std::wstring_view font_name,
     uint32_t color,
@@ -174,6 +224,8 @@ void Render(
     const Base::CRect& clipr,
     CBitmap& dst)
 {
+    using namespace Text;
+
     (void)wordwrap;
 
     Font& font = Text::GetFont(g_D3DD, font_name);
@@ -181,7 +233,7 @@ void Render(
     if (!font)
     {
         // can't render text
-        return;
+        return false;
     }
 
     RECT clipRect{clipr.left, clipr.top, clipr.right, clipr.bottom};
@@ -256,7 +308,7 @@ void Render(
     auto res = g_D3DD->CreateTexture(sizex, sizey, 0, 0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, texture, NULL);
     if (FAILED(res))
     {
-        return;
+        return false;
     }
 
     AutoRelease<IDirect3DSurface9> surface{nullptr};
@@ -276,7 +328,7 @@ void Render(
 
     if (FAILED(res))
     {
-        return;
+        return false;
     }
 
     if (icase_find(text, COLOR_TAG_START) == std::wstring::npos)
@@ -286,7 +338,17 @@ void Render(
     }
     else
     {
-        DrawComplexText(tokens, font, clipRect, format, color);
+        // the runs of the colors go out as one batch of the glyphs
+        LPD3DXSPRITE sprite = font.GetSprite();
+        if (sprite)
+        {
+            sprite->Begin(D3DXSPRITE_ALPHABLEND | D3DXSPRITE_SORT_TEXTURE);
+        }
+        DrawComplexText(tokens, font, clipRect, format, color, sprite);
+        if (sprite)
+        {
+            sprite->End();
+        }
     }
 
     texture->UnlockRect(0);
@@ -298,6 +360,78 @@ void Render(
     // tmp now does not own the image bytes, so we need to duplicate it
     dst.CreateRGBA(sizex, sizey);
     dst.Copy(CPoint(0, 0), tmp.Size(), tmp, CPoint(0, 0));
+    return true;
+}
+
+} // namespace
+
+namespace Text {
+
+void Render(
+    std::wstring_view text,
+    std::wstring_view font_name,
+    uint32_t color,
+    int sizex,
+    int sizey,
+    int alignx,
+    int aligny,
+    int wordwrap,
+    int smex,
+    int smy,
+    const Base::CRect& clipr,
+    CBitmap& dst)
+{
+    const auto time_start = std::chrono::steady_clock::now();
+    ++stats.renders;
+
+    CacheKey key{std::wstring{text}, std::wstring{font_name}, color, sizex, sizey, alignx, aligny, smex, smy,
+                 {clipr.left, clipr.top, clipr.right, clipr.bottom}};
+
+    auto it = cache.find(key);
+    if (it != cache.end())
+    {
+        const CachedText& cached = it->second;
+        const size_t row = cached.sizex * 4;
+
+        dst.CreateRGBA(cached.sizex, cached.sizey);
+        for (int y = 0; y < cached.sizey; ++y)
+        {
+            memcpy(dst.Data() + y * dst.Pitch(), cached.pixels.data() + y * row, row);
+        }
+
+        ++stats.cached;
+        stats.time += std::chrono::steady_clock::now() - time_start;
+        return;
+    }
+
+    if (RenderText(text, font_name, color, sizex, sizey, alignx, aligny, wordwrap, smex, smy, clipr, dst))
+    {
+        CachedText cached;
+        cached.sizex = dst.SizeX();
+        cached.sizey = dst.SizeY();
+
+        const size_t row = cached.sizex * 4;
+        cached.pixels.resize(row * cached.sizey);
+        for (int y = 0; y < cached.sizey; ++y)
+        {
+            memcpy(cached.pixels.data() + y * row, dst.Data() + y * dst.Pitch(), row);
+        }
+
+        if (cache_bytes + cached.pixels.size() > CACHE_MAX_BYTES)
+        {
+            cache.clear();
+            cache_bytes = 0;
+        }
+        cache_bytes += cached.pixels.size();
+        cache.emplace(std::move(key), std::move(cached));
+    }
+
+    stats.time += std::chrono::steady_clock::now() - time_start;
+}
+
+const Stats& GetStats()
+{
+    return stats;
 }
 
 } // namespace Text
\ No newline at end of file
@@ -2,10 +2,20 @@
 
 #include <CBitmap.hpp>
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 
 namespace Text {
 
+// totals of Render, for the benchmarks
+struct Stats
+{
+    int64_t renders{0};
+    int64_t cached{0};  // given from the cache of the rendered texts
+    std::chrono::steady_clock::duration time{};
+};
+
 void Render(
     std::wstring_view text,
     std::wstring_view font,
@@ -20,4 +30,6 @@ void Render(
     const Base::CRect& clipr,
     CBitmap& dst);
 
-} // namespace Text
\ No newline at end of file
+const Stats& GetStats();
+
+} // namespace Text
@@ -91,7 +91,8 @@ void processCheat_SHOWFPS()
 void processCheat_INFO()
 {
     INVERTFLAG(g_Config.m_DIFlags,
-                   DI_TMEM | DI_TARGETCOORD | DI_VISOBJ | DI_ACTIVESOUNDS | DI_FRUSTUMCENTER);
+                   DI_TMEM | DI_TARGETCOORD | DI_VISOBJ | DI_ACTIVESOUNDS | DI_FRUSTUMCENTER | DI_GATHERINFO |
+                       DI_CACHE | DI_STREAM | DI_CULL | DI_TERRAINLOD | DI_STREAMRING);
 }
 
 void processCheat_AUTO()
@@ -4,8 +4,11 @@
 // Refer to the LICENSE file included
 
 #include "Texture.hpp"
+#include "TextureStream.hpp"
 #include "3g.hpp"
 #include "Helper.hpp"
+#include "NullDevice.hpp"
+#include "FilterDevice.hpp"
 #include "../../MatrixGame/src/MatrixSampleStateManager.hpp"
 
 #include "CBlockPar.hpp"
@@ -120,6 +123,17 @@ std::wstring CExceptionD3D::Info() const
                DXGetErrorDescriptionW(m_Error)).c_str();
 }
 
+// puts the redundant state filter in front of g_D3DD, the null device stays behind it
+static void L3GFilterDevice(CBlockPar& bpcfg) {
+    if (bpcfg.ParGetNE(L"StateFilter").GetInt() == 0)
+        return;
+    lgr.info("State filter is on");
+    // the filter holds its own reference, released by ~CFilterDevice
+    g_D3DD->AddRef();
+    g_FilterDevice = new CFilterDevice(g_D3DD);
+    g_D3DD = g_FilterDevice;
+}
+
 void L3GInitAsEXE(HINSTANCE hinst, CBlockPar& bpcfg, const wchar* sysname, const wchar* captionname) {
     RECT tr;
 
@@ -230,7 +244,18 @@ void L3GInitAsEXE(HINSTANCE hinst, CBlockPar& bpcfg, const wchar* sysname, const
         ERROR_S(utils::to_wstring(str));
     }
 
-    g_D3D = Direct3DCreate9(D3D_SDK_VERSION);
+    // frames of the CPU only: nothing is drawn, the game exits after that many
+    int null_frames = bpcfg.ParGetNE(L"NullDevice").GetInt();
+    if (null_frames > 0)
+    {
+        lgr.info("Null device, {} frames")(null_frames);
+        g_D3D = NullDirect3DCreate();
+        SETFLAG(g_Flags, GFLAG_APPACTIVE | GFLAG_KEEPALIVE);
+    }
+    else
+    {
+        g_D3D = Direct3DCreate9(D3D_SDK_VERSION);
+    }
     if (!g_D3D)
     {
         ERROR_S(L"Direct3DCreate9 failed");
@@ -273,6 +298,13 @@ void L3GInitAsEXE(HINSTANCE hinst, CBlockPar& bpcfg, const wchar* sysname, const
             ERROR_S(L"CreateDevice failed: D3DERR_OUTOFVIDEOMEMORY");
     }
 
+    if (null_frames > 0)
+    {
+        g_NullDevice = static_cast<CNullDevice *>(g_D3DD);
+        g_NullDevice->SetFrameLimit(null_frames);
+    }
+    L3GFilterDevice(bpcfg);
+
     SetWindowLongPtr(g_Wnd, GWL_WNDPROC, uintptr_t((WNDPROC)L3G_WndProc));
 
     IDirect3DSurface9 *surf;
@@ -346,7 +378,7 @@ void L3GInitAsEXE(HINSTANCE hinst, CBlockPar& bpcfg, const wchar* sysname, const
 
 void L3GInitAsDLL(
     HINSTANCE hinst,
-    [[maybe_unused]] CBlockPar& bpcfg,
+    CBlockPar& bpcfg,
     [[maybe_unused]] const wchar* sysname,
     [[maybe_unused]] const wchar* captionname,
     HWND hwnd,
@@ -363,6 +395,7 @@ void L3GInitAsDLL(
 
     g_D3D = (IDirect3D9 *)FDirect3D;
     g_D3DD = (IDirect3DDevice9 *)FD3DDevice;
+    L3GFilterDevice(bpcfg);
 
     g_WndOldProg = GetWindowLong(g_Wnd, GWL_WNDPROC);
     if (g_WndOldProg == 0)
@@ -512,11 +545,19 @@ int L3GRun()
 #endif
         fps++;
 
+        g_TextureStream->Takt();
+        g_Cache->Takt();
+
         g_graphics_tick += 1;
 
         g_DrawFPS = fps.count();
 
         g_AvailableTexMem = g_D3DD->GetAvailableTextureMem() / (1024 * 1024);
+
+        if (g_NullDevice && g_NullDevice->IsFrameLimit())
+        {
+            SETFLAG(g_Flags, GFLAG_EXITLOOP);
+        }
     }
 
     return 1;
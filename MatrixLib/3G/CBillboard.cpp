@@ -6,137 +6,278 @@
 #include "3g.hpp"
 
 #include "CBillboard.hpp"
-
-#include "preallocated_list.hpp"
+#include "RenderQueue.hpp"
+#include "StreamRing.hpp"
+#include "TextureAtlas.hpp"
 
 #include <algorithm>
 #include <vector>
 
-static constexpr int MAX_BB_TEXGROUPS = 64;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BILLBOARD_SSE2
+#include <emmintrin.h>
+#endif
+
 static constexpr int MAX_BBOARDS = 8196;
 
 CTextureManaged* CBillboard::m_SortableTex{nullptr};
 // CTextureManaged * CBillboard::m_IntenseTex{nullptr};
 
-D3D_VB CBillboard::m_VB{nullptr};
 D3D_IB CBillboard::m_IB{nullptr};
 
-static std::vector<std::pair<double, const CBillboard*>> _bboards;
-static preallocated_list<CBillboard> _intense_queue;
-static preallocated_list<CBillboardLine> _draw_queue;
+SBillboardStats CBillboard::m_Stats{};
 
-/////////////////////////////////////////////////////////////
+// billboards of the frame in SoA layout, what the vertices are built of
+struct SBillboardBuffer {
+    std::vector<float> m_X, m_Y, m_Z;                  // center
+    std::vector<float> m_R11, m_R12, m_R21, m_R22;     // rotation by scale
+    std::vector<float> m_DX, m_DY;                     // displacement in the view plane
+    std::vector<float> m_U0, m_V0, m_U1, m_V1;
+    std::vector<DWORD> m_Color;
+    std::vector<CTextureManaged *> m_Tex;              // intense ones only
 
-void CBillboard::SortEndDraw(const D3DXMATRIX &iview, const D3DXVECTOR3 &campos) {
-    DTRACE();
+    int GetCount(void) const { return int(m_X.size()); }
 
-    if (m_VB == NULL || m_IB == NULL)
-        Init();
+    void Clear(void) {
+        for (std::vector<float> *v : {&m_X, &m_Y, &m_Z, &m_R11, &m_R12, &m_R21, &m_R22, &m_DX, &m_DY, &m_U0, &m_V0,
+                                      &m_U1, &m_V1}) {
+            v->clear();
+        }
+        m_Color.clear();
+        m_Tex.clear();
+    }
 
-    int ns = 0, ni = 0;
-    SBillboardVertex *vb;
+    int Add(const D3DXVECTOR3 &pos, float scale, const D3DXMATRIX &rot, DWORD color, const SBillboardTexture &uv,
+            CTextureManaged *tex) {
+        m_X.push_back(pos.x);
+        m_Y.push_back(pos.y);
+        m_Z.push_back(pos.z);
+        m_R11.push_back(rot._11 * scale);
+        m_R12.push_back(rot._12 * scale);
+        m_R21.push_back(rot._21 * scale);
+        m_R22.push_back(rot._22 * scale);
+        m_DX.push_back(rot._41);
+        m_DY.push_back(rot._42);
+        m_U0.push_back(uv.tu0);
+        m_V0.push_back(uv.tv0);
+        m_U1.push_back(uv.tu1);
+        m_V1.push_back(uv.tv1);
+        m_Color.push_back(color);
+        m_Tex.push_back(tex);
+        return GetCount() - 1;
+    }
+};
 
-    if (!_bboards.empty())
-    {
-        ns = _bboards.size();
+static const SBillboardTexture _whole_texture = {0, 0, 1, 1};
+
+static SBillboardBuffer _bboards;
+static CRenderQueue _sorted;    // by the view depth, data is an index of _bboards
+static CRenderQueue _additive;  // by the texture, data is an index of _bboards or of _lines (the key has bit 0)
+static std::vector<const CBillboardLine *> _lines;
+static std::vector<int> _order;
 
-        LOCK_VB_DYNAMIC(m_VB, &vb);
+static inline void *IndexData(int i) {
+    return (void *)uintptr_t(i);
+}
+static inline int DataIndex(const SRenderItem &it) {
+    return int(uintptr_t(it.m_Data));
+}
+
+// corners: o - a - b, o - a + b, o + a - b, o + a + b
+static inline void WriteQuad(SBillboardVertex *vb, const SBillboardBuffer &buf, int i, const D3DXVECTOR3 &right,
+                             const D3DXVECTOR3 &up) {
+    D3DXVECTOR3 a = right * buf.m_R11[i] + up * buf.m_R12[i];
+    D3DXVECTOR3 b = right * buf.m_R21[i] + up * buf.m_R22[i];
+    D3DXVECTOR3 o = D3DXVECTOR3(buf.m_X[i], buf.m_Y[i], buf.m_Z[i]) + right * buf.m_DX[i] + up * buf.m_DY[i];
+    DWORD color = buf.m_Color[i];
+
+    vb[0].p = o - a - b;
+    vb[0].color = color;
+    vb[0].tu = buf.m_U0[i];
+    vb[0].tv = buf.m_V1[i];
+    vb[1].p = o - a + b;
+    vb[1].color = color;
+    vb[1].tu = buf.m_U0[i];
+    vb[1].tv = buf.m_V0[i];
+    vb[2].p = o + a - b;
+    vb[2].color = color;
+    vb[2].tu = buf.m_U1[i];
+    vb[2].tv = buf.m_V1[i];
+    vb[3].p = o + a + b;
+    vb[3].color = color;
+    vb[3].tu = buf.m_U1[i];
+    vb[3].tv = buf.m_V0[i];
+}
+
+// four vertices per billboard of idx, in that order; right and up are the rows of the inversed view matrix
+static void WriteQuads(SBillboardVertex *vb, const SBillboardBuffer &buf, const int *idx, int cnt,
+                       const D3DXMATRIX &iview) {
+    D3DXVECTOR3 right(iview._11, iview._12, iview._13);
+    D3DXVECTOR3 up(iview._21, iview._22, iview._23);
+
+    int n = 0;
+#ifdef BILLBOARD_SSE2
+    // four billboards at once, a lane per billboard
+    const __m128 rx = _mm_set1_ps(right.x), ry = _mm_set1_ps(right.y), rz = _mm_set1_ps(right.z);
+    const __m128 ux = _mm_set1_ps(up.x), uy = _mm_set1_ps(up.y), uz = _mm_set1_ps(up.z);
+
+    for (; n + 4 <= cnt; n += 4, vb += 16) {
+        const int *j = idx + n;
+        auto gather = [j](const std::vector<float> &v) { return _mm_setr_ps(v[j[0]], v[j[1]], v[j[2]], v[j[3]]); };
+        auto madd = [](__m128 k0, __m128 v0, __m128 k1, __m128 v1) {
+            return _mm_add_ps(_mm_mul_ps(k0, v0), _mm_mul_ps(k1, v1));
+        };
 
-        for (auto bb : _bboards)
-        {
-            bb.second->UpdateVBSlot(vb, iview);
-            vb += 4;
+        __m128 r11 = gather(buf.m_R11), r12 = gather(buf.m_R12);
+        __m128 r21 = gather(buf.m_R21), r22 = gather(buf.m_R22);
+        __m128 dx = gather(buf.m_DX), dy = gather(buf.m_DY);
+
+        __m128 ax = madd(r11, rx, r12, ux), ay = madd(r11, ry, r12, uy), az = madd(r11, rz, r12, uz);
+        __m128 bx = madd(r21, rx, r22, ux), by = madd(r21, ry, r22, uy), bz = madd(r21, rz, r22, uz);
+        __m128 ox = _mm_add_ps(gather(buf.m_X), madd(dx, rx, dy, ux));
+        __m128 oy = _mm_add_ps(gather(buf.m_Y), madd(dx, ry, dy, uy));
+        __m128 oz = _mm_add_ps(gather(buf.m_Z), madd(dx, rz, dy, uz));
+
+        __m128 omx = _mm_sub_ps(ox, ax), omy = _mm_sub_ps(oy, ay), omz = _mm_sub_ps(oz, az);
+        __m128 opx = _mm_add_ps(ox, ax), opy = _mm_add_ps(oy, ay), opz = _mm_add_ps(oz, az);
+
+        // [corner][coordinate][lane]
+        alignas(16) float c[4][3][4];
+        _mm_store_ps(c[0][0], _mm_sub_ps(omx, bx));
+        _mm_store_ps(c[0][1], _mm_sub_ps(omy, by));
+        _mm_store_ps(c[0][2], _mm_sub_ps(omz, bz));
+        _mm_store_ps(c[1][0], _mm_add_ps(omx, bx));
+        _mm_store_ps(c[1][1], _mm_add_ps(omy, by));
+        _mm_store_ps(c[1][2], _mm_add_ps(omz, bz));
+        _mm_store_ps(c[2][0], _mm_sub_ps(opx, bx));
+        _mm_store_ps(c[2][1], _mm_sub_ps(opy, by));
+        _mm_store_ps(c[2][2], _mm_sub_ps(opz, bz));
+        _mm_store_ps(c[3][0], _mm_add_ps(opx, bx));
+        _mm_store_ps(c[3][1], _mm_add_ps(opy, by));
+        _mm_store_ps(c[3][2], _mm_add_ps(opz, bz));
+
+        for (int l = 0; l < 4; ++l) {
+            int i = j[l];
+            DWORD color = buf.m_Color[i];
+            float u0 = buf.m_U0[i], v0 = buf.m_V0[i], u1 = buf.m_U1[i], v1 = buf.m_V1[i];
+            SBillboardVertex *v = vb + l * 4;
+
+            v[0].p = D3DXVECTOR3(c[0][0][l], c[0][1][l], c[0][2][l]);
+            v[0].color = color;
+            v[0].tu = u0;
+            v[0].tv = v1;
+            v[1].p = D3DXVECTOR3(c[1][0][l], c[1][1][l], c[1][2][l]);
+            v[1].color = color;
+            v[1].tu = u0;
+            v[1].tv = v0;
+            v[2].p = D3DXVECTOR3(c[2][0][l], c[2][1][l], c[2][2][l]);
+            v[2].color = color;
+            v[2].tu = u1;
+            v[2].tv = v1;
+            v[3].p = D3DXVECTOR3(c[3][0][l], c[3][1][l], c[3][2][l]);
+            v[3].color = color;
+            v[3].tu = u1;
+            v[3].tv = v0;
         }
     }
+#endif
+    for (; n < cnt; ++n, vb += 4) {
+        WriteQuad(vb, buf, idx[n], right, up);
+    }
+}
 
-    struct SDrawBillGroup {
-        int cntv;  // vertices
-        int cntt;  // triangles
-        // int vbase;    // no need, always 0
-        int ibase;
-        int min_idx;
-        CTextureManaged *tex;
-    };
+/////////////////////////////////////////////////////////////
 
-    SDrawBillGroup groups[MAX_BB_TEXGROUPS];
-    int groupscnt = 0;
+void CBillboard::SortEndDraw(const D3DXMATRIX &iview, const D3DXVECTOR3 &campos) {
+    DTRACE();
 
-    if (!_intense_queue.empty() || !_draw_queue.empty())
-    {
-        int ost = (MAX_BBOARDS * 2) - ns;
+    if (m_IB == NULL)
+        Init();
 
-        if (ns == 0) {
-            // lock VB/IB if not locked yet
-            LOCK_VB_DYNAMIC(m_VB, &vb);
-        }
+    auto time_start = std::chrono::steady_clock::now();
 
-        int n = 0, minvi = ns * 4;
+    _sorted.Sort();
+    _additive.Sort();
 
-        groups[0].tex = NULL;
+    int ns = _sorted.GetCount();
+    int ni = std::min(_additive.GetCount(), MAX_BBOARDS * 2 - ns);
+    SBillboardVertex *vb = NULL;
+    int vbase = 0;
 
-        int ibt_ = ns * 6;
+    if (ns > 0 || ni > 0) {
+        vb = (SBillboardVertex *)CStreamRing::LockVerts((ns + ni) * 4, sizeof(SBillboardVertex), vbase);
+        if (vb == NULL) {
+            ns = 0;
+            ni = 0;
+        }
+    }
 
-        const auto process_queue = [&](auto& queue, const auto& update_param) {
-            for (auto iter = queue.begin(); iter != queue.end(); ++iter)
-            {
-                const auto* bl = *iter;
-                bl->UpdateVBSlot(vb, update_param);
-                vb += 4;
+    if (ns > 0) {
+        _order.resize(ns);
+        for (int i = 0; i < ns; ++i) {
+            _order[i] = DataIndex(_sorted.Get(i));
+        }
+        WriteQuads(vb, _bboards, _order.data(), ns, iview);
+        vb += ns * 4;
+    }
 
-                if (groups[groupscnt].tex == NULL) {
-                    // new group
-                    groups[groupscnt].tex = bl->m_Tex;
-                    groups[groupscnt].min_idx = minvi;
-    #ifdef _DEBUG
-                    if ((uintptr_t)groups[groupscnt].tex == 0xACACACAC)
-                        debugbreak();
-    #endif
-                    // groups[groupscnt].vbase = base;
-                    groups[groupscnt].ibase = ibt_;
-                }
+    struct SDrawBillGroup {
+        int vbase;
+        int cnt;  // quads
+        CTextureManaged *tex;
+    };
 
-                ++n;
-                ++ni;
-                minvi += 4;
-                ibt_ += 6;
-                --ost;
-
-                auto next = iter.next();
-                if (!next || bl->m_Tex != (*next)->m_Tex)
-                {
-                    // end of group
-                    groups[groupscnt].cntv = n * 4;
-                    groups[groupscnt].cntt = n * 2;
-                    if (++groupscnt >= MAX_BB_TEXGROUPS)
-                        break;
-                    groups[groupscnt].tex = NULL;
-
-                    n = 0;
-                }
+    // runs of the same texture, intense billboards and lines together; a run is not longer than the IB
+    static std::vector<SDrawBillGroup> groups;
+    groups.clear();
 
-                if (ost <= 0)
-                    break;
-            }
+    if (ni > 0) {
+        _order.clear();
+        const auto flush = [&]() {
+            WriteQuads(vb, _bboards, _order.data(), int(_order.size()), iview);
+            vb += _order.size() * 4;
+            _order.clear();
         };
 
-        process_queue(_intense_queue, iview);
+        for (int i = 0; i < ni; ++i) {
+            const SRenderItem &it = _additive.Get(i);
+            CTextureManaged *tex;
+            if (it.m_Key & 1) {
+                flush();
+                const CBillboardLine *bl = _lines[DataIndex(it)];
+                bl->UpdateVBSlot(vb, campos);
+                tex = bl->m_Tex;
+                if (const SAtlasRect *r = CTextureAtlas::Find(tex)) {
+                    for (int k = 0; k < 4; ++k) {
+                        r->Remap(vb[k].tu, vb[k].tv);
+                    }
+                    tex = r->m_Page;
+                }
+                vb += 4;
+            }
+            else {
+                _order.push_back(DataIndex(it));
+                tex = _bboards.m_Tex[DataIndex(it)];
+            }
+#ifdef _DEBUG
+            if ((uintptr_t)tex == 0xACACACAC)
+                debugbreak();
+#endif
 
-        if (groupscnt < MAX_BB_TEXGROUPS && ost > 0)
-        {
-            ASSERT(n == 0);
-            process_queue(_draw_queue, campos);
-            ASSERT((ost > 0 && n == 0) || ost <= 0);
+            if (groups.empty() || groups.back().tex != tex || groups.back().cnt == MAX_BBOARDS)
+                groups.push_back(SDrawBillGroup{vbase + (ns + i) * 4, 0, tex});
+            ++groups.back().cnt;
         }
+        flush();
+    }
 
-        _draw_queue.clear();
+    if (vb != NULL)
+        CStreamRing::UnlockVerts();
 
-        UNLOCK_VB(m_VB);
-    }
-    else {
-        if (ns > 0) {
-            UNLOCK_VB(m_VB);
-        }
-    }
+    m_Stats.m_Billboards += ns + _additive.GetCount() - int(_lines.size());
+    m_Stats.m_Lines += _lines.size();
+    m_Stats.m_Draws += (ns > 0 ? 1 : 0) + groups.size();
+    m_Stats.m_Time += std::chrono::steady_clock::now() - time_start;
 
     // draw sorted
 
@@ -166,12 +307,12 @@ void CBillboard::SortEndDraw(const D3DXMATRIX &iview, const D3DXVECTOR3 &campos)
         SetAlphaOpAnyOrder(0, D3DTOP_MODULATE, D3DTA_TEXTURE, D3DTA_DIFFUSE);
         SetColorOpDisable(1);
 
-        ASSERT_DX(g_D3DD->SetStreamSource(0, GET_VB(m_VB), 0, sizeof(SBillboardVertex)));
+        CStreamRing::SetStream(sizeof(SBillboardVertex));
         ASSERT_DX(g_D3DD->SetIndices(GET_IB(m_IB)));
 
         ASSERT_DX(g_D3DD->SetTexture(0, m_SortableTex->Tex()));
 
-        ASSERT_DX(g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, ns * 4, 0, ns * 2));
+        ASSERT_DX(g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, vbase, 0, ns * 4, 0, ns * 2));
     }
 
     if (ni > 0) {
@@ -190,14 +331,14 @@ void CBillboard::SortEndDraw(const D3DXMATRIX &iview, const D3DXVECTOR3 &campos)
 
         g_D3DD->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_ONE);
 
-        g_D3DD->SetStreamSource(0, GET_VB(m_VB), 0, sizeof(SBillboardVertex));
+        CStreamRing::SetStream(sizeof(SBillboardVertex));
         ASSERT_DX(g_D3DD->SetIndices(GET_IB(m_IB)));
 
-        for (int i = 0; i < groupscnt; ++i) {
-            groups[i].tex->Preload();
-            ASSERT_DX(g_D3DD->SetTexture(0, groups[i].tex->Tex()));
-            ASSERT_DX(g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, groups[i].min_idx, groups[i].cntv,
-                                                   groups[i].ibase, groups[i].cntt));
+        // the IB is the same for every quad, so a group starts at the base vertex
+        for (const SDrawBillGroup &g : groups) {
+            g.tex->Preload();
+            ASSERT_DX(g_D3DD->SetTexture(0, g.tex->Tex()));
+            ASSERT_DX(g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, g.vbase, 0, g.cnt * 4, 0, g.cnt * 2));
         }
     }
 
@@ -209,25 +350,20 @@ void CBillboard::SortEndDraw(const D3DXMATRIX &iview, const D3DXVECTOR3 &campos)
     ASSERT_DX(g_D3DD->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE));
     ASSERT_DX(g_D3DD->SetRenderState(D3DRS_ALPHAREF, 0x08));
 
-    // m_First = NULL;
-    _bboards.clear();
-    // m_Root = NULL;
-
-    _intense_queue.clear();
+    _bboards.Clear();
+    _sorted.Clear();
+    _additive.Clear();
+    _lines.clear();
 }
 
 void CBillboard::SortIntense(void) const
 {
-    auto iter =
-        std::find_if(
-            _intense_queue.begin(),
-            _intense_queue.end(),
-            [&](const auto& item) {
-                return m_Tex == item->m_Tex;
-            }
-        );
-
-    _intense_queue.insert(iter, this);
+    // additive ones, the order does not matter: grouped by the texture, the packed ones by the page of the atlas
+    const SAtlasRect *r = CTextureAtlas::Find(m_Tex);
+    SBillboardTexture uv = r ? SBillboardTexture{r->m_U0, r->m_V0, r->m_U1, r->m_V1} : _whole_texture;
+    CTextureManaged *tex = r ? r->m_Page : m_Tex;
+    int i = _bboards.Add(m_Pos, m_Scale, m_Rot, m_Color, uv, tex);
+    _additive.Add(uint64_t(CRenderQueue::Material(tex)) << 1, IndexData(i));
 }
 
 void CBillboard::Sort(const D3DXMATRIX &sort) const
@@ -238,38 +374,20 @@ void CBillboard::Sort(const D3DXMATRIX &sort) const
         return;
     }
 
-    if (_bboards.size() == MAX_BBOARDS)
+    if (_sorted.GetCount() == MAX_BBOARDS)
     {
         return;
     }
 
-    // here was a smart-ass optimized algorithm to build a sorted list of billboard in a plain array
-    // trying to minimize memory copying/moving, but still using them to insert the element into
-    // correct position.
-    // i've thrown in away for the sake of code readability. now we'll have a vector here, which will
-    // most probably optimize all the movement under the hood anyway as long as we're storing POD types,
-    // but will do it in 3 lines of code instead of 50.
-    // yes, pessimization. on modern platform most probably it's not. shall not try to optimize it
-    // until performance gain is explicitly proven.
-
-    double z_index = Double2Int((sort._13 * m_Pos.x + sort._23 * m_Pos.y + sort._33 * m_Pos.z + sort._43) * 256.0);
-
-    auto comp = [](const double new_value, const auto item) { return new_value < item.first; };
-    auto position = std::upper_bound(_bboards.begin(), _bboards.end(), z_index, comp);
-    _bboards.emplace(position, z_index, this);
+    // appended as is, sorted once in SortEndDraw (by the depth, the same depth keeps the order of adding)
+    float z = sort._13 * m_Pos.x + sort._23 * m_Pos.y + sort._33 * m_Pos.z + sort._43;
+    int i = _bboards.Add(m_Pos, m_Scale, m_Rot, m_Color, *m_Texture, NULL);
+    _sorted.Add(CRenderQueue::FloatKey(z), IndexData(i));
 }
 
 CBillboard::~CBillboard() {
     DTRACE();
-    // do nothing!
-#ifdef _DEBUG
-    if (!_intense_queue.empty())
-    // if (m_FirstIntense != NULL || m_Root != NULL)
-    // if (m_FirstIntense != NULL || m_First != NULL)
-    {
-        debugbreak();
-    }
-#endif
+    // do nothing! the queued billboards are copies
 #ifdef _DEBUG
     if (!release_called) {
         debugbreak();
@@ -281,10 +399,6 @@ void CBillboard::Release(void) {
     DTRACE();
 
 #ifdef _DEBUG
-    if (!_intense_queue.empty())
-    {
-        debugbreak();
-    }
     release_called = true;
 #endif
 }
@@ -292,10 +406,6 @@ void CBillboard::Release(void) {
 void CBillboard::Init(void) {
     DTRACE();
 
-    if (m_VB == NULL) {
-        CREATE_VB_DYNAMIC(MAX_BBOARDS * 2 * 4 * sizeof(SBillboardVertex), BILLBOARD_FVF, m_VB);
-    }
-
     if (m_IB == NULL) {
         CREATE_IB16(MAX_BBOARDS * 6, m_IB);
 
@@ -316,8 +426,6 @@ void CBillboard::Init(void) {
 }
 
 void CBillboard::Deinit(void) {
-    if (m_VB != NULL)
-        DESTROY_VB(m_VB);
     if (m_IB != NULL)
         DESTROY_IB(m_IB);
 }
@@ -490,7 +598,7 @@ CBillboardLine::~CBillboardLine()
 {
     // do nothing
 #ifdef _DEBUG
-    if (!_draw_queue.empty())
+    if (!_lines.empty())
     {
         debugbreak();
     }
@@ -508,7 +616,7 @@ void CBillboardLine::Release(void)
 #ifdef _DEBUG
     release_called = true;
 #endif
-    ASSERT(_draw_queue.empty());
+    ASSERT(_lines.empty());
 }
 
 void CBillboardLine::UpdateVBSlot(SBillboardVertex *vb, const D3DXVECTOR3 &campos) const {
@@ -610,14 +718,8 @@ void CBillboardLine::DrawNow(const D3DXVECTOR3 &campos) const
 
 void CBillboardLine::AddToDrawQueue(void) const
 {
-    auto iter =
-        std::find_if(
-            _draw_queue.begin(),
-            _draw_queue.end(),
-            [&](const auto& item) {
-                return m_Tex == item->m_Tex;
-            }
-        );
-
-    _draw_queue.insert(iter, this);
-}
\ No newline at end of file
+    const SAtlasRect *r = CTextureAtlas::Find(m_Tex);
+    _lines.push_back(this);
+    _additive.Add((uint64_t(CRenderQueue::Material(r ? r->m_Page : m_Tex)) << 1) | 1,
+                  IndexData(int(_lines.size()) - 1));
+}
@@ -8,6 +8,9 @@
 
 #include "D3DControl.hpp"
 
+#include <chrono>
+#include <cstdint>
+
 #define SORTABLE_FLAG_INTENSE SETBIT(0)
 
 #define BILLBOARD_FVF (D3DFVF_XYZ | D3DFVF_DIFFUSE | D3DFVF_TEX1)
@@ -22,13 +25,22 @@ struct SBillboardTexture {
     float tu1, tv1;
 };
 
+// totals of SortEndDraw, for the benchmarks
+struct SBillboardStats {
+    int64_t m_Billboards;                         // sorted and intense
+    int64_t m_Lines;
+    int64_t m_Draws;
+    std::chrono::steady_clock::duration m_Time;  // sorting and building the vertices
+};
+
 class CBillboard : public Base::CMain {
-    static D3D_VB m_VB;
     static D3D_IB m_IB;
 
     static CTextureManaged *m_SortableTex;
     // static CTextureManaged * m_IntenseTex;
 
+    static SBillboardStats m_Stats;
+
     DWORD m_Flags;
 
 public:
@@ -61,7 +73,7 @@ public:
 #endif
     };
 
-    static void Init(void);    // prepare VB
+    static void Init(void);    // prepare IB
     static void Deinit(void);  // prepare VB
 
     CBillboard(TRACE_PARAM_DEF const D3DXVECTOR3 &pos, float scale, float angle, DWORD color,
@@ -104,6 +116,8 @@ public:
     // static CTextureManaged * GetIntenseTex(void) {return m_IntenseTex;}
     // static void SetTextures(CTextureManaged *st, CTextureManaged *it) {m_SortableTex = st; m_IntenseTex = it;};
     static void SetSortTexture(CTextureManaged *st) { m_SortableTex = st; };
+
+    static const SBillboardStats &GetStats(void) { return m_Stats; }
 };
 
 class CBillboardLine : public CMain {
@@ -8,11 +8,13 @@
 #include "Cache.hpp"
 #include "CFile.hpp"
 #include "VectorObject.hpp"
+#include "TextureStream.hpp"
 
 #include <utils.hpp>
 
 #include <fstream>
 #include <filesystem>
+#include <list>
 
 void CacheReplaceFileExt(
     std::wstring &outname,
@@ -63,6 +65,7 @@ void CCacheData::Prepare()
     {
         Load();
     }
+    m_Used = true;
     if (m_Cache)
     {
         m_Cache->Up(this);
@@ -119,17 +122,69 @@ void CCacheData::LoadFromFile(CBuf &buf, const wchar *exts) {
         ERROR_S2(L"Error open file: ",m_Name.c_str());*/
 }
 
+void CCacheData::LoadFileView(CBuf &buf, std::span<const std::byte> &view, const wchar *exts) {
+    DTRACE();
+
+    std::wstring tstr, tname;
+
+    tname = ParamParser{m_Name}.GetStrPar(0, L"?");
+
+    if (!CFile::FileExist(tstr, tname.c_str(), exts, false)) {
+        ERROR_S(utils::format(L"File not found: %ls   Exts: %ls", tname.c_str(), exts));
+    }
+
+    if (!CFile::GetView(tstr, view)) {
+        buf.LoadFromFile(tstr);
+        view = std::span<const std::byte>((const std::byte *)buf.Get(), buf.Len());
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 
+void CCache::Link(CCacheData *cd)
+{
+    cd->m_Prev = NULL;
+    cd->m_Next = m_First;
+    if (m_First)
+        m_First->m_Prev = cd;
+    else
+        m_Last = cd;
+    m_First = cd;
+}
+
+void CCache::Unlink(CCacheData *cd)
+{
+    if (cd->m_Prev)
+        cd->m_Prev->m_Next = cd->m_Next;
+    else
+        m_First = cd->m_Next;
+    if (cd->m_Next)
+        cd->m_Next->m_Prev = cd->m_Prev;
+    else
+        m_Last = cd->m_Prev;
+    cd->m_Prev = NULL;
+    cd->m_Next = NULL;
+}
+
 void CCache::Add(CCacheData *cd)
 {
     DTRACE();
 
     ASSERT(cd);
 
-    _data.push_back(cd);
+    // new data goes to the end of the LRU list, as before
+    cd->m_Prev = m_Last;
+    cd->m_Next = NULL;
+    if (m_Last)
+        m_Last->m_Next = cd;
+    else
+        m_First = cd;
+    m_Last = cd;
+    ++m_Count;
+
+    m_Index[static_cast<int>(cd->m_Type)].emplace(cd->m_Name, cd);
     cd->m_Cache = this;
 }
 
@@ -140,7 +195,13 @@ void CCache::Delete(CCacheData *cd)
     ASSERT(cd);
     ASSERT(cd->m_Cache == this);
 
-    _data.remove(cd);
+    auto &index = m_Index[static_cast<int>(cd->m_Type)];
+    auto it = index.find(cd->m_Name);
+    if (it != index.end() && it->second == cd)
+        index.erase(it);
+
+    Unlink(cd);
+    --m_Count;
     cd->m_Cache = NULL;
 }
 
@@ -151,13 +212,15 @@ void CCache::Up(CCacheData *cd)
     ASSERT(cd);
     ASSERT(cd->m_Cache == this);
 
-    _data.remove(cd);
-    _data.push_front(cd);
+    if (m_First == cd)
+        return;
+    Unlink(cd);
+    Link(cd);
 }
 
 void CCache::PreLoad(void)
 {
-    for (auto cd : _data)
+    for (CCacheData *cd = m_First; cd; cd = cd->m_Next)
     {
         if (cd->m_Type == CacheClass::VO)
         {
@@ -167,16 +230,121 @@ void CCache::PreLoad(void)
     }
 }
 
-CCacheData* CCache::Find(CacheClass cc, const std::wstring_view name)
+void CCache::Takt(void)
+{
+    if (++m_Frame < CACHE_TRIM_PERIOD)
+        return;
+    m_Frame = 0;
+
+    for (auto &st : m_Stat)
+    {
+        st.m_Size = 0;
+        st.m_Loaded = 0;
+    }
+
+    // entries used since the last pass go to the front of the list in their order
+    CCacheData *first = NULL;
+    CCacheData *last = NULL;
+    CCacheData *cd = m_First;
+    while (cd)
+    {
+        CCacheData *next = cd->m_Next;
+
+        cd->m_Footprint = cd->IsLoaded() ? cd->GetFootprint() : 0;
+        if (cd->m_Footprint)
+        {
+            SCacheClassStat &st = m_Stat[static_cast<int>(cd->m_Type)];
+            st.m_Size += cd->m_Footprint;
+            ++st.m_Loaded;
+        }
+
+        if (cd->m_Used)
+        {
+            Unlink(cd);
+            cd->m_Prev = last;
+            if (last)
+                last->m_Next = cd;
+            else
+                first = cd;
+            last = cd;
+        }
+        cd = next;
+    }
+    if (first)
+    {
+        last->m_Next = m_First;
+        if (m_First)
+            m_First->m_Prev = last;
+        else
+            m_Last = last;
+        m_First = first;
+    }
+
+    for (int i = 0; i < static_cast<int>(CacheClass::Count); ++i)
+    {
+        if (m_Stat[i].m_Budget && m_Stat[i].m_Size > m_Stat[i].m_Budget)
+            Trim(static_cast<CacheClass>(i));
+    }
+
+    for (cd = m_First; cd && cd->m_Used; cd = cd->m_Next)
+    {
+        cd->m_Used = false;
+    }
+}
+
+int CCache::GetEvictions(void) const
+{
+    int cnt = 0;
+    for (const SCacheClassStat &st : m_Stat)
+        cnt += st.m_Evicted;
+    return cnt;
+}
+
+void CCache::Trim(CacheClass cc)
 {
     DTRACE();
 
-    for (auto cd : _data)
+    SCacheClassStat &st = m_Stat[static_cast<int>(cc)];
+    CCacheData *from = m_Last;
+    while (st.m_Size > st.m_Budget)
     {
-        if (cd->m_Type == cc && cd->m_Name == name)
+        // of the few least recently used entries the one which frees most per unit of reload cost goes first
+        CCacheData *best = NULL;
+        float best_score = 0;
+        int cnt = 0;
+        for (CCacheData *cd = from; cd && !cd->m_Used && cnt < CACHE_TRIM_WINDOW; cd = cd->m_Prev)
         {
-            return cd;
+            if (cd->m_Type != cc || cd->m_Footprint == 0 || cd->m_Ref > 0 || !cd->CanEvict())
+                continue;
+            if (cnt++ == 0)
+                from = cd;
+            float score = float(cd->m_Footprint) / cd->GetReloadCost();
+            if (best == NULL || score > best_score)
+            {
+                best = cd;
+                best_score = score;
+            }
         }
+        if (best == NULL)
+            break;
+
+        best->Evict();
+        st.m_Size -= best->m_Footprint;
+        --st.m_Loaded;
+        ++st.m_Evicted;
+        best->m_Footprint = 0;
+    }
+}
+
+CCacheData* CCache::Find(CacheClass cc, const std::wstring_view name)
+{
+    DTRACE();
+
+    auto &index = m_Index[static_cast<int>(cc)];
+    auto it = index.find(name);
+    if (it != index.end())
+    {
+        return it->second;
     }
     return NULL;
 }
@@ -188,8 +356,10 @@ CCacheData* CCache::Get(CacheClass cc, const std::wstring_view name)
     CCacheData *cd = Find(cc, name);
     if (cd)
     {
+        ++m_Hits;
         return cd;
     }
+    ++m_Misses;
 
 #ifdef _DEBUG
     cd = Create(cc, __FILE__, __LINE__);
@@ -291,16 +461,12 @@ void CCache::Dump(void) {
 
 void CCache::Clear(void)
 {
-    for (auto it = _data.begin(); it != _data.end();)
+    while (m_First)
     {
-        auto cd = *it;
-        it++;
-
+        CCacheData *cd = m_First;
         Delete(cd);
         CCache::Destroy(cd);
     }
-
-    _data.clear();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -315,6 +481,7 @@ void CacheInit(void) {
 
     g_CacheHeap = HNew(NULL) CHeap();
     g_Cache = HNew(g_CacheHeap) CCache;
+    g_TextureStream = HNew(g_CacheHeap) CTextureStreamer(g_CacheHeap);
 }
 
 void CacheDeinit() {
@@ -327,6 +494,11 @@ void CacheDeinit() {
         g_Cache = NULL;
     }
 
+    if (g_TextureStream) {
+        HDelete(CTextureStreamer, g_TextureStream, g_CacheHeap);
+        g_TextureStream = NULL;
+    }
+
     if (g_CacheHeap) {
         HDelete(CHeap, g_CacheHeap, NULL);
         g_CacheHeap = NULL;
@@ -9,22 +9,34 @@
 #include "CHeap.hpp"
 #include "CBuf.hpp"
 
-#include <list>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 class CCache;
 
+#define CACHE_TRIM_PERIOD 32  // frames between the footprint passes
+#define CACHE_TRIM_WINDOW 8   // least recently used entries compared by their reload cost
+
 enum class CacheClass
 {
     Unknown = 0,
     Texture,
     TextureManaged,
-    VO
+    VO,
+
+    Count
 };
 
 class CCacheData
 {
 public:
     CCache *m_Cache{nullptr};
+    CCacheData *m_Prev{nullptr};  // LRU list of m_Cache, most recently used first
+    CCacheData *m_Next{nullptr};
 #ifdef _DEBUG
     const char *d_file;
     int d_line;
@@ -35,6 +47,9 @@ public:
 
     int m_Ref{0};  // Кол-во ссылок на эти данные. (Для временных данных)
 
+    DWORD m_Footprint{0};  // bytes taken while loaded, as of the last footprint pass
+    bool m_Used{false};    // used since the last footprint pass
+
 public:
     CCacheData(void) = default;
     virtual ~CCacheData() = default;
@@ -57,21 +72,67 @@ public:
     void Prepare(void);
 
     void LoadFromFile(CBuf &buf, const wchar *exts = NULL);
+    // view of the file stored in a package, or of its copy loaded into buf
+    void LoadFileView(CBuf &buf, std::span<const std::byte> &view, const wchar *exts = NULL);
 
     virtual bool IsLoaded(void) = 0;
     virtual void Unload(void) = 0;
     virtual void Load(void) = 0;
+
+    // memory taken by the loaded data
+    virtual DWORD GetFootprint(void) { return 0; }
+    // relative cost of restoring the data after Evict
+    virtual int GetReloadCost(void) { return 1; }
+    // the data can be freed now and is restored by itself on the next use
+    virtual bool CanEvict(void) { return false; }
+    virtual void Evict(void) {}
+};
+
+// names are looked up by std::wstring_view without making a std::wstring
+struct SCacheNameHash
+{
+    using is_transparent = void;
+    size_t operator()(std::wstring_view name) const { return std::hash<std::wstring_view>{}(name); }
+};
+
+struct SCacheClassStat
+{
+    DWORD m_Budget{0};  // bytes, 0 - no limit
+    DWORD m_Size{0};    // footprint of the loaded entries
+    int m_Loaded{0};
+    int m_Evicted{0};   // entries freed to fit the budget
 };
 
 class CCache
 {
-public:
-    std::list<CCacheData*> _data;
+    CCacheData *m_First{nullptr};
+    CCacheData *m_Last{nullptr};
+    std::unordered_map<std::wstring, CCacheData*, SCacheNameHash, std::equal_to<>>
+        m_Index[static_cast<int>(CacheClass::Count)];
+
+    int m_Count{0};
+    int m_Hits{0};
+    int m_Misses{0};
+
+    SCacheClassStat m_Stat[static_cast<int>(CacheClass::Count)];
+    int m_Frame{0};
+
+    void Link(CCacheData *cd);
+    void Unlink(CCacheData *cd);
+    void Trim(CacheClass cc);
 
 public:
     CCache() = default;
     ~CCache() = default;
 
+    int GetCount(void) const { return m_Count; }
+    int GetHits(void) const { return m_Hits; }
+    int GetMisses(void) const { return m_Misses; }
+    int GetEvictions(void) const;  // entries freed by Trim, of all the classes
+
+    void SetBudget(CacheClass cc, DWORD bytes) { m_Stat[static_cast<int>(cc)].m_Budget = bytes; }
+    const SCacheClassStat &GetStat(CacheClass cc) const { return m_Stat[static_cast<int>(cc)]; }
+
 #ifdef _DEBUG
     static void Dump(void);
 #endif
@@ -81,6 +142,8 @@ public:
     void Up(CCacheData *cd);
 
     void PreLoad(void);
+    // once per frame after the draw: keeps the classes within their budgets
+    void Takt(void);
 
     CCacheData *Find(CacheClass cc, const std::wstring_view name);
     CCacheData *Get(CacheClass cc, const std::wstring_view name);
@@ -241,6 +241,10 @@ typedef D3DResource *D3D_VB;
     { /*ASSERT(!FLAG(g_Flags, GFLAG_RENDERINPROGRESS)); */        \
         ASSERT_DX(GET_IB(ib)->Lock((x), (y), (void **)(out), 0)); \
     }
+#define LOCKP_IB_NO(ib, x, y, out)                                                  \
+    { /*ASSERT(!FLAG(g_Flags, GFLAG_RENDERINPROGRESS)); */                          \
+        ASSERT_DX(GET_IB(ib)->Lock((x), (y), (void **)(out), D3DLOCK_NOOVERWRITE)); \
+    }
 #define UNLOCK_IB(ib)                                      \
     { /*ASSERT(!FLAG(g_Flags, GFLAG_RENDERINPROGRESS)); */ \
         ASSERT_DX(GET_IB(ib)->Unlock());                   \
@@ -317,6 +321,8 @@ typedef IDirect3DVertexBuffer9 *D3D_VB;
     { ASSERT_DX(ib->Lock((x), (y), (void **)(out), D3DLOCK_DISCARD)); }
 #define LOCKP_IB(ib, x, y, out) \
     { ASSERT_DX(ib->Lock((x), (y), (void **)(out), 0)); }
+#define LOCKP_IB_NO(ib, x, y, out) \
+    { ASSERT_DX(ib->Lock((x), (y), (void **)(out), D3DLOCK_NOOVERWRITE)); }
 #define UNLOCK_IB(ib) \
     { ASSERT_DX(ib->Unlock()); }
 
@@ -0,0 +1,673 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "FilterDevice.hpp"
+
+#include <cstring>
+
+CFilterDevice *g_FilterDevice = NULL;
+
+// the device of the block is the filter, applying it changes the device past the filter
+class CFilterStateBlock : public IDirect3DStateBlock9 {
+    ULONG m_Ref;
+    CFilterDevice *m_Filter;
+    IDirect3DStateBlock9 *m_Block;
+
+public:
+    CFilterStateBlock(CFilterDevice *filter, IDirect3DStateBlock9 *block) : m_Ref(1), m_Filter(filter), m_Block(block) {
+        m_Filter->AddRef();
+    }
+    virtual ~CFilterStateBlock() {
+        m_Block->Release();
+        m_Filter->Release();
+    }
+
+    STDMETHOD(QueryInterface)(REFIID riid, void **object) {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IDirect3DStateBlock9)) {
+            *object = static_cast<IDirect3DStateBlock9 *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *object = NULL;
+        return E_NOINTERFACE;
+    }
+    STDMETHOD_(ULONG, AddRef)(void) { return ++m_Ref; }
+    STDMETHOD_(ULONG, Release)(void) {
+        ULONG ref = --m_Ref;
+        if (ref == 0)
+            delete this;
+        return ref;
+    }
+    STDMETHOD(GetDevice)(IDirect3DDevice9 **dev) {
+        *dev = m_Filter;
+        m_Filter->AddRef();
+        return D3D_OK;
+    }
+    STDMETHOD(Capture)(void) { return m_Block->Capture(); }
+    STDMETHOD(Apply)(void) {
+        m_Filter->Invalidate();
+        return m_Block->Apply();
+    }
+};
+
+CFilterDevice::CFilterDevice(IDirect3DDevice9 *dev) : m_Ref(1), m_Dev(dev) {
+    m_Recording = false;
+    m_Passed = 0;
+    m_Dropped = 0;
+    Invalidate();
+}
+
+CFilterDevice::~CFilterDevice() {
+    m_Dev->Release();
+    if (g_FilterDevice == this)
+        g_FilterDevice = NULL;
+}
+
+void CFilterDevice::Invalidate(void) {
+    memset(m_RSValid, 0, sizeof(m_RSValid));
+    memset(m_TSSValid, 0, sizeof(m_TSSValid));
+    memset(m_SSValid, 0, sizeof(m_SSValid));
+    memset(m_TexValid, 0, sizeof(m_TexValid));
+    for (SStream &s : m_Streams) {
+        s.m_Valid = false;
+    }
+    m_IBValid = false;
+    m_FVFValid = false;
+    m_VSValid = false;
+    m_PSValid = false;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::QueryInterface(REFIID riid, void **object) {
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(IDirect3DDevice9)) {
+        *object = static_cast<IDirect3DDevice9 *>(this);
+        AddRef();
+        return S_OK;
+    }
+    return m_Dev->QueryInterface(riid, object);
+}
+
+ULONG STDMETHODCALLTYPE CFilterDevice::AddRef(void) {
+    return ++m_Ref;
+}
+
+ULONG STDMETHODCALLTYPE CFilterDevice::Release(void) {
+    ULONG ref = --m_Ref;
+    if (ref == 0)
+        delete this;
+    return ref;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::Reset(D3DPRESENT_PARAMETERS *pp) {
+    // all the states are set to the defaults, the resources are unbound
+    Invalidate();
+    return m_Dev->Reset(pp);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::BeginScene(void) {
+    Invalidate();
+    return m_Dev->BeginScene();
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateStateBlock(D3DSTATEBLOCKTYPE type, IDirect3DStateBlock9 **sb) {
+    IDirect3DStateBlock9 *block;
+    HRESULT hr = m_Dev->CreateStateBlock(type, &block);
+    if (FAILED(hr))
+        return hr;
+    *sb = new CFilterStateBlock(this, block);
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::BeginStateBlock(void) {
+    m_Recording = true;
+    return m_Dev->BeginStateBlock();
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::EndStateBlock(IDirect3DStateBlock9 **sb) {
+    m_Recording = false;
+    Invalidate();
+    IDirect3DStateBlock9 *block;
+    HRESULT hr = m_Dev->EndStateBlock(&block);
+    if (FAILED(hr))
+        return hr;
+    *sb = new CFilterStateBlock(this, block);
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetRenderState(D3DRENDERSTATETYPE state, DWORD value) {
+    if (UINT(state) >= FILTER_DEVICE_RS_CNT)
+        return m_Dev->SetRenderState(state, value);
+    if (Drop(m_RSValid[state] && m_RS[state] == value))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetRenderState(state, value);
+    m_RS[state] = value;
+    m_RSValid[state] = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetTextureStageState(DWORD stage, D3DTEXTURESTAGESTATETYPE type,
+                                                               DWORD value) {
+    if (stage >= FILTER_DEVICE_STAGES || UINT(type) >= FILTER_DEVICE_TSS_CNT)
+        return m_Dev->SetTextureStageState(stage, type, value);
+    if (Drop(m_TSSValid[stage][type] && m_TSS[stage][type] == value))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetTextureStageState(stage, type, value);
+    m_TSS[stage][type] = value;
+    m_TSSValid[stage][type] = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetSamplerState(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value) {
+    // the displacement map and the vertex texture samplers are not remembered
+    if (sampler >= FILTER_DEVICE_SAMPLERS || UINT(type) >= FILTER_DEVICE_SS_CNT)
+        return m_Dev->SetSamplerState(sampler, type, value);
+    if (Drop(m_SSValid[sampler][type] && m_SS[sampler][type] == value))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetSamplerState(sampler, type, value);
+    m_SS[sampler][type] = value;
+    m_SSValid[sampler][type] = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetTexture(DWORD stage, IDirect3DBaseTexture9 *texture) {
+    if (stage >= FILTER_DEVICE_SAMPLERS)
+        return m_Dev->SetTexture(stage, texture);
+    if (Drop(m_TexValid[stage] && m_Tex[stage] == texture))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetTexture(stage, texture);
+    m_Tex[stage] = texture;
+    m_TexValid[stage] = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetFVF(DWORD fvf) {
+    if (Drop(m_FVFValid && m_FVF == fvf))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetFVF(fvf);
+    m_FVF = fvf;
+    m_FVFValid = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetVertexDeclaration(IDirect3DVertexDeclaration9 *decl) {
+    // replaces the FVF
+    m_FVFValid = false;
+    return m_Dev->SetVertexDeclaration(decl);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetStreamSource(UINT stream, IDirect3DVertexBuffer9 *vb, UINT offset,
+                                                          UINT stride) {
+    if (stream >= FILTER_DEVICE_STREAMS)
+        return m_Dev->SetStreamSource(stream, vb, offset, stride);
+    SStream &s = m_Streams[stream];
+    if (Drop(s.m_Valid && s.m_VB == vb && s.m_Offset == offset && s.m_Stride == stride))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetStreamSource(stream, vb, offset, stride);
+    s.m_VB = vb;
+    s.m_Offset = offset;
+    s.m_Stride = stride;
+    s.m_Valid = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetIndices(IDirect3DIndexBuffer9 *ib) {
+    if (Drop(m_IBValid && m_IB == ib))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetIndices(ib);
+    m_IB = ib;
+    m_IBValid = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetVertexShader(IDirect3DVertexShader9 *shader) {
+    if (Drop(m_VSValid && m_VS == shader))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetVertexShader(shader);
+    m_VS = shader;
+    m_VSValid = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetPixelShader(IDirect3DPixelShader9 *shader) {
+    if (Drop(m_PSValid && m_PS == shader))
+        return D3D_OK;
+    HRESULT hr = m_Dev->SetPixelShader(shader);
+    m_PS = shader;
+    m_PSValid = SUCCEEDED(hr) && !m_Recording;
+    return hr;
+}
+
+// the rest goes to the device as it is
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::TestCooperativeLevel(void) {
+    return m_Dev->TestCooperativeLevel();
+}
+
+UINT STDMETHODCALLTYPE CFilterDevice::GetAvailableTextureMem(void) {
+    return m_Dev->GetAvailableTextureMem();
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::EvictManagedResources(void) {
+    return m_Dev->EvictManagedResources();
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetDirect3D(IDirect3D9 **d3d) {
+    return m_Dev->GetDirect3D(d3d);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetDeviceCaps(D3DCAPS9 *caps) {
+    return m_Dev->GetDeviceCaps(caps);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetDisplayMode(UINT swapchain, D3DDISPLAYMODE *mode) {
+    return m_Dev->GetDisplayMode(swapchain, mode);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetCreationParameters(D3DDEVICE_CREATION_PARAMETERS *params) {
+    return m_Dev->GetCreationParameters(params);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetCursorProperties(UINT x, UINT y, IDirect3DSurface9 *bitmap) {
+    return m_Dev->SetCursorProperties(x, y, bitmap);
+}
+
+void STDMETHODCALLTYPE CFilterDevice::SetCursorPosition(int x, int y, DWORD flags) {
+    m_Dev->SetCursorPosition(x, y, flags);
+}
+
+BOOL STDMETHODCALLTYPE CFilterDevice::ShowCursor(BOOL show) {
+    return m_Dev->ShowCursor(show);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateAdditionalSwapChain(D3DPRESENT_PARAMETERS *pp,
+                                                                   IDirect3DSwapChain9 **swapchain) {
+    return m_Dev->CreateAdditionalSwapChain(pp, swapchain);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetSwapChain(UINT no, IDirect3DSwapChain9 **swapchain) {
+    return m_Dev->GetSwapChain(no, swapchain);
+}
+
+UINT STDMETHODCALLTYPE CFilterDevice::GetNumberOfSwapChains(void) {
+    return m_Dev->GetNumberOfSwapChains();
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::Present(const RECT *src, const RECT *dst, HWND wnd, const RGNDATA *dirty) {
+    return m_Dev->Present(src, dst, wnd, dirty);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetBackBuffer(UINT swapchain, UINT no, D3DBACKBUFFER_TYPE type,
+                                                       IDirect3DSurface9 **surface) {
+    return m_Dev->GetBackBuffer(swapchain, no, type, surface);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetRasterStatus(UINT swapchain, D3DRASTER_STATUS *status) {
+    return m_Dev->GetRasterStatus(swapchain, status);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetDialogBoxMode(BOOL enable) {
+    return m_Dev->SetDialogBoxMode(enable);
+}
+
+void STDMETHODCALLTYPE CFilterDevice::SetGammaRamp(UINT swapchain, DWORD flags, const D3DGAMMARAMP *ramp) {
+    m_Dev->SetGammaRamp(swapchain, flags, ramp);
+}
+
+void STDMETHODCALLTYPE CFilterDevice::GetGammaRamp(UINT swapchain, D3DGAMMARAMP *ramp) {
+    m_Dev->GetGammaRamp(swapchain, ramp);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateTexture(UINT w, UINT h, UINT levels, DWORD usage, D3DFORMAT format,
+                                                       D3DPOOL pool, IDirect3DTexture9 **texture, HANDLE *shared) {
+    return m_Dev->CreateTexture(w, h, levels, usage, format, pool, texture, shared);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateVolumeTexture(UINT w, UINT h, UINT d, UINT levels, DWORD usage,
+                                                             D3DFORMAT format, D3DPOOL pool,
+                                                             IDirect3DVolumeTexture9 **texture, HANDLE *shared) {
+    return m_Dev->CreateVolumeTexture(w, h, d, levels, usage, format, pool, texture, shared);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateCubeTexture(UINT size, UINT levels, DWORD usage, D3DFORMAT format,
+                                                           D3DPOOL pool, IDirect3DCubeTexture9 **texture,
+                                                           HANDLE *shared) {
+    return m_Dev->CreateCubeTexture(size, levels, usage, format, pool, texture, shared);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateVertexBuffer(UINT len, DWORD usage, DWORD fvf, D3DPOOL pool,
+                                                            IDirect3DVertexBuffer9 **vb, HANDLE *shared) {
+    return m_Dev->CreateVertexBuffer(len, usage, fvf, pool, vb, shared);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateIndexBuffer(UINT len, DWORD usage, D3DFORMAT format, D3DPOOL pool,
+                                                           IDirect3DIndexBuffer9 **ib, HANDLE *shared) {
+    return m_Dev->CreateIndexBuffer(len, usage, format, pool, ib, shared);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateRenderTarget(UINT w, UINT h, D3DFORMAT format, D3DMULTISAMPLE_TYPE ms,
+                                                            DWORD quality, BOOL lockable, IDirect3DSurface9 **surface,
+                                                            HANDLE *shared) {
+    return m_Dev->CreateRenderTarget(w, h, format, ms, quality, lockable, surface, shared);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateDepthStencilSurface(UINT w, UINT h, D3DFORMAT format,
+                                                                   D3DMULTISAMPLE_TYPE ms, DWORD quality, BOOL discard,
+                                                                   IDirect3DSurface9 **surface, HANDLE *shared) {
+    return m_Dev->CreateDepthStencilSurface(w, h, format, ms, quality, discard, surface, shared);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::UpdateSurface(IDirect3DSurface9 *src, const RECT *srcrect,
+                                                       IDirect3DSurface9 *dst, const POINT *dstpoint) {
+    return m_Dev->UpdateSurface(src, srcrect, dst, dstpoint);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::UpdateTexture(IDirect3DBaseTexture9 *src, IDirect3DBaseTexture9 *dst) {
+    return m_Dev->UpdateTexture(src, dst);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetRenderTargetData(IDirect3DSurface9 *rt, IDirect3DSurface9 *dst) {
+    return m_Dev->GetRenderTargetData(rt, dst);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetFrontBufferData(UINT swapchain, IDirect3DSurface9 *dst) {
+    return m_Dev->GetFrontBufferData(swapchain, dst);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::StretchRect(IDirect3DSurface9 *src, const RECT *srcrect,
+                                                     IDirect3DSurface9 *dst, const RECT *dstrect,
+                                                     D3DTEXTUREFILTERTYPE filter) {
+    return m_Dev->StretchRect(src, srcrect, dst, dstrect, filter);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::ColorFill(IDirect3DSurface9 *surface, const RECT *rect, D3DCOLOR color) {
+    return m_Dev->ColorFill(surface, rect, color);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateOffscreenPlainSurface(UINT w, UINT h, D3DFORMAT format, D3DPOOL pool,
+                                                                     IDirect3DSurface9 **surface, HANDLE *shared) {
+    return m_Dev->CreateOffscreenPlainSurface(w, h, format, pool, surface, shared);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetRenderTarget(DWORD no, IDirect3DSurface9 *rt) {
+    return m_Dev->SetRenderTarget(no, rt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetRenderTarget(DWORD no, IDirect3DSurface9 **rt) {
+    return m_Dev->GetRenderTarget(no, rt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetDepthStencilSurface(IDirect3DSurface9 *ds) {
+    return m_Dev->SetDepthStencilSurface(ds);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetDepthStencilSurface(IDirect3DSurface9 **ds) {
+    return m_Dev->GetDepthStencilSurface(ds);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::EndScene(void) {
+    return m_Dev->EndScene();
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::Clear(DWORD cnt, const D3DRECT *rects, DWORD flags, D3DCOLOR color, float z,
+                                               DWORD stencil) {
+    return m_Dev->Clear(cnt, rects, flags, color, z, stencil);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetTransform(D3DTRANSFORMSTATETYPE state, const D3DMATRIX *matrix) {
+    return m_Dev->SetTransform(state, matrix);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetTransform(D3DTRANSFORMSTATETYPE state, D3DMATRIX *matrix) {
+    return m_Dev->GetTransform(state, matrix);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::MultiplyTransform(D3DTRANSFORMSTATETYPE state, const D3DMATRIX *matrix) {
+    return m_Dev->MultiplyTransform(state, matrix);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetViewport(const D3DVIEWPORT9 *vp) {
+    return m_Dev->SetViewport(vp);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetViewport(D3DVIEWPORT9 *vp) {
+    return m_Dev->GetViewport(vp);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetMaterial(const D3DMATERIAL9 *material) {
+    return m_Dev->SetMaterial(material);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetMaterial(D3DMATERIAL9 *material) {
+    return m_Dev->GetMaterial(material);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetLight(DWORD no, const D3DLIGHT9 *light) {
+    return m_Dev->SetLight(no, light);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetLight(DWORD no, D3DLIGHT9 *light) {
+    return m_Dev->GetLight(no, light);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::LightEnable(DWORD no, BOOL enable) {
+    return m_Dev->LightEnable(no, enable);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetLightEnable(DWORD no, BOOL *enable) {
+    return m_Dev->GetLightEnable(no, enable);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetClipPlane(DWORD no, const float *plane) {
+    return m_Dev->SetClipPlane(no, plane);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetClipPlane(DWORD no, float *plane) {
+    return m_Dev->GetClipPlane(no, plane);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetRenderState(D3DRENDERSTATETYPE state, DWORD *value) {
+    return m_Dev->GetRenderState(state, value);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetClipStatus(const D3DCLIPSTATUS9 *status) {
+    return m_Dev->SetClipStatus(status);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetClipStatus(D3DCLIPSTATUS9 *status) {
+    return m_Dev->GetClipStatus(status);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetTexture(DWORD stage, IDirect3DBaseTexture9 **texture) {
+    return m_Dev->GetTexture(stage, texture);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetTextureStageState(DWORD stage, D3DTEXTURESTAGESTATETYPE type,
+                                                              DWORD *value) {
+    return m_Dev->GetTextureStageState(stage, type, value);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetSamplerState(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD *value) {
+    return m_Dev->GetSamplerState(sampler, type, value);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::ValidateDevice(DWORD *passes) {
+    return m_Dev->ValidateDevice(passes);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetPaletteEntries(UINT palette, const PALETTEENTRY *entries) {
+    return m_Dev->SetPaletteEntries(palette, entries);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetPaletteEntries(UINT palette, PALETTEENTRY *entries) {
+    return m_Dev->GetPaletteEntries(palette, entries);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetCurrentTexturePalette(UINT palette) {
+    return m_Dev->SetCurrentTexturePalette(palette);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetCurrentTexturePalette(UINT *palette) {
+    return m_Dev->GetCurrentTexturePalette(palette);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetScissorRect(const RECT *rect) {
+    return m_Dev->SetScissorRect(rect);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetScissorRect(RECT *rect) {
+    return m_Dev->GetScissorRect(rect);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetSoftwareVertexProcessing(BOOL software) {
+    return m_Dev->SetSoftwareVertexProcessing(software);
+}
+
+BOOL STDMETHODCALLTYPE CFilterDevice::GetSoftwareVertexProcessing(void) {
+    return m_Dev->GetSoftwareVertexProcessing();
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetNPatchMode(float segments) {
+    return m_Dev->SetNPatchMode(segments);
+}
+
+float STDMETHODCALLTYPE CFilterDevice::GetNPatchMode(void) {
+    return m_Dev->GetNPatchMode();
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::DrawPrimitive(D3DPRIMITIVETYPE type, UINT start, UINT prims) {
+    return m_Dev->DrawPrimitive(type, start, prims);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::DrawIndexedPrimitive(D3DPRIMITIVETYPE type, INT base, UINT minvert, UINT verts,
+                                                              UINT start, UINT prims) {
+    return m_Dev->DrawIndexedPrimitive(type, base, minvert, verts, start, prims);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::DrawPrimitiveUP(D3DPRIMITIVETYPE type, UINT prims, const void *data,
+                                                         UINT stride) {
+    return m_Dev->DrawPrimitiveUP(type, prims, data, stride);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::DrawIndexedPrimitiveUP(D3DPRIMITIVETYPE type, UINT minvert, UINT verts,
+                                                                UINT prims, const void *indices, D3DFORMAT format,
+                                                                const void *data, UINT stride) {
+    return m_Dev->DrawIndexedPrimitiveUP(type, minvert, verts, prims, indices, format, data, stride);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::ProcessVertices(UINT src, UINT dst, UINT cnt, IDirect3DVertexBuffer9 *vb,
+                                                         IDirect3DVertexDeclaration9 *decl, DWORD flags) {
+    return m_Dev->ProcessVertices(src, dst, cnt, vb, decl, flags);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateVertexDeclaration(const D3DVERTEXELEMENT9 *elements,
+                                                                 IDirect3DVertexDeclaration9 **decl) {
+    return m_Dev->CreateVertexDeclaration(elements, decl);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetVertexDeclaration(IDirect3DVertexDeclaration9 **decl) {
+    return m_Dev->GetVertexDeclaration(decl);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetFVF(DWORD *fvf) {
+    return m_Dev->GetFVF(fvf);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateVertexShader(const DWORD *code, IDirect3DVertexShader9 **shader) {
+    return m_Dev->CreateVertexShader(code, shader);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetVertexShader(IDirect3DVertexShader9 **shader) {
+    return m_Dev->GetVertexShader(shader);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetVertexShaderConstantF(UINT reg, const float *data, UINT cnt) {
+    return m_Dev->SetVertexShaderConstantF(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetVertexShaderConstantF(UINT reg, float *data, UINT cnt) {
+    return m_Dev->GetVertexShaderConstantF(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetVertexShaderConstantI(UINT reg, const int *data, UINT cnt) {
+    return m_Dev->SetVertexShaderConstantI(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetVertexShaderConstantI(UINT reg, int *data, UINT cnt) {
+    return m_Dev->GetVertexShaderConstantI(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetVertexShaderConstantB(UINT reg, const BOOL *data, UINT cnt) {
+    return m_Dev->SetVertexShaderConstantB(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetVertexShaderConstantB(UINT reg, BOOL *data, UINT cnt) {
+    return m_Dev->GetVertexShaderConstantB(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetStreamSource(UINT stream, IDirect3DVertexBuffer9 **vb, UINT *offset,
+                                                         UINT *stride) {
+    return m_Dev->GetStreamSource(stream, vb, offset, stride);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetStreamSourceFreq(UINT stream, UINT divider) {
+    return m_Dev->SetStreamSourceFreq(stream, divider);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetStreamSourceFreq(UINT stream, UINT *divider) {
+    return m_Dev->GetStreamSourceFreq(stream, divider);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetIndices(IDirect3DIndexBuffer9 **ib) {
+    return m_Dev->GetIndices(ib);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreatePixelShader(const DWORD *code, IDirect3DPixelShader9 **shader) {
+    return m_Dev->CreatePixelShader(code, shader);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetPixelShader(IDirect3DPixelShader9 **shader) {
+    return m_Dev->GetPixelShader(shader);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetPixelShaderConstantF(UINT reg, const float *data, UINT cnt) {
+    return m_Dev->SetPixelShaderConstantF(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetPixelShaderConstantF(UINT reg, float *data, UINT cnt) {
+    return m_Dev->GetPixelShaderConstantF(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetPixelShaderConstantI(UINT reg, const int *data, UINT cnt) {
+    return m_Dev->SetPixelShaderConstantI(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetPixelShaderConstantI(UINT reg, int *data, UINT cnt) {
+    return m_Dev->GetPixelShaderConstantI(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::SetPixelShaderConstantB(UINT reg, const BOOL *data, UINT cnt) {
+    return m_Dev->SetPixelShaderConstantB(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::GetPixelShaderConstantB(UINT reg, BOOL *data, UINT cnt) {
+    return m_Dev->GetPixelShaderConstantB(reg, data, cnt);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::DrawRectPatch(UINT handle, const float *segments,
+                                                       const D3DRECTPATCH_INFO *info) {
+    return m_Dev->DrawRectPatch(handle, segments, info);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::DrawTriPatch(UINT handle, const float *segments,
+                                                      const D3DTRIPATCH_INFO *info) {
+    return m_Dev->DrawTriPatch(handle, segments, info);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::DeletePatch(UINT handle) {
+    return m_Dev->DeletePatch(handle);
+}
+
+HRESULT STDMETHODCALLTYPE CFilterDevice::CreateQuery(D3DQUERYTYPE type, IDirect3DQuery9 **query) {
+    return m_Dev->CreateQuery(type, query);
+}
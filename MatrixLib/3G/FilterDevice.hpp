@@ -0,0 +1,224 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "d3d9.h"
+
+#define FILTER_DEVICE_RS_CNT     256
+#define FILTER_DEVICE_STAGES     8
+#define FILTER_DEVICE_TSS_CNT    33
+#define FILTER_DEVICE_SAMPLERS   16
+#define FILTER_DEVICE_SS_CNT     14
+#define FILTER_DEVICE_STREAMS    16
+
+/**
+ * @brief Device which drops the calls setting what is set already and passes the rest to the real one.
+ *
+ * Every Draw sets its textures and states on its own, most of them are the same as for the previous object.
+ * The render, stage and sampler states, the textures, the streams, the indices, the FVF and the shaders set
+ * through it are remembered, a call with the same value does not reach the driver. The Get* calls go to the
+ * real device, it has the same values.
+ *
+ * What is remembered is forgotten when the device may have changed without it: Reset, BeginScene (the host
+ * draws between the scenes when the game runs as a DLL), the state blocks applied and recorded.
+ *
+ * Enabled by StateFilter=1 in the Config block.
+ */
+class CFilterDevice : public IDirect3DDevice9 {
+    ULONG m_Ref;
+    IDirect3DDevice9 *m_Dev;
+
+    DWORD m_RS[FILTER_DEVICE_RS_CNT];
+    DWORD m_TSS[FILTER_DEVICE_STAGES][FILTER_DEVICE_TSS_CNT];
+    DWORD m_SS[FILTER_DEVICE_SAMPLERS][FILTER_DEVICE_SS_CNT];
+    bool m_RSValid[FILTER_DEVICE_RS_CNT];
+    bool m_TSSValid[FILTER_DEVICE_STAGES][FILTER_DEVICE_TSS_CNT];
+    bool m_SSValid[FILTER_DEVICE_SAMPLERS][FILTER_DEVICE_SS_CNT];
+
+    // the device holds what is set, so a pointer is not reused while it is remembered
+    IDirect3DBaseTexture9 *m_Tex[FILTER_DEVICE_SAMPLERS];
+    bool m_TexValid[FILTER_DEVICE_SAMPLERS];
+    struct SStream {
+        IDirect3DVertexBuffer9 *m_VB;
+        UINT m_Offset;
+        UINT m_Stride;
+        bool m_Valid;
+    } m_Streams[FILTER_DEVICE_STREAMS];
+    IDirect3DIndexBuffer9 *m_IB;
+    bool m_IBValid;
+    DWORD m_FVF;
+    bool m_FVFValid;
+    IDirect3DVertexShader9 *m_VS;
+    bool m_VSValid;
+    IDirect3DPixelShader9 *m_PS;
+    bool m_PSValid;
+
+    bool m_Recording;  // between BeginStateBlock and EndStateBlock everything goes to the block
+
+    DWORD m_Passed;
+    DWORD m_Dropped;
+
+    bool Drop(bool same) {
+        if (same && !m_Recording) {
+            ++m_Dropped;
+            return true;
+        }
+        ++m_Passed;
+        return false;
+    }
+
+public:
+    // takes the reference of dev
+    CFilterDevice(IDirect3DDevice9 *dev);
+    virtual ~CFilterDevice();
+
+    // to be called after the device is used past the filter
+    void Invalidate(void);
+
+    IDirect3DDevice9 *GetDevice(void) const { return m_Dev; }
+    // the state calls passed to the device and dropped, since the start
+    DWORD GetPassed(void) const { return m_Passed; }
+    DWORD GetDropped(void) const { return m_Dropped; }
+
+    // IUnknown
+    STDMETHOD(QueryInterface)(REFIID riid, void **object);
+    STDMETHOD_(ULONG, AddRef)(void);
+    STDMETHOD_(ULONG, Release)(void);
+
+    // IDirect3DDevice9
+    STDMETHOD(TestCooperativeLevel)(void);
+    STDMETHOD_(UINT, GetAvailableTextureMem)(void);
+    STDMETHOD(EvictManagedResources)(void);
+    STDMETHOD(GetDirect3D)(IDirect3D9 **d3d);
+    STDMETHOD(GetDeviceCaps)(D3DCAPS9 *caps);
+    STDMETHOD(GetDisplayMode)(UINT swapchain, D3DDISPLAYMODE *mode);
+    STDMETHOD(GetCreationParameters)(D3DDEVICE_CREATION_PARAMETERS *params);
+    STDMETHOD(SetCursorProperties)(UINT x, UINT y, IDirect3DSurface9 *bitmap);
+    STDMETHOD_(void, SetCursorPosition)(int x, int y, DWORD flags);
+    STDMETHOD_(BOOL, ShowCursor)(BOOL show);
+    STDMETHOD(CreateAdditionalSwapChain)(D3DPRESENT_PARAMETERS *pp, IDirect3DSwapChain9 **swapchain);
+    STDMETHOD(GetSwapChain)(UINT no, IDirect3DSwapChain9 **swapchain);
+    STDMETHOD_(UINT, GetNumberOfSwapChains)(void);
+    STDMETHOD(Reset)(D3DPRESENT_PARAMETERS *pp);
+    STDMETHOD(Present)(const RECT *src, const RECT *dst, HWND wnd, const RGNDATA *dirty);
+    STDMETHOD(GetBackBuffer)(UINT swapchain, UINT no, D3DBACKBUFFER_TYPE type, IDirect3DSurface9 **surface);
+    STDMETHOD(GetRasterStatus)(UINT swapchain, D3DRASTER_STATUS *status);
+    STDMETHOD(SetDialogBoxMode)(BOOL enable);
+    STDMETHOD_(void, SetGammaRamp)(UINT swapchain, DWORD flags, const D3DGAMMARAMP *ramp);
+    STDMETHOD_(void, GetGammaRamp)(UINT swapchain, D3DGAMMARAMP *ramp);
+    STDMETHOD(CreateTexture)(UINT w, UINT h, UINT levels, DWORD usage, D3DFORMAT format, D3DPOOL pool,
+                             IDirect3DTexture9 **texture, HANDLE *shared);
+    STDMETHOD(CreateVolumeTexture)(UINT w, UINT h, UINT d, UINT levels, DWORD usage, D3DFORMAT format, D3DPOOL pool,
+                                   IDirect3DVolumeTexture9 **texture, HANDLE *shared);
+    STDMETHOD(CreateCubeTexture)(UINT size, UINT levels, DWORD usage, D3DFORMAT format, D3DPOOL pool,
+                                 IDirect3DCubeTexture9 **texture, HANDLE *shared);
+    STDMETHOD(CreateVertexBuffer)(UINT len, DWORD usage, DWORD fvf, D3DPOOL pool, IDirect3DVertexBuffer9 **vb,
+                                  HANDLE *shared);
+    STDMETHOD(CreateIndexBuffer)(UINT len, DWORD usage, D3DFORMAT format, D3DPOOL pool, IDirect3DIndexBuffer9 **ib,
+                                 HANDLE *shared);
+    STDMETHOD(CreateRenderTarget)(UINT w, UINT h, D3DFORMAT format, D3DMULTISAMPLE_TYPE ms, DWORD quality,
+                                  BOOL lockable, IDirect3DSurface9 **surface, HANDLE *shared);
+    STDMETHOD(CreateDepthStencilSurface)(UINT w, UINT h, D3DFORMAT format, D3DMULTISAMPLE_TYPE ms, DWORD quality,
+                                         BOOL discard, IDirect3DSurface9 **surface, HANDLE *shared);
+    STDMETHOD(UpdateSurface)(IDirect3DSurface9 *src, const RECT *srcrect, IDirect3DSurface9 *dst,
+                             const POINT *dstpoint);
+    STDMETHOD(UpdateTexture)(IDirect3DBaseTexture9 *src, IDirect3DBaseTexture9 *dst);
+    STDMETHOD(GetRenderTargetData)(IDirect3DSurface9 *rt, IDirect3DSurface9 *dst);
+    STDMETHOD(GetFrontBufferData)(UINT swapchain, IDirect3DSurface9 *dst);
+    STDMETHOD(StretchRect)(IDirect3DSurface9 *src, const RECT *srcrect, IDirect3DSurface9 *dst, const RECT *dstrect,
+                           D3DTEXTUREFILTERTYPE filter);
+    STDMETHOD(ColorFill)(IDirect3DSurface9 *surface, const RECT *rect, D3DCOLOR color);
+    STDMETHOD(CreateOffscreenPlainSurface)(UINT w, UINT h, D3DFORMAT format, D3DPOOL pool,
+                                           IDirect3DSurface9 **surface, HANDLE *shared);
+    STDMETHOD(SetRenderTarget)(DWORD no, IDirect3DSurface9 *rt);
+    STDMETHOD(GetRenderTarget)(DWORD no, IDirect3DSurface9 **rt);
+    STDMETHOD(SetDepthStencilSurface)(IDirect3DSurface9 *ds);
+    STDMETHOD(GetDepthStencilSurface)(IDirect3DSurface9 **ds);
+    STDMETHOD(BeginScene)(void);
+    STDMETHOD(EndScene)(void);
+    STDMETHOD(Clear)(DWORD cnt, const D3DRECT *rects, DWORD flags, D3DCOLOR color, float z, DWORD stencil);
+    STDMETHOD(SetTransform)(D3DTRANSFORMSTATETYPE state, const D3DMATRIX *matrix);
+    STDMETHOD(GetTransform)(D3DTRANSFORMSTATETYPE state, D3DMATRIX *matrix);
+    STDMETHOD(MultiplyTransform)(D3DTRANSFORMSTATETYPE state, const D3DMATRIX *matrix);
+    STDMETHOD(SetViewport)(const D3DVIEWPORT9 *vp);
+    STDMETHOD(GetViewport)(D3DVIEWPORT9 *vp);
+    STDMETHOD(SetMaterial)(const D3DMATERIAL9 *material);
+    STDMETHOD(GetMaterial)(D3DMATERIAL9 *material);
+    STDMETHOD(SetLight)(DWORD no, const D3DLIGHT9 *light);
+    STDMETHOD(GetLight)(DWORD no, D3DLIGHT9 *light);
+    STDMETHOD(LightEnable)(DWORD no, BOOL enable);
+    STDMETHOD(GetLightEnable)(DWORD no, BOOL *enable);
+    STDMETHOD(SetClipPlane)(DWORD no, const float *plane);
+    STDMETHOD(GetClipPlane)(DWORD no, float *plane);
+    STDMETHOD(SetRenderState)(D3DRENDERSTATETYPE state, DWORD value);
+    STDMETHOD(GetRenderState)(D3DRENDERSTATETYPE state, DWORD *value);
+    STDMETHOD(CreateStateBlock)(D3DSTATEBLOCKTYPE type, IDirect3DStateBlock9 **sb);
+    STDMETHOD(BeginStateBlock)(void);
+    STDMETHOD(EndStateBlock)(IDirect3DStateBlock9 **sb);
+    STDMETHOD(SetClipStatus)(const D3DCLIPSTATUS9 *status);
+    STDMETHOD(GetClipStatus)(D3DCLIPSTATUS9 *status);
+    STDMETHOD(GetTexture)(DWORD stage, IDirect3DBaseTexture9 **texture);
+    STDMETHOD(SetTexture)(DWORD stage, IDirect3DBaseTexture9 *texture);
+    STDMETHOD(GetTextureStageState)(DWORD stage, D3DTEXTURESTAGESTATETYPE type, DWORD *value);
+    STDMETHOD(SetTextureStageState)(DWORD stage, D3DTEXTURESTAGESTATETYPE type, DWORD value);
+    STDMETHOD(GetSamplerState)(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD *value);
+    STDMETHOD(SetSamplerState)(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value);
+    STDMETHOD(ValidateDevice)(DWORD *passes);
+    STDMETHOD(SetPaletteEntries)(UINT palette, const PALETTEENTRY *entries);
+    STDMETHOD(GetPaletteEntries)(UINT palette, PALETTEENTRY *entries);
+    STDMETHOD(SetCurrentTexturePalette)(UINT palette);
+    STDMETHOD(GetCurrentTexturePalette)(UINT *palette);
+    STDMETHOD(SetScissorRect)(const RECT *rect);
+    STDMETHOD(GetScissorRect)(RECT *rect);
+    STDMETHOD(SetSoftwareVertexProcessing)(BOOL software);
+    STDMETHOD_(BOOL, GetSoftwareVertexProcessing)(void);
+    STDMETHOD(SetNPatchMode)(float segments);
+    STDMETHOD_(float, GetNPatchMode)(void);
+    STDMETHOD(DrawPrimitive)(D3DPRIMITIVETYPE type, UINT start, UINT prims);
+    STDMETHOD(DrawIndexedPrimitive)(D3DPRIMITIVETYPE type, INT base, UINT minvert, UINT verts, UINT start,
+                                    UINT prims);
+    STDMETHOD(DrawPrimitiveUP)(D3DPRIMITIVETYPE type, UINT prims, const void *data, UINT stride);
+    STDMETHOD(DrawIndexedPrimitiveUP)(D3DPRIMITIVETYPE type, UINT minvert, UINT verts, UINT prims,
+                                      const void *indices, D3DFORMAT format, const void *data, UINT stride);
+    STDMETHOD(ProcessVertices)(UINT src, UINT dst, UINT cnt, IDirect3DVertexBuffer9 *vb,
+                               IDirect3DVertexDeclaration9 *decl, DWORD flags);
+    STDMETHOD(CreateVertexDeclaration)(const D3DVERTEXELEMENT9 *elements, IDirect3DVertexDeclaration9 **decl);
+    STDMETHOD(SetVertexDeclaration)(IDirect3DVertexDeclaration9 *decl);
+    STDMETHOD(GetVertexDeclaration)(IDirect3DVertexDeclaration9 **decl);
+    STDMETHOD(SetFVF)(DWORD fvf);
+    STDMETHOD(GetFVF)(DWORD *fvf);
+    STDMETHOD(CreateVertexShader)(const DWORD *code, IDirect3DVertexShader9 **shader);
+    STDMETHOD(SetVertexShader)(IDirect3DVertexShader9 *shader);
+    STDMETHOD(GetVertexShader)(IDirect3DVertexShader9 **shader);
+    STDMETHOD(SetVertexShaderConstantF)(UINT reg, const float *data, UINT cnt);
+    STDMETHOD(GetVertexShaderConstantF)(UINT reg, float *data, UINT cnt);
+    STDMETHOD(SetVertexShaderConstantI)(UINT reg, const int *data, UINT cnt);
+    STDMETHOD(GetVertexShaderConstantI)(UINT reg, int *data, UINT cnt);
+    STDMETHOD(SetVertexShaderConstantB)(UINT reg, const BOOL *data, UINT cnt);
+    STDMETHOD(GetVertexShaderConstantB)(UINT reg, BOOL *data, UINT cnt);
+    STDMETHOD(SetStreamSource)(UINT stream, IDirect3DVertexBuffer9 *vb, UINT offset, UINT stride);
+    STDMETHOD(GetStreamSource)(UINT stream, IDirect3DVertexBuffer9 **vb, UINT *offset, UINT *stride);
+    STDMETHOD(SetStreamSourceFreq)(UINT stream, UINT divider);
+    STDMETHOD(GetStreamSourceFreq)(UINT stream, UINT *divider);
+    STDMETHOD(SetIndices)(IDirect3DIndexBuffer9 *ib);
+    STDMETHOD(GetIndices)(IDirect3DIndexBuffer9 **ib);
+    STDMETHOD(CreatePixelShader)(const DWORD *code, IDirect3DPixelShader9 **shader);
+    STDMETHOD(SetPixelShader)(IDirect3DPixelShader9 *shader);
+    STDMETHOD(GetPixelShader)(IDirect3DPixelShader9 **shader);
+    STDMETHOD(SetPixelShaderConstantF)(UINT reg, const float *data, UINT cnt);
+    STDMETHOD(GetPixelShaderConstantF)(UINT reg, float *data, UINT cnt);
+    STDMETHOD(SetPixelShaderConstantI)(UINT reg, const int *data, UINT cnt);
+    STDMETHOD(GetPixelShaderConstantI)(UINT reg, int *data, UINT cnt);
+    STDMETHOD(SetPixelShaderConstantB)(UINT reg, const BOOL *data, UINT cnt);
+    STDMETHOD(GetPixelShaderConstantB)(UINT reg, BOOL *data, UINT cnt);
+    STDMETHOD(DrawRectPatch)(UINT handle, const float *segments, const D3DRECTPATCH_INFO *info);
+    STDMETHOD(DrawTriPatch)(UINT handle, const float *segments, const D3DTRIPATCH_INFO *info);
+    STDMETHOD(DeletePatch)(UINT handle);
+    STDMETHOD(CreateQuery)(D3DQUERYTYPE type, IDirect3DQuery9 **query);
+};
+
+// set by L3GInitAsEXE and L3GInitAsDLL when the filter is in front of the device
+extern CFilterDevice *g_FilterDevice;
@@ -0,0 +1,1317 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "NullDevice.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+CNullDevice *g_NullDevice = NULL;
+
+static bool FormatIsDXT(D3DFORMAT format) {
+    return format == D3DFMT_DXT1 || format == D3DFMT_DXT2 || format == D3DFMT_DXT3 || format == D3DFMT_DXT4 ||
+           format == D3DFMT_DXT5;
+}
+
+// bytes of a pixel, of a 4x4 block for DXT
+static UINT FormatBytes(D3DFORMAT format) {
+    switch (format) {
+        case D3DFMT_DXT1:
+            return 8;
+        case D3DFMT_DXT2:
+        case D3DFMT_DXT3:
+        case D3DFMT_DXT4:
+        case D3DFMT_DXT5:
+            return 16;
+        case D3DFMT_A8:
+        case D3DFMT_L8:
+        case D3DFMT_P8:
+            return 1;
+        case D3DFMT_R5G6B5:
+        case D3DFMT_X1R5G5B5:
+        case D3DFMT_A1R5G5B5:
+        case D3DFMT_A4R4G4B4:
+        case D3DFMT_X4R4G4B4:
+        case D3DFMT_A8L8:
+        case D3DFMT_L16:
+        case D3DFMT_D16:
+        case D3DFMT_D16_LOCKABLE:
+        case D3DFMT_D15S1:
+            return 2;
+        case D3DFMT_R8G8B8:
+            return 3;
+        case D3DFMT_A16B16G16R16:
+        case D3DFMT_A16B16G16R16F:
+        case D3DFMT_G32R32F:
+            return 8;
+        case D3DFMT_A32B32G32R32F:
+            return 16;
+        default:
+            return 4;
+    }
+}
+
+static UINT FormatPitch(D3DFORMAT format, UINT w) {
+    return FormatIsDXT(format) ? ((w + 3) / 4) * FormatBytes(format) : w * FormatBytes(format);
+}
+
+static UINT FormatRows(D3DFORMAT format, UINT h) {
+    return FormatIsDXT(format) ? (h + 3) / 4 : h;
+}
+
+static UINT LevelCnt(UINT levels, UINT size) {
+    UINT all = 1;
+    while (size > 1) {
+        size >>= 1;
+        ++all;
+    }
+    return (levels == 0 || levels > all) ? all : levels;
+}
+
+// IUnknown and GetDevice of everything the device creates
+template <class I>
+class CNullUnknown : public I {
+protected:
+    ULONG m_Ref;
+    CNullDevice *m_Dev;
+
+public:
+    explicit CNullUnknown(CNullDevice *dev) : m_Ref(1), m_Dev(dev) {}
+    virtual ~CNullUnknown() {}
+
+    STDMETHOD(QueryInterface)(REFIID riid, void **object) {
+        bool found = riid == __uuidof(IUnknown) || riid == __uuidof(I);
+        if constexpr (std::is_base_of_v<IDirect3DResource9, I>)
+            found = found || riid == __uuidof(IDirect3DResource9);
+        if constexpr (std::is_base_of_v<IDirect3DBaseTexture9, I>)
+            found = found || riid == __uuidof(IDirect3DBaseTexture9);
+        if (!found) {
+            *object = NULL;
+            return E_NOINTERFACE;
+        }
+        *object = static_cast<I *>(this);
+        this->AddRef();
+        return S_OK;
+    }
+    STDMETHOD_(ULONG, AddRef)(void) { return ++m_Ref; }
+    STDMETHOD_(ULONG, Release)(void) {
+        ULONG ref = --m_Ref;
+        if (ref == 0)
+            delete this;
+        return ref;
+    }
+
+    STDMETHOD(GetDevice)(IDirect3DDevice9 **device) {
+        *device = m_Dev;
+        m_Dev->AddRef();
+        return D3D_OK;
+    }
+};
+
+template <class I>
+class CNullResource : public CNullUnknown<I> {
+public:
+    explicit CNullResource(CNullDevice *dev) : CNullUnknown<I>(dev) {}
+
+    STDMETHOD(SetPrivateData)(REFGUID, const void *, DWORD, DWORD) { return D3D_OK; }
+    STDMETHOD(GetPrivateData)(REFGUID, void *, DWORD *) { return D3DERR_NOTFOUND; }
+    STDMETHOD(FreePrivateData)(REFGUID) { return D3D_OK; }
+    STDMETHOD_(DWORD, SetPriority)(DWORD) { return 0; }
+    STDMETHOD_(DWORD, GetPriority)(void) { return 0; }
+    STDMETHOD_(void, PreLoad)(void) {}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+class CNullSurface : public CNullResource<IDirect3DSurface9> {
+    IUnknown *m_Container;  // the texture or the device, the surface lives as long as it
+    D3DSURFACE_DESC m_Desc;
+    bool m_Texture;  // the locks are uploads
+    std::vector<BYTE> m_Data;
+
+public:
+    CNullSurface(CNullDevice *dev, IUnknown *container, bool texture, UINT w, UINT h, D3DFORMAT format, DWORD usage,
+                 D3DPOOL pool)
+      : CNullResource<IDirect3DSurface9>(dev), m_Container(container), m_Texture(texture) {
+        m_Desc.Format = format;
+        m_Desc.Type = D3DRTYPE_SURFACE;
+        m_Desc.Usage = usage;
+        m_Desc.Pool = pool;
+        m_Desc.MultiSampleType = D3DMULTISAMPLE_NONE;
+        m_Desc.MultiSampleQuality = 0;
+        m_Desc.Width = w;
+        m_Desc.Height = h;
+    }
+
+    UINT Size(void) const { return FormatPitch(m_Desc.Format, m_Desc.Width) * FormatRows(m_Desc.Format, m_Desc.Height); }
+    // the data is made on the first access only: most of the surfaces are never locked
+    BYTE *Data(void) {
+        if (m_Data.empty())
+            m_Data.resize(Size());
+        return m_Data.data();
+    }
+    void CopyFrom(CNullSurface *src) {
+        if (src->Size() == Size())
+            memcpy(Data(), src->Data(), Size());
+    }
+
+    STDMETHOD_(ULONG, AddRef)(void) {
+        if (m_Container)
+            return m_Container->AddRef();
+        return ++m_Ref;
+    }
+    STDMETHOD_(ULONG, Release)(void) {
+        if (m_Container)
+            return m_Container->Release();
+        ULONG ref = --m_Ref;
+        if (ref == 0)
+            delete this;
+        return ref;
+    }
+
+    STDMETHOD_(D3DRESOURCETYPE, GetType)(void) { return D3DRTYPE_SURFACE; }
+    STDMETHOD(GetContainer)(REFIID riid, void **container) {
+        if (m_Container)
+            return m_Container->QueryInterface(riid, container);
+        return m_Dev->QueryInterface(riid, container);
+    }
+    STDMETHOD(GetDesc)(D3DSURFACE_DESC *desc) {
+        *desc = m_Desc;
+        return D3D_OK;
+    }
+    STDMETHOD(LockRect)(D3DLOCKED_RECT *locked, const RECT *rect, DWORD flags) {
+        UINT pitch = FormatPitch(m_Desc.Format, m_Desc.Width);
+        UINT offset = 0;
+        UINT bytes = Size();
+        if (rect) {
+            UINT bw = FormatIsDXT(m_Desc.Format) ? 4 : 1;
+            offset = (rect->top / bw) * pitch + (rect->left / bw) * FormatBytes(m_Desc.Format);
+            bytes = FormatPitch(m_Desc.Format, rect->right - rect->left) *
+                    FormatRows(m_Desc.Format, rect->bottom - rect->top);
+        }
+        locked->Pitch = pitch;
+        locked->pBits = Data() + offset;
+
+        if (m_Texture && !(flags & D3DLOCK_READONLY))
+            m_Dev->Upload(bytes);
+        return D3D_OK;
+    }
+    STDMETHOD(UnlockRect)(void) { return D3D_OK; }
+    STDMETHOD(GetDC)(HDC *) { return D3DERR_INVALIDCALL; }
+    STDMETHOD(ReleaseDC)(HDC) { return D3DERR_INVALIDCALL; }
+};
+
+class CNullTexture : public CNullResource<IDirect3DTexture9> {
+    std::vector<CNullSurface *> m_Levels;
+
+public:
+    CNullTexture(CNullDevice *dev, UINT w, UINT h, UINT levels, DWORD usage, D3DFORMAT format, D3DPOOL pool)
+      : CNullResource<IDirect3DTexture9>(dev) {
+        levels = LevelCnt(levels, std::max(w, h));
+        for (UINT i = 0; i < levels; ++i) {
+            m_Levels.push_back(new CNullSurface(dev, this, true, std::max(1u, w >> i), std::max(1u, h >> i), format,
+                                                usage, pool));
+        }
+    }
+    ~CNullTexture() {
+        for (CNullSurface *s : m_Levels) {
+            delete s;
+        }
+    }
+
+    UINT Size(void) const {
+        UINT size = 0;
+        for (CNullSurface *s : m_Levels) {
+            size += s->Size();
+        }
+        return size;
+    }
+
+    STDMETHOD_(D3DRESOURCETYPE, GetType)(void) { return D3DRTYPE_TEXTURE; }
+    STDMETHOD_(DWORD, SetLOD)(DWORD) { return 0; }
+    STDMETHOD_(DWORD, GetLOD)(void) { return 0; }
+    STDMETHOD_(DWORD, GetLevelCount)(void) { return DWORD(m_Levels.size()); }
+    STDMETHOD(SetAutoGenFilterType)(D3DTEXTUREFILTERTYPE) { return D3D_OK; }
+    STDMETHOD_(D3DTEXTUREFILTERTYPE, GetAutoGenFilterType)(void) { return D3DTEXF_LINEAR; }
+    STDMETHOD_(void, GenerateMipSubLevels)(void) {}
+
+    STDMETHOD(GetLevelDesc)(UINT level, D3DSURFACE_DESC *desc) {
+        if (level >= m_Levels.size())
+            return D3DERR_INVALIDCALL;
+        return m_Levels[level]->GetDesc(desc);
+    }
+    STDMETHOD(GetSurfaceLevel)(UINT level, IDirect3DSurface9 **surface) {
+        if (level >= m_Levels.size())
+            return D3DERR_INVALIDCALL;
+        *surface = m_Levels[level];
+        AddRef();
+        return D3D_OK;
+    }
+    STDMETHOD(LockRect)(UINT level, D3DLOCKED_RECT *locked, const RECT *rect, DWORD flags) {
+        if (level >= m_Levels.size())
+            return D3DERR_INVALIDCALL;
+        return m_Levels[level]->LockRect(locked, rect, flags);
+    }
+    STDMETHOD(UnlockRect)(UINT) { return D3D_OK; }
+    STDMETHOD(AddDirtyRect)(const RECT *) { return D3D_OK; }
+};
+
+class CNullCubeTexture : public CNullResource<IDirect3DCubeTexture9> {
+    UINT m_LevelCnt;
+    std::vector<CNullSurface *> m_Faces;  // level by level for every face
+
+public:
+    CNullCubeTexture(CNullDevice *dev, UINT size, UINT levels, DWORD usage, D3DFORMAT format, D3DPOOL pool)
+      : CNullResource<IDirect3DCubeTexture9>(dev) {
+        m_LevelCnt = LevelCnt(levels, size);
+        for (UINT f = 0; f < 6; ++f) {
+            for (UINT i = 0; i < m_LevelCnt; ++i) {
+                UINT s = std::max(1u, size >> i);
+                m_Faces.push_back(new CNullSurface(dev, this, true, s, s, format, usage, pool));
+            }
+        }
+    }
+    ~CNullCubeTexture() {
+        for (CNullSurface *s : m_Faces) {
+            delete s;
+        }
+    }
+
+    CNullSurface *Face(D3DCUBEMAP_FACES face, UINT level) const {
+        if (UINT(face) >= 6 || level >= m_LevelCnt)
+            return NULL;
+        return m_Faces[face * m_LevelCnt + level];
+    }
+
+    STDMETHOD_(D3DRESOURCETYPE, GetType)(void) { return D3DRTYPE_CUBETEXTURE; }
+    STDMETHOD_(DWORD, SetLOD)(DWORD) { return 0; }
+    STDMETHOD_(DWORD, GetLOD)(void) { return 0; }
+    STDMETHOD_(DWORD, GetLevelCount)(void) { return m_LevelCnt; }
+    STDMETHOD(SetAutoGenFilterType)(D3DTEXTUREFILTERTYPE) { return D3D_OK; }
+    STDMETHOD_(D3DTEXTUREFILTERTYPE, GetAutoGenFilterType)(void) { return D3DTEXF_LINEAR; }
+    STDMETHOD_(void, GenerateMipSubLevels)(void) {}
+
+    STDMETHOD(GetLevelDesc)(UINT level, D3DSURFACE_DESC *desc) {
+        CNullSurface *s = Face(D3DCUBEMAP_FACE_POSITIVE_X, level);
+        return s ? s->GetDesc(desc) : D3DERR_INVALIDCALL;
+    }
+    STDMETHOD(GetCubeMapSurface)(D3DCUBEMAP_FACES face, UINT level, IDirect3DSurface9 **surface) {
+        CNullSurface *s = Face(face, level);
+        if (s == NULL)
+            return D3DERR_INVALIDCALL;
+        *surface = s;
+        AddRef();
+        return D3D_OK;
+    }
+    STDMETHOD(LockRect)(D3DCUBEMAP_FACES face, UINT level, D3DLOCKED_RECT *locked, const RECT *rect, DWORD flags) {
+        CNullSurface *s = Face(face, level);
+        return s ? s->LockRect(locked, rect, flags) : D3DERR_INVALIDCALL;
+    }
+    STDMETHOD(UnlockRect)(D3DCUBEMAP_FACES, UINT) { return D3D_OK; }
+    STDMETHOD(AddDirtyRect)(D3DCUBEMAP_FACES, const RECT *) { return D3D_OK; }
+};
+
+template <class I>
+class CNullBuffer : public CNullResource<I> {
+protected:
+    DWORD m_Usage;
+    D3DPOOL m_Pool;
+    std::vector<BYTE> m_Data;
+
+public:
+    CNullBuffer(CNullDevice *dev, UINT len, DWORD usage, D3DPOOL pool)
+      : CNullResource<I>(dev), m_Usage(usage), m_Pool(pool), m_Data(len) {}
+
+    STDMETHOD(Lock)(UINT offset, UINT size, void **data, DWORD) {
+        if (offset > m_Data.size())
+            return D3DERR_INVALIDCALL;
+        if (size == 0 || size > m_Data.size() - offset)
+            size = UINT(m_Data.size()) - offset;
+        this->m_Dev->Lock(size);
+        *data = m_Data.data() + offset;
+        return D3D_OK;
+    }
+    STDMETHOD(Unlock)(void) { return D3D_OK; }
+};
+
+class CNullVertexBuffer : public CNullBuffer<IDirect3DVertexBuffer9> {
+    DWORD m_FVF;
+
+public:
+    CNullVertexBuffer(CNullDevice *dev, UINT len, DWORD usage, DWORD fvf, D3DPOOL pool)
+      : CNullBuffer<IDirect3DVertexBuffer9>(dev, len, usage, pool), m_FVF(fvf) {}
+
+    STDMETHOD_(D3DRESOURCETYPE, GetType)(void) { return D3DRTYPE_VERTEXBUFFER; }
+    STDMETHOD(GetDesc)(D3DVERTEXBUFFER_DESC *desc) {
+        desc->Format = D3DFMT_VERTEXDATA;
+        desc->Type = D3DRTYPE_VERTEXBUFFER;
+        desc->Usage = m_Usage;
+        desc->Pool = m_Pool;
+        desc->Size = UINT(m_Data.size());
+        desc->FVF = m_FVF;
+        return D3D_OK;
+    }
+};
+
+class CNullIndexBuffer : public CNullBuffer<IDirect3DIndexBuffer9> {
+    D3DFORMAT m_Format;
+
+public:
+    CNullIndexBuffer(CNullDevice *dev, UINT len, DWORD usage, D3DFORMAT format, D3DPOOL pool)
+      : CNullBuffer<IDirect3DIndexBuffer9>(dev, len, usage, pool), m_Format(format) {}
+
+    STDMETHOD_(D3DRESOURCETYPE, GetType)(void) { return D3DRTYPE_INDEXBUFFER; }
+    STDMETHOD(GetDesc)(D3DINDEXBUFFER_DESC *desc) {
+        desc->Format = m_Format;
+        desc->Type = D3DRTYPE_INDEXBUFFER;
+        desc->Usage = m_Usage;
+        desc->Pool = m_Pool;
+        desc->Size = UINT(m_Data.size());
+        return D3D_OK;
+    }
+};
+
+class CNullVertexDeclaration : public CNullUnknown<IDirect3DVertexDeclaration9> {
+    std::vector<D3DVERTEXELEMENT9> m_Elements;  // with the end one
+
+public:
+    CNullVertexDeclaration(CNullDevice *dev, const D3DVERTEXELEMENT9 *elements)
+      : CNullUnknown<IDirect3DVertexDeclaration9>(dev) {
+        do {
+            m_Elements.push_back(*elements);
+        }
+        while ((elements++)->Stream != 0xFF);
+    }
+
+    STDMETHOD(GetDeclaration)(D3DVERTEXELEMENT9 *elements, UINT *cnt) {
+        *cnt = UINT(m_Elements.size());
+        if (elements)
+            std::copy(m_Elements.begin(), m_Elements.end(), elements);
+        return D3D_OK;
+    }
+};
+
+template <class I>
+class CNullShader : public CNullUnknown<I> {
+public:
+    explicit CNullShader(CNullDevice *dev) : CNullUnknown<I>(dev) {}
+
+    STDMETHOD(GetFunction)(void *, UINT *size) {
+        *size = 0;
+        return D3D_OK;
+    }
+};
+
+class CNullStateBlock : public CNullUnknown<IDirect3DStateBlock9> {
+public:
+    explicit CNullStateBlock(CNullDevice *dev) : CNullUnknown<IDirect3DStateBlock9>(dev) {}
+
+    STDMETHOD(Capture)(void) { return D3D_OK; }
+    STDMETHOD(Apply)(void) { return D3D_OK; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+CNullDevice::CNullDevice(IDirect3D9 *d3d, HWND wnd, DWORD flags, const D3DPRESENT_PARAMETERS &pp) {
+    m_Ref = 1;
+    m_D3D = d3d;
+    m_D3D->AddRef();
+    m_Pp = pp;
+    if (m_Pp.BackBufferWidth == 0)
+        m_Pp.BackBufferWidth = 800;
+    if (m_Pp.BackBufferHeight == 0)
+        m_Pp.BackBufferHeight = 600;
+    if (m_Pp.BackBufferFormat == D3DFMT_UNKNOWN)
+        m_Pp.BackBufferFormat = D3DFMT_X8R8G8B8;
+    m_Cp.AdapterOrdinal = D3DADAPTER_DEFAULT;
+    m_Cp.DeviceType = D3DDEVTYPE_HAL;
+    m_Cp.hFocusWindow = wnd;
+    m_Cp.BehaviorFlags = flags;
+
+    m_BackBuffer = new CNullSurface(this, this, false, m_Pp.BackBufferWidth, m_Pp.BackBufferHeight,
+                                    m_Pp.BackBufferFormat, D3DUSAGE_RENDERTARGET, D3DPOOL_DEFAULT);
+    m_DepthStencil = new CNullSurface(this, this, false, m_Pp.BackBufferWidth, m_Pp.BackBufferHeight,
+                                      D3DFMT_D24S8, D3DUSAGE_DEPTHSTENCIL, D3DPOOL_DEFAULT);
+    m_RenderTarget = m_BackBuffer;
+    m_DepthTarget = m_DepthStencil;
+
+    memset(m_RS, 0, sizeof(m_RS));
+    memset(m_TSS, 0, sizeof(m_TSS));
+    memset(m_SS, 0, sizeof(m_SS));
+    memset(m_Tex, 0, sizeof(m_Tex));
+    memset(m_Transform, 0, sizeof(m_Transform));
+    m_Viewport = D3DVIEWPORT9{0, 0, m_Pp.BackBufferWidth, m_Pp.BackBufferHeight, 0.0f, 1.0f};
+    memset(&m_Material, 0, sizeof(m_Material));
+    m_FVF = 0;
+
+    m_Frame = m_Last = m_Total = SDeviceStats{};
+    m_Frames = 0;
+    m_FrameLimit = 0;
+    m_FrameStart = std::chrono::steady_clock::now();
+    m_FrameTime = m_FrameTimeMax = m_FrameTimeTotal = std::chrono::steady_clock::duration::zero();
+}
+
+CNullDevice::~CNullDevice() {
+    UnbindTextures();
+    if (m_RenderTarget && m_RenderTarget != m_BackBuffer)
+        m_RenderTarget->Release();
+    if (m_DepthTarget && m_DepthTarget != m_DepthStencil)
+        m_DepthTarget->Release();
+    delete m_BackBuffer;
+    delete m_DepthStencil;
+    m_D3D->Release();
+    if (g_NullDevice == this)
+        g_NullDevice = NULL;
+}
+
+void CNullDevice::UnbindTextures(void) {
+    for (IDirect3DBaseTexture9 *&tex : m_Tex) {
+        if (tex) {
+            tex->Release();
+            tex = NULL;
+        }
+    }
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::QueryInterface(REFIID riid, void **object) {
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(IDirect3DDevice9)) {
+        *object = static_cast<IDirect3DDevice9 *>(this);
+        AddRef();
+        return S_OK;
+    }
+    *object = NULL;
+    return E_NOINTERFACE;
+}
+
+ULONG STDMETHODCALLTYPE CNullDevice::AddRef(void) {
+    return ++m_Ref;
+}
+
+ULONG STDMETHODCALLTYPE CNullDevice::Release(void) {
+    ULONG ref = --m_Ref;
+    if (ref == 0)
+        delete this;
+    return ref;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::TestCooperativeLevel(void) {
+    return D3D_OK;
+}
+
+UINT STDMETHODCALLTYPE CNullDevice::GetAvailableTextureMem(void) {
+    return 512 * 1024 * 1024;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::EvictManagedResources(void) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetDirect3D(IDirect3D9 **d3d) {
+    *d3d = m_D3D;
+    m_D3D->AddRef();
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetDeviceCaps(D3DCAPS9 *caps) {
+    return m_D3D->GetDeviceCaps(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, caps);
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetDisplayMode(UINT, D3DDISPLAYMODE *mode) {
+    mode->Width = m_Pp.BackBufferWidth;
+    mode->Height = m_Pp.BackBufferHeight;
+    mode->RefreshRate = 60;
+    mode->Format = D3DFMT_X8R8G8B8;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetCreationParameters(D3DDEVICE_CREATION_PARAMETERS *params) {
+    *params = m_Cp;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetCursorProperties(UINT, UINT, IDirect3DSurface9 *) {
+    return D3D_OK;
+}
+
+void STDMETHODCALLTYPE CNullDevice::SetCursorPosition(int, int, DWORD) {}
+
+BOOL STDMETHODCALLTYPE CNullDevice::ShowCursor(BOOL) {
+    return FALSE;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateAdditionalSwapChain(D3DPRESENT_PARAMETERS *, IDirect3DSwapChain9 **) {
+    return D3DERR_NOTAVAILABLE;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetSwapChain(UINT, IDirect3DSwapChain9 **swapchain) {
+    *swapchain = NULL;
+    return D3DERR_NOTAVAILABLE;
+}
+
+UINT STDMETHODCALLTYPE CNullDevice::GetNumberOfSwapChains(void) {
+    return 1;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::Reset(D3DPRESENT_PARAMETERS *) {
+    UnbindTextures();
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::Present(const RECT *, const RECT *, HWND, const RGNDATA *) {
+    auto now = std::chrono::steady_clock::now();
+    m_FrameTime = now - m_FrameStart;
+    m_FrameStart = now;
+    m_FrameTimeMax = std::max(m_FrameTimeMax, m_FrameTime);
+    m_FrameTimeTotal += m_FrameTime;
+
+    m_Last = m_Frame;
+    m_Total += m_Frame;
+    m_Frame = SDeviceStats{};
+    ++m_Frames;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetBackBuffer(UINT, UINT, D3DBACKBUFFER_TYPE, IDirect3DSurface9 **surface) {
+    *surface = m_BackBuffer;
+    m_BackBuffer->AddRef();
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetRasterStatus(UINT, D3DRASTER_STATUS *status) {
+    status->InVBlank = FALSE;
+    status->ScanLine = 0;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetDialogBoxMode(BOOL) {
+    return D3D_OK;
+}
+
+void STDMETHODCALLTYPE CNullDevice::SetGammaRamp(UINT, DWORD, const D3DGAMMARAMP *) {}
+
+void STDMETHODCALLTYPE CNullDevice::GetGammaRamp(UINT, D3DGAMMARAMP *ramp) {
+    for (int i = 0; i < 256; ++i) {
+        ramp->red[i] = ramp->green[i] = ramp->blue[i] = WORD(i * 257);
+    }
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateTexture(UINT w, UINT h, UINT levels, DWORD usage, D3DFORMAT format,
+                                                     D3DPOOL pool, IDirect3DTexture9 **texture, HANDLE *) {
+    if (w == 0 || h == 0)
+        return D3DERR_INVALIDCALL;
+    *texture = new CNullTexture(this, w, h, levels, usage, format, pool);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateVolumeTexture(UINT, UINT, UINT, UINT, DWORD, D3DFORMAT, D3DPOOL,
+                                                           IDirect3DVolumeTexture9 **texture, HANDLE *) {
+    *texture = NULL;
+    return D3DERR_NOTAVAILABLE;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateCubeTexture(UINT size, UINT levels, DWORD usage, D3DFORMAT format,
+                                                         D3DPOOL pool, IDirect3DCubeTexture9 **texture, HANDLE *) {
+    if (size == 0)
+        return D3DERR_INVALIDCALL;
+    *texture = new CNullCubeTexture(this, size, levels, usage, format, pool);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateVertexBuffer(UINT len, DWORD usage, DWORD fvf, D3DPOOL pool,
+                                                          IDirect3DVertexBuffer9 **vb, HANDLE *) {
+    if (len == 0)
+        return D3DERR_INVALIDCALL;
+    *vb = new CNullVertexBuffer(this, len, usage, fvf, pool);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateIndexBuffer(UINT len, DWORD usage, D3DFORMAT format, D3DPOOL pool,
+                                                         IDirect3DIndexBuffer9 **ib, HANDLE *) {
+    if (len == 0)
+        return D3DERR_INVALIDCALL;
+    *ib = new CNullIndexBuffer(this, len, usage, format, pool);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateRenderTarget(UINT w, UINT h, D3DFORMAT format, D3DMULTISAMPLE_TYPE,
+                                                          DWORD, BOOL, IDirect3DSurface9 **surface, HANDLE *) {
+    *surface = new CNullSurface(this, NULL, false, w, h, format, D3DUSAGE_RENDERTARGET, D3DPOOL_DEFAULT);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateDepthStencilSurface(UINT w, UINT h, D3DFORMAT format,
+                                                                 D3DMULTISAMPLE_TYPE, DWORD, BOOL,
+                                                                 IDirect3DSurface9 **surface, HANDLE *) {
+    *surface = new CNullSurface(this, NULL, false, w, h, format, D3DUSAGE_DEPTHSTENCIL, D3DPOOL_DEFAULT);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::UpdateSurface(IDirect3DSurface9 *src, const RECT *, IDirect3DSurface9 *dst,
+                                                     const POINT *) {
+    CNullSurface *s = static_cast<CNullSurface *>(src);
+    static_cast<CNullSurface *>(dst)->CopyFrom(s);
+    Upload(s->Size());
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::UpdateTexture(IDirect3DBaseTexture9 *src, IDirect3DBaseTexture9 *dst) {
+    if (src->GetType() != D3DRTYPE_TEXTURE || dst->GetType() != D3DRTYPE_TEXTURE)
+        return D3D_OK;
+
+    CNullTexture *s = static_cast<CNullTexture *>(src);
+    CNullTexture *d = static_cast<CNullTexture *>(dst);
+    DWORD cnt = std::min(s->GetLevelCount(), d->GetLevelCount());
+    for (DWORD i = 0; i < cnt; ++i) {
+        IDirect3DSurface9 *ss, *ds;
+        s->GetSurfaceLevel(i, &ss);
+        d->GetSurfaceLevel(i, &ds);
+        static_cast<CNullSurface *>(ds)->CopyFrom(static_cast<CNullSurface *>(ss));
+        ss->Release();
+        ds->Release();
+    }
+    Upload(s->Size());
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetRenderTargetData(IDirect3DSurface9 *rt, IDirect3DSurface9 *dst) {
+    static_cast<CNullSurface *>(dst)->CopyFrom(static_cast<CNullSurface *>(rt));
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetFrontBufferData(UINT, IDirect3DSurface9 *) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::StretchRect(IDirect3DSurface9 *, const RECT *, IDirect3DSurface9 *,
+                                                   const RECT *, D3DTEXTUREFILTERTYPE) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::ColorFill(IDirect3DSurface9 *, const RECT *, D3DCOLOR) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateOffscreenPlainSurface(UINT w, UINT h, D3DFORMAT format, D3DPOOL pool,
+                                                                   IDirect3DSurface9 **surface, HANDLE *) {
+    *surface = new CNullSurface(this, NULL, false, w, h, format, 0, pool);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetRenderTarget(DWORD no, IDirect3DSurface9 *rt) {
+    State(false);
+    if (no != 0)
+        return D3D_OK;
+
+    // the device holds the target while it is set, as the real one does
+    CNullSurface *s = static_cast<CNullSurface *>(rt);
+    if (s && s != m_BackBuffer)
+        s->AddRef();
+    if (m_RenderTarget && m_RenderTarget != m_BackBuffer)
+        m_RenderTarget->Release();
+    m_RenderTarget = s;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetRenderTarget(DWORD no, IDirect3DSurface9 **rt) {
+    if (no != 0 || m_RenderTarget == NULL) {
+        *rt = NULL;
+        return D3DERR_NOTFOUND;
+    }
+    *rt = m_RenderTarget;
+    m_RenderTarget->AddRef();
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetDepthStencilSurface(IDirect3DSurface9 *ds) {
+    State(false);
+    CNullSurface *s = static_cast<CNullSurface *>(ds);
+    if (s && s != m_DepthStencil)
+        s->AddRef();
+    if (m_DepthTarget && m_DepthTarget != m_DepthStencil)
+        m_DepthTarget->Release();
+    m_DepthTarget = s;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetDepthStencilSurface(IDirect3DSurface9 **ds) {
+    if (m_DepthTarget == NULL) {
+        *ds = NULL;
+        return D3DERR_NOTFOUND;
+    }
+    *ds = m_DepthTarget;
+    m_DepthTarget->AddRef();
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::BeginScene(void) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::EndScene(void) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::Clear(DWORD, const D3DRECT *, DWORD, D3DCOLOR, float, DWORD) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetTransform(D3DTRANSFORMSTATETYPE state, const D3DMATRIX *matrix) {
+    if (UINT(state) >= 512)
+        return D3DERR_INVALIDCALL;
+    State(memcmp(&m_Transform[state], matrix, sizeof(D3DMATRIX)) == 0);
+    m_Transform[state] = *matrix;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetTransform(D3DTRANSFORMSTATETYPE state, D3DMATRIX *matrix) {
+    if (UINT(state) >= 512)
+        return D3DERR_INVALIDCALL;
+    *matrix = m_Transform[state];
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::MultiplyTransform(D3DTRANSFORMSTATETYPE state, const D3DMATRIX *matrix) {
+    if (UINT(state) >= 512)
+        return D3DERR_INVALIDCALL;
+    State(false);
+    D3DMATRIX r;
+    for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            r.m[i][j] = 0.0f;
+            for (int k = 0; k < 4; ++k) {
+                r.m[i][j] += matrix->m[i][k] * m_Transform[state].m[k][j];
+            }
+        }
+    }
+    m_Transform[state] = r;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetViewport(const D3DVIEWPORT9 *vp) {
+    State(memcmp(&m_Viewport, vp, sizeof(D3DVIEWPORT9)) == 0);
+    m_Viewport = *vp;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetViewport(D3DVIEWPORT9 *vp) {
+    *vp = m_Viewport;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetMaterial(const D3DMATERIAL9 *material) {
+    State(memcmp(&m_Material, material, sizeof(D3DMATERIAL9)) == 0);
+    m_Material = *material;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetMaterial(D3DMATERIAL9 *material) {
+    *material = m_Material;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetLight(DWORD, const D3DLIGHT9 *) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetLight(DWORD, D3DLIGHT9 *light) {
+    memset(light, 0, sizeof(D3DLIGHT9));
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::LightEnable(DWORD, BOOL) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetLightEnable(DWORD, BOOL *enable) {
+    *enable = FALSE;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetClipPlane(DWORD, const float *) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetClipPlane(DWORD, float *plane) {
+    plane[0] = plane[1] = plane[2] = plane[3] = 0.0f;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetRenderState(D3DRENDERSTATETYPE state, DWORD value) {
+    if (UINT(state) >= NULL_DEVICE_RS_CNT)
+        return D3DERR_INVALIDCALL;
+    State(m_RS[state] == value);
+    m_RS[state] = value;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetRenderState(D3DRENDERSTATETYPE state, DWORD *value) {
+    if (UINT(state) >= NULL_DEVICE_RS_CNT)
+        return D3DERR_INVALIDCALL;
+    *value = m_RS[state];
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateStateBlock(D3DSTATEBLOCKTYPE, IDirect3DStateBlock9 **sb) {
+    *sb = new CNullStateBlock(this);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::BeginStateBlock(void) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::EndStateBlock(IDirect3DStateBlock9 **sb) {
+    *sb = new CNullStateBlock(this);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetClipStatus(const D3DCLIPSTATUS9 *) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetClipStatus(D3DCLIPSTATUS9 *status) {
+    memset(status, 0, sizeof(D3DCLIPSTATUS9));
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetTexture(DWORD stage, IDirect3DBaseTexture9 **texture) {
+    *texture = stage < 16 ? m_Tex[stage] : NULL;
+    if (*texture)
+        (*texture)->AddRef();
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetTexture(DWORD stage, IDirect3DBaseTexture9 *texture) {
+    if (stage >= 16)
+        return D3D_OK;  // the displacement map samplers
+    ++m_Frame.m_Textures;
+    if (texture)
+        texture->AddRef();
+    if (m_Tex[stage])
+        m_Tex[stage]->Release();
+    m_Tex[stage] = texture;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetTextureStageState(DWORD stage, D3DTEXTURESTAGESTATETYPE type,
+                                                            DWORD *value) {
+    if (stage >= 8 || UINT(type) >= NULL_DEVICE_TSS_CNT)
+        return D3DERR_INVALIDCALL;
+    *value = m_TSS[stage][type];
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetTextureStageState(DWORD stage, D3DTEXTURESTAGESTATETYPE type,
+                                                            DWORD value) {
+    if (stage >= 8 || UINT(type) >= NULL_DEVICE_TSS_CNT)
+        return D3DERR_INVALIDCALL;
+    State(m_TSS[stage][type] == value);
+    m_TSS[stage][type] = value;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetSamplerState(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD *value) {
+    if (sampler >= 16 || UINT(type) >= NULL_DEVICE_SS_CNT)
+        return D3DERR_INVALIDCALL;
+    *value = m_SS[sampler][type];
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetSamplerState(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value) {
+    if (sampler >= 16 || UINT(type) >= NULL_DEVICE_SS_CNT)
+        return D3DERR_INVALIDCALL;
+    State(m_SS[sampler][type] == value);
+    m_SS[sampler][type] = value;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::ValidateDevice(DWORD *passes) {
+    *passes = 1;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetPaletteEntries(UINT, const PALETTEENTRY *) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetPaletteEntries(UINT, PALETTEENTRY *) {
+    return D3DERR_INVALIDCALL;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetCurrentTexturePalette(UINT) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetCurrentTexturePalette(UINT *palette) {
+    *palette = 0;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetScissorRect(const RECT *) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetScissorRect(RECT *rect) {
+    *rect = RECT{0, 0, LONG(m_Pp.BackBufferWidth), LONG(m_Pp.BackBufferHeight)};
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetSoftwareVertexProcessing(BOOL) {
+    return D3D_OK;
+}
+
+BOOL STDMETHODCALLTYPE CNullDevice::GetSoftwareVertexProcessing(void) {
+    return FALSE;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetNPatchMode(float) {
+    return D3D_OK;
+}
+
+float STDMETHODCALLTYPE CNullDevice::GetNPatchMode(void) {
+    return 0.0f;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::DrawPrimitive(D3DPRIMITIVETYPE, UINT, UINT prims) {
+    Draw(prims);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::DrawIndexedPrimitive(D3DPRIMITIVETYPE, INT, UINT, UINT, UINT, UINT prims) {
+    Draw(prims);
+    return D3D_OK;
+}
+
+// vertices of the primitives
+static UINT PrimVerts(D3DPRIMITIVETYPE type, UINT prims) {
+    switch (type) {
+        case D3DPT_POINTLIST:
+            return prims;
+        case D3DPT_LINELIST:
+            return prims * 2;
+        case D3DPT_LINESTRIP:
+            return prims + 1;
+        case D3DPT_TRIANGLELIST:
+            return prims * 3;
+        default:
+            return prims + 2;
+    }
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::DrawPrimitiveUP(D3DPRIMITIVETYPE type, UINT prims, const void *, UINT stride) {
+    Draw(prims);
+    m_Frame.m_LockedBytes += PrimVerts(type, prims) * stride;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::DrawIndexedPrimitiveUP(D3DPRIMITIVETYPE type, UINT, UINT verts, UINT prims,
+                                                              const void *, D3DFORMAT format, const void *,
+                                                              UINT stride) {
+    Draw(prims);
+    m_Frame.m_LockedBytes += verts * stride + PrimVerts(type, prims) * (format == D3DFMT_INDEX32 ? 4 : 2);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::ProcessVertices(UINT, UINT, UINT, IDirect3DVertexBuffer9 *,
+                                                       IDirect3DVertexDeclaration9 *, DWORD) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateVertexDeclaration(const D3DVERTEXELEMENT9 *elements,
+                                                               IDirect3DVertexDeclaration9 **decl) {
+    *decl = new CNullVertexDeclaration(this, elements);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetVertexDeclaration(IDirect3DVertexDeclaration9 *) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetVertexDeclaration(IDirect3DVertexDeclaration9 **decl) {
+    *decl = NULL;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetFVF(DWORD fvf) {
+    State(m_FVF == fvf);
+    m_FVF = fvf;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetFVF(DWORD *fvf) {
+    *fvf = m_FVF;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateVertexShader(const DWORD *, IDirect3DVertexShader9 **shader) {
+    *shader = new CNullShader<IDirect3DVertexShader9>(this);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetVertexShader(IDirect3DVertexShader9 *) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetVertexShader(IDirect3DVertexShader9 **shader) {
+    *shader = NULL;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetVertexShaderConstantF(UINT, const float *, UINT) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetVertexShaderConstantF(UINT, float *, UINT) {
+    return D3DERR_INVALIDCALL;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetVertexShaderConstantI(UINT, const int *, UINT) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetVertexShaderConstantI(UINT, int *, UINT) {
+    return D3DERR_INVALIDCALL;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetVertexShaderConstantB(UINT, const BOOL *, UINT) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetVertexShaderConstantB(UINT, BOOL *, UINT) {
+    return D3DERR_INVALIDCALL;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetStreamSource(UINT, IDirect3DVertexBuffer9 *, UINT, UINT) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetStreamSource(UINT, IDirect3DVertexBuffer9 **vb, UINT *offset,
+                                                       UINT *stride) {
+    *vb = NULL;
+    *offset = *stride = 0;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetStreamSourceFreq(UINT, UINT) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetStreamSourceFreq(UINT, UINT *divider) {
+    *divider = 1;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetIndices(IDirect3DIndexBuffer9 *) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetIndices(IDirect3DIndexBuffer9 **ib) {
+    *ib = NULL;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreatePixelShader(const DWORD *, IDirect3DPixelShader9 **shader) {
+    *shader = new CNullShader<IDirect3DPixelShader9>(this);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetPixelShader(IDirect3DPixelShader9 *) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetPixelShader(IDirect3DPixelShader9 **shader) {
+    *shader = NULL;
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetPixelShaderConstantF(UINT, const float *, UINT) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetPixelShaderConstantF(UINT, float *, UINT) {
+    return D3DERR_INVALIDCALL;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetPixelShaderConstantI(UINT, const int *, UINT) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetPixelShaderConstantI(UINT, int *, UINT) {
+    return D3DERR_INVALIDCALL;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::SetPixelShaderConstantB(UINT, const BOOL *, UINT) {
+    State(false);
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::GetPixelShaderConstantB(UINT, BOOL *, UINT) {
+    return D3DERR_INVALIDCALL;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::DrawRectPatch(UINT, const float *, const D3DRECTPATCH_INFO *) {
+    return D3DERR_NOTAVAILABLE;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::DrawTriPatch(UINT, const float *, const D3DTRIPATCH_INFO *) {
+    return D3DERR_NOTAVAILABLE;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::DeletePatch(UINT) {
+    return D3D_OK;
+}
+
+HRESULT STDMETHODCALLTYPE CNullDevice::CreateQuery(D3DQUERYTYPE, IDirect3DQuery9 **query) {
+    if (query)
+        *query = NULL;
+    return D3DERR_NOTAVAILABLE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class CNullDirect3D : public IDirect3D9 {
+    ULONG m_Ref;
+
+public:
+    CNullDirect3D(void) : m_Ref(1) {}
+    virtual ~CNullDirect3D() {}
+
+    STDMETHOD(QueryInterface)(REFIID riid, void **object) {
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(IDirect3D9)) {
+            *object = static_cast<IDirect3D9 *>(this);
+            AddRef();
+            return S_OK;
+        }
+        *object = NULL;
+        return E_NOINTERFACE;
+    }
+    STDMETHOD_(ULONG, AddRef)(void) { return ++m_Ref; }
+    STDMETHOD_(ULONG, Release)(void) {
+        ULONG ref = --m_Ref;
+        if (ref == 0)
+            delete this;
+        return ref;
+    }
+
+    STDMETHOD(RegisterSoftwareDevice)(void *) { return D3DERR_NOTAVAILABLE; }
+    STDMETHOD_(UINT, GetAdapterCount)(void) { return 1; }
+    STDMETHOD(GetAdapterIdentifier)(UINT, DWORD, D3DADAPTER_IDENTIFIER9 *id) {
+        memset(id, 0, sizeof(D3DADAPTER_IDENTIFIER9));
+        strcpy(id->Driver, "null");
+        strcpy(id->Description, "Null device");
+        strcpy(id->DeviceName, "\\\\.\\NULL");
+        return D3D_OK;
+    }
+    STDMETHOD_(UINT, GetAdapterModeCount)(UINT, D3DFORMAT) { return 1; }
+    STDMETHOD(EnumAdapterModes)(UINT, D3DFORMAT format, UINT, D3DDISPLAYMODE *mode) {
+        mode->Width = 1920;
+        mode->Height = 1080;
+        mode->RefreshRate = 60;
+        mode->Format = format;
+        return D3D_OK;
+    }
+    STDMETHOD(GetAdapterDisplayMode)(UINT, D3DDISPLAYMODE *mode) {
+        mode->Width = 1920;
+        mode->Height = 1080;
+        mode->RefreshRate = 60;
+        mode->Format = D3DFMT_X8R8G8B8;
+        return D3D_OK;
+    }
+    STDMETHOD(CheckDeviceType)(UINT, D3DDEVTYPE, D3DFORMAT, D3DFORMAT, BOOL) { return D3D_OK; }
+    STDMETHOD(CheckDeviceFormat)(UINT, D3DDEVTYPE, D3DFORMAT, DWORD, D3DRESOURCETYPE, D3DFORMAT) { return D3D_OK; }
+    STDMETHOD(CheckDeviceMultiSampleType)(UINT, D3DDEVTYPE, D3DFORMAT, BOOL, D3DMULTISAMPLE_TYPE type,
+                                          DWORD *quality) {
+        if (quality)
+            *quality = 1;
+        return type == D3DMULTISAMPLE_NONE ? D3D_OK : D3DERR_NOTAVAILABLE;
+    }
+    STDMETHOD(CheckDepthStencilMatch)(UINT, D3DDEVTYPE, D3DFORMAT, D3DFORMAT, D3DFORMAT) { return D3D_OK; }
+    STDMETHOD(CheckDeviceFormatConversion)(UINT, D3DDEVTYPE, D3DFORMAT, D3DFORMAT) { return D3D_OK; }
+    STDMETHOD(GetDeviceCaps)(UINT, D3DDEVTYPE, D3DCAPS9 *caps);
+    STDMETHOD_(HMONITOR, GetAdapterMonitor)(UINT) { return NULL; }
+    STDMETHOD(CreateDevice)(UINT, D3DDEVTYPE, HWND wnd, DWORD flags, D3DPRESENT_PARAMETERS *pp,
+                            IDirect3DDevice9 **device) {
+        *device = new CNullDevice(this, wnd, flags, *pp);
+        return D3D_OK;
+    }
+};
+
+// a plain fixed function card with a stencil: every path of the render is taken
+HRESULT STDMETHODCALLTYPE CNullDirect3D::GetDeviceCaps(UINT, D3DDEVTYPE, D3DCAPS9 *caps) {
+    memset(caps, 0, sizeof(D3DCAPS9));
+    caps->DeviceType = D3DDEVTYPE_HAL;
+    caps->PresentationIntervals = D3DPRESENT_INTERVAL_IMMEDIATE | D3DPRESENT_INTERVAL_ONE;
+    caps->DevCaps = D3DDEVCAPS_HWTRANSFORMANDLIGHT | D3DDEVCAPS_HWRASTERIZATION | D3DDEVCAPS_DRAWPRIMTLVERTEX |
+                    D3DDEVCAPS_TEXTUREVIDEOMEMORY;
+    caps->PrimitiveMiscCaps = D3DPMISCCAPS_CULLNONE | D3DPMISCCAPS_CULLCW | D3DPMISCCAPS_CULLCCW |
+                              D3DPMISCCAPS_COLORWRITEENABLE | D3DPMISCCAPS_BLENDOP;
+    caps->RasterCaps = D3DPRASTERCAPS_ZTEST | D3DPRASTERCAPS_FOGVERTEX | D3DPRASTERCAPS_FOGTABLE |
+                       D3DPRASTERCAPS_FOGRANGE | D3DPRASTERCAPS_MIPMAPLODBIAS | D3DPRASTERCAPS_ANISOTROPY |
+                       D3DPRASTERCAPS_SCISSORTEST | D3DPRASTERCAPS_DEPTHBIAS | D3DPRASTERCAPS_SLOPESCALEDEPTHBIAS;
+    caps->ZCmpCaps = caps->AlphaCmpCaps = 0xFF;
+    caps->SrcBlendCaps = caps->DestBlendCaps = 0x1FFF;
+    caps->ShadeCaps = D3DPSHADECAPS_COLORGOURAUDRGB | D3DPSHADECAPS_SPECULARGOURAUDRGB |
+                      D3DPSHADECAPS_ALPHAGOURAUDBLEND | D3DPSHADECAPS_FOGGOURAUD;
+    caps->TextureCaps = D3DPTEXTURECAPS_PERSPECTIVE | D3DPTEXTURECAPS_ALPHA | D3DPTEXTURECAPS_MIPMAP |
+                        D3DPTEXTURECAPS_CUBEMAP | D3DPTEXTURECAPS_PROJECTED;
+    caps->TextureFilterCaps = caps->CubeTextureFilterCaps =
+            D3DPTFILTERCAPS_MINFPOINT | D3DPTFILTERCAPS_MINFLINEAR | D3DPTFILTERCAPS_MINFANISOTROPIC |
+            D3DPTFILTERCAPS_MIPFPOINT | D3DPTFILTERCAPS_MIPFLINEAR | D3DPTFILTERCAPS_MAGFPOINT |
+            D3DPTFILTERCAPS_MAGFLINEAR | D3DPTFILTERCAPS_MAGFANISOTROPIC;
+    caps->StretchRectFilterCaps = D3DPTFILTERCAPS_MINFPOINT | D3DPTFILTERCAPS_MINFLINEAR |
+                                  D3DPTFILTERCAPS_MAGFPOINT | D3DPTFILTERCAPS_MAGFLINEAR;
+    caps->TextureAddressCaps = D3DPTADDRESSCAPS_WRAP | D3DPTADDRESSCAPS_MIRROR | D3DPTADDRESSCAPS_CLAMP |
+                               D3DPTADDRESSCAPS_BORDER;
+    caps->MaxTextureWidth = caps->MaxTextureHeight = 4096;
+    caps->MaxTextureRepeat = 8192;
+    caps->MaxTextureAspectRatio = 4096;
+    caps->MaxAnisotropy = 16;
+    caps->MaxVertexW = 1e10f;
+    caps->StencilCaps = 0x1FF;  // all the ops and two sided
+    caps->FVFCaps = 8;
+    caps->TextureOpCaps = 0x03FFFFFF;  // all the ops
+    caps->MaxTextureBlendStages = 8;
+    caps->MaxSimultaneousTextures = 8;
+    caps->VertexProcessingCaps = D3DVTXPCAPS_TEXGEN | D3DVTXPCAPS_MATERIALSOURCE7 | D3DVTXPCAPS_DIRECTIONALLIGHTS |
+                                 D3DVTXPCAPS_POSITIONALLIGHTS | D3DVTXPCAPS_LOCALVIEWER;
+    caps->MaxActiveLights = 8;
+    caps->MaxUserClipPlanes = 6;
+    caps->MaxVertexBlendMatrices = 4;
+    caps->MaxPointSize = 64.0f;
+    caps->MaxPrimitiveCount = 0xFFFFF;
+    caps->MaxVertexIndex = 0xFFFFFF;
+    caps->MaxStreams = 16;
+    caps->MaxStreamStride = 255;
+    caps->VertexShaderVersion = D3DVS_VERSION(2, 0);
+    caps->MaxVertexShaderConst = 256;
+    caps->PixelShaderVersion = D3DPS_VERSION(2, 0);
+    caps->PixelShader1xMaxValue = 8.0f;
+    caps->NumberOfAdaptersInGroup = 1;
+    caps->NumSimultaneousRTs = 1;
+    caps->MaxVShaderInstructionsExecuted = 65535;
+    caps->MaxPShaderInstructionsExecuted = 512;
+    return D3D_OK;
+}
+
+IDirect3D9 *NullDirect3DCreate(void) {
+    return new CNullDirect3D;
+}
@@ -0,0 +1,259 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "d3d9.h"
+
+#include <chrono>
+
+// what a frame has asked the device for
+struct SDeviceStats {
+    DWORD m_Draws;        // DrawPrimitive*, the UP ones included
+    DWORD m_Prims;
+    DWORD m_States;       // render, stage, sampler states, transforms, streams, shaders...
+    DWORD m_StatesSame;   // of them: the value was set already
+    DWORD m_Textures;     // SetTexture
+    DWORD m_Locks;        // of the vertex and index buffers
+    DWORD m_LockedBytes;  // the locks and the data of the UP draws
+    DWORD m_Uploads;      // texture locks for writing, UpdateTexture, UpdateSurface
+    DWORD m_UploadBytes;
+
+    SDeviceStats &operator+=(const SDeviceStats &s) {
+        m_Draws += s.m_Draws;
+        m_Prims += s.m_Prims;
+        m_States += s.m_States;
+        m_StatesSame += s.m_StatesSame;
+        m_Textures += s.m_Textures;
+        m_Locks += s.m_Locks;
+        m_LockedBytes += s.m_LockedBytes;
+        m_Uploads += s.m_Uploads;
+        m_UploadBytes += s.m_UploadBytes;
+        return *this;
+    }
+};
+
+class CNullSurface;
+
+#define NULL_DEVICE_RS_CNT  256
+#define NULL_DEVICE_TSS_CNT 33
+#define NULL_DEVICE_SS_CNT  14
+
+/**
+ * @brief Device which draws nothing and counts what it is asked for.
+ *
+ * It stands for the real one behind g_D3DD (and its IDirect3D9 behind g_D3D), so the whole CPU side of a frame runs
+ * as it is: culling, sorting, filling the buffers, building the shadows. The resources keep their data in memory,
+ * so whatever is locked can be written and read back. Present closes the frame: the counters of it and the time
+ * since the previous Present are added to the totals.
+ *
+ * Enabled by NullDevice=<frames> in the Config block, the game exits after that many frames.
+ */
+class CNullDevice : public IDirect3DDevice9 {
+    ULONG m_Ref;
+    IDirect3D9 *m_D3D;
+    D3DPRESENT_PARAMETERS m_Pp;
+    D3DDEVICE_CREATION_PARAMETERS m_Cp;
+
+    CNullSurface *m_BackBuffer;
+    CNullSurface *m_DepthStencil;
+    CNullSurface *m_RenderTarget;  // held by the device while set
+    CNullSurface *m_DepthTarget;
+
+    // to tell the same value from a change, as the drivers do
+    DWORD m_RS[NULL_DEVICE_RS_CNT];
+    DWORD m_TSS[8][NULL_DEVICE_TSS_CNT];
+    DWORD m_SS[16][NULL_DEVICE_SS_CNT];
+    IDirect3DBaseTexture9 *m_Tex[16];  // held by the device while set
+    D3DMATRIX m_Transform[512];
+    D3DVIEWPORT9 m_Viewport;
+    D3DMATERIAL9 m_Material;
+    DWORD m_FVF;
+
+    SDeviceStats m_Frame;  // the one being drawn
+    SDeviceStats m_Last;   // the last presented
+    SDeviceStats m_Total;
+    int m_Frames;
+    int m_FrameLimit;
+    std::chrono::steady_clock::time_point m_FrameStart;
+    std::chrono::steady_clock::duration m_FrameTime, m_FrameTimeMax, m_FrameTimeTotal;
+
+    void State(bool same) {
+        ++m_Frame.m_States;
+        if (same)
+            ++m_Frame.m_StatesSame;
+    }
+    void Draw(UINT prims) {
+        ++m_Frame.m_Draws;
+        m_Frame.m_Prims += prims;
+    }
+    void UnbindTextures(void);
+
+public:
+    CNullDevice(IDirect3D9 *d3d, HWND wnd, DWORD flags, const D3DPRESENT_PARAMETERS &pp);
+    virtual ~CNullDevice();
+
+    void SetFrameLimit(int frames) { m_FrameLimit = frames; }
+    bool IsFrameLimit(void) const { return m_FrameLimit > 0 && m_Frames >= m_FrameLimit; }
+
+    int GetFrames(void) const { return m_Frames; }
+    const SDeviceStats &GetLast(void) const { return m_Last; }
+    const SDeviceStats &GetTotal(void) const { return m_Total; }
+    std::chrono::steady_clock::duration GetFrameTime(void) const { return m_FrameTime; }
+    std::chrono::steady_clock::duration GetFrameTimeMax(void) const { return m_FrameTimeMax; }
+    std::chrono::steady_clock::duration GetFrameTimeTotal(void) const { return m_FrameTimeTotal; }
+
+    // the counters for the resources
+    void Lock(DWORD bytes) {
+        ++m_Frame.m_Locks;
+        m_Frame.m_LockedBytes += bytes;
+    }
+    void Upload(DWORD bytes) {
+        ++m_Frame.m_Uploads;
+        m_Frame.m_UploadBytes += bytes;
+    }
+
+    // IUnknown
+    STDMETHOD(QueryInterface)(REFIID riid, void **object);
+    STDMETHOD_(ULONG, AddRef)(void);
+    STDMETHOD_(ULONG, Release)(void);
+
+    // IDirect3DDevice9
+    STDMETHOD(TestCooperativeLevel)(void);
+    STDMETHOD_(UINT, GetAvailableTextureMem)(void);
+    STDMETHOD(EvictManagedResources)(void);
+    STDMETHOD(GetDirect3D)(IDirect3D9 **d3d);
+    STDMETHOD(GetDeviceCaps)(D3DCAPS9 *caps);
+    STDMETHOD(GetDisplayMode)(UINT swapchain, D3DDISPLAYMODE *mode);
+    STDMETHOD(GetCreationParameters)(D3DDEVICE_CREATION_PARAMETERS *params);
+    STDMETHOD(SetCursorProperties)(UINT x, UINT y, IDirect3DSurface9 *bitmap);
+    STDMETHOD_(void, SetCursorPosition)(int x, int y, DWORD flags);
+    STDMETHOD_(BOOL, ShowCursor)(BOOL show);
+    STDMETHOD(CreateAdditionalSwapChain)(D3DPRESENT_PARAMETERS *pp, IDirect3DSwapChain9 **swapchain);
+    STDMETHOD(GetSwapChain)(UINT no, IDirect3DSwapChain9 **swapchain);
+    STDMETHOD_(UINT, GetNumberOfSwapChains)(void);
+    STDMETHOD(Reset)(D3DPRESENT_PARAMETERS *pp);
+    STDMETHOD(Present)(const RECT *src, const RECT *dst, HWND wnd, const RGNDATA *dirty);
+    STDMETHOD(GetBackBuffer)(UINT swapchain, UINT no, D3DBACKBUFFER_TYPE type, IDirect3DSurface9 **surface);
+    STDMETHOD(GetRasterStatus)(UINT swapchain, D3DRASTER_STATUS *status);
+    STDMETHOD(SetDialogBoxMode)(BOOL enable);
+    STDMETHOD_(void, SetGammaRamp)(UINT swapchain, DWORD flags, const D3DGAMMARAMP *ramp);
+    STDMETHOD_(void, GetGammaRamp)(UINT swapchain, D3DGAMMARAMP *ramp);
+    STDMETHOD(CreateTexture)(UINT w, UINT h, UINT levels, DWORD usage, D3DFORMAT format, D3DPOOL pool,
+                             IDirect3DTexture9 **texture, HANDLE *shared);
+    STDMETHOD(CreateVolumeTexture)(UINT w, UINT h, UINT d, UINT levels, DWORD usage, D3DFORMAT format, D3DPOOL pool,
+                                   IDirect3DVolumeTexture9 **texture, HANDLE *shared);
+    STDMETHOD(CreateCubeTexture)(UINT size, UINT levels, DWORD usage, D3DFORMAT format, D3DPOOL pool,
+                                 IDirect3DCubeTexture9 **texture, HANDLE *shared);
+    STDMETHOD(CreateVertexBuffer)(UINT len, DWORD usage, DWORD fvf, D3DPOOL pool, IDirect3DVertexBuffer9 **vb,
+                                  HANDLE *shared);
+    STDMETHOD(CreateIndexBuffer)(UINT len, DWORD usage, D3DFORMAT format, D3DPOOL pool, IDirect3DIndexBuffer9 **ib,
+                                 HANDLE *shared);
+    STDMETHOD(CreateRenderTarget)(UINT w, UINT h, D3DFORMAT format, D3DMULTISAMPLE_TYPE ms, DWORD quality,
+                                  BOOL lockable, IDirect3DSurface9 **surface, HANDLE *shared);
+    STDMETHOD(CreateDepthStencilSurface)(UINT w, UINT h, D3DFORMAT format, D3DMULTISAMPLE_TYPE ms, DWORD quality,
+                                         BOOL discard, IDirect3DSurface9 **surface, HANDLE *shared);
+    STDMETHOD(UpdateSurface)(IDirect3DSurface9 *src, const RECT *srcrect, IDirect3DSurface9 *dst,
+                             const POINT *dstpoint);
+    STDMETHOD(UpdateTexture)(IDirect3DBaseTexture9 *src, IDirect3DBaseTexture9 *dst);
+    STDMETHOD(GetRenderTargetData)(IDirect3DSurface9 *rt, IDirect3DSurface9 *dst);
+    STDMETHOD(GetFrontBufferData)(UINT swapchain, IDirect3DSurface9 *dst);
+    STDMETHOD(StretchRect)(IDirect3DSurface9 *src, const RECT *srcrect, IDirect3DSurface9 *dst, const RECT *dstrect,
+                           D3DTEXTUREFILTERTYPE filter);
+    STDMETHOD(ColorFill)(IDirect3DSurface9 *surface, const RECT *rect, D3DCOLOR color);
+    STDMETHOD(CreateOffscreenPlainSurface)(UINT w, UINT h, D3DFORMAT format, D3DPOOL pool,
+                                           IDirect3DSurface9 **surface, HANDLE *shared);
+    STDMETHOD(SetRenderTarget)(DWORD no, IDirect3DSurface9 *rt);
+    STDMETHOD(GetRenderTarget)(DWORD no, IDirect3DSurface9 **rt);
+    STDMETHOD(SetDepthStencilSurface)(IDirect3DSurface9 *ds);
+    STDMETHOD(GetDepthStencilSurface)(IDirect3DSurface9 **ds);
+    STDMETHOD(BeginScene)(void);
+    STDMETHOD(EndScene)(void);
+    STDMETHOD(Clear)(DWORD cnt, const D3DRECT *rects, DWORD flags, D3DCOLOR color, float z, DWORD stencil);
+    STDMETHOD(SetTransform)(D3DTRANSFORMSTATETYPE state, const D3DMATRIX *matrix);
+    STDMETHOD(GetTransform)(D3DTRANSFORMSTATETYPE state, D3DMATRIX *matrix);
+    STDMETHOD(MultiplyTransform)(D3DTRANSFORMSTATETYPE state, const D3DMATRIX *matrix);
+    STDMETHOD(SetViewport)(const D3DVIEWPORT9 *vp);
+    STDMETHOD(GetViewport)(D3DVIEWPORT9 *vp);
+    STDMETHOD(SetMaterial)(const D3DMATERIAL9 *material);
+    STDMETHOD(GetMaterial)(D3DMATERIAL9 *material);
+    STDMETHOD(SetLight)(DWORD no, const D3DLIGHT9 *light);
+    STDMETHOD(GetLight)(DWORD no, D3DLIGHT9 *light);
+    STDMETHOD(LightEnable)(DWORD no, BOOL enable);
+    STDMETHOD(GetLightEnable)(DWORD no, BOOL *enable);
+    STDMETHOD(SetClipPlane)(DWORD no, const float *plane);
+    STDMETHOD(GetClipPlane)(DWORD no, float *plane);
+    STDMETHOD(SetRenderState)(D3DRENDERSTATETYPE state, DWORD value);
+    STDMETHOD(GetRenderState)(D3DRENDERSTATETYPE state, DWORD *value);
+    STDMETHOD(CreateStateBlock)(D3DSTATEBLOCKTYPE type, IDirect3DStateBlock9 **sb);
+    STDMETHOD(BeginStateBlock)(void);
+    STDMETHOD(EndStateBlock)(IDirect3DStateBlock9 **sb);
+    STDMETHOD(SetClipStatus)(const D3DCLIPSTATUS9 *status);
+    STDMETHOD(GetClipStatus)(D3DCLIPSTATUS9 *status);
+    STDMETHOD(GetTexture)(DWORD stage, IDirect3DBaseTexture9 **texture);
+    STDMETHOD(SetTexture)(DWORD stage, IDirect3DBaseTexture9 *texture);
+    STDMETHOD(GetTextureStageState)(DWORD stage, D3DTEXTURESTAGESTATETYPE type, DWORD *value);
+    STDMETHOD(SetTextureStageState)(DWORD stage, D3DTEXTURESTAGESTATETYPE type, DWORD value);
+    STDMETHOD(GetSamplerState)(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD *value);
+    STDMETHOD(SetSamplerState)(DWORD sampler, D3DSAMPLERSTATETYPE type, DWORD value);
+    STDMETHOD(ValidateDevice)(DWORD *passes);
+    STDMETHOD(SetPaletteEntries)(UINT palette, const PALETTEENTRY *entries);
+    STDMETHOD(GetPaletteEntries)(UINT palette, PALETTEENTRY *entries);
+    STDMETHOD(SetCurrentTexturePalette)(UINT palette);
+    STDMETHOD(GetCurrentTexturePalette)(UINT *palette);
+    STDMETHOD(SetScissorRect)(const RECT *rect);
+    STDMETHOD(GetScissorRect)(RECT *rect);
+    STDMETHOD(SetSoftwareVertexProcessing)(BOOL software);
+    STDMETHOD_(BOOL, GetSoftwareVertexProcessing)(void);
+    STDMETHOD(SetNPatchMode)(float segments);
+    STDMETHOD_(float, GetNPatchMode)(void);
+    STDMETHOD(DrawPrimitive)(D3DPRIMITIVETYPE type, UINT start, UINT prims);
+    STDMETHOD(DrawIndexedPrimitive)(D3DPRIMITIVETYPE type, INT base, UINT minvert, UINT verts, UINT start,
+                                    UINT prims);
+    STDMETHOD(DrawPrimitiveUP)(D3DPRIMITIVETYPE type, UINT prims, const void *data, UINT stride);
+    STDMETHOD(DrawIndexedPrimitiveUP)(D3DPRIMITIVETYPE type, UINT minvert, UINT verts, UINT prims,
+                                      const void *indices, D3DFORMAT format, const void *data, UINT stride);
+    STDMETHOD(ProcessVertices)(UINT src, UINT dst, UINT cnt, IDirect3DVertexBuffer9 *vb,
+                               IDirect3DVertexDeclaration9 *decl, DWORD flags);
+    STDMETHOD(CreateVertexDeclaration)(const D3DVERTEXELEMENT9 *elements, IDirect3DVertexDeclaration9 **decl);
+    STDMETHOD(SetVertexDeclaration)(IDirect3DVertexDeclaration9 *decl);
+    STDMETHOD(GetVertexDeclaration)(IDirect3DVertexDeclaration9 **decl);
+    STDMETHOD(SetFVF)(DWORD fvf);
+    STDMETHOD(GetFVF)(DWORD *fvf);
+    STDMETHOD(CreateVertexShader)(const DWORD *code, IDirect3DVertexShader9 **shader);
+    STDMETHOD(SetVertexShader)(IDirect3DVertexShader9 *shader);
+    STDMETHOD(GetVertexShader)(IDirect3DVertexShader9 **shader);
+    STDMETHOD(SetVertexShaderConstantF)(UINT reg, const float *data, UINT cnt);
+    STDMETHOD(GetVertexShaderConstantF)(UINT reg, float *data, UINT cnt);
+    STDMETHOD(SetVertexShaderConstantI)(UINT reg, const int *data, UINT cnt);
+    STDMETHOD(GetVertexShaderConstantI)(UINT reg, int *data, UINT cnt);
+    STDMETHOD(SetVertexShaderConstantB)(UINT reg, const BOOL *data, UINT cnt);
+    STDMETHOD(GetVertexShaderConstantB)(UINT reg, BOOL *data, UINT cnt);
+    STDMETHOD(SetStreamSource)(UINT stream, IDirect3DVertexBuffer9 *vb, UINT offset, UINT stride);
+    STDMETHOD(GetStreamSource)(UINT stream, IDirect3DVertexBuffer9 **vb, UINT *offset, UINT *stride);
+    STDMETHOD(SetStreamSourceFreq)(UINT stream, UINT divider);
+    STDMETHOD(GetStreamSourceFreq)(UINT stream, UINT *divider);
+    STDMETHOD(SetIndices)(IDirect3DIndexBuffer9 *ib);
+    STDMETHOD(GetIndices)(IDirect3DIndexBuffer9 **ib);
+    STDMETHOD(CreatePixelShader)(const DWORD *code, IDirect3DPixelShader9 **shader);
+    STDMETHOD(SetPixelShader)(IDirect3DPixelShader9 *shader);
+    STDMETHOD(GetPixelShader)(IDirect3DPixelShader9 **shader);
+    STDMETHOD(SetPixelShaderConstantF)(UINT reg, const float *data, UINT cnt);
+    STDMETHOD(GetPixelShaderConstantF)(UINT reg, float *data, UINT cnt);
+    STDMETHOD(SetPixelShaderConstantI)(UINT reg, const int *data, UINT cnt);
+    STDMETHOD(GetPixelShaderConstantI)(UINT reg, int *data, UINT cnt);
+    STDMETHOD(SetPixelShaderConstantB)(UINT reg, const BOOL *data, UINT cnt);
+    STDMETHOD(GetPixelShaderConstantB)(UINT reg, BOOL *data, UINT cnt);
+    STDMETHOD(DrawRectPatch)(UINT handle, const float *segments, const D3DRECTPATCH_INFO *info);
+    STDMETHOD(DrawTriPatch)(UINT handle, const float *segments, const D3DTRIPATCH_INFO *info);
+    STDMETHOD(DeletePatch)(UINT handle);
+    STDMETHOD(CreateQuery)(D3DQUERYTYPE type, IDirect3DQuery9 **query);
+};
+
+// set by L3GInitAsEXE when the frames are not drawn
+extern CNullDevice *g_NullDevice;
+
+// IDirect3D9 which creates CNullDevice
+IDirect3D9 *NullDirect3DCreate(void);
@@ -0,0 +1,49 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "RenderQueue.hpp"
+
+#include <cstring>
+#include <utility>
+
+void CRenderQueue::Sort(void) {
+    int cnt = int(m_Items.size());
+    if (cnt < 2)
+        return;
+
+    // all the histograms in one pass over the keys
+    uint32_t counts[8][256];
+    memset(counts, 0, sizeof(counts));
+    for (const SRenderItem &it : m_Items) {
+        uint64_t key = it.m_Key;
+        for (int b = 0; b < 8; ++b) {
+            ++counts[b][(key >> (b * 8)) & 0xFF];
+        }
+    }
+
+    m_Temp.resize(cnt);
+    SRenderItem *src = m_Items.data();
+    SRenderItem *dst = m_Temp.data();
+    for (int b = 0; b < 8; ++b) {
+        uint32_t *c = counts[b];
+        int shift = b * 8;
+        if (c[(src[0].m_Key >> shift) & 0xFF] == uint32_t(cnt))
+            continue;
+
+        uint32_t offs[256];
+        uint32_t sum = 0;
+        for (int i = 0; i < 256; ++i) {
+            offs[i] = sum;
+            sum += c[i];
+        }
+        for (int i = 0; i < cnt; ++i) {
+            dst[offs[(src[i].m_Key >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != m_Items.data())
+        m_Items.swap(m_Temp);
+}
@@ -0,0 +1,59 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "CMain.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// key: pass in the top byte, then the material (what the draw sets on the device), then the depth
+#define RENDER_KEY_PASS_SHIFT     56
+#define RENDER_KEY_MATERIAL_SHIFT 24
+#define RENDER_KEY_MATERIAL_MASK  0xFFFFFFFFULL
+#define RENDER_KEY_DEPTH_MASK     0xFFFFFFULL
+
+struct SRenderItem {
+    uint64_t m_Key;
+    void *m_Data;
+};
+
+/**
+ * @brief Draws of a frame, sorted by a 64-bit key.
+ *
+ * Whatever is drawn is added with a key and a pointer, after Sort the draws go in the order of the keys. The sort
+ * is a radix one, a byte per pass; a pass is skipped when all the keys have the same byte there. The sort is
+ * stable, the draws of the same key keep the order they were added in.
+ */
+class CRenderQueue : public Base::CMain {
+    std::vector<SRenderItem> m_Items;
+    std::vector<SRenderItem> m_Temp;
+
+public:
+    void Clear(void) { m_Items.clear(); }
+    void Add(uint64_t key, void *data) { m_Items.push_back(SRenderItem{key, data}); }
+    void Sort(void);
+
+    int GetCount(void) const { return int(m_Items.size()); }
+    const SRenderItem &Get(int i) const { return m_Items[i]; }
+
+    static uint64_t Key(uint32_t pass, uint32_t material, uint32_t depth) {
+        return (uint64_t(pass) << RENDER_KEY_PASS_SHIFT) |
+               ((uint64_t(material) & RENDER_KEY_MATERIAL_MASK) << RENDER_KEY_MATERIAL_SHIFT) |
+               (uint64_t(depth) & RENDER_KEY_DEPTH_MASK);
+    }
+    // 32 bits of a pointer to what the draw sets
+    static uint32_t Material(const void *p) {
+        uint64_t v = uint64_t(uintptr_t(p));
+        return uint32_t(v ^ (v >> 32));
+    }
+    // bits of a float, ordered as the floats are (negative ones below the positive ones)
+    static uint32_t FloatKey(float f) {
+        uint32_t u = std::bit_cast<uint32_t>(f);
+        return (u & 0x80000000) ? ~u : (u | 0x80000000);
+    }
+};
@@ -5,6 +5,9 @@
 
 #include "ShadowStencil.hpp"
 #include "VectorObject.hpp"
+#include "TaskGraph.hpp"
+
+#include <algorithm>
 
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -14,6 +17,9 @@ static const DWORD SVOShadowStencilVertex_FVF = D3DFVF_XYZ;
 
 CVOShadowStencil *CVOShadowStencil::m_First;
 CVOShadowStencil *CVOShadowStencil::m_Last;
+std::vector<CVOShadowStencil *> CVOShadowStencil::m_Queue;
+std::unordered_map<SVOShadowStencilKey, std::weak_ptr<const SVOShadowStencilData>, SVOShadowStencilKeyHash>
+        CVOShadowStencil::m_Cache;
 
 void CVOShadowStencil::BeforeRenderAll()
 {
@@ -49,12 +55,17 @@ CVOShadowStencil::CVOShadowStencil()
     m_FrameFor = -1;
     m_FramesCnt = 0;
 
+    m_Queued = false;
+
     LIST_ADD(this, m_First, m_Last, m_Prev, m_Next);
 }
 
 CVOShadowStencil::~CVOShadowStencil() {
     DTRACE();
 
+    if (m_Queued)
+        m_Queue.erase(std::find(m_Queue.begin(), m_Queue.end(), this));
+
     DX_Free();
 
     LIST_DEL(this, m_First, m_Last, m_Prev, m_Next);
@@ -76,12 +87,7 @@ void CVOShadowStencil::Build(CVectorObject &obj, int frame, const D3DXVECTOR3 &v
         m_Frames.resize(m_FramesCnt);
         for (int i = 0; i < m_FramesCnt; ++i)
         {
-            m_Frames[i].m_preVerts.reserve(256);
-            m_Frames[i].m_preVerts.clear();
-
-            m_Frames[i].m_preInds.reserve(256);
-            m_Frames[i].m_preInds.clear();
-
+            m_Frames[i].m_Data.reset();
             m_Frames[i].m_len = 0;
             m_Frames[i].m_light.all = 0;
         }
@@ -109,7 +115,7 @@ void CVOShadowStencil::Build(CVectorObject &obj, int frame, const D3DXVECTOR3 &v
     }
 
     SSSFrameData *fd = &m_Frames[frame];
-    SVOKadr *k = obj.m_Geometry.m_Frames + frame;
+    const SVOKadr *k = obj.m_Geometry.m_Frames + frame;
 
     len += k->m_Radius * 2 + k->m_GeoCenter.z;
 
@@ -131,24 +137,45 @@ void CVOShadowStencil::Build(CVectorObject &obj, int frame, const D3DXVECTOR3 &v
     fd->m_light.all = vlight.all;
     m_DirtyDX = true;
 
+    // the length along the light, as the volume is extruded by vLight * len
+    float lightlen = D3DXVec3Length(&vLight);
+    m_Key = SVOShadowStencilKey{&obj, frame, vlight.all, Float2Int(len * lightlen), invert};
+    if (lightlen > 0)
+        m_LightDir = vLight / lightlen;
+    else
+        m_LightDir = D3DXVECTOR3(0, 0, 0);
+
+    if (!m_Queued) {
+        m_Queued = true;
+        m_Queue.push_back(this);
+    }
+}
+
+void CVOShadowStencil::BuildData(SVOShadowStencilData &data, const SVOShadowStencilKey &key,
+                                 const D3DXVECTOR3 &dir) {
+    // no DTRACE: runs on the worker threads
+    const CVectorObject &obj = *key.m_VO;
+    int frame = key.m_Frame;
+    bool invert = key.m_Invert;
+    SVONormal vlight;
+    vlight.all = key.m_Light;
+    const SVOKadr *k = obj.m_Geometry.m_Frames + frame;
+
 #define MUL_X(v) (vlight.x * v)
 #define MUL_Y(v) (vlight.y * v)
 #define MUL_Z(v) (vlight.z * v)
 
-    D3DXVECTOR3 lenv(vLight * len);
-
-    fd->m_preVerts.reserve(k->m_EdgeCnt * 4);
-    fd->m_preVerts.clear();
+    D3DXVECTOR3 lenv(dir * float(key.m_Len));
 
-    fd->m_preInds.reserve(k->m_EdgeCnt * 4);
-    fd->m_preInds.clear();
+    data.m_Verts.reserve(k->m_EdgeCnt * 4);
+    data.m_Inds.reserve(k->m_EdgeCnt * 4);
 
     // TAKT_BEGIN();
 
-    SVOKadrEdge *keb = obj.m_Geometry.m_Edges + k->m_EdgeStart;
-    SVOKadrEdge *kee = keb + k->m_EdgeCnt;
+    const SVOKadrEdge *keb = obj.m_Geometry.m_Edges + k->m_EdgeStart;
+    const SVOKadrEdge *kee = keb + k->m_EdgeCnt;
 
-    SVOFrameRuntime *frr = obj.m_Geometry.m_FramesRuntime + frame;
+    const SVOFrameRuntime *frr = obj.m_Geometry.m_FramesRuntime + frame;
 
     int sz = (frr->m_EdgeVertexIndexCount) * sizeof(int);
     int *verts = (int *)_alloca(sz);
@@ -220,8 +247,8 @@ void CVOShadowStencil::Build(CVectorObject &obj, int frame, const D3DXVECTOR3 &v
             const D3DXVECTOR3 *vv = &(((SVOVertex *)(((BYTE *)obj.m_Geometry.m_Vertices.verts) + keb->v00))->v);
             D3DXVECTOR3 vv_(*vv + lenv);
 
-            fd->m_preVerts.emplace_back(*vv);
-            fd->m_preVerts.emplace_back(vv_);
+            data.m_Verts.emplace_back(*vv);
+            data.m_Verts.emplace_back(vv_);
         }
         else {
             vi0 = verts[vi0];
@@ -233,8 +260,8 @@ void CVOShadowStencil::Build(CVectorObject &obj, int frame, const D3DXVECTOR3 &v
             const D3DXVECTOR3 *vv = &(((SVOVertex *)(((BYTE *)obj.m_Geometry.m_Vertices.verts) + keb->v01))->v);
             D3DXVECTOR3 vv_(*vv + lenv);
 
-            fd->m_preVerts.emplace_back(*vv);
-            fd->m_preVerts.emplace_back(vv_);
+            data.m_Verts.emplace_back(*vv);
+            data.m_Verts.emplace_back(vv_);
         }
         else {
             vi1 = verts[vi1];
@@ -265,60 +292,139 @@ void CVOShadowStencil::Build(CVectorObject &obj, int frame, const D3DXVECTOR3 &v
             p2 = (vi0 * 2) | ((vi1 * 2) << 16);
         }
 
-        fd->m_preInds.emplace_back(0xFFFF & p0);
-        fd->m_preInds.emplace_back(0xFFFF & p0 >> 16);
-        fd->m_preInds.emplace_back(0xFFFF & p1);
-        fd->m_preInds.emplace_back(0xFFFF & p1 >> 16);
-        fd->m_preInds.emplace_back(0xFFFF & p2);
-        fd->m_preInds.emplace_back(0xFFFF & p2 >> 16);
+        data.m_Inds.emplace_back(0xFFFF & p0);
+        data.m_Inds.emplace_back(0xFFFF & p0 >> 16);
+        data.m_Inds.emplace_back(0xFFFF & p1);
+        data.m_Inds.emplace_back(0xFFFF & p1 >> 16);
+        data.m_Inds.emplace_back(0xFFFF & p2);
+        data.m_Inds.emplace_back(0xFFFF & p2 >> 16);
+    }
+}
+
+void CVOShadowStencil::BuildNow(void) {
+    m_Queued = false;
+
+    std::shared_ptr<const SVOShadowStencilData> data;
+    auto it = m_Cache.find(m_Key);
+    if (it != m_Cache.end())
+        data = it->second.lock();
+    if (!data) {
+        auto d = std::make_shared<SVOShadowStencilData>();
+        BuildData(*d, m_Key, m_LightDir);
+        data = d;
+        m_Cache[m_Key] = data;
+    }
+    m_Frames[m_Key.m_Frame].m_Data = std::move(data);
+}
+
+void CVOShadowStencil::BuildAll(void) {
+    DTRACE();
+
+    if (m_Queue.empty())
+        return;
+
+    if (m_Cache.size() > SHADOW_STENCIL_CACHE_PRUNE) {
+        std::erase_if(m_Cache, [](const auto &e) { return e.second.expired(); });
+    }
+
+    // the same volume is built once, whoever else needs it gets the same data
+    struct SJob {
+        SVOShadowStencilKey m_Key;
+        D3DXVECTOR3 m_Dir;
+        std::shared_ptr<SVOShadowStencilData> m_Data;
+    };
+    std::vector<SJob> jobs;
+    std::unordered_map<SVOShadowStencilKey, int, SVOShadowStencilKeyHash> jobidx;
+    std::vector<std::pair<CVOShadowStencil *, int>> waits;
+
+    for (CVOShadowStencil *s : m_Queue) {
+        s->m_Queued = false;
+
+        auto it = m_Cache.find(s->m_Key);
+        if (it != m_Cache.end()) {
+            if (auto data = it->second.lock()) {
+                s->m_Frames[s->m_Key.m_Frame].m_Data = std::move(data);
+                continue;
+            }
+        }
+        auto [ji, added] = jobidx.try_emplace(s->m_Key, int(jobs.size()));
+        if (added)
+            jobs.push_back(SJob{s->m_Key, s->m_LightDir, std::make_shared<SVOShadowStencilData>()});
+        waits.emplace_back(s, ji->second);
+    }
+    m_Queue.clear();
+
+    auto build = [&jobs](int from, int to) {
+        for (int i = from; i < to; ++i) {
+            BuildData(*jobs[i].m_Data, jobs[i].m_Key, jobs[i].m_Dir);
+        }
+    };
+    if (int(jobs.size()) < SHADOW_STENCIL_THREADED_MIN) {
+        build(0, int(jobs.size()));
+    }
+    else {
+        CTaskGraph graph;
+        graph.AddSplit(L"shadows", int(jobs.size()), build);
+        graph.Run();
+    }
+
+    for (SJob &j : jobs) {
+        m_Cache[j.m_Key] = j.m_Data;
+    }
+    for (auto &[s, ji] : waits) {
+        s->m_Frames[s->m_Key.m_Frame].m_Data = jobs[ji].m_Data;
     }
 }
 
 void CVOShadowStencil::DX_Prepare(void) {
+    if (m_Queued)
+        BuildNow();
     if (!m_DirtyDX)
         return;
     if (m_FrameFor < 0)
         return;
 
-    SSSFrameData *fd = &m_Frames[m_FrameFor];
+    const SVOShadowStencilData *fd = m_Frames[m_FrameFor].m_Data.get();
+    if (fd == NULL)
+        return;
 
-    if (!IS_VB(m_VB) || fd->m_preVerts.size() > m_VBSize) {
+    if (!IS_VB(m_VB) || fd->m_Verts.size() > m_VBSize) {
         if (IS_VB(m_VB)) {
             DESTROY_VB(m_VB);
         }
-        CREATE_VB_DYNAMIC(fd->m_preVerts.size() * sizeof(SVOShadowStencilVertex), SVOShadowStencilVertex_FVF, m_VB);
+        CREATE_VB_DYNAMIC(fd->m_Verts.size() * sizeof(SVOShadowStencilVertex), SVOShadowStencilVertex_FVF, m_VB);
         if (m_VB == NULL)
             return;
 
-        m_VBSize = fd->m_preVerts.size();
+        m_VBSize = fd->m_Verts.size();
     }
 
-    if (!IS_IB(m_IB) || fd->m_preInds.size() > m_IBSize)
+    if (!IS_IB(m_IB) || fd->m_Inds.size() > m_IBSize)
     {
         if (IS_VB(m_IB))
         {
             DESTROY_VB(m_IB);
         }
-        CREATE_IBD16(fd->m_preInds.size() * sizeof(WORD), m_IB);
+        CREATE_IBD16(fd->m_Inds.size() * sizeof(WORD), m_IB);
         if (m_IB == NULL)
             return;
 
-        m_IBSize = fd->m_preInds.size();
+        m_IBSize = fd->m_Inds.size();
     }
 
     {
         SVOShadowStencilVertex *p;
 
-        LOCKP_VB_DYNAMIC(m_VB, 0, fd->m_preVerts.size() * sizeof(SVOShadowStencilVertex), &p);
-        memcpy(p, fd->m_preVerts.data(), fd->m_preVerts.size() * sizeof(SVOShadowStencilVertex));
+        LOCKP_VB_DYNAMIC(m_VB, 0, fd->m_Verts.size() * sizeof(SVOShadowStencilVertex), &p);
+        memcpy(p, fd->m_Verts.data(), fd->m_Verts.size() * sizeof(SVOShadowStencilVertex));
         UNLOCK_VB(m_VB);
     }
 
     {
         WORD *p;
 
-        LOCKPD_IB(m_IB, 0, fd->m_preInds.size() * sizeof(WORD), &p);
-        memcpy(p, fd->m_preInds.data(), fd->m_preInds.size() * sizeof(WORD));
+        LOCKPD_IB(m_IB, 0, fd->m_Inds.size() * sizeof(WORD), &p);
+        memcpy(p, fd->m_Inds.data(), fd->m_Inds.size() * sizeof(WORD));
         UNLOCK_IB(m_IB);
     }
 
@@ -329,7 +435,7 @@ void CVOShadowStencil::Render(const D3DXMATRIX &objma)
 {
     DTRACE();
 
-    if (m_DirtyDX)
+    if (m_DirtyDX || m_Queued)
         DX_Prepare();
 
     if (!IS_VB(m_VB))
@@ -342,9 +448,11 @@ void CVOShadowStencil::Render(const D3DXMATRIX &objma)
     g_D3DD->SetStreamSource(0, GET_VB(m_VB), 0, sizeof(SVOShadowStencilVertex));
     g_D3DD->SetIndices(GET_IB(m_IB));
 
-    SSSFrameData& fd = m_Frames[m_FrameFor];
+    const SVOShadowStencilData *fd = m_Frames[m_FrameFor].m_Data.get();
+    if (fd == NULL)
+        return;
 
-    int vcnt = fd.m_preVerts.size();
-    int tcnt = fd.m_preInds.size() / 3;
+    int vcnt = fd->m_Verts.size();
+    int tcnt = fd->m_Inds.size() / 3;
     g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0, 0, vcnt, 0, tcnt);
 }
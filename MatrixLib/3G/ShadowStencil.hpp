@@ -8,10 +8,45 @@
 
 #include "VectorObject.hpp"
 
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 using SVOShadowStencilVertex = D3DXVECTOR3;
 
+#define SHADOW_STENCIL_THREADED_MIN 8     // fewer builds are done on the calling thread
+#define SHADOW_STENCIL_CACHE_PRUNE  1024  // entries in the cache before the unused ones are dropped
+
+// a volume, shared by all the instances of the same frame lit from the same side
+struct SVOShadowStencilData {
+    std::vector<SVOShadowStencilVertex> m_Verts;
+    std::vector<WORD> m_Inds;
+};
+
+// what a volume is built from: the frame, the light quantized as SVONormal, the length in whole units
+struct SVOShadowStencilKey {
+    const CVectorObject *m_VO;
+    int m_Frame;
+    DWORD m_Light;
+    int m_Len;
+    bool m_Invert;
+
+    bool operator==(const SVOShadowStencilKey &k) const {
+        return m_VO == k.m_VO && m_Frame == k.m_Frame && m_Light == k.m_Light && m_Len == k.m_Len &&
+               m_Invert == k.m_Invert;
+    }
+};
+
+struct SVOShadowStencilKeyHash {
+    size_t operator()(const SVOShadowStencilKey &k) const {
+        size_t h = std::hash<const void *>()(k.m_VO);
+        h = h * 31 + size_t(k.m_Frame);
+        h = h * 31 + size_t(k.m_Light);
+        h = h * 31 + size_t(k.m_Len);
+        return h * 2 + (k.m_Invert ? 1 : 0);
+    }
+};
+
 class CVOShadowStencil
 {
     DWORD m_DirtyDX;
@@ -32,8 +67,7 @@ class CVOShadowStencil
     int m_FrameFor;
 
     struct SSSFrameData {
-        std::vector<SVOShadowStencilVertex> m_preVerts;
-        std::vector<WORD> m_preInds;
+        std::shared_ptr<const SVOShadowStencilData> m_Data;
 
         SVONormal m_light;
         float m_len;
@@ -42,6 +76,19 @@ class CVOShadowStencil
     std::vector<SSSFrameData> m_Frames;
     int m_FramesCnt;
 
+    // the build waiting for BuildAll
+    bool m_Queued;
+    SVOShadowStencilKey m_Key;
+    D3DXVECTOR3 m_LightDir;
+
+    static std::vector<CVOShadowStencil *> m_Queue;
+    static std::unordered_map<SVOShadowStencilKey, std::weak_ptr<const SVOShadowStencilData>,
+                              SVOShadowStencilKeyHash>
+            m_Cache;
+
+    static void BuildData(SVOShadowStencilData &data, const SVOShadowStencilKey &key, const D3DXVECTOR3 &dir);
+    void BuildNow(void);
+
 public:
     static void StaticInit(void)
     {
@@ -52,6 +99,9 @@ public:
 
     static void MarkAllBuffersNoNeed(void);
 
+    // builds what Build has queued, on the worker threads when there is enough
+    static void BuildAll(void);
+
     CVOShadowStencil();
     ~CVOShadowStencil();
 
@@ -66,9 +116,13 @@ public:
         m_DirtyDX = true;
     }
 
+    // queues the build if the frame or the light has changed, BuildAll or the first use does it
     void Build(CVectorObject &obj, int frame, const D3DXVECTOR3 &vLight, float len, bool invert);
 
-    void BeforeRender(void) { DX_Prepare(); }
+    void BeforeRender(void) {
+        if (!m_Queued)
+            DX_Prepare();
+    }
     void Render(const D3DXMATRIX &objma);
 };
 
@@ -0,0 +1,133 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "StreamRing.hpp"
+
+#include <bit>
+
+D3D_VB CStreamRing::m_VB;
+D3D_IB CStreamRing::m_IB;
+CStreamRing::SRing CStreamRing::m_VBRing;
+CStreamRing::SRing CStreamRing::m_IBRing;
+SStreamRingStats CStreamRing::m_Frame;
+SStreamRingStats CStreamRing::m_Last;
+SStreamRingStats CStreamRing::m_Total;
+int CStreamRing::m_Frames;
+
+// the size for the bytes of a frame: twice as much
+static int GrownSize(int size, int used) {
+    if (used * 2 <= size)
+        return size;
+    return int(std::bit_ceil(unsigned(used) * 2));
+}
+
+void CStreamRing::BeginFrame(void) {
+    int vbsize = GrownSize(m_VBRing.m_Size, m_VBRing.m_Used);
+    if (vbsize != m_VBRing.m_Size) {
+        m_VBRing.m_Size = vbsize;
+        if (IS_VB(m_VB))
+            DESTROY_VB(m_VB);
+    }
+    int ibsize = GrownSize(m_IBRing.m_Size, m_IBRing.m_Used);
+    if (ibsize != m_IBRing.m_Size) {
+        m_IBRing.m_Size = ibsize;
+        if (IS_IB(m_IB))
+            DESTROY_IB(m_IB);
+    }
+    m_VBRing.m_Used = 0;
+    m_IBRing.m_Used = 0;
+
+    m_Last = m_Frame;
+    m_Frame = SStreamRingStats{};
+    ++m_Frames;
+}
+
+int CStreamRing::Alloc(SRing &r, int bytes, int align, bool &discard) {
+    int pos = (r.m_Pos + align - 1) / align * align;
+    discard = pos + bytes > r.m_Size;
+    if (discard) {
+        pos = 0;
+        ++m_Frame.m_Discards;
+        ++m_Total.m_Discards;
+    }
+    r.m_Pos = pos + bytes;
+    r.m_Used += bytes;
+
+    ++m_Frame.m_Locks;
+    ++m_Total.m_Locks;
+    return pos;
+}
+
+void *CStreamRing::LockVerts(int cnt, int stride, int &base) {
+    DTRACE();
+
+    int bytes = cnt * stride;
+    if (bytes > m_VBRing.m_Size) {
+        // a frame does not fit, the same as BeginFrame would do
+        m_VBRing.m_Size = GrownSize(m_VBRing.m_Size, bytes);
+        if (IS_VB(m_VB))
+            DESTROY_VB(m_VB);
+    }
+    if (!IS_VB(m_VB)) {
+        CREATE_VB_DYNAMIC(m_VBRing.m_Size, 0, m_VB);
+        if (!IS_VB(m_VB))
+            return NULL;
+        m_VBRing.m_Pos = 0;
+    }
+
+    bool discard;
+    int pos = Alloc(m_VBRing, bytes, stride, discard);
+    m_Frame.m_VBBytes += bytes;
+    m_Total.m_VBBytes += bytes;
+
+    void *p;
+    if (discard) {
+        LOCKP_VB_DYNAMIC(m_VB, pos, bytes, &p);
+    }
+    else {
+        LOCKP_VB_NO(m_VB, pos, bytes, &p);
+    }
+    base = pos / stride;
+    return p;
+}
+
+WORD *CStreamRing::LockInds(int cnt, int &base) {
+    DTRACE();
+
+    int bytes = cnt * sizeof(WORD);
+    if (bytes > m_IBRing.m_Size) {
+        m_IBRing.m_Size = GrownSize(m_IBRing.m_Size, bytes);
+        if (IS_IB(m_IB))
+            DESTROY_IB(m_IB);
+    }
+    if (!IS_IB(m_IB)) {
+        CREATE_IBD16(m_IBRing.m_Size, m_IB);
+        if (!IS_IB(m_IB))
+            return NULL;
+        m_IBRing.m_Pos = 0;
+    }
+
+    bool discard;
+    int pos = Alloc(m_IBRing, bytes, sizeof(WORD), discard);
+    m_Frame.m_IBBytes += bytes;
+    m_Total.m_IBBytes += bytes;
+
+    WORD *p;
+    if (discard) {
+        LOCKPD_IB(m_IB, pos, bytes, &p);
+    }
+    else {
+        LOCKP_IB_NO(m_IB, pos, bytes, &p);
+    }
+    base = pos / sizeof(WORD);
+    return p;
+}
+
+void CStreamRing::MarkAllBuffersNoNeed(void) {
+    if (IS_VB(m_VB))
+        DESTROY_VB(m_VB);
+    if (IS_IB(m_IB))
+        DESTROY_IB(m_IB);
+}
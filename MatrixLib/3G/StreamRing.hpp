@@ -0,0 +1,81 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "D3DControl.hpp"
+
+#include <cstdint>
+
+#define STREAM_RING_VB_SIZE (1024 * 1024)  // bytes at start, a ring grows if a frame does not fit into a half of it
+#define STREAM_RING_IB_SIZE (256 * 1024)
+
+struct SStreamRingStats {
+    int64_t m_VBBytes;
+    int64_t m_IBBytes;
+    int64_t m_Locks;
+    int64_t m_Discards;  // wraps of the rings
+};
+
+/**
+ * @brief Vertices and indices written every frame, of all the systems, in one dynamic VB and one dynamic IB.
+ *
+ * A lock takes the next part of the ring with NOOVERWRITE: the GPU may still read the parts before it. When the
+ * rest of the ring is too short the whole buffer is discarded and writing starts from its beginning again. A ring
+ * grows at the start of a frame if the last frame has written more than a half of it, so a frame discards once at
+ * most.
+ *
+ * The data must be drawn before the next lock of the same ring: that one may discard it.
+ */
+class CStreamRing : public Base::CMain {
+    struct SRing {
+        int m_Size;  // bytes
+        int m_Pos;
+        int m_Used;  // bytes of the frame
+    };
+
+    static D3D_VB m_VB;
+    static D3D_IB m_IB;
+    static SRing m_VBRing;
+    static SRing m_IBRing;
+
+    static SStreamRingStats m_Frame;
+    static SStreamRingStats m_Last;  // of the previous frame
+    static SStreamRingStats m_Total;
+    static int m_Frames;
+
+    // offset of the bytes aligned to align, discard is set if the ring starts again
+    static int Alloc(SRing &r, int bytes, int align, bool &discard);
+
+public:
+    static void StaticInit(void) {
+        m_VB = NULL;
+        m_IB = NULL;
+        m_VBRing = SRing{STREAM_RING_VB_SIZE, 0, 0};
+        m_IBRing = SRing{STREAM_RING_IB_SIZE, 0, 0};
+        m_Frame = SStreamRingStats{};
+        m_Last = SStreamRingStats{};
+        m_Total = SStreamRingStats{};
+        m_Frames = 0;
+    }
+
+    static void BeginFrame(void);
+
+    // cnt vertices of the stride, base is the index of the first one (for SetStream(stride)); NULL if no VB
+    static void *LockVerts(int cnt, int stride, int &base);
+    static void UnlockVerts(void) { UNLOCK_VB(m_VB); }
+    // cnt 16 bit indices, base is the index of the first one; NULL if no IB
+    static WORD *LockInds(int cnt, int &base);
+    static void UnlockInds(void) { UNLOCK_IB(m_IB); }
+
+    static void SetStream(int stride) { ASSERT_DX(g_D3DD->SetStreamSource(0, GET_VB(m_VB), 0, stride)); }
+    static void SetIndices(void) { ASSERT_DX(g_D3DD->SetIndices(GET_IB(m_IB))); }
+
+    static void MarkAllBuffersNoNeed(void);
+
+    static const SStreamRingStats &GetFrameStats(void) { return m_Last; }
+    static const SStreamRingStats &GetTotalStats(void) { return m_Total; }
+    static int GetFrames(void) { return m_Frames; }
+};
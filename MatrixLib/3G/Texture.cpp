@@ -4,6 +4,7 @@
 // Refer to the LICENSE file included
 
 #include "Texture.hpp"
+#include "TextureStream.hpp"
 
 #include "CFile.hpp"
 #include "CStorage.hpp"
@@ -77,22 +78,21 @@ LPDIRECT3DTEXTURE9 CBaseTexture::LoadTextureFromFile(bool to16, D3DPOOL pool) {
 
 autoload:
 
+    // a texture stored in a package is read by D3DX right from the mapped package
     CBuf buf;
+    std::span<const std::byte> data;
+    LoadFileView(buf, data, CacheExtsTex);
     if (FLAG(m_Flags, TF_COMPRESSED)) {
-        LoadFromFile(buf, CacheExtsTex);
-
         CStorage ccc(g_CacheHeap);
-        ccc.Load(buf);
+        ccc.Load(data);
 
         CDataBuf *b = ccc.GetBuf(L"0", L"0", ST_BYTE);
         buf.Clear();
         buf.Add(b->GetFirst<BYTE>(0), b->GetArrayLength(0));
-    }
-    else {
-        LoadFromFile(buf, CacheExtsTex);
+        data = std::span<const std::byte>((const std::byte *)buf.Get(), buf.Len());
     }
 
-    if (FAILED(D3DXCreateTextureFromFileInMemoryEx(g_D3DD, buf.Get(), buf.Len(), 0, 0,
+    if (FAILED(D3DXCreateTextureFromFileInMemoryEx(g_D3DD, data.data(), UINT(data.size()), 0, 0,
                                                    FLAG(m_Flags, TF_NOMIPMAP) ? 1 : 0, 0, D3DFMT_UNKNOWN, pool,
                                                    D3DX_FILTER_NONE, D3DX_FILTER_BOX, 0, NULL, NULL, &ret))) {
         return NULL;
@@ -100,6 +100,46 @@ autoload:
     return ret;
 }
 
+static DWORD FormatBits(D3DFORMAT fmt) {
+    switch (fmt) {
+        case D3DFMT_DXT1:
+            return 4;
+        case D3DFMT_DXT2:
+        case D3DFMT_DXT3:
+        case D3DFMT_DXT4:
+        case D3DFMT_DXT5:
+        case D3DFMT_A8:
+        case D3DFMT_L8:
+        case D3DFMT_R3G3B2:
+            return 8;
+        case D3DFMT_R5G6B5:
+        case D3DFMT_X1R5G5B5:
+        case D3DFMT_A1R5G5B5:
+        case D3DFMT_A4R4G4B4:
+        case D3DFMT_X4R4G4B4:
+        case D3DFMT_A8R3G3B2:
+        case D3DFMT_A8L8:
+            return 16;
+        default:
+            return 32;
+    }
+}
+
+DWORD CBaseTexture::GetFootprint(void) {
+    if (m_Tex == NULL)
+        return 0;
+
+    DWORD size = 0;
+    DWORD cnt = m_Tex->GetLevelCount();
+    for (DWORD i = 0; i < cnt; ++i) {
+        D3DSURFACE_DESC desc;
+        if (FAILED(m_Tex->GetLevelDesc(i, &desc)))
+            break;
+        size += desc.Width * desc.Height * FormatBits(desc.Format) / 8;
+    }
+    return size;
+}
+
 void CBaseTexture::ParseFlags(const ParamParser& name) {
     m_Flags = 0;
     std::wstring tstr;
@@ -353,6 +393,7 @@ void CTexture::Load(void) {
         m_OOM_counter = OOM_TEXTRUE_HIT_COUNTER;
         return;
     }
+    SETFLAG(m_Flags, TF_FILE);
 
     D3DSURFACE_DESC desc;
     m_Tex->GetLevelDesc(0, &desc);
@@ -441,7 +482,11 @@ void CTextureManaged::Init(bool to16) {
 #ifdef USE_DX_MANAGED_TEXTURES
     if (m_Tex)
         return;
+    DWORD stream = m_Flags & TF_STREAM;
     m_Tex = LoadTextureFromFile(to16, D3DPOOL_MANAGED);
+    m_Flags |= stream;
+    if (!to16)
+        SETFLAG(m_Flags, TF_FILE);  // Load gives the same
 
     D3DSURFACE_DESC desc;
     m_Tex->GetLevelDesc(0, &desc);
@@ -472,6 +517,8 @@ void CTextureManaged::Load(void) {
         if (m_Name.length() == 0)
             ERROR_E;
 #endif
+        if (m_Stream && g_TextureStream->Finish(m_Stream))
+            return;
         Init(false);
     }
 
@@ -519,6 +566,50 @@ void CTextureManaged::Unload(void) {
     // CDText::T("texcnt", g_TexManagedCnt);
 }
 
+void CTextureManaged::StreamOn(void) {
+#ifdef USE_DX_MANAGED_TEXTURES
+    if (FLAG(m_Flags, TF_STREAM))
+        return;
+    if (m_Tex == NULL)
+        ParseFlags(m_Name);
+    SETFLAG(m_Flags, TF_STREAM);
+#endif
+}
+
+void CTextureManaged::StreamOff(void) {
+    if (m_Stream)
+        g_TextureStream->Discard(m_Stream);
+    RESETFLAG(m_Flags, TF_STREAM);
+}
+
+LPDIRECT3DTEXTURE9 CTextureManaged::Placeholder(void) {
+    if (m_Stream == NULL && (g_TextureStream == NULL || !g_TextureStream->Request(this)))
+        return NULL;
+    return g_TextureStream->GetPlaceholder(FLAG(m_Flags, TF_ALPHATEST | TF_ALPHABLEND));
+}
+
+bool CTextureManaged::CanEvict(void) {
+#ifdef USE_DX_MANAGED_TEXTURES
+    return m_Tex != NULL && FLAG(m_Flags, TF_FILE);
+#else
+    return m_Tex != NULL;
+#endif
+}
+
+void CTextureManaged::Evict(void) {
+#ifdef USE_DX_MANAGED_TEXTURES
+    // Unload keeps managed textures, the runtime pages them itself; the budget needs the memory back
+    m_Tex->Release();
+    m_Tex = NULL;
+    // Flags of a streamed texture do not load it
+    DWORD stream = m_Flags & TF_STREAM;
+    ParseFlags(m_Name);
+    m_Flags |= stream;
+#else
+    Unload();
+#endif
+}
+
 // void CTextureManaged::LoadFromBitmapAsIs(const CBitmap & bm)
 //{
 //    DTRACE();
@@ -711,6 +802,8 @@ void CTextureManaged::LoadFromBitmap(const CBitmap &bm, D3DFORMAT fmt, int level
     if (m_TexFrom)
         m_TexFrom->Release();
 #endif
+    StreamOff();
+    RESETFLAG(m_Flags, TF_FILE);
 
     CBuf buf;
 
@@ -757,6 +850,8 @@ void CTextureManaged::LoadFromBitmap(const CBitmap &bm, bool convert_to_16bit, i
     if (m_TexFrom)
         m_TexFrom->Release();
 #endif
+    StreamOff();
+    RESETFLAG(m_Flags, TF_FILE);
 
     int lx, ly;
     D3DLOCKED_RECT lr;
@@ -24,6 +24,8 @@
 
 #define TF_LOST       SETBIT(6)  // texture lost. m_Tex is SM texture
 #define TF_COMPRESSED SETBIT(7)
+#define TF_FILE       SETBIT(8)  // m_Tex holds just what the file gives, so it can be loaded again
+#define TF_STREAM     SETBIT(9)  // may be loaded in the background by g_TextureStream, see CTextureManaged::StreamOn
 
 #define OOM_TEXTRUE_HIT_COUNTER 50
 
@@ -64,7 +66,7 @@ public:
     void MipmapOff(void) { SETFLAG(m_Flags, TF_NOMIPMAP); }
 
     DWORD Flags(void) {
-        if (!m_Tex)
+        if (!m_Tex && !FLAG(m_Flags, TF_STREAM))
             Load();
         return m_Flags;
     }
@@ -82,6 +84,9 @@ public:
     virtual void Unload(void) = 0;
     virtual void Load(void) = 0;
 
+    virtual DWORD GetFootprint(void);
+    virtual int GetReloadCost(void) { return FLAG(m_Flags, TF_COMPRESSED) ? 3 : 2; }
+
     static void OnLostDevice(void);
     static void OnResetDevice(void);
 };
@@ -123,6 +128,7 @@ public:
         if (m_OOM_counter > 0 || FLAG(m_Flags, TF_LOST))
             return NULL;
         ASSERT(m_Type == CacheClass::Texture);
+        m_Used = true;
         if (!m_Tex) {
 #ifdef _DEBUG
             // ASSERT(!FLAG(g_Flags, GFLAG_RENDERINPROGRESS));
@@ -142,12 +148,17 @@ public:
 
     virtual void Unload(void);
     virtual void Load(void);
+
+    virtual bool CanEvict(void) { return m_Tex != NULL && FLAG(m_Flags, TF_FILE) && !FLAG(m_Flags, TF_LOST); }
+    virtual void Evict(void) { Unload(); }
 };
 
 #ifndef USE_DX_MANAGED_TEXTURES
 void UnloadTextureManaged(DWORD user);
 #endif
 
+struct STexStreamJob;
+
 class CTextureManaged : public CBaseTexture {
 #ifndef USE_DX_MANAGED_TEXTURES
     D3DFORMAT m_Format;
@@ -157,8 +168,14 @@ class CTextureManaged : public CBaseTexture {
     int m_OOM_counter;
 #endif
 
+    STexStreamJob *m_Stream;  // being loaded in the background
+
     void LoadFromBitmap(int level, const CBitmap &bm, bool convert_to_16bit);  // valid only for 24 and 32 bpp images
+    LPDIRECT3DTEXTURE9 Placeholder(void);
+
 public:
+    friend class CTextureStreamer;
+
 #pragma warning(disable : 4355)
     CTextureManaged(void)
       : CBaseTexture()
@@ -170,6 +187,7 @@ public:
         m_Type = CacheClass::TextureManaged;
         m_Tex = NULL;
         m_Flags = 0;
+        m_Stream = NULL;
 #ifndef USE_DX_MANAGED_TEXTURES
         m_OOM_counter = 0;
 #endif
@@ -183,6 +201,7 @@ public:
 
     virtual ~CTextureManaged() {
         DTRACE();
+        StreamOff();
 #ifndef USE_DX_MANAGED_TEXTURES
         if (m_TexFrom) {
             m_TexFrom->Release();
@@ -201,8 +220,14 @@ public:
             return NULL;
 #endif
         if (!m_Tex) {
+            if (FLAG(m_Flags, TF_STREAM)) {
+                LPDIRECT3DTEXTURE9 tex = Placeholder();
+                if (tex)
+                    return tex;
+            }
             Load();
         }
+        m_Used = true;
 #ifndef USE_DX_MANAGED_TEXTURES
         m_RemindCore.Use(5000);
 #endif
@@ -223,12 +248,18 @@ public:
         m_RemindCore.Use(5000);
 #else
         if (!m_Tex) {
+            if (FLAG(m_Flags, TF_STREAM) && Placeholder())
+                return;
             Load();
         }
         m_Tex->PreLoad();
 #endif
     }
 
+    // the texture is only drawn: until it is loaded in the background Tex gives a placeholder
+    void StreamOn(void);
+    void StreamOff(void);
+
     HRESULT CreateLock(D3DFORMAT fmt, int sx, int sy, int levels, D3DLOCKED_RECT &lr) {
 #ifdef USE_DX_MANAGED_TEXTURES
         ASSERT(m_Tex == NULL);
@@ -277,8 +308,13 @@ public:
 #ifndef USE_DX_MANAGED_TEXTURES
                     ASSERT_DX(TexFrom()->LockRect(0, &lr, NULL, Flags));
 #else
+        if (!m_Tex)
+            Load();  // not a placeholder
         ASSERT_DX(Tex()->LockRect(0, &lr, NULL, Flags));
 #endif
+        // after the load, which marks the texture as the file again
+        if (!FLAG(Flags, D3DLOCK_READONLY))
+            RESETFLAG(m_Flags, TF_FILE);
     }
     void UnlockRect(void) {
 #ifndef USE_DX_MANAGED_TEXTURES
@@ -294,6 +330,9 @@ public:
 
     virtual void Unload(void);
     virtual void Load(void);
+
+    virtual bool CanEvict(void);
+    virtual void Evict(void);
 };
 
 #ifndef USE_DX_MANAGED_TEXTURES
@@ -0,0 +1,154 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "TextureAtlas.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+static std::vector<CTextureManaged *> _queued;
+static std::vector<CTextureManaged *> _pages;
+static std::unordered_map<const CTextureManaged *, SAtlasRect> _rects;
+
+static constexpr int ATLAS_ALIGN = 1 << (ATLAS_LEVELS - 1);
+
+static int AlignCell(int size) {
+    return (size + 2 * ATLAS_PADDING + ATLAS_ALIGN - 1) / ATLAS_ALIGN * ATLAS_ALIGN;
+}
+
+static CTextureManaged *CreatePage(void) {
+    CTextureManaged *page = CACHE_CREATE_TEXTUREMANAGED();
+    D3DLOCKED_RECT lr;
+    if (D3D_OK != page->CreateLock(D3DFMT_A8R8G8B8, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, ATLAS_LEVELS, lr)) {
+        CCache::Destroy(page);
+        return NULL;
+    }
+    for (int y = 0; y < ATLAS_PAGE_SIZE; ++y) {
+        memset((BYTE *)lr.pBits + y * lr.Pitch, 0, ATLAS_PAGE_SIZE * sizeof(DWORD));
+    }
+    page->UnlockRect();
+    return page;
+}
+
+// the image at x, y of the page and its edges stretched over the padding around
+static bool CopyImage(IDirect3DSurface9 *to, CTextureManaged *tex, int x, int y) {
+    IDirect3DSurface9 *from;
+    if (D3D_OK != tex->Tex()->GetSurfaceLevel(0, &from))
+        return false;
+
+    int w = tex->GetSizeX();
+    int h = tex->GetSizeY();
+    const int dx[4] = {x, x + ATLAS_PADDING, x + ATLAS_PADDING + w, x + 2 * ATLAS_PADDING + w};
+    const int dy[4] = {y, y + ATLAS_PADDING, y + ATLAS_PADDING + h, y + 2 * ATLAS_PADDING + h};
+
+    bool ok = true;
+    for (int j = 0; j < 3 && ok; ++j) {
+        for (int i = 0; i < 3 && ok; ++i) {
+            RECT dr = {dx[i], dy[j], dx[i + 1], dy[j + 1]};
+            RECT sr = {i == 2 ? w - 1 : 0, j == 2 ? h - 1 : 0, i == 0 ? 1 : w, j == 0 ? 1 : h};
+            ok = D3D_OK == D3DXLoadSurfaceFromSurface(to, NULL, &dr, from, NULL, &sr, D3DX_FILTER_POINT, 0);
+        }
+    }
+
+    from->Release();
+    return ok;
+}
+
+static void FinishPage(CTextureManaged *page, IDirect3DSurface9 *to) {
+    to->Release();
+    ASSERT_DX(D3DXFilterTexture(page->Tex(), NULL, 0, D3DX_FILTER_BOX));
+}
+
+void CTextureAtlas::Add(CTextureManaged *tex) {
+    if (tex == NULL || _rects.count(tex) != 0 || std::find(_queued.begin(), _queued.end(), tex) != _queued.end())
+        return;
+    if (!tex->IsLoaded())
+        tex->Load();
+    if (!tex->IsLoaded() || tex->GetSizeX() > ATLAS_MAX_IMAGE || tex->GetSizeY() > ATLAS_MAX_IMAGE)
+        return;
+    _queued.push_back(tex);
+}
+
+void CTextureAtlas::Build(void) {
+    DTRACE();
+
+    // the highest first: a shelf is as high as its first image
+    std::stable_sort(_queued.begin(), _queued.end(), [](CTextureManaged *a, CTextureManaged *b) {
+        return a->GetSizeY() > b->GetSizeY();
+    });
+
+    CTextureManaged *page = NULL;
+    IDirect3DSurface9 *to = NULL;
+    int x = 0, y = 0, shelf = 0;
+
+    for (CTextureManaged *tex : _queued) {
+        int cw = AlignCell(tex->GetSizeX());
+        int ch = AlignCell(tex->GetSizeY());
+
+        if (x + cw > ATLAS_PAGE_SIZE) {
+            x = 0;
+            y += shelf;
+            shelf = 0;
+        }
+        if (page == NULL || y + ch > ATLAS_PAGE_SIZE) {
+            if (page != NULL)
+                FinishPage(page, to);
+            page = CreatePage();
+            if (page == NULL)
+                break;
+            if (D3D_OK != page->Tex()->GetSurfaceLevel(0, &to)) {
+                CCache::Destroy(page);
+                page = NULL;
+                break;
+            }
+            _pages.push_back(page);
+            x = 0;
+            y = 0;
+            shelf = 0;
+        }
+
+        if (CopyImage(to, tex, x, y)) {
+            SAtlasRect r;
+            r.m_Page = page;
+            r.m_U0 = float(x + ATLAS_PADDING) / float(ATLAS_PAGE_SIZE);
+            r.m_V0 = float(y + ATLAS_PADDING) / float(ATLAS_PAGE_SIZE);
+            r.m_U1 = float(x + ATLAS_PADDING + tex->GetSizeX()) / float(ATLAS_PAGE_SIZE);
+            r.m_V1 = float(y + ATLAS_PADDING + tex->GetSizeY()) / float(ATLAS_PAGE_SIZE);
+            _rects[tex] = r;
+        }
+
+        x += cw;
+        shelf = std::max(shelf, ch);
+    }
+
+    if (page != NULL)
+        FinishPage(page, to);
+
+    _queued.clear();
+}
+
+void CTextureAtlas::Clear(void) {
+    for (CTextureManaged *page : _pages) {
+        CCache::Destroy(page);
+    }
+    _pages.clear();
+    _rects.clear();
+    _queued.clear();
+}
+
+const SAtlasRect *CTextureAtlas::Find(const CTextureManaged *tex) {
+    auto it = _rects.find(tex);
+    return it == _rects.end() ? NULL : &it->second;
+}
+
+int CTextureAtlas::GetPagesCount(void) {
+    return int(_pages.size());
+}
+
+int CTextureAtlas::GetImagesCount(void) {
+    return int(_rects.size());
+}
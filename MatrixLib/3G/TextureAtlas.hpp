@@ -0,0 +1,45 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "Texture.hpp"
+
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_MAX_IMAGE 256  // bigger images are left as they are
+#define ATLAS_PADDING   4    // edge pixels repeated around an image: mipmaps and filtering do not mix the neighbours
+#define ATLAS_LEVELS    3    // mipmaps of a page, the padding is a pixel at the last one
+
+struct SAtlasRect {
+    CTextureManaged *m_Page;
+    float m_U0, m_V0;
+    float m_U1, m_V1;
+
+    // 0..1 of the image to the page
+    void Remap(float &tu, float &tv) const {
+        tu = m_U0 + tu * (m_U1 - m_U0);
+        tv = m_V0 + tv * (m_V1 - m_V0);
+    }
+};
+
+/**
+ * @brief Small textures packed into a few pages at runtime, so quads of different images draw with one texture.
+ *
+ * The images are added when loaded and packed at once by Build: sorted by the height, in shelves. A page has
+ * ATLAS_LEVELS mipmaps and an image is placed at a multiple of 1 << (ATLAS_LEVELS - 1) pixels, so the padding
+ * keeps it apart at every level. Only images used with 0..1 coordinates may be packed: there is no wrapping.
+ */
+class CTextureAtlas : public Base::CMain {
+public:
+    static void Add(CTextureManaged *tex);  // to be packed by Build
+    static void Build(void);
+    static void Clear(void);
+
+    // NULL if the texture is not packed
+    static const SAtlasRect *Find(const CTextureManaged *tex);
+
+    static int GetPagesCount(void);
+    static int GetImagesCount(void);
+};
@@ -0,0 +1,354 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "TextureStream.hpp"
+#include "Texture.hpp"
+#include "CFile.hpp"
+#include "FilePNG.hpp"
+
+#include <utils.hpp>
+
+#include <algorithm>
+
+CTextureStreamer *g_TextureStream;
+
+CTextureStreamer::CTextureStreamer(CHeap *heap) : m_Heap(heap) {
+    InitializeCriticalSection(&m_Lock);
+    m_Wake = CreateSemaphoreW(NULL, 0, 0x7fffffff, NULL);
+    m_Done = CreateEventW(NULL, FALSE, FALSE, NULL);
+}
+
+CTextureStreamer::~CTextureStreamer() {
+    Stop();
+    CloseHandle(m_Wake);
+    CloseHandle(m_Done);
+    DeleteCriticalSection(&m_Lock);
+}
+
+void CTextureStreamer::Start(void) {
+#ifdef USE_DX_MANAGED_TEXTURES
+    if (m_ThreadCnt > 0)
+        return;
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int cnt = std::min(int(si.dwNumberOfProcessors) - 1, TEXSTREAM_THREADS_MAX);
+
+    m_Stop = false;
+    for (int i = 0; i < cnt; ++i) {
+        HANDLE h = CreateThread(NULL, 0, ThreadProc, this, 0, NULL);
+        if (h == NULL)
+            break;
+        m_Threads[m_ThreadCnt++] = h;
+    }
+#endif
+}
+
+void CTextureStreamer::Stop(void) {
+    if (m_ThreadCnt > 0) {
+        EnterCriticalSection(&m_Lock);
+        m_Stop = true;
+        LeaveCriticalSection(&m_Lock);
+
+        ReleaseSemaphore(m_Wake, m_ThreadCnt, NULL);
+        WaitForMultipleObjects(m_ThreadCnt, m_Threads, TRUE, INFINITE);
+        for (int i = 0; i < m_ThreadCnt; ++i) {
+            CloseHandle(m_Threads[i]);
+        }
+        m_ThreadCnt = 0;
+    }
+
+    while (!m_Jobs.empty()) {
+        Discard(m_Jobs.back());
+    }
+
+    for (auto &p : m_Placeholder) {
+        if (p) {
+            p->Release();
+            p = NULL;
+        }
+    }
+}
+
+DWORD WINAPI CTextureStreamer::ThreadProc(LPVOID param) {
+    CTextureStreamer *ts = (CTextureStreamer *)param;
+    for (;;) {
+        WaitForSingleObject(ts->m_Wake, INFINITE);
+
+        EnterCriticalSection(&ts->m_Lock);
+        bool stop = ts->m_Stop;
+        LeaveCriticalSection(&ts->m_Lock);
+        if (stop)
+            break;
+
+        // the main thread may have taken the job back already
+        if (STexStreamJob *job = ts->PopJob()) {
+            bool ok = Decode(job);
+
+            EnterCriticalSection(&ts->m_Lock);
+            job->m_State = ok ? TSS_READY : TSS_FAILED;
+            LeaveCriticalSection(&ts->m_Lock);
+            SetEvent(ts->m_Done);
+        }
+    }
+    return 0;
+}
+
+STexStreamJob *CTextureStreamer::PopJob(void) {
+    STexStreamJob *job = NULL;
+    EnterCriticalSection(&m_Lock);
+    if (!m_Queue.empty()) {
+        job = m_Queue.front();
+        m_Queue.erase(m_Queue.begin());
+        job->m_State = TSS_DECODING;
+    }
+    LeaveCriticalSection(&m_Lock);
+    return job;
+}
+
+ETexStreamState CTextureStreamer::GetState(STexStreamJob *job) {
+    EnterCriticalSection(&m_Lock);
+    ETexStreamState state = job->m_State;
+    LeaveCriticalSection(&m_Lock);
+    return state;
+}
+
+// box filter of 2x2 texels
+static void MakeSmaller(const STexStreamLevel &from, STexStreamLevel &to) {
+    to.m_SizeX = from.m_SizeX / 2;
+    to.m_SizeY = from.m_SizeY / 2;
+    to.m_Pixels.resize(size_t(to.m_SizeX) * to.m_SizeY * 4);
+
+    const int pitch = from.m_SizeX * 4;
+    uint8_t *des = to.m_Pixels.data();
+    for (int y = 0; y < to.m_SizeY; ++y) {
+        const uint8_t *sou = from.m_Pixels.data() + y * 2 * pitch;
+        for (int x = 0; x < to.m_SizeX; ++x, sou += 8, des += 4) {
+            for (int c = 0; c < 4; ++c) {
+                des[c] = uint8_t((sou[c] + sou[c + 4] + sou[pitch + c] + sou[pitch + c + 4] + 2) / 4);
+            }
+        }
+    }
+}
+
+bool CTextureStreamer::Decode(STexStreamJob *job) {
+    try {
+        uint32_t lenx, leny, countcolor, format;
+        uintptr_t id = FilePNG::ReadStart_Buf((void *)job->m_Data.data(), uint32_t(job->m_Data.size()), &lenx, &leny,
+                                              &countcolor, &format);
+        if (id == 0)
+            return false;
+
+        // a line of 4 bytes a texel fits any format; Read frees the id whatever comes next
+        STexStreamLevel &lev = job->m_Level[0];
+        lev.m_SizeX = int(lenx);
+        lev.m_SizeY = int(leny);
+        lev.m_Pixels.resize(size_t(lenx) * leny * 4);
+        if (!FilePNG::Read(id, lev.m_Pixels.data(), lenx * 4, NULL))
+            return false;
+
+        // anything else goes the usual way through D3DX, which rounds sizes up and converts formats
+        if (format != 2 && format != 3)
+            return false;
+        if ((lenx & (lenx - 1)) != 0 || (leny & (leny - 1)) != 0)
+            return false;
+
+        if (format == 2) {
+            // rgb to rgba in place, from the end of each line
+            for (uint32_t y = 0; y < leny; ++y) {
+                uint8_t *line = lev.m_Pixels.data() + y * lenx * 4;
+                for (int x = int(lenx) - 1; x >= 0; --x) {
+                    line[x * 4 + 3] = 255;
+                    line[x * 4 + 2] = line[x * 3 + 2];
+                    line[x * 4 + 1] = line[x * 3 + 1];
+                    line[x * 4 + 0] = line[x * 3 + 0];
+                }
+            }
+        }
+
+        job->m_LevelCnt = 1;
+        job->m_Size = lenx * leny * 4;
+        while (job->m_Mipmap && job->m_LevelCnt < TEXSTREAM_LEVELS_MAX) {
+            const STexStreamLevel &prev = job->m_Level[job->m_LevelCnt - 1];
+            if (prev.m_SizeX < 2 || prev.m_SizeY < 2)
+                break;
+            STexStreamLevel &next = job->m_Level[job->m_LevelCnt++];
+            MakeSmaller(prev, next);
+            job->m_Size += next.m_SizeX * next.m_SizeY * 4;
+        }
+    }
+    catch (...) {
+        return false;
+    }
+    return true;
+}
+
+bool CTextureStreamer::Request(CTextureManaged *tex) {
+    DTRACE();
+
+    if (!IsActive())
+        return false;
+
+    // png only, the rest is loaded as usual
+    std::wstring name = ParamParser{tex->m_Name}.GetStrPar(0, L"?");
+    std::wstring path;
+    bool png = !FLAG(tex->m_Flags, TF_COMPRESSED) && CFile::FileExist(path, name.c_str(), CacheExtsTex, false);
+    if (png) {
+        auto dot = path.rfind(L'.');
+        std::wstring ext{dot == std::wstring::npos ? L"" : path.substr(dot + 1)};
+        utils::to_lower(ext);
+        png = ext == L"png";
+    }
+    if (!png) {
+        RESETFLAG(tex->m_Flags, TF_STREAM);
+        return false;
+    }
+
+    STexStreamJob *job = HNew(m_Heap) STexStreamJob;
+    job->m_Tex = tex;
+    if (!CFile::GetView(path, job->m_Data)) {
+        job->m_File.LoadFromFile(path);
+        job->m_Data = std::span<const std::byte>((const std::byte *)job->m_File.Get(), job->m_File.Len());
+    }
+    job->m_Mipmap = !FLAG(tex->m_Flags, TF_NOMIPMAP);
+    job->m_State = TSS_QUEUED;
+    job->m_LevelCnt = 0;
+    job->m_Size = 0;
+    job->m_Start = std::chrono::steady_clock::now();
+
+    EnterCriticalSection(&m_Lock);
+    m_Queue.push_back(job);
+    LeaveCriticalSection(&m_Lock);
+    m_Jobs.push_back(job);
+    ReleaseSemaphore(m_Wake, 1, NULL);
+
+    tex->m_Stream = job;
+    return true;
+}
+
+void CTextureStreamer::Take(STexStreamJob *job, bool decode) {
+    EnterCriticalSection(&m_Lock);
+    auto it = std::find(m_Queue.begin(), m_Queue.end(), job);
+    bool queued = it != m_Queue.end();
+    if (queued) {
+        m_Queue.erase(it);
+        job->m_State = TSS_FAILED;
+    }
+    LeaveCriticalSection(&m_Lock);
+
+    if (queued) {
+        if (decode)
+            job->m_State = Decode(job) ? TSS_READY : TSS_FAILED;
+    }
+    else {
+        while (GetState(job) == TSS_DECODING) {
+            WaitForSingleObject(m_Done, INFINITE);
+        }
+    }
+
+    m_Jobs.erase(std::find(m_Jobs.begin(), m_Jobs.end(), job));
+}
+
+bool CTextureStreamer::Upload(STexStreamJob *job) {
+    DTRACE();
+
+    CTextureManaged *tex = job->m_Tex;
+    const STexStreamLevel &top = job->m_Level[0];
+    ASSERT(tex->m_Tex == NULL);
+
+    if (D3D_OK != g_D3DD->CreateTexture(top.m_SizeX, top.m_SizeY, job->m_LevelCnt, 0, D3DFMT_A8R8G8B8,
+                                        D3DPOOL_MANAGED, &tex->m_Tex, 0)) {
+        tex->m_Tex = NULL;
+        return false;
+    }
+    tex->m_Size.x = top.m_SizeX;
+    tex->m_Size.y = top.m_SizeY;
+    for (int i = 0; i < job->m_LevelCnt; ++i) {
+        // the bitmap only points to the pixels of the job
+        STexStreamLevel &lev = job->m_Level[i];
+        CBitmap bm;
+        bm.CreateRGBA(lev.m_SizeX, lev.m_SizeY, lev.m_SizeX * 4, lev.m_Pixels.data());
+        tex->LoadFromBitmap(i, bm, false);
+    }
+    SETFLAG(tex->m_Flags, TF_FILE);
+
+    auto latency = std::chrono::steady_clock::now() - job->m_Start;
+    ++m_Uploaded;
+    m_LastLatency = DWORD(std::chrono::duration_cast<std::chrono::milliseconds>(latency).count());
+    m_MaxLatency = std::max(m_MaxLatency, m_LastLatency);
+    m_LastName = tex->m_Name;
+    return true;
+}
+
+void CTextureStreamer::FreeJob(STexStreamJob *job) {
+    job->m_Tex->m_Stream = NULL;
+    HDelete(STexStreamJob, job, m_Heap);
+}
+
+bool CTextureStreamer::Finish(STexStreamJob *job) {
+    DTRACE();
+
+    Take(job, true);
+    bool ok = job->m_State == TSS_READY && Upload(job);
+    if (!ok)
+        RESETFLAG(job->m_Tex->m_Flags, TF_STREAM);
+    FreeJob(job);
+    return ok;
+}
+
+void CTextureStreamer::Discard(STexStreamJob *job) {
+    Take(job, false);
+    FreeJob(job);
+}
+
+void CTextureStreamer::Takt(void) {
+    DTRACE();
+
+    // finished jobs go in the order of the requests until the budget is spent
+    DWORD uploaded = 0;
+    for (int i = 0; i < int(m_Jobs.size()) && uploaded < TEXSTREAM_UPLOAD_BUDGET;) {
+        STexStreamJob *job = m_Jobs[i];
+        ETexStreamState state = GetState(job);
+        if (state != TSS_READY && state != TSS_FAILED) {
+            ++i;
+            continue;
+        }
+
+        m_Jobs.erase(m_Jobs.begin() + i);
+        if (state == TSS_READY && Upload(job))
+            uploaded += job->m_Size;
+        else
+            RESETFLAG(job->m_Tex->m_Flags, TF_STREAM);  // next time it loads as usual
+        FreeJob(job);
+    }
+}
+
+LPDIRECT3DTEXTURE9 CTextureStreamer::GetPlaceholder(bool transparent) {
+    LPDIRECT3DTEXTURE9 &tex = m_Placeholder[transparent ? 1 : 0];
+    if (tex == NULL) {
+        if (D3D_OK != g_D3DD->CreateTexture(TEXSTREAM_PLACEHOLDER, TEXSTREAM_PLACEHOLDER, 1, 0, D3DFMT_A8R8G8B8,
+                                            D3DPOOL_MANAGED, &tex, 0)) {
+            tex = NULL;
+            return NULL;
+        }
+        D3DLOCKED_RECT lr;
+        ASSERT_DX(tex->LockRect(0, &lr, NULL, 0));
+        for (int y = 0; y < TEXSTREAM_PLACEHOLDER; ++y) {
+            DWORD *des = (DWORD *)((BYTE *)lr.pBits + y * lr.Pitch);
+            for (int x = 0; x < TEXSTREAM_PLACEHOLDER; ++x) {
+                des[x] = transparent ? 0x00808080 : 0xFF808080;
+            }
+        }
+        ASSERT_DX(tex->UnlockRect(0));
+    }
+    return tex;
+}
+
+int CTextureStreamer::GetQueued(void) {
+    EnterCriticalSection(&m_Lock);
+    int cnt = int(m_Queue.size());
+    LeaveCriticalSection(&m_Lock);
+    return cnt;
+}
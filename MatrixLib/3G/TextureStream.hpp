@@ -0,0 +1,130 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "CMain.hpp"
+#include "CHeap.hpp"
+#include "CBuf.hpp"
+
+#include "d3d9.h"
+
+#include <windows.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+class CTextureManaged;
+
+#define TEXSTREAM_THREADS_MAX    3
+#define TEXSTREAM_LEVELS_MAX     13               // 4096x4096 down to 1x1
+#define TEXSTREAM_UPLOAD_BUDGET  (1024 * 1024)    // texel bytes uploaded per frame
+#define TEXSTREAM_PLACEHOLDER    4                // size of the placeholder textures
+
+enum ETexStreamState
+{
+    TSS_QUEUED,
+    TSS_DECODING,
+    TSS_READY,
+    TSS_FAILED
+};
+
+// rgba, 4 bytes a texel; a plain vector: the workers must not touch the heaps of CHeap
+struct STexStreamLevel
+{
+    int m_SizeX;
+    int m_SizeY;
+    std::vector<uint8_t> m_Pixels;
+};
+
+struct STexStreamJob
+{
+    CTextureManaged *m_Tex;
+    CBuf m_File;                       // the file unless it is read right from a package
+    std::span<const std::byte> m_Data;
+    bool m_Mipmap;
+
+    ETexStreamState m_State;
+    STexStreamLevel m_Level[TEXSTREAM_LEVELS_MAX];
+    int m_LevelCnt;
+    DWORD m_Size;  // texel bytes of all the levels
+
+    std::chrono::steady_clock::time_point m_Start;
+};
+
+/**
+ * @brief Loads the png textures of CTextureManaged in the background while the game is running.
+ *
+ * A texture which allows it (CTextureManaged::StreamOn) is not loaded on the first use: its file is read and queued,
+ * and until it is ready the texture draws with a placeholder. Worker threads decode the png and build the mipmaps,
+ * Takt uploads the finished ones within a per-frame budget. Whoever needs the real data (Load, LockRect) gets it at
+ * once: a queued job is taken back and decoded by the calling thread.
+ *
+ * Only the queues are shared with the workers; the textures and the device are touched by the main thread only.
+ * The workers do not use CBitmap either: HAlloc and DTRACE are not thread-safe in the debug builds (MEM_SPY_ENABLE),
+ * so they decode with FilePNG into plain buffers and the levels become a CBitmap at the upload.
+ */
+class CTextureStreamer : public Base::CMain
+{
+    CHeap *m_Heap;
+
+    HANDLE m_Threads[TEXSTREAM_THREADS_MAX];
+    int m_ThreadCnt{0};
+    CRITICAL_SECTION m_Lock;
+    HANDLE m_Wake;  // semaphore: a job is queued
+    HANDLE m_Done;  // some job is decoded
+    bool m_Stop{false};
+
+    std::vector<STexStreamJob *> m_Queue;  // waiting for a worker, oldest first
+    std::vector<STexStreamJob *> m_Jobs;   // all the jobs not uploaded yet
+
+    LPDIRECT3DTEXTURE9 m_Placeholder[2]{};  // opaque, transparent
+
+    int m_Uploaded{0};
+    DWORD m_LastLatency{0};  // ms
+    DWORD m_MaxLatency{0};
+    std::wstring m_LastName;
+
+    static DWORD WINAPI ThreadProc(LPVOID param);
+    STexStreamJob *PopJob(void);
+    static bool Decode(STexStreamJob *job);
+    ETexStreamState GetState(STexStreamJob *job);
+    void Take(STexStreamJob *job, bool decode);
+    bool Upload(STexStreamJob *job);
+    void FreeJob(STexStreamJob *job);
+
+public:
+    CTextureStreamer(CHeap *heap);
+    ~CTextureStreamer();
+
+    bool IsActive(void) const { return m_ThreadCnt > 0; }
+
+    void Start(void);
+    // drops all the jobs: their textures load as usual when they are used next time
+    void Stop(void);
+
+    // false if the texture has to be loaded as usual
+    bool Request(CTextureManaged *tex);
+    // upload the job right now, decoding it if no worker has done it yet; false if it failed
+    bool Finish(STexStreamJob *job);
+    void Discard(STexStreamJob *job);
+
+    LPDIRECT3DTEXTURE9 GetPlaceholder(bool transparent);
+
+    // once per frame after the draw
+    void Takt(void);
+
+    int GetQueued(void);
+    int GetPending(void) const { return int(m_Jobs.size()); }
+    int GetUploaded(void) const { return m_Uploaded; }
+    DWORD GetLastLatency(void) const { return m_LastLatency; }
+    DWORD GetMaxLatency(void) const { return m_MaxLatency; }
+    const std::wstring &GetLastName(void) const { return m_LastName; }
+};
+
+extern CTextureStreamer *g_TextureStream;
@@ -1465,9 +1465,23 @@ void CVectorObject::UnloadTextures(void)
 }
 */
 
+DWORD CVectorObject::GetFootprint(void) {
+    if (m_Geometry.m_Vertices.verts == NULL || (uintptr_t)m_Geometry.m_Vertices.verts == 0xFFFFFFFF)
+        return 0;
+
+    DWORD size = 0;
+    if (!m_Geometry.m_Vertices.IsMarkedNoNeed(m_VB))
+        size += m_Geometry.m_Vertices.size;
+    if (m_Geometry.m_Idxs.inds != NULL && !m_Geometry.m_Idxs.IsMarkedNoNeed(m_IB))
+        size += m_Geometry.m_Idxs.size;
+    return size;
+}
+
 void CVectorObject::BeforeDraw(void) {
     DTRACE();
 
+    m_Used = true;
+
     for (int i = 0; i < m_Geometry.m_SurfacesCnt; ++i) {
         if (m_Geometry.m_Surfaces[i].skin) {
             m_Geometry.m_Surfaces[i].skin->m_Preload(m_Geometry.m_Surfaces[i].skin);
@@ -1532,41 +1546,101 @@ void CVectorObject::Draw(int noframe, DWORD user_param, const SSkin *ds) {
             again |= (nextpass[surf] = ss->m_SetupStages(ss, user_param, pass));
             ss->m_SetupTex(ss, user_param, pass);
 
-            SVOKadr *k = m_Geometry.m_Frames + noframe;
-            for (int i = 0; i < k->m_UnionCnt; ++i) {
-                SVOUnion *gr = m_Geometry.m_Unions + m_Geometry.m_UnionsIdx[i + k->m_UnionStart];
-                if (gr->m_Surface != surf)
-                    continue;
+            DrawSurface(noframe, surf, vbase, ibase);
+
+            ss->m_SetupClear(ss, user_param);
+        }
+    }
+    while (again);
+}
+
+void CVectorObject::DrawSurface(int noframe, int surf, int vbase, int ibase) {
+    SVOKadr *k = m_Geometry.m_Frames + noframe;
+    for (int i = 0; i < k->m_UnionCnt; ++i) {
+        SVOUnion *gr = m_Geometry.m_Unions + m_Geometry.m_UnionsIdx[i + k->m_UnionStart];
+        if (gr->m_Surface != surf)
+            continue;
 
 #ifdef _DEBUG
 
-                HRESULT res;
-                if (gr->m_IBase < 0) {
-                    res = g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, gr->m_Base + vbase, 0, gr->m_VerCnt,
-                                                       -gr->m_IBase + ibase, gr->m_TriCnt);
-                }
-                else {
-                    res = g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, gr->m_Base + vbase, gr->m_VerMinIndex,
-                                                       gr->m_VerCnt, gr->m_TriStart * 3 + ibase, gr->m_TriCnt);
-                }
+        HRESULT res;
+        if (gr->m_IBase < 0) {
+            res = g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, gr->m_Base + vbase, 0, gr->m_VerCnt,
+                                               -gr->m_IBase + ibase, gr->m_TriCnt);
+        }
+        else {
+            res = g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, gr->m_Base + vbase, gr->m_VerMinIndex,
+                                               gr->m_VerCnt, gr->m_TriStart * 3 + ibase, gr->m_TriCnt);
+        }
 
-                if (D3D_OK != res) {
-                    debugbreak();
-                }
+        if (D3D_OK != res) {
+            debugbreak();
+        }
 
 #else
-                // g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST,gr->m_Base +
-                // vbase,gr->m_VerMinIndex,gr->m_VerCnt,gr->m_TriStart * 3 + ibase, gr->m_TriCnt);
-                if (gr->m_IBase < 0) {
-                    g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, gr->m_Base + vbase, 0, gr->m_VerCnt,
-                                                 -gr->m_IBase + ibase, gr->m_TriCnt);
+        // g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST,gr->m_Base +
+        // vbase,gr->m_VerMinIndex,gr->m_VerCnt,gr->m_TriStart * 3 + ibase, gr->m_TriCnt);
+        if (gr->m_IBase < 0) {
+            g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, gr->m_Base + vbase, 0, gr->m_VerCnt,
+                                         -gr->m_IBase + ibase, gr->m_TriCnt);
+        }
+        else {
+            g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, gr->m_Base + vbase, gr->m_VerMinIndex,
+                                         gr->m_VerCnt, gr->m_TriStart * 3 + ibase, gr->m_TriCnt);
+        }
+
+#endif
+    }
+}
+
+void CVectorObject::DrawBatch(int noframe, DWORD user_param, const SSkin *ds, const SVOInstance *inst, int cnt) {
+    DTRACE();
+
+    if (noframe < 0 || cnt <= 0)
+        return;
+
+    int vbase = m_Geometry.m_Vertices.Select(m_VB);
+    if (vbase < 0)
+        return;
+    int ibase = m_Geometry.m_Idxs.Select(m_IB);
+    if (ibase < 0)
+        return;
+
+    int pass = -1;
+
+    bool *nextpass = (bool *)_alloca(m_Geometry.m_SurfacesCnt);
+
+    for (int i = 0; i < m_Geometry.m_SurfacesCnt; ++i)
+        nextpass[i] = true;
+
+    bool again;
+    do {
+        ++pass;
+
+        again = false;
+
+        for (int surf = 0; surf < m_Geometry.m_SurfacesCnt; ++surf) {
+            if (!nextpass[surf])
+                continue;
+
+            const SSkin *ss = m_Geometry.m_Surfaces[surf].skin;
+            if (ss == NULL)
+                ss = ds;
+
+            again |= (nextpass[surf] = ss->m_SetupStages(ss, user_param, pass));
+            ss->m_SetupTex(ss, user_param, pass);
+
+            for (int j = 0; j < cnt; ++j) {
+                ASSERT_DX(g_D3DD->SetTransform(D3DTS_WORLD, &inst[j].m_Matrix));
+                g_D3DD->SetRenderState(D3DRS_TEXTUREFACTOR, inst[j].m_TFactor);
+                if (inst[j].m_Invert) {
+                    g_D3DD->SetRenderState(D3DRS_CULLMODE, D3DCULL_CW);
+                    DrawSurface(noframe, surf, vbase, ibase);
+                    g_D3DD->SetRenderState(D3DRS_CULLMODE, D3DCULL_CCW);
                 }
                 else {
-                    g_D3DD->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, gr->m_Base + vbase, gr->m_VerMinIndex,
-                                                 gr->m_VerCnt, gr->m_TriStart * 3 + ibase, gr->m_TriCnt);
+                    DrawSurface(noframe, surf, vbase, ibase);
                 }
-
-#endif
             }
 
             ss->m_SetupClear(ss, user_param);
@@ -1575,6 +1649,41 @@ void CVectorObject::Draw(int noframe, DWORD user_param, const SSkin *ds) {
     while (again);
 }
 
+void CVOBatch::Flush(void) {
+    DTRACE();
+
+    m_Open = false;
+    int cnt = int(m_Items.size());
+    if (cnt == 0)
+        return;
+
+    // the same frame of the same skin gets the same key, the order within a group is the order of adding
+    m_Queue.Clear();
+    for (int i = 0; i < cnt; ++i) {
+        const SItem &it = m_Items[i];
+        uint32_t mat = CRenderQueue::Material(it.m_VO) ^ (CRenderQueue::Material(it.m_Skin) * 31) ^
+                       (uint32_t(it.m_UserParam) * 17) ^ (uint32_t(it.m_Frame) * 0x9E3779B9);
+        m_Queue.Add(CRenderQueue::Key(0, mat, i), &m_Items[i]);
+    }
+    m_Queue.Sort();
+
+    int i = 0;
+    while (i < cnt) {
+        const SItem &first = *(const SItem *)m_Queue.Get(i).m_Data;
+        m_Group.clear();
+        for (; i < cnt; ++i) {
+            const SItem &it = *(const SItem *)m_Queue.Get(i).m_Data;
+            if (it.m_VO != first.m_VO || it.m_Frame != first.m_Frame || it.m_Skin != first.m_Skin ||
+                it.m_UserParam != first.m_UserParam)
+                break;
+            m_Group.push_back(it.m_Inst);
+        }
+        first.m_VO->DrawBatch(first.m_Frame, first.m_UserParam, first.m_Skin, m_Group.data(), int(m_Group.size()));
+    }
+
+    m_Items.clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
@@ -15,6 +15,9 @@
 #include "ShadowProj.hpp"
 #include "CBillboard.hpp"
 #include "CReminder.hpp"
+#include "RenderQueue.hpp"
+
+#include <vector>
 
 extern IDirect3DDevice9 *g_D3DD;
 
@@ -313,6 +316,13 @@ struct SVOGeometry {
 
 typedef bool (*ENUM_VERTS_HANDLER)(const SVOVertex &v, uintptr_t data);
 
+// a draw of a frame put off to be drawn together with the other ones of the same frame and skin
+struct SVOInstance {
+    D3DXMATRIX m_Matrix;  // world
+    DWORD m_TFactor;
+    bool m_Invert;        // mirrored, drawn with the reversed culling
+};
+
 class CVectorObjectAnim;
 class CVectorObject : public CCacheData {
     static CBigVB<SVOVertex> *m_VB;
@@ -328,6 +338,8 @@ class CVectorObject : public CCacheData {
     bool PickSimple(const D3DXMATRIX &ma, const D3DXMATRIX &ima, const D3DXVECTOR3 &origin, const D3DXVECTOR3 &dir,
                     float *outt) const;
 
+    void DrawSurface(int noframe, int surf, int vbase, int ibase);
+
     SRemindCore m_RemindCore;
 
 public:
@@ -428,6 +440,8 @@ public:
 
     void BeforeDraw(void);
     void Draw(int noframe, DWORD user_param, const SSkin *ds);
+    // the stages and the textures of a surface are set once for all the instances
+    void DrawBatch(int noframe, DWORD user_param, const SSkin *ds, const SVOInstance *inst, int cnt);
 
     void LoadSpecial(EObjectLoad flags, SKIN_GET sg, DWORD gsp);
     void PrepareSpecial(EObjectLoad flags, SKIN_GET sg, DWORD gsp) {
@@ -440,6 +454,12 @@ public:
     virtual bool IsLoaded(void) { return (m_Geometry.m_Vertices.verts != NULL); }
     virtual void Unload(void);
     virtual void Load(void) { LoadSpecial(OLF_NO_TEX, NULL, 0); };
+
+    // the geometry stays in memory: only its part of the big vertex and index buffers is accounted and freed,
+    // BeforeDraw restores it
+    virtual DWORD GetFootprint(void);
+    virtual bool CanEvict(void) { return true; }
+    virtual void Evict(void) { DX_Free(); }
 };
 
 struct SSkin {
@@ -652,6 +672,40 @@ public:
     void DrawLights(bool now, const D3DXMATRIX &objma, const D3DXMATRIX *iview);
 };
 
+/**
+ * @brief Draws of the units of a frame, grouped by what they set on the device.
+ *
+ * The units are added between Open and Flush instead of being drawn. Flush sorts them by the object, the frame,
+ * the skin and the user param and draws every group with CVectorObject::DrawBatch: the skin sets the stages and
+ * the textures once, every unit sets only its world matrix, the texture factor and the culling. The stages are
+ * fixed function, so the units are still drawn one by one.
+ */
+class CVOBatch : public CMain {
+    struct SItem {
+        CVectorObject *m_VO;
+        int m_Frame;
+        const SSkin *m_Skin;
+        DWORD m_UserParam;
+        SVOInstance m_Inst;
+    };
+    std::vector<SItem> m_Items;
+    std::vector<SVOInstance> m_Group;
+    CRenderQueue m_Queue;
+    bool m_Open{false};
+
+public:
+    void Open(void) { m_Open = true; }
+    bool IsOpen(void) const { return m_Open; }
+
+    void Add(CVectorObjectAnim *obj, DWORD user_param, const D3DXMATRIX &m, DWORD tfactor, bool invert) {
+        m_Items.push_back(SItem{obj->VO(), obj->GetVOFrame(), obj->GetSkin(), user_param, {m, tfactor, invert}});
+    }
+    // draws what is added and closes
+    void Flush(void);
+
+    int GetCount(void) const { return int(m_Items.size()); }
+};
+
 class CVectorObjectGroup;
 
 class CVectorObjectGroupUnit : public CMain {
@@ -0,0 +1,261 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "BlockParImage.hpp"
+#include "CBlockPar.hpp"
+#include "CFile.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace Base {
+
+static void SourceStamp(const std::wstring &name, SBPImageSource &src) {
+    WIN32_FILE_ATTRIBUTE_DATA fa;
+    if (GetFileAttributesExW(name.c_str(), GetFileExInfoStandard, &fa)) {
+        src.m_Size = fa.nFileSizeLow;
+        src.m_TimeLow = fa.ftLastWriteTime.dwLowDateTime;
+        src.m_TimeHigh = fa.ftLastWriteTime.dwHighDateTime;
+        return;
+    }
+
+    // packages have no times, the size has to do
+    std::wstring found;
+    src.m_Size = 0xFFFFFFFF;
+    src.m_TimeLow = 0;
+    src.m_TimeHigh = 0;
+    if (CFile::FileExist(found, name.c_str())) {
+        CFile fi(name);
+        fi.OpenRead();
+        src.m_Size = fi.Size();
+        fi.Close();
+    }
+}
+
+CBlockParImage::CBlockParImage(void) : CMain() {
+    m_File = INVALID_HANDLE_VALUE;
+    m_Mapping = NULL;
+    m_View = NULL;
+    m_Header = NULL;
+}
+
+CBlockParImage::~CBlockParImage() {
+    Close();
+}
+
+bool CBlockParImage::Open(const std::wstring &filename) {
+    DTRACE();
+    Close();
+
+    m_File = CreateFileW(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                         NULL);
+    if (m_File == INVALID_HANDLE_VALUE)
+        return false;
+
+    DWORD size = GetFileSize(m_File, NULL);
+    if (size >= sizeof(SBPImageHeader)) {
+        m_Mapping = CreateFileMappingW(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_Mapping)
+            m_View = (const BYTE *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (m_View == NULL) {
+        Close();
+        return false;
+    }
+
+    // the tables have to be inside the file, the rest is trusted: the image is written by Compile only
+    const SBPImageHeader *h = (const SBPImageHeader *)m_View;
+    auto inside = [size](DWORD offset, DWORD cnt, DWORD item) {
+        return offset <= size && cnt <= (size - offset) / item;
+    };
+    if (h->m_Magic != BPI_MAGIC || h->m_Version != BPI_VERSION || h->m_Size != size || h->m_BlockCnt == 0 ||
+        !inside(h->m_Sources, h->m_SourceCnt, sizeof(SBPImageSource)) ||
+        !inside(h->m_Blocks, h->m_BlockCnt, sizeof(SBPImageBlock)) ||
+        !inside(h->m_Units, h->m_UnitCnt, sizeof(SBPImageUnit)) || !inside(h->m_Refs, h->m_RefCnt, sizeof(DWORD)) ||
+        !inside(h->m_Strs, h->m_StrCnt, sizeof(SBPImageStr)) || !inside(h->m_Chars, h->m_CharCnt, sizeof(wchar))) {
+        Close();
+        return false;
+    }
+
+    m_Header = h;
+    return true;
+}
+
+void CBlockParImage::Close(void) {
+    if (m_View) {
+        UnmapViewOfFile(m_View);
+        m_View = NULL;
+    }
+    if (m_Mapping) {
+        CloseHandle(m_Mapping);
+        m_Mapping = NULL;
+    }
+    if (m_File != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+    m_Header = NULL;
+}
+
+bool CBlockParImage::IsFresh(void) const {
+    DTRACE();
+
+    const SBPImageSource *sources = Table<SBPImageSource>(m_Header->m_Sources);
+    for (DWORD i = 0; i < m_Header->m_SourceCnt; ++i) {
+        SBPImageSource now;
+        SourceStamp(std::wstring{Str(sources[i].m_Name)}, now);
+        if (now.m_Size != sources[i].m_Size || now.m_TimeLow != sources[i].m_TimeLow ||
+            now.m_TimeHigh != sources[i].m_TimeHigh)
+            return false;
+    }
+    return true;
+}
+
+const SBPImageUnit *CBlockParImage::FindPar(DWORD block, std::wstring_view name, int index) const {
+    const SBPImageBlock &b = Block(block);
+    const DWORD *first = Table<DWORD>(m_Header->m_Refs) + b.m_Sorted;
+    const DWORD *last = first + b.m_ParCnt + b.m_BlockCnt;
+
+    first = std::lower_bound(first, last, name, [this](DWORD u, std::wstring_view n) { return Str(Unit(u).m_Name) < n; });
+    for (; first < last; ++first) {
+        const SBPImageUnit &u = Unit(*first);
+        if (Str(u.m_Name) != name)
+            break;
+        if (u.m_Type == DWORD(CBlockParUnit::Type::Par) && (index-- == 0))
+            return &u;
+    }
+    return NULL;
+}
+
+int CBlockParImage::CountPar(DWORD block, std::wstring_view name) const {
+    int cnt = 0;
+    while (FindPar(block, name, cnt))
+        ++cnt;
+    return cnt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+class BPImageCompiler {
+public:
+    std::vector<SBPImageSource> m_Sources;
+    std::vector<SBPImageBlock> m_Blocks;
+    std::vector<SBPImageUnit> m_Units;
+    std::vector<DWORD> m_Refs;
+    std::vector<SBPImageStr> m_Strs;
+    std::wstring m_Chars;
+    std::unordered_map<std::wstring, DWORD> m_StrIndex;
+
+    DWORD Str(const std::wstring &str) {
+        auto res = m_StrIndex.try_emplace(str, DWORD(m_Strs.size()));
+        if (res.second) {
+            m_Strs.push_back(SBPImageStr{DWORD(m_Chars.size()), DWORD(str.length())});
+            m_Chars += str;
+            m_Chars += wchar(0);
+        }
+        return res.first->second;
+    }
+
+    std::wstring_view Name(DWORD unit) const {
+        const SBPImageStr &s = m_Strs[m_Units[unit].m_Name];
+        return std::wstring_view{m_Chars}.substr(s.m_Char, s.m_Len);
+    }
+
+    void Source(const std::wstring &name) {
+        SBPImageSource src;
+        src.m_Name = Str(name);
+        SourceStamp(name, src);
+        m_Sources.push_back(src);
+    }
+
+    DWORD Block(const std::vector<CBlockParUnit *> &units, const std::wstring &fromfile) {
+        DWORD no = DWORD(m_Blocks.size());
+        m_Blocks.emplace_back();
+
+        // the units of a block go in a row, the blocks inside come after them
+        DWORD first = DWORD(m_Units.size());
+        m_Units.resize(first + units.size());
+        std::vector<DWORD> pars, blocks;
+        for (size_t i = 0; i < units.size(); ++i) {
+            const CBlockParUnit *el = units[i];
+            SBPImageUnit &u = m_Units[first + i];
+            u.m_Type = DWORD(el->m_Type);
+            u.m_Name = Str(el->m_Name);
+            u.m_Com = Str(el->m_Com);
+            u.m_Value = el->isPar() ? Str(*el->m_Par) : 0;
+            if (el->isPar())
+                pars.push_back(first + DWORD(i));
+            else if (el->isBlock())
+                blocks.push_back(first + DWORD(i));
+        }
+        for (DWORD u : blocks) {
+            const CBlockPar *bp = units[u - first]->m_Block;
+            bp->Expand();
+            if (!bp->m_FromFile.empty())
+                Source(bp->m_FromFile);
+            DWORD child = Block(bp->m_Units, bp->m_FromFile);
+            m_Units[u].m_Value = child;
+        }
+
+        std::vector<DWORD> sorted{pars};
+        sorted.insert(sorted.end(), blocks.begin(), blocks.end());
+        std::sort(sorted.begin(), sorted.end());  // the file order
+        std::stable_sort(sorted.begin(), sorted.end(), [this](DWORD a, DWORD b) { return Name(a) < Name(b); });
+
+        SBPImageBlock &b = m_Blocks[no];
+        b.m_First = first;
+        b.m_Cnt = DWORD(units.size());
+        b.m_Pars = DWORD(m_Refs.size());
+        b.m_ParCnt = DWORD(pars.size());
+        m_Refs.insert(m_Refs.end(), pars.begin(), pars.end());
+        b.m_Blocks = DWORD(m_Refs.size());
+        b.m_BlockCnt = DWORD(blocks.size());
+        m_Refs.insert(m_Refs.end(), blocks.begin(), blocks.end());
+        b.m_Sorted = DWORD(m_Refs.size());
+        m_Refs.insert(m_Refs.end(), sorted.begin(), sorted.end());
+        b.m_FromFile = Str(fromfile);
+        return no;
+    }
+
+    template <class T>
+    static void Table(CBuf &buf, DWORD &offset, DWORD &cnt, const T *data, size_t size) {
+        offset = DWORD(buf.Pointer());
+        cnt = DWORD(size);
+        buf.Add(data, sizeof(T) * size);
+    }
+
+    void Compile(const CBlockPar &bp, const std::wstring &source, const std::wstring &filename) {
+        Source(source);
+        bp.Expand();
+        Block(bp.m_Units, bp.m_FromFile);
+
+        SBPImageHeader h;
+        CBuf buf;
+        buf.Add(&h, sizeof(h));
+        Table(buf, h.m_Sources, h.m_SourceCnt, m_Sources.data(), m_Sources.size());
+        Table(buf, h.m_Blocks, h.m_BlockCnt, m_Blocks.data(), m_Blocks.size());
+        Table(buf, h.m_Units, h.m_UnitCnt, m_Units.data(), m_Units.size());
+        Table(buf, h.m_Refs, h.m_RefCnt, m_Refs.data(), m_Refs.size());
+        Table(buf, h.m_Strs, h.m_StrCnt, m_Strs.data(), m_Strs.size());
+        Table(buf, h.m_Chars, h.m_CharCnt, m_Chars.data(), m_Chars.size());
+        h.m_Magic = BPI_MAGIC;
+        h.m_Version = BPI_VERSION;
+        h.m_Size = DWORD(buf.Len());
+
+        buf.Pointer(0);
+        buf.Add(&h, sizeof(h));
+        buf.SaveInFile(filename);
+    }
+};
+
+void CBlockParImage::Compile(const CBlockPar &bp, const std::wstring &source, const std::wstring &filename) {
+    DTRACE();
+
+    BPImageCompiler co;
+    co.Compile(bp, source, filename);
+}
+
+}  // namespace Base
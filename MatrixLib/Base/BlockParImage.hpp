@@ -0,0 +1,105 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "CMain.hpp"
+
+#include <windows.h>
+#include <string>
+#include <string_view>
+
+namespace Base {
+
+class CBlockPar;
+
+#define BPI_MAGIC   0x31495042  // "BPI1"
+#define BPI_VERSION 1
+
+// All the offsets are from the start of the image, all the indices are into the tables of the header.
+struct SBPImageHeader {
+    DWORD m_Magic;
+    DWORD m_Version;
+    DWORD m_Size;  // of the whole image
+    DWORD m_Sources, m_SourceCnt;  // SBPImageSource
+    DWORD m_Blocks, m_BlockCnt;    // SBPImageBlock, the root block is the first one
+    DWORD m_Units, m_UnitCnt;      // SBPImageUnit
+    DWORD m_Refs, m_RefCnt;        // DWORD unit indices for the lists of the blocks
+    DWORD m_Strs, m_StrCnt;        // SBPImageStr
+    DWORD m_Chars, m_CharCnt;      // wchar, every string is zero terminated
+};
+
+// file the image was compiled from: the image is stale once it changes
+struct SBPImageSource {
+    DWORD m_Name;
+    DWORD m_Size;
+    DWORD m_TimeLow, m_TimeHigh;  // 0 for a file in a package
+};
+
+struct SBPImageStr {
+    DWORD m_Char;
+    DWORD m_Len;
+};
+
+struct SBPImageUnit {
+    DWORD m_Type;   // CBlockParUnit::Type
+    DWORD m_Name;   // string
+    DWORD m_Value;  // string of a parameter, block of a block
+    DWORD m_Com;    // string
+};
+
+struct SBPImageBlock {
+    DWORD m_First, m_Cnt;        // units in the file order
+    DWORD m_Pars, m_ParCnt;      // refs: the parameters in the file order
+    DWORD m_Blocks, m_BlockCnt;  // refs: the blocks in the file order
+    DWORD m_Sorted;              // refs: the parameters and the blocks sorted by name, in the file order within a name
+    DWORD m_FromFile;            // string
+};
+
+/**
+ * @brief Compiled CBlockPar mapped read-only from a file.
+ *
+ * The image is flat: a string table, a table of blocks with their units, and per block the lists of parameters,
+ * blocks and a name-sorted index of them. Nothing is parsed or allocated when it is opened, CBlockPar makes its
+ * units from it only when a block is accessed (CBlockPar::LoadFromImage), and looks the parameters of a block
+ * up right in the image until then.
+ */
+class BASE_API CBlockParImage : public CMain {
+    HANDLE m_File;
+    HANDLE m_Mapping;
+    const BYTE *m_View;
+    const SBPImageHeader *m_Header;
+
+    template <class T>
+    const T *Table(DWORD offset) const {
+        return (const T *)(m_View + offset);
+    }
+
+public:
+    CBlockParImage(void);
+    ~CBlockParImage();
+
+    // false if there is no such file or it is not a valid image
+    bool Open(const std::wstring &filename);
+    void Close(void);
+    // none of the sources has changed since the image was compiled
+    bool IsFresh(void) const;
+
+    const SBPImageBlock &Block(DWORD no) const { return Table<SBPImageBlock>(m_Header->m_Blocks)[no]; }
+    const SBPImageUnit &Unit(DWORD no) const { return Table<SBPImageUnit>(m_Header->m_Units)[no]; }
+    DWORD Ref(DWORD no) const { return Table<DWORD>(m_Header->m_Refs)[no]; }
+    std::wstring_view Str(DWORD no) const {
+        const SBPImageStr &s = Table<SBPImageStr>(m_Header->m_Strs)[no];
+        return std::wstring_view{Table<wchar>(m_Header->m_Chars) + s.m_Char, s.m_Len};
+    }
+
+    // index-th parameter with the name in the block, NULL if there is no such
+    const SBPImageUnit *FindPar(DWORD block, std::wstring_view name, int index) const;
+    int CountPar(DWORD block, std::wstring_view name) const;
+
+    static void Compile(const CBlockPar &bp, const std::wstring &source, const std::wstring &filename);
+};
+
+}  // namespace Base
@@ -3,10 +3,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the LICENSE file included
 
+#include <windows.h>
+
 #include <string>
 #include <algorithm>
 
 #include "CBlockPar.hpp"
+#include "BlockParImage.hpp"
 #include "CFile.hpp"
 #include "CException.hpp"
 
@@ -239,10 +242,67 @@ int ParamParser::GetCountPar(const wchar *ogsim) const {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+struct SKeyHash {
+    using is_transparent = void;
+    size_t operator()(std::wstring_view name) const { return std::hash<std::wstring_view>{}(name); }
+};
+
+// All the names ever given to units; an atom is the index of its name in m_Names.
+// Config may be read by the loading threads too, so the table is behind a slim lock.
+struct SKeyTable {
+    SRWLOCK m_Lock = SRWLOCK_INIT;
+    std::unordered_map<std::wstring, uint32_t, SKeyHash, std::equal_to<>> m_Atoms;
+    std::vector<const std::wstring *> m_Names;
+};
+
+// Taken by the first access to a block of an image, see CBlockPar::ExpandImage.
+SRWLOCK g_ExpandLock = SRWLOCK_INIT;
+
+SKeyTable &Keys()
+{
+    static SKeyTable keys;
+    return keys;
+}
+
+bool KeyFind(std::wstring_view name, uint32_t &atom)
+{
+    SKeyTable &keys = Keys();
+    AcquireSRWLockShared(&keys.m_Lock);
+    auto it = keys.m_Atoms.find(name);
+    bool found = it != keys.m_Atoms.end();
+    if (found)
+        atom = it->second;
+    ReleaseSRWLockShared(&keys.m_Lock);
+    return found;
+}
+
+uint32_t KeyAdd(std::wstring_view name)
+{
+    uint32_t atom;
+    if (KeyFind(name, atom))
+        return atom;
+
+    SKeyTable &keys = Keys();
+    AcquireSRWLockExclusive(&keys.m_Lock);
+    auto res = keys.m_Atoms.try_emplace(std::wstring{name}, uint32_t(keys.m_Names.size()));
+    if (res.second)
+        keys.m_Names.push_back(&res.first->first);
+    atom = res.first->second;
+    ReleaseSRWLockExclusive(&keys.m_Lock);
+    return atom;
+}
+
+}  // namespace
+
+////////////////////////////////////////////////////////////////////////////////
+
 CBlockParUnit::CBlockParUnit(Type type)
 : CMain{}
 , m_Parent{nullptr}
 , m_Type{type}
+, m_Atom{0}
 {
     DTRACE();
 
@@ -275,8 +335,8 @@ CBlockParUnit& CBlockParUnit::operator = (const CBlockParUnit& that)
 {
     // TODO: we don't check if unit has the same type here only because there
     // is only one usage of this function. but to be updated...
+    // The name is not copied either: the unit is indexed under the name given to UnitAdd.
     DTRACE();
-    m_Name = that.m_Name;
     m_Com = that.m_Com;
     if (isPar())
         *m_Par = *that.m_Par;
@@ -292,9 +352,6 @@ CBlockParUnit& CBlockParUnit::operator = (const CBlockParUnit& that)
 CBlockPar::CBlockPar() : CMain()
 {
     DTRACE();
-
-    m_CntPar = 0;
-    m_CntBlock = 0;
 }
 
 CBlockPar::~CBlockPar() {
@@ -305,52 +362,128 @@ CBlockPar::~CBlockPar() {
 void CBlockPar::Clear() {
     DTRACE();
 
-    m_CntPar = 0;
-    m_CntBlock = 0;
-
+    for (CBlockParUnit *el : m_Units)
+    {
+        delete el;
+    }
     m_Units.clear();
+    m_Pars.clear();
+    m_Blocks.clear();
+    m_Index.clear();
     m_FromFile.clear();
+
+    // the blocks made from the image are gone already
+    m_Image = nullptr;
+    m_ImageBlock = 0;
+    if (m_ImageOwner)
+    {
+        delete m_ImageOwner;
+        m_ImageOwner = nullptr;
+    }
 }
 
 void CBlockPar::CopyFrom(CBlockPar &bp) {
     DTRACE();
     Clear();
-    for(auto& el : bp.m_Units)
+    bp.Expand();
+    for(CBlockParUnit *el : bp.m_Units)
     {
-        CBlockParUnit& el2 = UnitAdd(el.m_Type);
-        el2 = el;
-
-        if (el.isPar())
-            m_CntPar++;
-        else if (el.isBlock())
-            m_CntBlock++;
+        CBlockParUnit& el2 = UnitAdd(el->m_Type, el->m_Name);
+        el2 = *el;
     }
 }
 
-CBlockParUnit& CBlockPar::UnitAdd(CBlockParUnit::Type type) {
+CBlockParUnit& CBlockPar::UnitAdd(CBlockParUnit::Type type, const std::wstring &name) {
     DTRACE();
+    Expand();
+    return UnitMake(type, name);
+}
 
-    m_Units.emplace_back(type);
+CBlockParUnit& CBlockPar::UnitMake(CBlockParUnit::Type type, const std::wstring &name) {
+    CBlockParUnit *el = new CBlockParUnit{type};
+    el->m_Parent = this;
+    el->m_Name = name;
+    m_Units.push_back(el);
 
-    m_Units.back().m_Parent = this;
+    if (el->isPar())
+        m_Pars.push_back(el);
+    else if (el->isBlock())
+        m_Blocks.push_back(el);
 
-    return m_Units.back();
+    if (!el->isEmpty())
+    {
+        el->m_Atom = KeyAdd(name);
+        m_Index[el->m_Atom].push_back(el);
+    }
+
+    return *el;
 }
 
 void CBlockPar::UnitDel(CBlockParUnit& el) {
     DTRACE();
 
+    auto res = std::ranges::find(m_Units, &el);
+    if (res == m_Units.end())
+    {
+        ERROR_S(L"Not a single unit removed by UnitDel call");
+    }
+    m_Units.erase(res);
+
+    auto drop = [&el](std::vector<CBlockParUnit *> &units) { units.erase(std::ranges::find(units, &el)); };
+
     if (el.isPar())
-        m_CntPar--;
+        drop(m_Pars);
     else if (el.isBlock())
-        m_CntBlock--;
+        drop(m_Blocks);
 
-    size_t removed = m_Units.remove_if([&el](auto& unit){ return &el == &unit; });
+    if (!el.isEmpty())
+    {
+        auto idx = m_Index.find(el.m_Atom);
+        drop(idx->second);
+        if (idx->second.empty())
+            m_Index.erase(idx);
+    }
 
-    if (removed != 1)
+    delete &el;
+}
+
+CBlockParUnit *CBlockPar::UnitFind(uint32_t atom, CBlockParUnit::Type type, int index) const
+{
+    Expand();
+    auto idx = m_Index.find(atom);
+    if (idx == m_Index.end())
+        return nullptr;
+
+    for (CBlockParUnit *el : idx->second)
     {
-        ERROR_S(L"Not a single unit removed by UnitDel call");
+        if ((type == CBlockParUnit::Type::Empty || el->m_Type == type) && (index-- == 0))
+            return el;
     }
+    return nullptr;
+}
+
+CBlockParUnit *CBlockPar::UnitFind(std::wstring_view name, CBlockParUnit::Type type, int index) const
+{
+    // a name which is not interned is not in any block
+    Expand();
+    uint32_t atom;
+    if (!KeyFind(name, atom))
+        return nullptr;
+    return UnitFind(atom, type, index);
+}
+
+int CBlockPar::UnitCount(std::wstring_view name, CBlockParUnit::Type type) const
+{
+    Expand();
+    uint32_t atom;
+    if (!KeyFind(name, atom))
+        return 0;
+
+    auto idx = m_Index.find(atom);
+    if (idx == m_Index.end())
+        return 0;
+
+    return std::ranges::count_if(idx->second, [type](const auto *el) { return el->m_Type == type; });
 }
 
 CBlockParUnit& CBlockPar::UnitGet(const std::wstring &path)
@@ -401,19 +534,8 @@ CBlockParUnit& CBlockPar::UnitGet(const std::wstring &path)
         }
         // end
 
-        int u = 0;
-        for(auto& el : us->m_Units)
-        {
-            if (el.m_Name == std::wstring{path.c_str() + name_sme, static_cast<size_t>(name_len)})
-            {
-                if (u == no)
-                {
-                    ne = &el;
-                    break;
-                }
-                u++;
-            }
-        }
+        ne = us->UnitFind(std::wstring_view{path.c_str() + name_sme, static_cast<size_t>(name_len)},
+                          CBlockParUnit::Type::Empty, no);
 
         if (ne == nullptr)
             ERROR_S2(L"Path not found: ", path.c_str());
@@ -429,17 +551,31 @@ CBlockParUnit& CBlockPar::UnitGet(const std::wstring &path)
     return *ne;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+SBlockParKey CBlockPar::Key(const std::wstring &name)
+{
+    return SBlockParKey{KeyAdd(name)};
+}
+
+std::wstring CBlockPar::KeyName(SBlockParKey key)
+{
+    SKeyTable &keys = Keys();
+    AcquireSRWLockShared(&keys.m_Lock);
+    std::wstring name = *keys.m_Names[key.m_Atom];
+    ReleaseSRWLockShared(&keys.m_Lock);
+    return name;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////////
 CBlockParUnit *CBlockPar::ParAdd(const std::wstring& name, const std::wstring& zn) {
     DTRACE();
-    CBlockParUnit& el = UnitAdd(CBlockParUnit::Type::Par);
-    el.m_Name = name;
+    CBlockParUnit& el = UnitAdd(CBlockParUnit::Type::Par, name);
     *(el.m_Par) = zn;
 
-    m_CntPar++;
-
     return &el;
 }
 
@@ -447,10 +583,9 @@ void CBlockPar::ParSetAdd(const std::wstring& name, const std::wstring& zn)
 {
     DTRACE();
 
-    auto pred = [&name](const auto& u) { return u.isPar() && (u.m_Name == name); };
-    auto res = std::ranges::find_if(m_Units, pred);
+    CBlockParUnit *res = UnitFind(name, CBlockParUnit::Type::Par, 0);
 
-    if (res == m_Units.end())
+    if (res == nullptr)
     {
         ParAdd(name, zn);
         return;
@@ -463,25 +598,31 @@ void CBlockPar::ParDelete(int no)
 {
     DTRACE();
 
-    auto pred = [&no](const auto& u) { return u.isPar() && (no-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
-
-    if (res == m_Units.end())
+    if (no < 0 || no >= ParCount())
     {
         ERROR_E;
     }
 
-    UnitDel(*res);
+    UnitDel(*m_Pars[no]);
 }
 
 ParamParser CBlockPar::ParGet(const std::wstring& name, int index) const
 {
     DTRACE();
 
-    auto pred = [&index, &name](const auto& u) { return u.isPar() && (u.m_Name == name) && (index-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
+    if (const CBlockParImage *image = Image())
+    {
+        const SBPImageUnit *u = image->FindPar(m_ImageBlock, name, index);
+        if (u == nullptr)
+        {
+            ERROR_S2(L"Not found: ", name.c_str());
+        }
+        return std::wstring{image->Str(u->m_Value)};
+    }
+
+    CBlockParUnit *res = UnitFind(name, CBlockParUnit::Type::Par, index);
 
-    if (res == m_Units.end())
+    if (res == nullptr)
     {
         ERROR_S2(L"Not found: ", name.c_str());
     }
@@ -493,10 +634,43 @@ ParamParser CBlockPar::ParGetNE(const std::wstring& name, int index) const
 {
     DTRACE();
 
-    auto pred = [&index, &name](const auto& u) { return u.isPar() && (u.m_Name == name) && (index-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
+    if (const CBlockParImage *image = Image())
+    {
+        const SBPImageUnit *u = image->FindPar(m_ImageBlock, name, index);
+        return u ? std::wstring{image->Str(u->m_Value)} : std::wstring();
+    }
 
-    if (res == m_Units.end())
+    CBlockParUnit *res = UnitFind(name, CBlockParUnit::Type::Par, index);
+
+    if (res == nullptr)
+    {
+        return std::wstring();
+    }
+
+    return *(res->m_Par);
+}
+
+ParamParser CBlockPar::ParGet(SBlockParKey key, int index) const
+{
+    DTRACE();
+
+    CBlockParUnit *res = UnitFind(key.m_Atom, CBlockParUnit::Type::Par, index);
+
+    if (res == nullptr)
+    {
+        ERROR_S2(L"Not found: ", KeyName(key).c_str());
+    }
+
+    return *(res->m_Par);
+}
+
+ParamParser CBlockPar::ParGetNE(SBlockParKey key, int index) const
+{
+    DTRACE();
+
+    CBlockParUnit *res = UnitFind(key.m_Atom, CBlockParUnit::Type::Par, index);
+
+    if (res == nullptr)
     {
         return std::wstring();
     }
@@ -508,38 +682,34 @@ int CBlockPar::ParCount(const std::wstring& name) const
 {
     DTRACE();
 
-    auto pred = [&name](const auto& u) { return u.isPar() && (u.m_Name == name); };
-    return std::ranges::count_if(m_Units, pred);
+    if (const CBlockParImage *image = Image())
+        return image->CountPar(m_ImageBlock, name);
+
+    return UnitCount(name, CBlockParUnit::Type::Par);
 }
 
 ParamParser CBlockPar::ParGet(int no) const
 {
     DTRACE();
 
-    auto pred = [&no](const auto& u) { return u.isPar() && (no-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
-
-    if (res == m_Units.end())
+    if (no < 0 || no >= ParCount())
     {
         ERROR_E;
     }
 
-    return *(res->m_Par);
+    return *(m_Pars[no]->m_Par);
 }
 
 ParamParser CBlockPar::ParGetName(int no) const
 {
     DTRACE();
 
-    auto pred = [&no](const auto& u) { return u.isPar() && (no-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
-
-    if (res == m_Units.end())
+    if (no < 0 || no >= ParCount())
     {
         ERROR_E;
     }
 
-    return res->m_Name;
+    return m_Pars[no]->m_Name;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -548,9 +718,7 @@ ParamParser CBlockPar::ParGetName(int no) const
 CBlockPar *CBlockPar::BlockAdd(const std::wstring& name)
 {
     DTRACE();
-    CBlockParUnit& el = UnitAdd(CBlockParUnit::Type::Block);
-    el.m_Name = name;
-    m_CntBlock++;
+    CBlockParUnit& el = UnitAdd(CBlockParUnit::Type::Block, name);
 
     return el.m_Block;
 }
@@ -559,10 +727,9 @@ CBlockPar *CBlockPar::BlockGetNE(const std::wstring& name)
 {
     DTRACE();
 
-    auto pred = [&name](const auto& u) { return u.isBlock() && (u.m_Name == name); };
-    auto res = std::ranges::find_if(m_Units, pred);
+    CBlockParUnit *res = UnitFind(name, CBlockParUnit::Type::Block, 0);
 
-    if (res == m_Units.end())
+    if (res == nullptr)
     {
         return nullptr;
     }
@@ -578,6 +745,28 @@ CBlockPar* CBlockPar::BlockGet(const std::wstring &name)
     return bp;
 }
 
+CBlockPar *CBlockPar::BlockGetNE(SBlockParKey key)
+{
+    DTRACE();
+
+    CBlockParUnit *res = UnitFind(key.m_Atom, CBlockParUnit::Type::Block, 0);
+
+    if (res == nullptr)
+    {
+        return nullptr;
+    }
+
+    return res->m_Block;
+}
+
+CBlockPar* CBlockPar::BlockGet(SBlockParKey key)
+{
+    CBlockPar *bp = BlockGetNE(key);
+    if (!bp)
+        ERROR_S2(L"Block not found: ", KeyName(key).c_str());
+    return bp;
+}
+
 CBlockPar* CBlockPar::BlockGetAdd(const std::wstring &name)
 {
     CBlockPar *bp = BlockGetNE(name);
@@ -591,10 +780,9 @@ void CBlockPar::BlockDelete(const std::wstring &name)
 {
     DTRACE();
 
-    auto pred = [&name](const auto& u) { return u.isBlock() && (u.m_Name == name); };
-    auto res = std::ranges::find_if(m_Units, pred);
+    CBlockParUnit *res = UnitFind(name, CBlockParUnit::Type::Block, 0);
 
-    if (res == m_Units.end())
+    if (res == nullptr)
     {
         ERROR_E;
     }
@@ -607,67 +795,54 @@ void CBlockPar::BlockDelete(int no)
 {
     DTRACE();
 
-    auto pred = [&no](const auto& u) { return u.isBlock() && (no-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
-
-    if (res == m_Units.end())
+    if (no < 0 || no >= BlockCount())
     {
         ERROR_E;
     }
 
-    UnitDel(*res);
+    UnitDel(*m_Blocks[no]);
 }
 
 int CBlockPar::BlockCount(const std::wstring& name) const
 {
     DTRACE();
 
-    auto pred = [&name](const auto& u) { return u.isBlock() && (u.m_Name == name); };
-    return std::ranges::count_if(m_Units, pred);
+    return UnitCount(name, CBlockParUnit::Type::Block);
 }
 
 CBlockPar* CBlockPar::BlockGet(int no)
 {
     DTRACE();
 
-    auto pred = [&no](const auto& u) { return u.isBlock() && (no-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
-
-    if (res == m_Units.end())
+    if (no < 0 || no >= BlockCount())
     {
         ERROR_E;
     }
 
-    return res->m_Block;
+    return m_Blocks[no]->m_Block;
 }
 
 const CBlockPar* CBlockPar::BlockGet(int no) const
 {
     DTRACE();
 
-    auto pred = [&no](const auto& u) { return u.isBlock() && (no-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
-
-    if (res == m_Units.end())
+    if (no < 0 || no >= BlockCount())
     {
         ERROR_E;
     }
 
-    return res->m_Block;
+    return m_Blocks[no]->m_Block;
 }
 
 ParamParser CBlockPar::BlockGetName(int no) const {
     DTRACE();
 
-    auto pred = [&no](const auto& u) { return u.isBlock() && (no-- == 0); };
-    auto res = std::ranges::find_if(m_Units, pred);
-
-    if (res == m_Units.end())
+    if (no < 0 || no >= BlockCount())
     {
         ERROR_E;
     }
 
-    return res->m_Name;
+    return m_Blocks[no]->m_Name;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -700,10 +875,8 @@ void CBlockPar::ParPathAdd(const std::wstring &path, const std::wstring &zn)
         //        name:=name;
         cd = this;
     }
-    CBlockParUnit& el = cd->UnitAdd(CBlockParUnit::Type::Par);
-    el.m_Name = name;
+    CBlockParUnit& el = cd->UnitAdd(CBlockParUnit::Type::Par, name);
     *(el.m_Par) = zn;
-    m_CntPar++;
 }
 
 void CBlockPar::ParPathSet(const std::wstring &path, const std::wstring &zn)
@@ -765,9 +938,7 @@ CBlockPar *CBlockPar::BlockPathAdd(const std::wstring &path)
     else {
         cd = this;
     }
-    CBlockParUnit& el = cd->UnitAdd(CBlockParUnit::Type::Block);
-    el.m_Name = name;
-    m_CntBlock++;
+    CBlockParUnit& el = cd->UnitAdd(CBlockParUnit::Type::Block, name);
     return el.m_Block;
 }
 
@@ -937,7 +1108,7 @@ public:
 
         while (m_Line < m_TextLen) {
             if (m_Line >= m_ComSpace) {
-                CBlockParUnit& unit = m_BP->UnitAdd(CBlockParUnit::Type::Empty);
+                CBlockParUnit& unit = m_BP->UnitAdd(CBlockParUnit::Type::Empty, std::wstring{});
                 if (m_ComSpace < m_LineEnd)
                     unit.m_Com = std::wstring{m_Text + m_ComSpace, static_cast<size_t>(m_LineEnd - m_ComSpace)};
             }
@@ -952,14 +1123,15 @@ public:
                 m_WordBegin = m_Line;
                 m_WordSearchEnd = m_Block;
 
-                CBlockParUnit& unit = m_BP->UnitAdd(CBlockParUnit::Type::Block);
-                m_BP->m_CntBlock++;
-
+                // the unit is indexed by its name, so the name goes first
+                std::wstring name;
                 if (WordFindBlockName()) {
-                    unit.m_Name = std::wstring{m_Text + m_WordBegin, static_cast<size_t>(m_WordEnd - m_WordBegin)};
+                    name = std::wstring{m_Text + m_WordBegin, static_cast<size_t>(m_WordEnd - m_WordBegin)};
                     m_WordBegin = m_WordEnd;
                 }
 
+                CBlockParUnit& unit = m_BP->UnitAdd(CBlockParUnit::Type::Block, name);
+
                 m_FileBegin = m_FileEnd = -1;
 
                 while (WordFindOption()) {
@@ -1013,18 +1185,15 @@ public:
                 }
             }
             else if (FindPar()) {
-                CBlockParUnit& unit = m_BP->UnitAdd(CBlockParUnit::Type::Par);
-                m_BP->m_CntPar++;
-
-                unit.m_Name = std::wstring{m_Text + m_Line, static_cast<size_t>(ParNameSize())};
+                CBlockParUnit& unit =
+                        m_BP->UnitAdd(CBlockParUnit::Type::Par, std::wstring{m_Text + m_Line, static_cast<size_t>(ParNameSize())});
                 *(unit.m_Par) = std::wstring{m_Text + m_Par + 1, static_cast<size_t>(m_ComSpace - (m_Par + 1))};
 
                 if (m_ComSpace < m_LineEnd)
                     unit.m_Com = std::wstring{m_Text + m_ComSpace, static_cast<size_t>(m_LineEnd - m_ComSpace)};
             }
             else {
-                CBlockParUnit& unit = m_BP->UnitAdd(CBlockParUnit::Type::Par);
-                m_BP->m_CntPar++;
+                CBlockParUnit& unit = m_BP->UnitAdd(CBlockParUnit::Type::Par, std::wstring{});
 
                 *(unit.m_Par) = std::wstring{m_Text + m_Line, static_cast<size_t>(m_ComSpace - m_Line)};
 
@@ -1087,6 +1256,7 @@ void CBlockPar::LoadFromTextFile(const std::wstring &filename) {
 
 void CBlockPar::SaveInText(CBuf &buf, bool ansi, int level) {
     DTRACE();
+    Expand();
 
 #define SaveLevel                      \
     {                                  \
@@ -1126,8 +1296,9 @@ void CBlockPar::SaveInText(CBuf &buf, bool ansi, int level) {
 
     bool addspace;
 
-    for(auto& unit : m_Units)
+    for(CBlockParUnit *el : m_Units)
     {
+        CBlockParUnit& unit = *el;
         SaveLevel;
 
         if (unit.isPar()) {
@@ -1201,4 +1372,68 @@ void CBlockPar::SaveInTextFile(const std::wstring &filename, bool ansi)
     fi.Close();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+void CBlockPar::ExpandImage(void)
+{
+    DTRACE();
+
+    AcquireSRWLockExclusive(&g_ExpandLock);
+
+    // another thread may have made the units meanwhile
+    const CBlockParImage *image = m_Image.load(std::memory_order_relaxed);
+    if (image)
+    {
+        const SBPImageBlock &b = image->Block(m_ImageBlock);
+        for (DWORD i = 0; i < b.m_Cnt; ++i)
+        {
+            const SBPImageUnit &u = image->Unit(b.m_First + i);
+            CBlockParUnit& el = UnitMake(CBlockParUnit::Type(u.m_Type), std::wstring{image->Str(u.m_Name)});
+            el.m_Com = image->Str(u.m_Com);
+
+            if (el.isPar())
+            {
+                *(el.m_Par) = image->Str(u.m_Value);
+            }
+            else if (el.isBlock())
+            {
+                el.m_Block->m_Image.store(image, std::memory_order_relaxed);
+                el.m_Block->m_ImageBlock = u.m_Value;
+                el.m_Block->m_FromFile = image->Str(image->Block(u.m_Value).m_FromFile);
+            }
+        }
+
+        // the units are published with it
+        m_Image.store(nullptr, std::memory_order_release);
+    }
+
+    ReleaseSRWLockExclusive(&g_ExpandLock);
+}
+
+bool CBlockPar::LoadFromImage(const std::wstring &filename)
+{
+    DTRACE();
+
+    CBlockParImage *image = new CBlockParImage;
+    if (!image->Open(filename) || !image->IsFresh())
+    {
+        delete image;
+        return false;
+    }
+
+    Clear();
+    m_Image = image;
+    m_ImageBlock = 0;
+    m_ImageOwner = image;
+    m_FromFile = image->Str(image->Block(0).m_FromFile);
+    return true;
+}
+
+void CBlockPar::SaveInImage(const std::wstring &filename, const std::wstring &source) const
+{
+    DTRACE();
+    CBlockParImage::Compile(*this, source, filename);
+}
+
 }  // namespace Base
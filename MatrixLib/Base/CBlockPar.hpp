@@ -5,8 +5,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
-#include <list>
+#include <string_view>
+#include <unordered_map>
 
 #include "CMain.hpp"
 #include "CHeap.hpp"
@@ -18,6 +20,8 @@ namespace Base {
 
 class CBlockPar;
 class BPCompiler;
+class BPImageCompiler;
+class CBlockParImage;
 
 class ParamParser : public std::wstring
 {
@@ -58,9 +62,21 @@ public:
     ParamParser GetStrPar(int nps, int npe, const wchar *ogsim) const;
 };
 
+/**
+ * @brief Interned name of a parameter or a block.
+ *
+ * Equal names give equal keys, so a lookup by key hashes and compares a single integer.
+ * Keys stay valid for the whole run: get them once with CBlockPar::Key and keep them.
+ */
+struct SBlockParKey {
+    uint32_t m_Atom;
+};
+
 class BASE_API CBlockParUnit : public CMain {
     friend CBlockPar;
     friend BPCompiler;
+    friend BPImageCompiler;
+    friend CBlockParImage;
 
 private:
     CBlockPar *m_Parent;
@@ -74,6 +90,7 @@ private:
     const Type m_Type;
 
     std::wstring m_Name;
+    uint32_t m_Atom;    // interned m_Name
     std::wstring m_Com; // Seems like Com is a comment inside of .dat
     union {
         std::wstring *m_Par;
@@ -114,18 +131,40 @@ private:
  * The name "BlockPar" means "Blocks of Parameters". You can think of parameters as of files which can have any content or value.
  * You can think of blocks as of directories which can hold any number of children sub-directories or files(parameters).
  * One interesting thing is that it is possible to have multiple parameters with the same name at the same path.
+ *
+ * Units are kept in the file order. Each block indexes its units by the interned name (SBlockParKey), and the
+ * parameters and blocks by their number, so that lookups do not scan the block. Units with the same name stay
+ * in the file order within the index, which is what the index argument of ParGet and the "name:no" paths count.
+ *
+ * A block loaded from a compiled image (LoadFromImage) makes its units only when it is accessed the first time.
+ * The loading threads read the config too, so the units are made under a lock and the image is dropped only
+ * after them: a reader sees either the image or all the units.
  */
 class BASE_API CBlockPar : public CMain
 {
     friend BPCompiler;
+    friend BPImageCompiler;
 
 private:
-    std::list<CBlockParUnit> m_Units;
-
-    int m_CntPar;
-    int m_CntBlock;
+    std::vector<CBlockParUnit *> m_Units;
+    std::vector<CBlockParUnit *> m_Pars;
+    std::vector<CBlockParUnit *> m_Blocks;
+    std::unordered_map<uint32_t, std::vector<CBlockParUnit *>> m_Index;  // by name, empty units are not there
 
     std::wstring m_FromFile;
+
+    // units not made yet: they are in the block of the image
+    std::atomic<const CBlockParImage *> m_Image{nullptr};
+    uint32_t m_ImageBlock{0};
+    CBlockParImage *m_ImageOwner{nullptr};  // root of the image
+
+    const CBlockParImage *Image(void) const { return m_Image.load(std::memory_order_acquire); }
+    void Expand(void) const {
+        if (Image())
+            const_cast<CBlockPar *>(this)->ExpandImage();
+    }
+    void ExpandImage(void);
+
 public:
     CBlockPar();
     ~CBlockPar();
@@ -135,12 +174,23 @@ public:
     void CopyFrom(CBlockPar &bp);
 
 private:
-    CBlockParUnit& UnitAdd(CBlockParUnit::Type type);
+    CBlockParUnit& UnitAdd(CBlockParUnit::Type type, const std::wstring &name);
+    CBlockParUnit& UnitMake(CBlockParUnit::Type type, const std::wstring &name);  // UnitAdd without Expand
     void UnitDel(CBlockParUnit& el);
     CBlockParUnit& UnitGet(const std::wstring &path);
 
+    // index-th unit of the type with the name, any type if Empty
+    CBlockParUnit *UnitFind(uint32_t atom, CBlockParUnit::Type type, int index) const;
+    CBlockParUnit *UnitFind(std::wstring_view name, CBlockParUnit::Type type, int index) const;
+    int UnitCount(std::wstring_view name, CBlockParUnit::Type type) const;
+
     //////////////////////////////////////////////////////////////
 public:
+    static SBlockParKey Key(const std::wstring &name);
+    static std::wstring KeyName(SBlockParKey key);
+
+    //////////////////////////////////////////////////////////////
+
     CBlockParUnit *ParAdd(const std::wstring& name, const std::wstring& zn);
 
     void ParSetAdd(const std::wstring &name, const std::wstring &zn);
@@ -154,8 +204,13 @@ public:
 
     ParamParser ParGet(const std::wstring& name, int index = 0) const;
     ParamParser ParGetNE(const std::wstring& name, int index = 0) const;
+    ParamParser ParGet(SBlockParKey key, int index = 0) const;
+    ParamParser ParGetNE(SBlockParKey key, int index = 0) const;
 
-    int ParCount(void) const { return m_CntPar; }
+    int ParCount(void) const {
+        Expand();
+        return int(m_Pars.size());
+    }
     int ParCount(const std::wstring &name) const;
 
     ParamParser ParGet(int no) const;
@@ -166,13 +221,18 @@ public:
     CBlockPar *BlockAdd(const std::wstring& name);
     CBlockPar *BlockGetNE(const std::wstring &name);
     CBlockPar *BlockGet(const std::wstring &name);
+    CBlockPar *BlockGetNE(SBlockParKey key);
+    CBlockPar *BlockGet(SBlockParKey key);
 
     CBlockPar *BlockGetAdd(const std::wstring &name);
 
     void BlockDelete(const std::wstring &name);
     void BlockDelete(int no);
 
-    int BlockCount(void) const { return m_CntBlock; }
+    int BlockCount(void) const {
+        Expand();
+        return int(m_Blocks.size());
+    }
     int BlockCount(const std::wstring &name) const;
 
     CBlockPar *BlockGet(int no);
@@ -202,6 +262,11 @@ public:
     int LoadFromText(const std::wstring &text);
     void LoadFromTextFile(const std::wstring &filename);
     void SaveInTextFile(const std::wstring &filename, bool ansi = false);
+
+    // Compiled image of the block: it is mapped, not parsed. source is the file the block was loaded from,
+    // the image is not loaded anymore once that file or a file included by it has changed.
+    bool LoadFromImage(const std::wstring &filename);
+    void SaveInImage(const std::wstring &filename, const std::wstring &source) const;
 };
 
 }  // namespace Base
\ No newline at end of file
@@ -68,6 +68,13 @@ size_t CBuf::WStrTextLen(void) {
 void CBuf::LoadFromFile(const std::wstring &filename)
 {
     Clear();
+
+    std::span<const std::byte> view;
+    if (CFile::GetView(filename, view)) {
+        m_Buf.assign((const uint8_t *)view.data(), (const uint8_t *)view.data() + view.size());
+        return;
+    }
+
     CFile file(filename.c_str(), filename.length());
     file.OpenRead();
     Len(file.Size());
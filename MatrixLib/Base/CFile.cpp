@@ -43,6 +43,27 @@ void CFile::ReleasePackFiles(void) {
 }
 #endif
 
+bool CFile::GetView([[maybe_unused]] const std::wstring &filename, [[maybe_unused]] std::span<const std::byte> &view) {
+#ifndef MAXEXP_EXPORTS
+    if (m_Packs == NULL)
+        return false;
+
+    DWORD attr;
+    if (IS_UNICODE()) {
+        attr = GetFileAttributesW(filename.c_str());
+    }
+    else {
+        attr = GetFileAttributesA(utils::from_wstring(filename).c_str());
+    }
+    if (attr != INVALID_FILE_ATTRIBUTES)
+        return false;
+
+    return m_Packs->GetView(utils::from_wstring(filename), view);
+#else
+    return false;
+#endif
+}
+
 CFile::CFile() : CMain(), m_FileName{} {
 #ifndef MAXEXP_EXPORTS
     m_PackHandle = 0xFFFFFFFF;
@@ -8,6 +8,8 @@
 #include "CMain.hpp"
 
 #include <windows.h>
+#include <cstddef>
+#include <span>
 #include <string>
 
 namespace Base {
@@ -50,6 +52,11 @@ public:
     static void ReleasePackFiles(void);
 #endif
 
+    // Bytes of a file stored uncompressed in a package, right in the mapped package: no copy and no handle.
+    // False if the file is on disk (it is taken first, as by OpenRead), is compressed or is not in a package.
+    // The view is valid until ReleasePackFiles.
+    static bool GetView(const std::wstring &filename, std::span<const std::byte> &view);
+
     static void FindFiles(const std::wstring &folderfrom, const wchar *files, ENUM_FILES ef, DWORD user);
 
     void Clear(void);
@@ -7,6 +7,7 @@
 
 #include "CStorage.hpp"
 #include "CRC32.hpp"
+#include "CFile.hpp"
 
 #undef ZEXPORT
 #define ZEXPORT __cdecl
@@ -15,7 +16,7 @@
 
 namespace Base {
 
-static int ZL03_UnCompress(CBuf &out, BYTE *in, int inlen) {
+static int ZL03_UnCompress(CBuf &out, const BYTE *in, int inlen) {
     out.Clear();
 
     if (inlen < 8)
@@ -23,7 +24,7 @@ static int ZL03_UnCompress(CBuf &out, BYTE *in, int inlen) {
     if (*(in + 0) != 'Z' || *(in + 1) != 'L' || *(in + 2) != '0' || *(in + 3) != '3')
         return 0;
 
-    int cnt = *(int *)(in + 4);
+    int cnt = *(const int *)(in + 4);
 
     int optr = 0;
     int iptr = 8;
@@ -33,7 +34,7 @@ static int ZL03_UnCompress(CBuf &out, BYTE *in, int inlen) {
         out.Expand(65000);
 
         DWORD len = out.Len() - optr;
-        int szb = *(DWORD *)(in + iptr);
+        int szb = *(const DWORD *)(in + iptr);
         if (uncompress(out.Buff<BYTE>() + optr, &len, in + iptr + 4, szb) != Z_OK) {
             out.Clear();
             return 0;
@@ -99,6 +100,26 @@ static void ZL03_Compression(CBuf &out, BYTE *in, int inlen) {
     *(DWORD *)(out.Buff<BYTE>() + 4) = cnt;
 }
 
+// readers of a storage image: take the value from the front of data
+static bool StorageGet(std::span<const std::byte> &data, DWORD &v) {
+    if (data.size() < sizeof(DWORD))
+        return false;
+    memcpy(&v, data.data(), sizeof(DWORD));
+    data = data.subspan(sizeof(DWORD));
+    return true;
+}
+
+static bool StorageGet(std::span<const std::byte> &data, std::wstring &str) {
+    for (size_t i = 0; i + 1 < data.size(); i += 2) {
+        if (data[i] == std::byte{0} && data[i + 1] == std::byte{0}) {
+            str.assign((const wchar *)data.data(), i >> 1);
+            data = data.subspan(i + 2);
+            return true;
+        }
+    }
+    return false;
+}
+
 CStorageRecordItem::~CStorageRecordItem() {}
 
 void CStorageRecordItem::InitBuf(CHeap *heap) {
@@ -138,23 +159,26 @@ void CStorageRecordItem::Save(CBuf &buf, bool compression) {
         buf.Add(m_Buf->Get(), m_Buf->Len());
     }
 }
-bool CStorageRecordItem::Load(CBuf &buf) {
+bool CStorageRecordItem::Load(std::span<const std::byte> &data) {
     ASSERT(m_Buf);
 
-    m_Name = buf.WStr();
-    m_Type = (EStorageType)buf.Get<DWORD>();
-    DWORD sz = buf.Get<DWORD>();
+    DWORD type, sz;
+    if (!StorageGet(data, m_Name) || !StorageGet(data, type) || !StorageGet(data, sz) || data.size() < sz)
+        return false;
+    m_Type = (EStorageType)type;
 
     if (m_Type & ST_COMPRESSED) {
         m_Type = (EStorageType)(m_Type & ST_COMPRESSED);
-        if (0 == ZL03_UnCompress(*m_Buf, buf.Buff<BYTE>() + buf.Pointer(), sz))
+        if (0 == ZL03_UnCompress(*m_Buf, (const BYTE *)data.data(), sz))
             return false;
     }
     else {
         m_Buf->Clear();
         m_Buf->Expand(sz);
-        buf.Get(m_Buf->Get(), sz);
+        if (sz)
+            memcpy(m_Buf->Get(), data.data(), sz);
     }
+    data = data.subspan(sz);
 
     return true;
 }
@@ -209,7 +233,7 @@ DWORD CStorageRecord::CalcUniqID(DWORD xi) {
     return x;
 }
 
-bool CStorageRecord::Load(CBuf &buf) {
+bool CStorageRecord::Load(std::span<const std::byte> &data) {
     if (m_Items) {
         for (int i = 0; i < m_ItemsCount; ++i) {
             m_Items[i].ReleaseBuf(m_Heap);
@@ -219,15 +243,18 @@ bool CStorageRecord::Load(CBuf &buf) {
         m_Items = NULL;
     }
 
-    m_Name = buf.WStr();
-    m_ItemsCount = buf.Get<DWORD>();
+    DWORD cnt;
+    m_ItemsCount = 0;
+    if (!StorageGet(data, m_Name) || !StorageGet(data, cnt))
+        return false;
+    m_ItemsCount = cnt;
     if (m_ItemsCount == 0)
         return true;
 
     m_Items = (CStorageRecordItem *)HAlloc(sizeof(CStorageRecordItem) * m_ItemsCount, m_Heap);
     for (int i = 0; i < m_ItemsCount; ++i) {
         new(&m_Items[i]) CStorageRecordItem(m_Heap);
-        if (!m_Items[i].Load(buf)) {
+        if (!m_Items[i].Load(data)) {
             for (int j = 0; j <= i; ++j) {
                 m_Items[j].ReleaseBuf(m_Heap);
                 m_Items[j].~CStorageRecordItem();
@@ -320,6 +347,11 @@ void CStorage::Save(const wchar *fname, bool compression) {
 }
 
 bool CStorage::Load(const wchar *fname) {
+    std::span<const std::byte> view;
+    if (CFile::GetView(fname, view)) {
+        return Load(view);
+    }
+
     CBuf buf;
     buf.LoadFromFile(fname);
     return Load(buf);
@@ -345,26 +377,31 @@ void CStorage::Save(CBuf &buf, bool compression) {
     }
 }
 
-bool CStorage::Load(CBuf &buf_in) {
-    buf_in.Pointer(0);
-    DWORD tag = buf_in.Get<DWORD>();
-    if (tag != 0x47525453)
+bool CStorage::Load(CBuf &buf) {
+    return Load(std::span<const std::byte>((const std::byte *)buf.Get(), buf.Len()));
+}
+
+bool CStorage::Load(std::span<const std::byte> data) {
+    DWORD tag, ver;
+    if (!StorageGet(data, tag) || tag != 0x47525453 || !StorageGet(data, ver))
         return false;
-    DWORD ver = buf_in.Get<DWORD>();
 
     if (ver > 1)
         return false;
 
-    CBuf buf2;
-    CBuf *buf = &buf_in;
-
     if (ver == 1) {
         // compression!
-        ZL03_UnCompress(buf2, buf_in.Buff<BYTE>() + 8, buf_in.Len() - 8);
-        buf = &buf2;
-        buf2.Pointer(0);
+        CBuf buf;
+        ZL03_UnCompress(buf, (const BYTE *)data.data(), int(data.size()));
+        std::span<const std::byte> image((const std::byte *)buf.Get(), buf.Len());
+        return LoadRecords(image);
     }
 
+    // uncompressed image is parsed in place
+    return LoadRecords(data);
+}
+
+bool CStorage::LoadRecords(std::span<const std::byte> &data) {
     if (m_Records) {
         for (int i = 0; i < m_RecordsCnt; ++i) {
             m_Records[i].~CStorageRecord();
@@ -373,14 +410,18 @@ bool CStorage::Load(CBuf &buf_in) {
         m_Records = NULL;
     }
 
-    m_RecordsCnt = buf->Get<DWORD>();
+    DWORD cnt;
+    m_RecordsCnt = 0;
+    if (!StorageGet(data, cnt))
+        return false;
+    m_RecordsCnt = cnt;
     if (m_RecordsCnt == 0)
         return true;
 
     m_Records = (CStorageRecord *)HAlloc(sizeof(CStorageRecord) * m_RecordsCnt, m_Heap);
     for (int i = 0; i < m_RecordsCnt; ++i) {
         new(&m_Records[i]) CStorageRecord(m_Heap);
-        if (!m_Records[i].Load(*buf)) {
+        if (!m_Records[i].Load(data)) {
             for (int j = 0; j <= i; ++j) {
                 m_Records[j].~CStorageRecord();
             }
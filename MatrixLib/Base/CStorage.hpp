@@ -7,6 +7,8 @@
 #define STORAGE_INCLUDE
 
 #include <windows.h>
+#include <cstddef>
+#include <span>
 
 #include "CHeap.hpp"
 #include "CException.hpp"
@@ -256,7 +258,7 @@ public:
     DWORD CalcUniqID(DWORD x);
 
     void Save(CBuf &buf, bool compression);
-    bool Load(CBuf &buf);
+    bool Load(std::span<const std::byte> &data);
 };
 
 class CStorageRecord : public CMain {
@@ -281,7 +283,7 @@ public:
     DWORD CalcUniqID(DWORD x);
 
     void Save(CBuf &buf, bool compression);
-    bool Load(CBuf &buf);
+    bool Load(std::span<const std::byte> &data);
 };
 
 class CStorage : public CMain {
@@ -290,6 +292,8 @@ class CStorage : public CMain {
     CStorageRecord *m_Records;
     int m_RecordsCnt;
 
+    bool LoadRecords(std::span<const std::byte> &data);
+
 public:
     CStorage(CHeap *heap = NULL);
     ~CStorage();
@@ -309,6 +313,8 @@ public:
 
     void Save(CBuf &buf, bool compression = false);
     bool Load(CBuf &buf);
+    // image of a storage file, e.g. CFile::GetView
+    bool Load(std::span<const std::byte> data);
 
     void StoreBlockPar(const wchar *root, const CBlockPar &bp);
     void RestoreBlockPar(const wchar *root, CBlockPar &bp);
@@ -115,7 +115,7 @@ static int OKGF_ZLib_UnCompress(BYTE *desbuf, int lendesbuf, BYTE *soubuf, int l
 // if desbuf==NULL then return размер выходного буфера
 // return размер выходного буфера
 // return 0 если ошибка
-int OKGF_ZLib_UnCompress2(BYTE *desbuf, int len_des_buf, BYTE *soubuf, int len_sou_buf) {
+int OKGF_ZLib_UnCompress2(BYTE *desbuf, int len_des_buf, const BYTE *soubuf, int len_sou_buf) {
     DWORD deslen = len_des_buf;
 
     if (len_sou_buf < 8)
@@ -1508,6 +1508,10 @@ CPackFile::CPackFile(CHeap *heap, const wchar *name) : m_Heap(heap), m_FileName{
 
     m_RootFolder = NULL;
     m_RootOffset = 0;
+    m_Mapping = NULL;
+    m_View = NULL;
+    m_ViewSize = 0;
+    m_Inflater = NULL;
     // m_ID = 0xFFFFFFFF;
     for (int i = 0; i < MAX_VIRTUAL_HANDLE_COUNT; ++i) {
         m_Handles[i].m_Free = true;
@@ -1578,9 +1582,44 @@ bool CPackFile::OpenPacketFile(void) {
 #endif
         return false;
     }
+    MapView();
     return true;
 }
 
+void CPackFile::MapView(void) {
+    DWORD size = ::GetFileSize((HANDLE)m_Handle, NULL);
+    if (size == INVALID_FILE_SIZE || size < 4)
+        return;
+
+    m_Mapping = CreateFileMappingW((HANDLE)m_Handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_Mapping == NULL)
+        return;
+
+    m_View = (const BYTE *)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_View == NULL) {
+        // no address space for it: keep reading through the file handle
+        CloseHandle(m_Mapping);
+        m_Mapping = NULL;
+        return;
+    }
+    m_ViewSize = size;
+}
+
+void CPackFile::UnmapView(void) {
+    if (m_View) {
+        if (m_Inflater) {
+            m_Inflater->Purge(m_View, m_ViewSize);
+        }
+        UnmapViewOfFile(m_View);
+        m_View = NULL;
+    }
+    if (m_Mapping) {
+        CloseHandle(m_Mapping);
+        m_Mapping = NULL;
+    }
+    m_ViewSize = 0;
+}
+
 bool CPackFile::ClosePacketFile(void) {
     if (m_Handle == 0xFFFFFFFF && m_RootFolder == NULL)
         return false;
@@ -1589,6 +1628,7 @@ bool CPackFile::ClosePacketFile(void) {
         HDelete(CHsFolder, m_RootFolder, m_Heap);
         m_RootFolder = NULL;
     }
+    UnmapView();
     bool res;
     if (m_Handle != 0xFFFFFFFF) {
         res = CloseHandle((HANDLE)m_Handle) != FALSE;
@@ -1735,6 +1775,7 @@ DWORD CPackFile::Open(
         m_Handles[H].m_Size = ::GetFileSize((HANDLE)m_Handles[H].m_Handle, NULL);
         m_Handles[H].m_SouBuf = NULL;
         m_Handles[H].m_DesBuf = NULL;
+        m_Handles[H].m_Inflated = NULL;
         m_Handles[H].m_Compressed = false;
         m_Handles[H].m_Blocknumber = -1;
         if (m_Handles[H].m_Size == INVALID_FILE_SIZE) {
@@ -1753,6 +1794,14 @@ DWORD CPackFile::Open(
 #endif
     }
 
+    return Open(PFile, filename);
+}
+
+DWORD CPackFile::Open(SFileRec *PFile, const std::string& filename) {
+    int H = GetFreeHandle();
+    if (H < 0)
+        return 0xFFFFFFFF;
+
     // *** Файл был найден внутри пакетного файла - открываем его для чтения ***
     if (m_Handle == 0xFFFFFFFF)
         return 0xFFFFFFFF;
@@ -1764,14 +1813,25 @@ DWORD CPackFile::Open(
     m_Handles[H].m_Free = false;
     m_Handles[H].m_Compressed = PFile->m_Type == FILEEC_COMPRESSED;
     m_Handles[H].m_Blocknumber = -1;
+    m_Handles[H].m_SouBuf = NULL;
+    m_Handles[H].m_DesBuf = NULL;
+    m_Handles[H].m_Inflated = NULL;
     if (m_Handles[H].m_Compressed) {
-        m_Handles[H].m_SouBuf = (BYTE *)HAlloc(72112, m_Heap);
-        m_Handles[H].m_DesBuf = (BYTE *)HAlloc(65536, m_Heap);
+        if (m_Inflater && m_View && m_Handles[H].m_StartOffset < m_ViewSize) {
+            m_Handles[H].m_Inflated =
+                    m_Inflater->Acquire(m_View + m_Handles[H].m_StartOffset, m_View + m_ViewSize, PFile->m_RealSize);
+        }
+        if (m_Handles[H].m_Inflated == NULL) {
+            // compressed blocks of a mapped package are unpacked right from the view
+            if (m_View == NULL) {
+                m_Handles[H].m_SouBuf = (BYTE *)HAlloc(72112, m_Heap);
+            }
+            m_Handles[H].m_DesBuf = (BYTE *)HAlloc(65536, m_Heap);
+        }
+    }
+    if (m_View) {
+        return H;
     }
-    else {
-        m_Handles[H].m_SouBuf = NULL;
-        m_Handles[H].m_DesBuf = NULL;
-    };
     DWORD Error = SetFilePointer((HANDLE)m_Handles[H].m_Handle, m_Handles[H].m_Offset, NULL, FILE_BEGIN);
     if (Error == 0xFFFFFFFF) {
         ERROR_S(utils::format(L"Packet file system error: %ls", utils::to_wstring(filename).c_str()));
@@ -1790,10 +1850,18 @@ bool CPackFile::Close(DWORD Handle) {
 
     if (m_Handles[Handle].m_Handle == m_Handle) {
         // in pack file
+        if (m_Handles[Handle].m_Inflated) {
+            m_Inflater->Release(m_Handles[Handle].m_Inflated);
+            m_Handles[Handle].m_Inflated = NULL;
+        }
         if (m_Handles[Handle].m_Compressed) {
-            HFree(m_Handles[Handle].m_SouBuf, m_Heap);
+            if (m_Handles[Handle].m_SouBuf) {
+                HFree(m_Handles[Handle].m_SouBuf, m_Heap);
+            }
             m_Handles[Handle].m_SouBuf = NULL;
-            HFree(m_Handles[Handle].m_DesBuf, m_Heap);
+            if (m_Handles[Handle].m_DesBuf) {
+                HFree(m_Handles[Handle].m_DesBuf, m_Heap);
+            }
             m_Handles[Handle].m_DesBuf = NULL;
         }
         m_Handles[Handle].m_Free = true;
@@ -1833,6 +1901,22 @@ DWORD CPackFile::SetCompressedBlockPointer(DWORD StartOffset, int nBlock) {
     return Size;
 }
 
+const BYTE *CPackFile::GetCompressedBlock(DWORD StartOffset, int nBlock, DWORD &Size) const {
+    DWORD Offset = StartOffset;
+    for (;;) {
+        if (Offset > m_ViewSize - 4)
+            return NULL;
+        Size = *(const DWORD *)(m_View + Offset);
+        if (nBlock == 0)
+            break;
+        --nBlock;
+        Offset += Size + 4;
+    }
+    if (Size > m_ViewSize - Offset - 4)
+        return NULL;
+    return m_View + Offset + 4;
+}
+
 bool CPackFile::Read(DWORD Handle, void *buf, int Size) {
     DWORD Temp;
     int Block;
@@ -1854,6 +1938,15 @@ bool CPackFile::Read(DWORD Handle, void *buf, int Size) {
     if (m_Handles[Handle].m_Free)
         return false;
 
+    if (m_Handles[Handle].m_Inflated) {
+        DWORD Offset = m_Handles[Handle].m_Offset - m_Handles[Handle].m_StartOffset;
+        if (Offset > m_Handles[Handle].m_Size || DWORD(Size) > m_Handles[Handle].m_Size - Offset)
+            return false;
+        memcpy(buf, m_Handles[Handle].m_Inflated + Offset, Size);
+        m_Handles[Handle].m_Offset += Size;
+        return true;
+    }
+
     // *** Установка указателя на нужную позицию
     if (m_Handles[Handle].m_Compressed) {
         //  Определение номера блока, с которого начинаются читаемые данные
@@ -1872,12 +1965,21 @@ bool CPackFile::Read(DWORD Handle, void *buf, int Size) {
 
             // Если блок не был расжат заранее, то расжимаем его
             if (m_Handles[Handle].m_Blocknumber != Block) {
-                CompSize = SetCompressedBlockPointer(m_Handles[Handle].m_StartOffset, Block);
-                BOOL res = ::ReadFile((HANDLE)m_Handle, m_Handles[Handle].m_SouBuf, CompSize, &Temp, NULL);
-                if (res == FALSE)
-                    return false;
+                const BYTE *CompBuf;
+                if (m_View) {
+                    CompBuf = GetCompressedBlock(m_Handles[Handle].m_StartOffset, Block, CompSize);
+                    if (CompBuf == NULL)
+                        return false;
+                }
+                else {
+                    CompSize = SetCompressedBlockPointer(m_Handles[Handle].m_StartOffset, Block);
+                    BOOL res = ::ReadFile((HANDLE)m_Handle, m_Handles[Handle].m_SouBuf, CompSize, &Temp, NULL);
+                    if (res == FALSE)
+                        return false;
+                    CompBuf = m_Handles[Handle].m_SouBuf;
+                }
 
-                OKGF_ZLib_UnCompress2(m_Handles[Handle].m_DesBuf, 65536, m_Handles[Handle].m_SouBuf, CompSize);
+                OKGF_ZLib_UnCompress2(m_Handles[Handle].m_DesBuf, 65536, CompBuf, CompSize);
 
                 m_Handles[Handle].m_Blocknumber = Block;
             }
@@ -1889,6 +1991,14 @@ bool CPackFile::Read(DWORD Handle, void *buf, int Size) {
         }
         return true;
     }
+    else if (m_View && m_Handles[Handle].m_Handle == m_Handle) {
+        // as ReadFile: short only at the end of the package
+        DWORD Offset = m_Handles[Handle].m_Offset;
+        DWORD Cnt = Offset < m_ViewSize ? std::min(DWORD(Size), m_ViewSize - Offset) : 0;
+        memcpy(buf, m_View + Offset, Cnt);
+        m_Handles[Handle].m_Offset = Offset + Cnt;
+        return Cnt == DWORD(Size);
+    }
     else {
         ::SetFilePointer((HANDLE)m_Handles[Handle].m_Handle, m_Handles[Handle].m_Offset, NULL, FILE_BEGIN);
         BOOL res = ::ReadFile((HANDLE)m_Handles[Handle].m_Handle, buf, Size, &Temp, NULL);
@@ -1959,6 +2069,9 @@ bool CPackFile::SetPos(DWORD Handle, DWORD Pos, int ftype) {
         }
         m_Handles[Handle].m_Offset = Pos + m_Handles[Handle].m_StartOffset;
     }
+    else if (m_View && m_Handles[Handle].m_Handle == m_Handle) {
+        m_Handles[Handle].m_Offset = m_Handles[Handle].m_StartOffset + Pos;
+    }
     else {
         Error = SetFilePointer((HANDLE)m_Handles[Handle].m_Handle, m_Handles[Handle].m_StartOffset + Pos, NULL,
                                FILE_BEGIN);
@@ -2005,6 +2118,27 @@ DWORD CPackFile::GetHandle(DWORD Handle) {
     return m_Handles[Handle].m_Handle;
 }
 
+bool CPackFile::GetView(const std::string& filename, std::span<const std::byte> &view) {
+    if (m_View == NULL || m_RootFolder == NULL)
+        return false;
+    SFileRec *PFile = m_RootFolder->GetFileRecEx(filename);
+    if (PFile == NULL)
+        return false;
+    return GetView(PFile, view);
+}
+
+bool CPackFile::GetView(SFileRec *PFile, std::span<const std::byte> &view) {
+    if (m_View == NULL || (PFile->m_Type != FILEEC_BINARY && PFile->m_Type != FILEEC_TEXT))
+        return false;
+
+    uintptr_t Offset = PFile->m_Offset + 4;
+    if (Offset > m_ViewSize || PFile->m_RealSize > m_ViewSize - Offset) {
+        ERROR_S(utils::format(L"Packet file system error: %ls", utils::to_wstring(PFile->m_RealName).c_str()));
+    }
+    view = std::span<const std::byte>((const std::byte *)(m_View + Offset), PFile->m_RealSize);
+    return true;
+}
+
 #ifdef HANDLE_OUT_OF_PACK_FILES
 bool CPackFile::PathExists(const std::string& path) {
     if (m_RootFolder->PathExists(path))
@@ -2328,21 +2462,173 @@ int CPackFile::FindFirst(
     return S.Folder->FindNext(S);
 }
 
+//**********************************************************************
+//***************** ИНДЕКС ИМЕН ФАЙЛОВ КОЛЛЕКЦИИ ***********************
+//**********************************************************************
+
+// the folder walk compares upper cased components, split by either separator
+static inline char PackKeyChar(char c) {
+    return c == '\\' ? '/' : char(std::toupper((unsigned char)c));
+}
+
+static DWORD PackKeyHash(const char *str, size_t len) {
+    DWORD h = 2166136261u;  // FNV-1a
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ BYTE(PackKeyChar(str[i]))) * 16777619u;
+    }
+    return h;
+}
+
+// names GetFileRec can match
+static bool IsPackKey(const char *name, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if (name[i] == '/' || PackKeyChar(name[i]) != name[i])
+            return false;
+    }
+    return len > 0;
+}
+
+void CPackIndex::Clear(void) {
+    m_Slots.clear();
+    m_Keys.clear();
+    m_Cnt = 0;
+}
+
+SPackIndexEntry *CPackIndex::Lookup(const char *path, size_t len) {
+    if (m_Cnt == 0)
+        return NULL;
+
+    // "DIR/" is "DIR" for the folder walk too
+    if (len > 0 && (path[len - 1] == '/' || path[len - 1] == '\\'))
+        --len;
+
+    DWORD hash = PackKeyHash(path, len);
+    DWORD mask = DWORD(m_Slots.size() - 1);
+    for (DWORD i = hash & mask;; i = (i + 1) & mask) {
+        SPackIndexEntry &e = m_Slots[i];
+        if (e.m_Rec == NULL)
+            return NULL;
+        if (e.m_Hash != hash || e.m_KeyLen != len)
+            continue;
+
+        const char *key = &m_Keys[e.m_Key];
+        size_t k = 0;
+        while (k < len && key[k] == PackKeyChar(path[k]))
+            ++k;
+        if (k == len)
+            return &e;
+    }
+}
+
+const SPackIndexEntry *CPackIndex::Find(const std::string& path) const {
+    return const_cast<CPackIndex *>(this)->Lookup(path.c_str(), path.length());
+}
+
+void CPackIndex::Grow(void) {
+    std::vector<SPackIndexEntry> old;
+    old.swap(m_Slots);
+    m_Slots.resize(old.empty() ? 1024 : old.size() * 2);  // zeroed: all the slots are empty
+
+    DWORD mask = DWORD(m_Slots.size() - 1);
+    for (const auto &e : old) {
+        if (e.m_Rec == NULL)
+            continue;
+        DWORD i = e.m_Hash & mask;
+        while (m_Slots[i].m_Rec != NULL)
+            i = (i + 1) & mask;
+        m_Slots[i] = e;
+    }
+}
+
+void CPackIndex::Insert(const std::string& path, int pack, SFileRec *PFile) {
+    if ((m_Cnt + 1) * 2 > int(m_Slots.size()))
+        Grow();
+
+    SPackIndexEntry e;
+    e.m_Hash = PackKeyHash(path.c_str(), path.length());
+    e.m_Key = DWORD(m_Keys.size());
+    e.m_KeyLen = DWORD(path.length());
+    e.m_Pack = pack;
+    e.m_LastPack = pack;
+    e.m_Rec = PFile;
+    e.m_File = PFile->m_Type != FILEEC_FOLDER;
+    m_Keys.insert(m_Keys.end(), path.begin(), path.end());
+
+    DWORD mask = DWORD(m_Slots.size() - 1);
+    DWORD i = e.m_Hash & mask;
+    while (m_Slots[i].m_Rec != NULL)
+        i = (i + 1) & mask;
+    m_Slots[i] = e;
+    ++m_Cnt;
+}
+
+void CPackIndex::AddFolder(CHsFolder *folder, std::string& path, int pack) {
+    size_t base = path.length();
+    for (DWORD i = 0; i < folder->m_FolderRec.m_Recnum; ++i) {
+        SFileRec *PFile = folder->GetFileRec(i);
+        size_t len = strnlen(PFile->m_Name, MAX_FILENAME_LENGTH);
+        if (PFile->m_Free != 0 || !IsPackKey(PFile->m_Name, len))
+            continue;
+
+        path.resize(base);
+        path.append(PFile->m_Name, len);
+
+        SPackIndexEntry *e = Lookup(path.c_str(), path.length());
+        if (e == NULL) {
+            Insert(path, pack, PFile);
+        }
+        else if (e->m_LastPack == pack) {
+            // GetFileRec finds the first record of a name: the others are not reachable
+            continue;
+        }
+        else {
+            // the earlier package keeps the path, this one may still have a file there
+            e->m_LastPack = pack;
+            e->m_File |= PFile->m_Type != FILEEC_FOLDER;
+        }
+
+        if (PFile->m_Type == FILEEC_FOLDER && PFile->m_Extra) {
+            path += '/';
+            AddFolder((CHsFolder *)PFile->m_Extra, path, pack);
+        }
+    }
+    path.resize(base);
+}
+
+void CPackIndex::AddPacket(CHsFolder *root, int pack) {
+    if (root == NULL)
+        return;
+    std::string path;
+    AddFolder(root, path, pack);
+}
+
 //**********************************************************************
 //***************** КЛАСС - КОЛЛЕКЦИЯ ПАКЕТНЫХ ФАЙЛОВ ******************
 //**********************************************************************
 
 void CPackCollection::Clear(void)
 {
+    m_Index.Clear();
     for (auto item : m_PackFiles)
     {
         HDelete(CPackFile, item, nullptr);
     }
     m_PackFiles.clear();
+    m_Inflater.Stop();
+}
+
+void CPackCollection::BuildIndex(void)
+{
+    m_Index.Clear();
+    for (int i = 0; i < int(m_PackFiles.size()); ++i)
+    {
+        m_Index.AddPacket(m_PackFiles[i]->m_RootFolder, i);
+    }
 }
 
 void CPackCollection::AddPacketFile(const wchar *name)
 {
+    m_Index.Clear();
     auto f = HNew(m_Heap) CPackFile(m_Heap, name);
     m_PackFiles.push_back(f);
 }
@@ -2353,6 +2639,7 @@ void CPackCollection::DelPacketFile(const wchar *name)
     auto item = std::ranges::find_if(m_PackFiles, pred);
     if (item != m_PackFiles.end())
     {
+        m_Index.Clear();
         m_PackFiles.erase(item);
     }
 }
@@ -2379,15 +2666,23 @@ bool CPackCollection::OpenPacketFiles(void)
         return false;
     }
 
+    BuildIndex();
+    m_Inflater.Start();
+    for (auto item : m_PackFiles)
+    {
+        item->m_Inflater = &m_Inflater;
+    }
     return true;
 }
 
 bool CPackCollection::ClosePacketFiles(void)
 {
+    m_Index.Clear();
     for (auto item : m_PackFiles)
     {
         item->ClosePacketFile();
     }
+    m_Inflater.Stop();
 
     return true;
 }
@@ -2414,11 +2709,13 @@ bool CPackCollection::OpenPacketFilesEx(void)
         return false;
     }
 
+    BuildIndex();
     return true;
 }
 
 bool CPackCollection::ClosePacketFilesEx(void)
 {
+    m_Index.Clear();
     for (auto item : m_PackFiles)
     {
         item->ClosePacketFileEx();
@@ -2431,6 +2728,12 @@ bool CPackCollection::ClosePacketFilesEx(void)
 
 bool CPackCollection::FileExists(const std::string& name)
 {
+    if (m_Index.GetCount() > 0)
+    {
+        const SPackIndexEntry *e = m_Index.Find(name);
+        return e != NULL && e->m_File;
+    }
+
     for (auto item : m_PackFiles)
     {
         if(item->FileExists(name))
@@ -2444,6 +2747,11 @@ bool CPackCollection::FileExists(const std::string& name)
 
 bool CPackCollection::PathExists(const std::string& path)
 {
+    if (m_Index.GetCount() > 0)
+    {
+        return m_Index.Find(path) != NULL;
+    }
+
     for (auto item : m_PackFiles)
     {
         if(item->PathExists(path))
@@ -2457,9 +2765,19 @@ bool CPackCollection::PathExists(const std::string& path)
 
 //******* работа с виртуальными номерами объектов CPackFile
 DWORD CPackCollection::Open(const std::string& name, DWORD modeopen) {
-    DWORD Handle;
+    DWORD Handle = 0xFFFFFFFF;
     DWORD Counter = 0;
 
+    if (m_Index.GetCount() > 0)
+    {
+        const SPackIndexEntry *e = m_Index.Find(name);
+        if (e == NULL)
+            return 0xFFFFFFFF;
+        Handle = m_PackFiles[e->m_Pack]->Open(e->m_Rec, name);
+        if (Handle != 0xFFFFFFFF)
+            return Handle + (DWORD(e->m_Pack) << MAX_VIRTUAL_HANDLE_COUNT_BITS);
+    }
+
     for (auto item : m_PackFiles)
     {
         Handle = item->Open(name, modeopen);
@@ -2532,6 +2850,24 @@ DWORD CPackCollection::GetSize(DWORD Handle) {
     return P->GetSize(Handle & (MAX_VIRTUAL_HANDLE_COUNT - 1));
 }
 
+bool CPackCollection::GetView(const std::string& name, std::span<const std::byte> &view) {
+    // the same package Open would take the file from
+    if (m_Index.GetCount() > 0)
+    {
+        const SPackIndexEntry *e = m_Index.Find(name);
+        return e != NULL && m_PackFiles[e->m_Pack]->GetView(e->m_Rec, view);
+    }
+
+    for (auto item : m_PackFiles)
+    {
+        if (item->PathExists(name))
+        {
+            return item->GetView(name, view);
+        }
+    }
+    return false;
+}
+
 DWORD CPackCollection::GetHandle(DWORD Handle) {
     ASSERT(MAX_VIRTUAL_HANDLE_COUNT == (1 << MAX_VIRTUAL_HANDLE_COUNT_BITS));
 
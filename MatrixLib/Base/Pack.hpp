@@ -10,7 +10,10 @@
 #include "CMain.hpp"
 #include "CHeap.hpp"
 #include "CBuf.hpp"
+#include "PackInflate.hpp"
 
+#include <cstddef>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -68,6 +71,7 @@ struct SFileHandleRec {
     bool m_Free;        // Запись свободна
     bool m_Compressed;  // Является ли файл сжатым
     WORD dummy00;       // align
+    const BYTE *m_Inflated;  // the whole unpacked file, see CPackInflater
 };
 
 typedef bool (*FILENAME_CALLBACK_FUNC)(bool Dir, bool Compr, const std::string& name);
@@ -84,6 +88,8 @@ struct SSearchRec {
 };
 
 class CHsFolder : public CMain {
+    friend class CPackIndex;
+
     CHeap *m_Heap;
 
     std::string m_Name;      // Имя папки без учета регистров
@@ -195,10 +201,22 @@ public:
     // DWORD           m_WorkFileStartOffset;      // Начальное смещение рабочего файла
     // DWORD           m_ID;                       // Идентификационный номер пакета в группе.
 
+    // Read-only mapping of the whole package. Reads are served from it when it is present,
+    // the file handle is only the fallback for when the mapping can not be made.
+    HANDLE m_Mapping;
+    const BYTE *m_View;
+    DWORD m_ViewSize;
+    CPackInflater *m_Inflater;  // NULL - compressed files are unpacked block by block while they are read
+
     int GetFreeHandle(void);
 
+    void MapView(void);
+    void UnmapView(void);
+
     // Устанавливает указатель в файл - возвращает размер сжатого блока
     DWORD SetCompressedBlockPointer(DWORD StartOffset, int nBlock);
+    // Same, for the mapped package: returns the block and its size, NULL if it is out of the package
+    const BYTE *GetCompressedBlock(DWORD StartOffset, int nBlock, DWORD &Size) const;
 
 public:
     CPackFile(CHeap *heap, const wchar *name);
@@ -219,6 +237,7 @@ public:
     void Clear(void);
     //***** Процедуры работы с файлами -- позиционирование указателя в файл ложится на объект PackFile
     DWORD Open(const std::string& filename, DWORD modeopen = GENERIC_READ | GENERIC_WRITE);
+    DWORD Open(SFileRec *PFile, const std::string& filename);  // record of this package
     bool Close(DWORD Handle);
     bool Read(DWORD Handle, void *buf, int Size);
 #ifdef HANDLE_OUT_OF_PACK_FILES
@@ -229,6 +248,11 @@ public:
     DWORD GetSize(DWORD Handle);
     DWORD GetHandle(DWORD Handle);
 
+    // Bytes of a stored (not compressed) file right in the mapped package: no copy and no virtual handle.
+    // The view is valid until the package is closed. False for compressed files or if the package is not mapped.
+    bool GetView(const std::string& filename, std::span<const std::byte> &view);
+    bool GetView(SFileRec *PFile, std::span<const std::byte> &view);
+
     //***** Общесистемные процедуры работы с файлами ****
 
 #ifdef HANDLE_OUT_OF_PACK_FILES
@@ -312,13 +336,50 @@ public:
     }
 };
 
+struct SPackIndexEntry {
+    DWORD m_Hash;
+    DWORD m_Key;  // normalized path in the key pool
+    DWORD m_KeyLen;
+    int m_Pack;         // first package the path is found in: the one CPackCollection::Open takes the file from
+    int m_LastPack;     // used while building
+    SFileRec *m_Rec;    // record in m_Pack, NULL - empty slot
+    bool m_File;        // the path is a file in some package
+};
+
+// Full paths of all the files and folders of the opened packages of a collection, in an open addressing table.
+// Gives the same answers as walking the folders package by package. Queries are normalized (upper case,
+// either separator) while they are hashed and compared, so a lookup does not allocate.
+class CPackIndex : public CMain {
+    std::vector<SPackIndexEntry> m_Slots;  // power of two
+    std::vector<char> m_Keys;
+    int m_Cnt;
+
+    SPackIndexEntry *Lookup(const char *path, size_t len);
+    void Insert(const std::string& path, int pack, SFileRec *PFile);
+    void Grow(void);
+    void AddFolder(CHsFolder *folder, std::string& path, int pack);
+
+public:
+    CPackIndex(void) : m_Cnt(0) {}
+
+    void Clear(void);
+    void AddPacket(CHsFolder *root, int pack);  // packages are added in the collection order
+
+    const SPackIndexEntry *Find(const std::string& path) const;
+    int GetCount(void) const { return m_Cnt; }
+};
+
 class CPackCollection : public CMain {
 public:
     CHeap *m_Heap;
     std::vector<CPackFile*> m_PackFiles;
+    CPackIndex m_Index;  // built when all the packages are opened, empty otherwise
+    CPackInflater m_Inflater;
+
+    void BuildIndex(void);
 
 public:
-    CPackCollection(CHeap *heap) : m_Heap(heap) {}
+    CPackCollection(CHeap *heap) : m_Heap(heap), m_Inflater(heap) {}
     ~CPackCollection() { Clear(); };
 
     //******** Процедуры работы со списком пакетных файлом ********//
@@ -343,6 +404,8 @@ public:
     DWORD GetPos(DWORD Handle);
     DWORD GetSize(DWORD Handle);
     DWORD GetHandle(DWORD Handle);
+    //******* прямой доступ к отображенным в память файлам
+    bool GetView(const std::string& name, std::span<const std::byte> &view);
     //******* работа с извлекаемыми файлами *********************
     // bool        UnpackFile(const std::string& souname) {UnpackFile(souname,souname);};
     // bool        UnpackFile(const std::string& souname,const std::string& desname);
@@ -0,0 +1,241 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "PackInflate.hpp"
+#include "CException.hpp"
+
+#include <algorithm>
+
+int OKGF_ZLib_UnCompress2(BYTE *desbuf, int len_des_buf, const BYTE *soubuf, int len_sou_buf);
+
+namespace Base {
+
+CPackInflater::CPackInflater(CHeap *heap) : m_Heap(heap) {
+    m_ThreadCnt = 0;
+    InitializeCriticalSection(&m_Lock);
+    m_Wake = CreateSemaphoreW(NULL, 0, 0x7fffffff, NULL);
+    m_Done = CreateEventW(NULL, FALSE, FALSE, NULL);
+    m_Stop = false;
+    m_FilesSize = 0;
+    m_Tick = 0;
+}
+
+CPackInflater::~CPackInflater() {
+    Stop();
+    for (auto &f : m_Files) {
+        HFree(f.m_Data, m_Heap);
+    }
+    m_Files.clear();
+    CloseHandle(m_Wake);
+    CloseHandle(m_Done);
+    DeleteCriticalSection(&m_Lock);
+}
+
+void CPackInflater::Start(void) {
+    if (m_ThreadCnt > 0)
+        return;
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    int cnt = std::min(int(si.dwNumberOfProcessors) - 1, PACK_INFLATE_THREADS_MAX);
+
+    m_Stop = false;
+    for (int i = 0; i < cnt; ++i) {
+        HANDLE h = CreateThread(NULL, 0, ThreadProc, this, 0, NULL);
+        if (h == NULL)
+            break;
+        m_Threads[m_ThreadCnt++] = h;
+    }
+}
+
+void CPackInflater::Stop(void) {
+    if (m_ThreadCnt == 0)
+        return;
+
+    EnterCriticalSection(&m_Lock);
+    m_Stop = true;
+    LeaveCriticalSection(&m_Lock);
+
+    ReleaseSemaphore(m_Wake, m_ThreadCnt, NULL);
+    WaitForMultipleObjects(m_ThreadCnt, m_Threads, TRUE, INFINITE);
+    for (int i = 0; i < m_ThreadCnt; ++i) {
+        CloseHandle(m_Threads[i]);
+    }
+    m_ThreadCnt = 0;
+}
+
+DWORD WINAPI CPackInflater::ThreadProc(LPVOID param) {
+    CPackInflater *inflater = (CPackInflater *)param;
+    for (;;) {
+        WaitForSingleObject(inflater->m_Wake, INFINITE);
+
+        EnterCriticalSection(&inflater->m_Lock);
+        bool stop = inflater->m_Stop;
+        LeaveCriticalSection(&inflater->m_Lock);
+        if (stop)
+            break;
+
+        // the opening thread may have taken the blocks already
+        while (SInflateBlock *block = inflater->PopBlock()) {
+            inflater->Unpack(block);
+        }
+    }
+    return 0;
+}
+
+SInflateBlock *CPackInflater::PopBlock(void) {
+    SInflateBlock *block = NULL;
+    EnterCriticalSection(&m_Lock);
+    if (!m_Queue.empty()) {
+        block = m_Queue.back();
+        m_Queue.pop_back();
+    }
+    LeaveCriticalSection(&m_Lock);
+    return block;
+}
+
+void CPackInflater::Unpack(SInflateBlock *block) {
+    SInflateJob *job = block->m_Job;
+    int len = OKGF_ZLib_UnCompress2(block->m_Des, block->m_DesSize, block->m_Sou, block->m_SouSize);
+    if (DWORD(len) != block->m_DesSize) {
+        InterlockedExchange(&job->m_Failed, 1);
+    }
+    // the job is gone as soon as its last block is done
+    if (InterlockedDecrement(&job->m_Left) == 0) {
+        SetEvent(m_Done);
+    }
+}
+
+bool CPackInflater::UnpackBlocks(std::vector<SInflateBlock> &blocks) {
+    SInflateJob job;
+    job.m_Left = LONG(blocks.size());
+    job.m_Failed = 0;
+    for (auto &b : blocks) {
+        b.m_Job = &job;
+    }
+
+    if (m_ThreadCnt > 0 && blocks.size() > 1) {
+        EnterCriticalSection(&m_Lock);
+        for (auto &b : blocks) {
+            m_Queue.push_back(&b);
+        }
+        LeaveCriticalSection(&m_Lock);
+        ReleaseSemaphore(m_Wake, std::min(int(blocks.size()) - 1, m_ThreadCnt), NULL);
+
+        while (SInflateBlock *block = PopBlock()) {
+            Unpack(block);
+        }
+        while (job.m_Left > 0) {
+            WaitForSingleObject(m_Done, INFINITE);
+        }
+    }
+    else {
+        for (auto &b : blocks) {
+            Unpack(&b);
+        }
+    }
+
+    return job.m_Failed == 0;
+}
+
+const BYTE *CPackInflater::Acquire(const BYTE *sou, const BYTE *souend, DWORD realsize) {
+    for (auto &f : m_Files) {
+        if (f.m_Sou == sou) {
+            ++f.m_Ref;
+            f.m_Used = ++m_Tick;
+            return f.m_Data;
+        }
+    }
+
+    if (realsize == 0)
+        return NULL;
+
+    // blocks go one by one: compressed size, then the block
+    int cnt = (realsize + PACK_BLOCK_SIZE - 1) / PACK_BLOCK_SIZE;
+    std::vector<SInflateBlock> blocks(cnt);
+    BYTE *data = (BYTE *)HAlloc(realsize, m_Heap);
+    const BYTE *ptr = sou;
+    for (int i = 0; i < cnt; ++i) {
+        if (souend - ptr < 4 || *(const DWORD *)ptr > DWORD(souend - ptr - 4)) {
+            HFree(data, m_Heap);
+            return NULL;
+        }
+        SInflateBlock &b = blocks[i];
+        b.m_Sou = ptr + 4;
+        b.m_SouSize = *(const DWORD *)ptr;
+        b.m_Des = data + i * PACK_BLOCK_SIZE;
+        b.m_DesSize = std::min(DWORD(PACK_BLOCK_SIZE), realsize - i * PACK_BLOCK_SIZE);
+        ptr += b.m_SouSize + 4;
+    }
+
+    if (!UnpackBlocks(blocks)) {
+        HFree(data, m_Heap);
+        return NULL;
+    }
+
+    SInflatedFile f;
+    f.m_Sou = sou;
+    f.m_Data = data;
+    f.m_Size = realsize;
+    f.m_Ref = 1;
+    f.m_Used = ++m_Tick;
+    m_Files.push_back(f);
+    m_FilesSize += realsize;
+    Trim();
+
+    return data;
+}
+
+void CPackInflater::Release(const BYTE *data) {
+    for (int i = 0; i < int(m_Files.size()); ++i) {
+        SInflatedFile &f = m_Files[i];
+        if (f.m_Data == data) {
+            ASSERT(f.m_Ref > 0);
+            --f.m_Ref;
+            if (f.m_Ref <= 0 && f.m_Sou == NULL) {
+                // its package is gone, nobody can open it again
+                m_FilesSize -= f.m_Size;
+                HFree(f.m_Data, m_Heap);
+                m_Files.erase(m_Files.begin() + i);
+            }
+            break;
+        }
+    }
+    Trim();
+}
+
+void CPackInflater::Trim(void) {
+    while (m_FilesSize > PACK_INFLATE_CACHE_SIZE) {
+        int lru = -1;
+        for (int i = 0; i < int(m_Files.size()); ++i) {
+            if (m_Files[i].m_Ref == 0 && (lru < 0 || m_Files[i].m_Used < m_Files[lru].m_Used))
+                lru = i;
+        }
+        if (lru < 0)
+            break;
+
+        m_FilesSize -= m_Files[lru].m_Size;
+        HFree(m_Files[lru].m_Data, m_Heap);
+        m_Files.erase(m_Files.begin() + lru);
+    }
+}
+
+void CPackInflater::Purge(const BYTE *view, DWORD size) {
+    for (int i = int(m_Files.size()) - 1; i >= 0; --i) {
+        SInflatedFile &f = m_Files[i];
+        if (f.m_Sou >= view && f.m_Sou < view + size) {
+            if (f.m_Ref != 0) {
+                // still open: the data stays until Release, but the address may be mapped again for another file
+                f.m_Sou = NULL;
+                continue;
+            }
+            m_FilesSize -= f.m_Size;
+            HFree(f.m_Data, m_Heap);
+            m_Files.erase(m_Files.begin() + i);
+        }
+    }
+}
+
+}  // namespace Base
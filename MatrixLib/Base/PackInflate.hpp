@@ -0,0 +1,86 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "CMain.hpp"
+#include "CHeap.hpp"
+
+#include <windows.h>
+#include <vector>
+
+namespace Base {
+
+#define PACK_BLOCK_SIZE          65536              // size of an unpacked block of a compressed file
+#define PACK_INFLATE_THREADS_MAX 7                  // workers besides the calling thread
+#define PACK_INFLATE_CACHE_SIZE  (16 * 1024 * 1024)  // unpacked files kept after they are closed
+
+struct SInflateJob {
+    volatile LONG m_Left;  // blocks not unpacked yet
+    volatile LONG m_Failed;
+};
+
+struct SInflateBlock {
+    SInflateJob *m_Job;
+    const BYTE *m_Sou;
+    DWORD m_SouSize;
+    BYTE *m_Des;
+    DWORD m_DesSize;
+};
+
+struct SInflatedFile {
+    const BYTE *m_Sou;  // first block in the mapped package, NULL once the package is unmapped
+    BYTE *m_Data;
+    DWORD m_Size;
+    int m_Ref;
+    DWORD m_Used;
+};
+
+/**
+ * @brief Unpacks compressed files of the mapped packages for CPackFile.
+ *
+ * A compressed file is unpacked as a whole when it is opened: its blocks are queued for a few worker threads
+ * and the opening thread unpacks them together with the workers. Unpacked files stay in a small cache after
+ * they are closed, so opening the same file again costs nothing.
+ *
+ * Only the block queue is shared with the workers; everything else is used by the thread which opens the files.
+ */
+class CPackInflater : public CMain {
+    CHeap *m_Heap;
+
+    HANDLE m_Threads[PACK_INFLATE_THREADS_MAX];
+    int m_ThreadCnt;
+    CRITICAL_SECTION m_Lock;
+    HANDLE m_Wake;  // semaphore: a block is queued
+    HANDLE m_Done;  // some job has finished
+    std::vector<SInflateBlock *> m_Queue;
+    bool m_Stop;
+
+    std::vector<SInflatedFile> m_Files;
+    DWORD m_FilesSize;
+    DWORD m_Tick;
+
+    static DWORD WINAPI ThreadProc(LPVOID param);
+    SInflateBlock *PopBlock(void);
+    void Unpack(SInflateBlock *block);
+    bool UnpackBlocks(std::vector<SInflateBlock> &blocks);
+    void Trim(void);
+
+public:
+    CPackInflater(CHeap *heap);
+    ~CPackInflater();
+
+    void Start(void);
+    void Stop(void);
+
+    // File of realsize bytes which blocks start at sou; souend is the end of the package.
+    // NULL if it can not be unpacked. The data stays valid until Release.
+    const BYTE *Acquire(const BYTE *sou, const BYTE *souend, DWORD realsize);
+    void Release(const BYTE *data);
+    // drop the cached files of a package which is being unmapped; the open ones are dropped on their Release
+    void Purge(const BYTE *view, DWORD size);
+};
+
+}  // namespace Base
@@ -0,0 +1,243 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#include "TaskGraph.hpp"
+#include "CException.hpp"
+
+#include <algorithm>
+#include <cwchar>
+
+namespace Base {
+
+static int TaskGraphThreads(void) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return std::max(0, std::min(int(si.dwNumberOfProcessors) - 1, TASK_GRAPH_THREADS_MAX));
+}
+
+CTaskGraph::CTaskGraph(void) : CMain() {
+    m_ThreadCnt = 0;
+    InitializeCriticalSection(&m_Lock);
+    m_Wake = CreateSemaphoreW(NULL, 0, 0x7fffffff, NULL);
+    m_Done = CreateEventW(NULL, FALSE, FALSE, NULL);
+    m_Left = 0;
+    m_Stop = false;
+}
+
+CTaskGraph::~CTaskGraph() {
+    CloseHandle(m_Wake);
+    CloseHandle(m_Done);
+    DeleteCriticalSection(&m_Lock);
+}
+
+int CTaskGraph::Add(const wchar *name, std::function<void(void)> func, std::initializer_list<int> deps, bool main) {
+    int no = int(m_Tasks.size());
+    STask &t = m_Tasks.emplace_back();
+    t.m_Name = name;
+    t.m_Func = std::move(func);
+    t.m_Main = main;
+    t.m_Wait = 0;
+    t.m_Thread = -1;
+    t.m_Start = t.m_End = std::chrono::steady_clock::duration::zero();
+    for (int d : deps) {
+        ASSERT(d >= 0 && d < no);
+        m_Tasks[d].m_Next.push_back(no);
+        ++m_Tasks[no].m_Wait;
+    }
+    return no;
+}
+
+int CTaskGraph::AddSplit(const wchar *name, int cnt, std::function<void(int, int)> func,
+                         std::initializer_list<int> deps) {
+    // a few parts per thread, so that a slow one does not hold the rest
+    int parts = std::max(1, std::min(cnt, (TaskGraphThreads() + 1) * 4));
+    std::vector<int> split;
+    for (int i = 0; i < parts; ++i) {
+        int from = int(int64_t(cnt) * i / parts);
+        int to = int(int64_t(cnt) * (i + 1) / parts);
+        split.push_back(Add(name, [func, from, to]() { func(from, to); }, deps));
+    }
+
+    // the join has no work, it is not counted in the stage
+    int join = Add(name, nullptr);
+    for (int s : split) {
+        m_Tasks[s].m_Next.push_back(join);
+        ++m_Tasks[join].m_Wait;
+    }
+    return join;
+}
+
+DWORD WINAPI CTaskGraph::ThreadProc(LPVOID param) {
+    SWorker *w = (SWorker *)param;
+    CTaskGraph *graph = w->m_Graph;
+    for (;;) {
+        WaitForSingleObject(graph->m_Wake, INFINITE);
+
+        EnterCriticalSection(&graph->m_Lock);
+        bool stop = graph->m_Stop;
+        LeaveCriticalSection(&graph->m_Lock);
+        if (stop)
+            break;
+
+        // the calling thread may have taken the task already
+        int task;
+        while ((task = graph->PopTask(false)) >= 0) {
+            graph->Execute(task, w->m_No);
+        }
+    }
+    return 0;
+}
+
+int CTaskGraph::PopTask(bool main) {
+    int task = -1;
+    EnterCriticalSection(&m_Lock);
+    if (main && !m_ReadyMain.empty()) {
+        task = m_ReadyMain.front();
+        m_ReadyMain.erase(m_ReadyMain.begin());
+    }
+    else if (!m_Ready.empty()) {
+        task = m_Ready.front();
+        m_Ready.erase(m_Ready.begin());
+    }
+    LeaveCriticalSection(&m_Lock);
+    return task;
+}
+
+void CTaskGraph::Execute(int task, int thread) {
+    STask &t = m_Tasks[task];
+    t.m_Thread = thread;
+    t.m_Start = std::chrono::steady_clock::now() - m_Begin;
+
+    if (t.m_Func) {
+        EnterCriticalSection(&m_Lock);
+        bool failed = m_Error != nullptr;
+        LeaveCriticalSection(&m_Lock);
+
+        if (!failed) {
+            try {
+                t.m_Func();
+            }
+            catch (...) {
+                EnterCriticalSection(&m_Lock);
+                if (m_Error == nullptr)
+                    m_Error = std::current_exception();
+                LeaveCriticalSection(&m_Lock);
+            }
+        }
+    }
+
+    t.m_End = std::chrono::steady_clock::now() - m_Begin;
+
+    int wake = 0;
+    EnterCriticalSection(&m_Lock);
+    for (int n : t.m_Next) {
+        STask &next = m_Tasks[n];
+        if (--next.m_Wait > 0)
+            continue;
+        if (next.m_Main) {
+            m_ReadyMain.push_back(n);
+        }
+        else {
+            m_Ready.push_back(n);
+            ++wake;
+        }
+    }
+    --m_Left;
+    LeaveCriticalSection(&m_Lock);
+
+    if (wake > 0 && m_ThreadCnt > 0)
+        ReleaseSemaphore(m_Wake, std::min(wake, m_ThreadCnt), NULL);
+    SetEvent(m_Done);
+}
+
+void CTaskGraph::Run(void) {
+    m_Begin = std::chrono::steady_clock::now();
+    m_Left = int(m_Tasks.size());
+    m_Error = nullptr;
+    m_Stop = false;
+    m_Ready.clear();
+    m_ReadyMain.clear();
+    for (int i = 0; i < int(m_Tasks.size()); ++i) {
+        if (m_Tasks[i].m_Wait == 0)
+            (m_Tasks[i].m_Main ? m_ReadyMain : m_Ready).push_back(i);
+    }
+
+    // wakes left from the previous run
+    while (WaitForSingleObject(m_Wake, 0) == WAIT_OBJECT_0) {}
+
+    m_ThreadCnt = 0;
+    int cnt = TaskGraphThreads();
+    for (int i = 0; i < cnt; ++i) {
+        m_Workers[i].m_Graph = this;
+        m_Workers[i].m_No = i + 1;
+        HANDLE h = CreateThread(NULL, 0, ThreadProc, &m_Workers[i], 0, NULL);
+        if (h == NULL)
+            break;
+        m_Threads[m_ThreadCnt++] = h;
+    }
+    if (m_ThreadCnt > 0 && !m_Ready.empty())
+        ReleaseSemaphore(m_Wake, std::min(int(m_Ready.size()), m_ThreadCnt), NULL);
+
+    // the main tasks first: the workers can not take them
+    for (;;) {
+        int task = PopTask(true);
+        if (task >= 0) {
+            Execute(task, 0);
+            continue;
+        }
+
+        EnterCriticalSection(&m_Lock);
+        int left = m_Left;
+        LeaveCriticalSection(&m_Lock);
+        if (left == 0)
+            break;
+        WaitForSingleObject(m_Done, INFINITE);
+    }
+
+    if (m_ThreadCnt > 0) {
+        EnterCriticalSection(&m_Lock);
+        m_Stop = true;
+        LeaveCriticalSection(&m_Lock);
+
+        ReleaseSemaphore(m_Wake, m_ThreadCnt, NULL);
+        WaitForMultipleObjects(m_ThreadCnt, m_Threads, TRUE, INFINITE);
+        for (int i = 0; i < m_ThreadCnt; ++i) {
+            CloseHandle(m_Threads[i]);
+        }
+    }
+
+    if (m_Error != nullptr)
+        std::rethrow_exception(m_Error);
+}
+
+std::vector<STaskStage> CTaskGraph::GetStages(void) const {
+    std::vector<STaskStage> stages;
+    std::vector<DWORD> threads;
+    for (const STask &t : m_Tasks) {
+        if (!t.m_Func)
+            continue;
+
+        auto it = std::find_if(stages.begin(), stages.end(),
+                               [&t](const STaskStage &s) { return std::wcscmp(s.m_Name, t.m_Name) == 0; });
+        if (it == stages.end()) {
+            stages.push_back(STaskStage{t.m_Name, 0, 0, t.m_Start, t.m_End, std::chrono::steady_clock::duration::zero()});
+            threads.push_back(0);
+            it = stages.end() - 1;
+        }
+        ++it->m_Tasks;
+        it->m_Start = std::min(it->m_Start, t.m_Start);
+        it->m_End = std::max(it->m_End, t.m_End);
+        it->m_Busy += t.m_End - t.m_Start;
+
+        DWORD &mask = threads[it - stages.begin()];
+        if (t.m_Thread >= 0 && !(mask & (1 << t.m_Thread))) {
+            mask |= 1 << t.m_Thread;
+            ++it->m_Threads;
+        }
+    }
+    return stages;
+}
+
+}  // namespace Base
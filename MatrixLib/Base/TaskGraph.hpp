@@ -0,0 +1,95 @@
+// MatrixGame - SR2 Planetary battles engine
+// Copyright (C) 2012, Elemental Games, Katauri Interactive, CHK-Games
+// Licensed under GPLv2 or any later version
+// Refer to the LICENSE file included
+
+#pragma once
+
+#include "CMain.hpp"
+
+#include <windows.h>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+namespace Base {
+
+#define TASK_GRAPH_THREADS_MAX 7  // workers besides the calling thread
+
+struct STask {
+    const wchar *m_Name;
+    std::function<void(void)> m_Func;
+    bool m_Main;                // runs on the calling thread: the device, the load progress
+    std::vector<int> m_Next;    // tasks which wait for this one
+    int m_Wait;                 // dependencies not done yet
+    int m_Thread;               // which one has run it, 0 is the calling thread
+    std::chrono::steady_clock::duration m_Start, m_End;  // since Run
+};
+
+// all the tasks of a name together
+struct STaskStage {
+    const wchar *m_Name;
+    int m_Tasks;
+    int m_Threads;
+    std::chrono::steady_clock::duration m_Start, m_End;  // first start, last end
+    std::chrono::steady_clock::duration m_Busy;          // sum of the tasks
+};
+
+/**
+ * @brief Runs a set of tasks with dependencies between them on a few worker threads.
+ *
+ * A task runs as soon as all of its dependencies are done. The main tasks run on the thread which calls Run,
+ * the rest go to whichever thread is free, the calling one included. Work over a range can be split into a few
+ * tasks of the same name (AddSplit), the tasks depending on it wait for all of them.
+ *
+ * The workers live for one Run only. If a task throws, the tasks which are not started yet are skipped and Run
+ * throws the exception after all the running ones are done.
+ */
+class BASE_API CTaskGraph : public CMain {
+    std::vector<STask> m_Tasks;
+
+    HANDLE m_Threads[TASK_GRAPH_THREADS_MAX];
+    int m_ThreadCnt;
+    CRITICAL_SECTION m_Lock;
+    HANDLE m_Wake;  // semaphore: a task for the workers is ready
+    HANDLE m_Done;  // some task is done
+    std::vector<int> m_Ready;      // for any thread, in the order they have become ready
+    std::vector<int> m_ReadyMain;  // for the calling thread only
+    int m_Left;
+    bool m_Stop;
+    std::exception_ptr m_Error;
+    std::chrono::steady_clock::time_point m_Begin;
+
+    struct SWorker {
+        CTaskGraph *m_Graph;
+        int m_No;
+    } m_Workers[TASK_GRAPH_THREADS_MAX];
+
+    static DWORD WINAPI ThreadProc(LPVOID param);
+    int PopTask(bool main);
+    void Execute(int task, int thread);
+
+public:
+    CTaskGraph(void);
+    ~CTaskGraph();
+
+    // index of the task, to be given as a dependency of the next ones
+    int Add(const wchar *name, std::function<void(void)> func, std::initializer_list<int> deps = {},
+            bool main = false);
+    int AddMain(const wchar *name, std::function<void(void)> func, std::initializer_list<int> deps = {}) {
+        return Add(name, std::move(func), deps, true);
+    }
+    // func(from, to) over [0, cnt) in a few parts; the index is of the task which waits for all of them
+    int AddSplit(const wchar *name, int cnt, std::function<void(int, int)> func, std::initializer_list<int> deps = {});
+
+    void Run(void);
+
+    const std::vector<STask> &GetTasks(void) const { return m_Tasks; }
+    // in the order the stages were added
+    std::vector<STaskStage> GetStages(void) const;
+    int GetThreadCnt(void) const { return m_ThreadCnt; }
+};
+
+}  // namespace Base